@@ -0,0 +1,175 @@
+#include "archive_asset_source.hpp"
+#include <mbgl/actor/scheduler.hpp>
+#include <mbgl/storage/response.hpp>
+#include <mbgl/util/async_request.hpp>
+#include <mbgl/util/url.hpp>
+#include <algorithm>
+#include <cctype>
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        constexpr std::string_view ASSET_SCHEME = "asset://";
+        constexpr std::string_view ARCHIVE_SEPARATOR = "!/";
+
+        bool hasArchiveExtension(const std::string &path)
+        {
+            auto endsWith = [&](std::string_view suffix)
+            {
+                return path.size() >= suffix.size() &&
+                       std::equal(suffix.rbegin(), suffix.rend(), path.rbegin(), [](char a, char b)
+                                  { return a == std::tolower(static_cast<unsigned char>(b)); });
+            };
+            return endsWith(".jar") || endsWith(".zip");
+        }
+    } // namespace
+
+    struct ArchiveAssetSource::Task
+    {
+        Callback callback;
+        // RunLoop of the requesting thread
+        mbgl::Scheduler *scheduler = nullptr;
+    };
+
+    // Handed to the requester; dropping it discards the response
+    class ArchiveAssetSource::Request final : public mbgl::AsyncRequest
+    {
+    public:
+        explicit Request(std::shared_ptr<Task> task_)
+            : task(std::move(task_))
+        {
+        }
+
+    private:
+        std::shared_ptr<Task> task;
+    };
+
+    namespace
+    {
+        template <typename Task>
+        void deliver(const std::weak_ptr<Task> &weak, mbgl::Scheduler *scheduler, const mbgl::Response &response)
+        {
+            if (!scheduler)
+            {
+                if (auto task = weak.lock())
+                {
+                    task->callback(response);
+                }
+                return;
+            }
+            scheduler->schedule([weak, response]
+                                {
+                                    if (auto task = weak.lock())
+                                    {
+                                        task->callback(response);
+                                    } });
+        }
+
+        template <typename Task>
+        void respond(const std::weak_ptr<Task> &weak, mbgl::Scheduler *scheduler, const ZipArchive &archive, const ZipArchive::Entry &entry)
+        {
+            mbgl::Response response;
+            try
+            {
+                response.data = std::make_shared<std::string>(archive.read(entry));
+            }
+            catch (const std::exception &e)
+            {
+                response.error = std::make_unique<mbgl::Response::Error>(mbgl::Response::Error::Reason::Other, e.what());
+            }
+            deliver(weak, scheduler, response);
+        }
+    } // namespace
+
+    std::optional<ArchiveAssetSource::Location> ArchiveAssetSource::parseAssetPath(const std::string &assetPath)
+    {
+        const auto separator = assetPath.find(ARCHIVE_SEPARATOR);
+        if (separator != std::string::npos)
+        {
+            return Location{assetPath.substr(0, separator), assetPath.substr(separator + ARCHIVE_SEPARATOR.size())};
+        }
+        if (hasArchiveExtension(assetPath))
+        {
+            return Location{assetPath, {}};
+        }
+        return std::nullopt;
+    }
+
+    ArchiveAssetSource::ArchiveAssetSource(const Location &location, const mbgl::ResourceOptions &resourceOptions_,
+                                           const mbgl::ClientOptions &clientOptions_)
+        : archive(ZipArchive::open(location.archive)),
+          prefix(location.prefix),
+          resourceOptions(resourceOptions_.clone()),
+          clientOptions(clientOptions_.clone())
+    {
+        if (!prefix.empty() && prefix.back() != '/')
+        {
+            prefix += '/';
+        }
+    }
+
+    ArchiveAssetSource::~ArchiveAssetSource() = default;
+
+    std::unique_ptr<mbgl::AsyncRequest> ArchiveAssetSource::request(const mbgl::Resource &resource, Callback callback)
+    {
+        auto task = std::make_shared<Task>();
+        task->callback = std::move(callback);
+        task->scheduler = mbgl::Scheduler::GetCurrent();
+        std::weak_ptr<Task> weak = task;
+
+        std::string path = mbgl::util::percentDecode(resource.url.substr(ASSET_SCHEME.size()));
+        path.erase(0, path.find_first_not_of('/'));
+
+        const auto entry = archive->find(prefix + path);
+        if (!entry)
+        {
+            mbgl::Response response;
+            response.error = std::make_unique<mbgl::Response::Error>(mbgl::Response::Error::Reason::NotFound,
+                                                                     "Asset " + path + " not found in " + archive->getPath());
+            deliver(weak, task->scheduler, response);
+        }
+        else if (!entry->deflated || !task->scheduler)
+        {
+            respond(weak, task->scheduler, *archive, *entry);
+        }
+        else
+        {
+            mbgl::Scheduler::GetBackground()->schedule([weak, scheduler = task->scheduler, archive = archive, entry = *entry]
+                                                       {
+                                                           if (!weak.expired())
+                                                           {
+                                                               respond(weak, scheduler, *archive, entry);
+                                                           } });
+        }
+
+        return std::make_unique<Request>(std::move(task));
+    }
+
+    bool ArchiveAssetSource::canRequest(const mbgl::Resource &resource) const
+    {
+        return resource.url.compare(0, ASSET_SCHEME.size(), ASSET_SCHEME) == 0;
+    }
+
+    void ArchiveAssetSource::setResourceOptions(mbgl::ResourceOptions options)
+    {
+        resourceOptions = std::move(options);
+    }
+
+    mbgl::ResourceOptions ArchiveAssetSource::getResourceOptions()
+    {
+        return resourceOptions.clone();
+    }
+
+    void ArchiveAssetSource::setClientOptions(mbgl::ClientOptions options)
+    {
+        clientOptions = std::move(options);
+    }
+
+    mbgl::ClientOptions ArchiveAssetSource::getClientOptions()
+    {
+        return clientOptions.clone();
+    }
+
+} // namespace maplibre_jni
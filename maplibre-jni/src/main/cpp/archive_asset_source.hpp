@@ -0,0 +1,58 @@
+#pragma once
+
+#include "zip_archive.hpp"
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/resource.hpp>
+#include <mbgl/storage/resource_options.hpp>
+#include <mbgl/util/client_options.hpp>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace maplibre_jni
+{
+
+    // FileSource serving asset:// URLs out of a ZIP or JAR archive instead of a directory
+    //
+    // The archive is memory-mapped and indexed once, and shared by every source reading it.
+    // Stored entries are copied straight out of the mapping on the requesting thread; deflated
+    // entries are decompressed on mbgl's background scheduler. Either way the response is
+    // delivered on the requesting thread's RunLoop.
+    class ArchiveAssetSource final : public mbgl::FileSource
+    {
+    public:
+        struct Location
+        {
+            std::string archive;
+            // Prepended to asset paths to form entry names, e.g. "maplibre/"
+            std::string prefix;
+        };
+
+        // Archive named by an asset path, either "app.jar!/prefix/" or a path ending in .jar or
+        // .zip; nullopt for anything else, which is left to mbgl's directory asset source
+        static std::optional<Location> parseAssetPath(const std::string &assetPath);
+
+        // Throws std::runtime_error if the archive can't be opened
+        ArchiveAssetSource(const Location &location, const mbgl::ResourceOptions &resourceOptions,
+                           const mbgl::ClientOptions &clientOptions);
+        ~ArchiveAssetSource() override;
+
+        std::unique_ptr<mbgl::AsyncRequest> request(const mbgl::Resource &resource, Callback callback) override;
+
+        bool canRequest(const mbgl::Resource &resource) const override;
+        void setResourceOptions(mbgl::ResourceOptions options) override;
+        mbgl::ResourceOptions getResourceOptions() override;
+        void setClientOptions(mbgl::ClientOptions options) override;
+        mbgl::ClientOptions getClientOptions() override;
+
+    private:
+        struct Task;
+        class Request;
+
+        std::shared_ptr<ZipArchive> archive;
+        std::string prefix;
+        mbgl::ResourceOptions resourceOptions;
+        mbgl::ClientOptions clientOptions;
+    };
+
+} // namespace maplibre_jni
@@ -20,15 +20,20 @@ namespace maplibre_jni
         jobject canvas,
         int width,
         int height,
-        const mbgl::gfx::ContextMode contextMode)
+        const mbgl::gfx::ContextMode contextMode,
+        const std::optional<std::string> &shaderCachePath)
     {
 #ifdef USE_METAL_BACKEND
         return std::make_unique<MetalBackend>(env, canvas, width, height);
 #elif USE_VULKAN_BACKEND
-        return std::make_unique<VulkanBackend>(env, canvas, width, height);
+        return std::make_unique<VulkanBackend>(env, canvas, width, height, shaderCachePath);
 #elif USE_EGL_BACKEND
-        auto strategy = std::make_unique<EGLContextStrategy>();
-        return std::make_unique<GLBackend>(env, canvas, width, height, std::move(strategy));
+        // Shared mode renders every such map through one context; mbgl re-syncs its GL state
+        // assumptions each frame because other maps touched the context in between. Each map
+        // still creates its own GL objects and programs in it.
+        const bool shareContext = contextMode == mbgl::gfx::ContextMode::Shared;
+        auto strategy = std::make_unique<EGLContextStrategy>(shaderCachePath, shareContext);
+        return std::make_unique<GLBackend>(env, canvas, width, height, std::move(strategy), contextMode);
 #elif USE_WGL_BACKEND
         auto strategy = std::make_unique<WGLContextStrategy>();
         return std::make_unique<GLBackend>(env, canvas, width, height, std::move(strategy));
@@ -41,4 +46,14 @@ namespace maplibre_jni
 #endif
     }
 
+    std::optional<std::string> shaderCachePathFor(const mbgl::ResourceOptions &resourceOptions)
+    {
+        const std::string &cachePath = resourceOptions.cachePath();
+        if (cachePath.empty() || cachePath == ":memory:")
+        {
+            return std::nullopt;
+        }
+        return cachePath + ".shaders";
+    }
+
 } // namespace maplibre_jni
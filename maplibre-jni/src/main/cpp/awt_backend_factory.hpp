@@ -1,8 +1,11 @@
 #pragma once
 
 #include <mbgl/gfx/renderer_backend.hpp>
+#include <mbgl/storage/resource_options.hpp>
 #include <mbgl/util/size.hpp>
 #include <memory>
+#include <optional>
+#include <string>
 #include <jni.h>
 
 #ifdef USE_METAL_BACKEND
@@ -28,6 +31,10 @@ namespace maplibre_jni
         jobject canvas,
         int width,
         int height,
-        const mbgl::gfx::ContextMode contextMode);
+        const mbgl::gfx::ContextMode contextMode,
+        const std::optional<std::string> &shaderCachePath = std::nullopt);
+
+    // Directory for compiled GPU programs next to the ambient cache database, if it is on disk
+    std::optional<std::string> shaderCachePathFor(const mbgl::ResourceOptions &resourceOptions);
 
 } // namespace maplibre_jni
@@ -1,11 +1,14 @@
 #include "awt_canvas_renderer.hpp"
 #include "jni_helpers.hpp"
 #include "awt_backend_factory.hpp"
+#include "frame_budget.hpp"
+#include "renderer_host.hpp"
 
 #include <mbgl/actor/scheduler.hpp>
 #include <mbgl/gfx/backend_scope.hpp>
 #include <mbgl/gfx/renderer_backend.hpp>
 #include <mbgl/gfx/renderable.hpp>
+#include <mbgl/map/transform_state.hpp>
 #include <mbgl/renderer/renderer.hpp>
 #include <mbgl/renderer/renderer_observer.hpp>
 #include <mbgl/renderer/update_parameters.hpp>
@@ -17,10 +20,32 @@
 #include <jawt_md.h>
 #include <memory>
 #include <atomic>
+#include <chrono>
 
 namespace maplibre_jni
 {
 
+    namespace
+    {
+        bool cameraChanged(const mbgl::UpdateParameters &previous, const mbgl::UpdateParameters &next)
+        {
+            const auto &a = previous.transformState;
+            const auto &b = next.transformState;
+            return a.getLatLng() != b.getLatLng() || a.getZoom() != b.getZoom() ||
+                   a.getBearing() != b.getBearing() || a.getPitch() != b.getPitch() || a.getSize() != b.getSize();
+        }
+
+        // Whether the style, annotations or render settings changed. Updates where neither this nor
+        // the camera changed only bring in newly loaded tiles or continue a fade.
+        bool mapStateChanged(const mbgl::UpdateParameters &previous, const mbgl::UpdateParameters &next)
+        {
+            return previous.mode != next.mode || previous.pixelRatio != next.pixelRatio ||
+                   previous.debugOptions != next.debugOptions || previous.glyphURL != next.glyphURL ||
+                   previous.spriteLoaded != next.spriteLoaded || previous.light != next.light ||
+                   previous.images != next.images || previous.sources != next.sources || previous.layers != next.layers;
+        }
+    } // namespace
+
     // Implementation class that combines frontend and backend functionality
     class AwtCanvasRenderer::Impl : public mbgl::RendererObserver
     {
@@ -30,11 +55,15 @@ namespace maplibre_jni
              int width,
              int height,
              float pixelRatio,
-             const std::optional<std::string> &localFontFamily)
-            : runLoop(std::make_unique<mbgl::util::RunLoop>(mbgl::util::RunLoop::Type::New)),
+             const std::optional<std::string> &localFontFamily,
+             const std::optional<std::string> &shaderCachePath,
+             mbgl::gfx::ContextMode contextMode,
+             std::shared_ptr<mbgl::Scheduler> workerPool)
+            : host(RendererHost::forCurrentThread()),
               jvm(nullptr),
               canvasRef(nullptr),
-              dirty(false)
+              dirty(false),
+              size{static_cast<uint32_t>(width), static_cast<uint32_t>(height)}
         {
 
             // Get JavaVM for later thread attachment
@@ -44,7 +73,11 @@ namespace maplibre_jni
             canvasRef = env->NewGlobalRef(canvas);
 
             // Create platform-specific backend (Metal on macOS, OpenGL ES on Linux)
-            backend = createPlatformBackend(env, canvas, width, height, mbgl::gfx::ContextMode::Unique);
+            backend = createPlatformBackend(env, canvas, width, height, contextMode, shaderCachePath);
+            if (workerPool)
+            {
+                backend->setWorkerPool(std::move(workerPool));
+            }
 
             // Create the renderer with backend
             renderer = std::make_unique<mbgl::Renderer>(
@@ -63,7 +96,7 @@ namespace maplibre_jni
             // Clean up in reverse order
             renderer.reset();
             backend.reset();
-            runLoop.reset();
+            host.reset();
 
             // Release global references
             if (canvasRef && jvm)
@@ -79,11 +112,27 @@ namespace maplibre_jni
         bool tick()
         {
             // Process RunLoop events (network callbacks, timers, etc.)
-            runLoop->runOnce();
+            host->getRunLoop().runOnce();
+
+            // Frames that only bring in new tiles or continue a fade may wait while over budget
+            if (dirty && !urgentFrame && !budget.shouldRenderDeferrable())
+            {
+                return false;
+            }
 
             // Check if we need to render
             if (dirty.exchange(false))
             {
+                urgentFrame = false;
+                // Region hints only hold while the camera, size and render scale stay put
+                if (fullFrame)
+                {
+                    damage.markFull();
+                }
+                applyFrameDamage(damage.takeFrameDamage(size));
+                fullFrame = false;
+                const auto frameStart = std::chrono::steady_clock::now();
+
                 // Render the frame
                 mbgl::gfx::BackendScope scope(*backend);
                 if (updateParameters)
@@ -94,6 +143,15 @@ namespace maplibre_jni
                 // Swap buffers (platform-specific)
                 swapBuffers();
 
+                frameCount++;
+
+                const std::chrono::duration<double, std::milli> frameTime = std::chrono::steady_clock::now() - frameStart;
+                budget.addFrameTime(frameTime.count());
+                if (resolution.addFrameTime(frameTime.count()))
+                {
+                    applyRenderScale();
+                }
+
                 return true; // Did render
             }
 
@@ -102,13 +160,52 @@ namespace maplibre_jni
 
         void updateSize(int width, int height)
         {
+            const mbgl::Size newSize{static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+            if (newSize == size)
+            {
+                return;
+            }
+            size = newSize;
+
             // Update the backend size directly - no cast needed!
-            backend->setSize(mbgl::Size{static_cast<uint32_t>(width), static_cast<uint32_t>(height)});
+            backend->setSize(size);
 
             // Mark as dirty to trigger render
+            fullFrame = true;
+            urgentFrame = true;
             dirty = true;
         }
 
+        void setDynamicResolution(const DynamicResolutionController::Options &options)
+        {
+            resolution.setOptions(options);
+            applyRenderScale();
+        }
+
+        void setInteractionActive(bool active)
+        {
+            if (resolution.setInteractionActive(active))
+            {
+                applyRenderScale();
+            }
+        }
+
+        void addDamageRegion(const DamageRect &rect)
+        {
+            damage.addRegion(rect);
+            dirty = true;
+        }
+
+        void setFrameBudget(double targetFrameMs)
+        {
+            budget.setTargetFrameMs(targetFrameMs);
+        }
+
+        const FrameBudgetGovernor &getFrameBudget() const
+        {
+            return budget;
+        }
+
         void reset()
         {
             renderer.reset();
@@ -121,6 +218,25 @@ namespace maplibre_jni
 
         void update(std::shared_ptr<mbgl::UpdateParameters> parameters)
         {
+            // Region hints don't cover what a camera change moves
+            if (!updateParameters || cameraChanged(*updateParameters, *parameters))
+            {
+                fullFrame = true;
+                urgentFrame = true;
+                damage.markFull();
+            }
+            else if (mapStateChanged(*updateParameters, *parameters))
+            {
+                // The application change the pending hints were declared for, if there are any
+                urgentFrame = true;
+                damage.markUpdate();
+            }
+            else
+            {
+                // New tiles or a fade, which may touch any pixel
+                damage.markFull();
+            }
+
             // Store the update parameters for the next render
             updateParameters = std::move(parameters);
             // Mark dirty when map state changes
@@ -137,10 +253,21 @@ namespace maplibre_jni
             return backend.get();
         }
 
+        mbgl::Renderer *getRenderer()
+        {
+            return renderer.get();
+        }
+
+        uint64_t getFrameCount() const
+        {
+            return frameCount;
+        }
+
         // RendererObserver implementation
         void onInvalidate() override
         {
-            // Map needs to be redrawn
+            // Map needs to be redrawn; tile arrivals and the like come without region hints
+            damage.markFull();
             dirty = true;
 
             // Forward to external observer if set
@@ -162,6 +289,8 @@ namespace maplibre_jni
         {
             if (repaintNeeded)
             {
+                // Fades and transitions may touch any pixel
+                damage.markFull();
                 dirty = true;
             }
 
@@ -196,8 +325,33 @@ namespace maplibre_jni
             // The backend will handle this through its platform-specific implementation
         }
 
+        void applyFrameDamage(std::vector<DamageRect> frameDamage)
+        {
+#ifndef USE_METAL_BACKEND
+            backend->setFrameDamage(std::move(frameDamage));
+#else
+            (void)frameDamage;
+#endif
+        }
+
+        void applyRenderScale()
+        {
+#if defined(USE_EGL_BACKEND) || defined(USE_WGL_BACKEND) || defined(USE_GLX_BACKEND)
+            const float scale = resolution.getScale();
+            if (scale != backend->getRenderScale())
+            {
+                backend->setRenderScale(scale);
+                // Redraw at the new scale, so the end of an interaction snaps back to full resolution
+                fullFrame = true;
+                urgentFrame = true;
+                dirty = true;
+            }
+#endif
+        }
+
         // Core components
-        std::unique_ptr<mbgl::util::RunLoop> runLoop;
+        // Owns the RunLoop shared with the other maps on this thread
+        std::shared_ptr<RendererHost> host;
         std::unique_ptr<PlatformBackend> backend;
         std::unique_ptr<mbgl::Renderer> renderer;
 
@@ -207,6 +361,15 @@ namespace maplibre_jni
 
         // State
         std::atomic<bool> dirty;
+        mbgl::Size size;
+        DynamicResolutionController resolution;
+        FrameBudgetGovernor budget;
+        DamageTracker damage;
+        // Set when the camera, size or render scale changed since the last frame
+        bool fullFrame = false;
+        // Set when the pending frame shows more than new tiles or a fade, so the budget can't defer it
+        bool urgentFrame = false;
+        uint64_t frameCount = 0;
         std::shared_ptr<mbgl::UpdateParameters> updateParameters;
 
         // External observer (usually the Map)
@@ -225,11 +388,14 @@ namespace maplibre_jni
         int width,
         int height,
         float pixelRatio,
-        const std::optional<std::string> &localFontFamily)
+        const std::optional<std::string> &localFontFamily,
+        const std::optional<std::string> &shaderCachePath,
+        mbgl::gfx::ContextMode contextMode,
+        std::shared_ptr<mbgl::Scheduler> workerPool)
     {
 
         auto renderer = std::unique_ptr<AwtCanvasRenderer>(new AwtCanvasRenderer());
-        renderer->impl = std::make_unique<Impl>(env, canvas, width, height, pixelRatio, localFontFamily);
+        renderer->impl = std::make_unique<Impl>(env, canvas, width, height, pixelRatio, localFontFamily, shaderCachePath, contextMode, std::move(workerPool));
         return renderer;
     }
 
@@ -243,6 +409,31 @@ namespace maplibre_jni
         impl->updateSize(width, height);
     }
 
+    void AwtCanvasRenderer::setDynamicResolution(const DynamicResolutionController::Options &options)
+    {
+        impl->setDynamicResolution(options);
+    }
+
+    void AwtCanvasRenderer::setInteractionActive(bool active)
+    {
+        impl->setInteractionActive(active);
+    }
+
+    void AwtCanvasRenderer::addDamageRegion(const DamageRect &rect)
+    {
+        impl->addDamageRegion(rect);
+    }
+
+    void AwtCanvasRenderer::setFrameBudget(double targetFrameMs)
+    {
+        impl->setFrameBudget(targetFrameMs);
+    }
+
+    const FrameBudgetGovernor &AwtCanvasRenderer::getFrameBudget() const
+    {
+        return impl->getFrameBudget();
+    }
+
     void AwtCanvasRenderer::reset()
     {
         impl->reset();
@@ -268,6 +459,16 @@ namespace maplibre_jni
         return impl->getRendererBackend();
     }
 
+    mbgl::Renderer *AwtCanvasRenderer::getRenderer()
+    {
+        return impl->getRenderer();
+    }
+
+    uint64_t AwtCanvasRenderer::getFrameCount() const
+    {
+        return impl->getFrameCount();
+    }
+
 } // namespace maplibre_jni
 
 // JNI bindings
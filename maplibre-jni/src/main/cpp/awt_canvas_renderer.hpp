@@ -1,9 +1,13 @@
 #pragma once
 
 #include <jni.h>
+#include "damage_tracker.hpp"
+#include "dynamic_resolution.hpp"
+#include "frame_budget.hpp"
 #include <mbgl/renderer/renderer_frontend.hpp>
 #include <mbgl/renderer/renderer_observer.hpp>
 #include <mbgl/actor/scheduler.hpp>
+#include <mbgl/gfx/context_mode.hpp>
 #include <mbgl/util/run_loop.hpp>
 #include <memory>
 #include <atomic>
@@ -30,7 +34,13 @@ public:
         int width,
         int height,
         float pixelRatio,
-        const std::optional<std::string>& localFontFamily = std::nullopt
+        const std::optional<std::string>& localFontFamily = std::nullopt,
+        const std::optional<std::string>& shaderCachePath = std::nullopt,
+        // Shared lets maps on one thread render through a single GL context (EGL only); each
+        // map keeps its own renderer, programs and buffers within it
+        mbgl::gfx::ContextMode contextMode = mbgl::gfx::ContextMode::Unique,
+        // Pool tiles are parsed on; null uses mbgl's background pool
+        std::shared_ptr<mbgl::Scheduler> workerPool = nullptr
     );
     
     ~AwtCanvasRenderer() override;
@@ -41,6 +51,22 @@ public:
     
     // Update the size of the rendering surface
     void updateSize(int width, int height);
+
+    // Render at a reduced scale during interactions when frames are slow (OpenGL backends only)
+    void setDynamicResolution(const DynamicResolutionController::Options& options);
+
+    // Whether a gesture is in progress, which is when dynamic resolution applies
+    void setInteractionActive(bool active);
+
+    // Declare that the next style or annotation change only changes this region, so its frame is
+    // presented as a partial update where the platform supports it. Tile arrivals, fades and
+    // camera or size changes still present in full
+    void addDamageRegion(const DamageRect& rect);
+
+    // Target frame time; while over it, frames that only show new tiles or a fade wait a few
+    // ticks. 0 disables the budget
+    void setFrameBudget(double targetFrameMs);
+    const FrameBudgetGovernor& getFrameBudget() const;
     
     // RendererFrontend implementation
     void reset() override;
@@ -50,6 +76,12 @@ public:
     
     // Get the underlying renderer backend for Map creation
     mbgl::gfx::RendererBackend* getRendererBackend();
+
+    // Get the renderer for feature queries (null after reset)
+    mbgl::Renderer* getRenderer();
+
+    // Number of frames rendered so far, used to detect stale query results
+    uint64_t getFrameCount() const;
     
 protected:
     // Hide constructor to force use of factory method
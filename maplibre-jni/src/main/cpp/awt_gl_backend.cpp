@@ -1,8 +1,14 @@
 #include "awt_gl_backend.hpp"
 #include "gl_context_strategy.hpp"
+#include <mbgl/gfx/backend_scope.hpp>
+#include <mbgl/gfx/renderbuffer.hpp>
 #include <mbgl/gl/context.hpp>
+#include <mbgl/gl/framebuffer.hpp>
 #include <mbgl/gl/renderable_resource.hpp>
+#include <mbgl/platform/gl_functions.hpp>
 #include <mbgl/util/logging.hpp>
+#include <algorithm>
+#include <cmath>
 
 // Forward declaration
 namespace maplibre_jni
@@ -27,9 +33,42 @@ private:
 namespace maplibre_jni
 {
 
+    namespace
+    {
+        // Offscreen targets are allocated in steps so resizes and scale changes rarely reallocate
+        constexpr uint32_t SIZE_BUCKET = 128;
+
+        // Blit enums without pulling in GL headers
+        constexpr unsigned int FRAMEBUFFER_ENUM = 0x8D40;
+        constexpr unsigned int READ_FRAMEBUFFER_ENUM = 0x8CA8;
+        constexpr unsigned int DRAW_FRAMEBUFFER_ENUM = 0x8CA9;
+        constexpr unsigned int COLOR_BUFFER_BIT_ENUM = 0x4000;
+        constexpr unsigned int LINEAR_ENUM = 0x2601;
+
+        uint32_t roundUpToBucket(uint32_t value)
+        {
+            return (value + SIZE_BUCKET - 1) / SIZE_BUCKET * SIZE_BUCKET;
+        }
+    } // namespace
+
+    struct GLBackend::OffscreenTarget
+    {
+        OffscreenTarget(mbgl::gl::Context &context, mbgl::Size size)
+            : color(context.createRenderbuffer<mbgl::gfx::RenderbufferPixelType::RGBA>(size)),
+              depthStencil(context.createRenderbuffer<mbgl::gfx::RenderbufferPixelType::DepthStencil>(size)),
+              framebuffer(context.createFramebuffer(*color, *depthStencil))
+        {
+        }
+
+        mbgl::gfx::RenderbufferPtr<mbgl::gfx::RenderbufferPixelType::RGBA> color;
+        mbgl::gfx::RenderbufferPtr<mbgl::gfx::RenderbufferPixelType::DepthStencil> depthStencil;
+        mbgl::gl::Framebuffer framebuffer;
+    };
+
     GLBackend::GLBackend(JNIEnv *env, jobject canvas, int width, int height,
-                         std::unique_ptr<GLContextStrategy> strategy)
-        : mbgl::gl::RendererBackend(mbgl::gfx::ContextMode::Unique),
+                         std::unique_ptr<GLContextStrategy> strategy,
+                         mbgl::gfx::ContextMode contextMode)
+        : mbgl::gl::RendererBackend(contextMode),
           mbgl::gfx::Renderable(
               mbgl::Size{static_cast<uint32_t>(width), static_cast<uint32_t>(height)},
               std::make_unique<GLRenderableResource>(*this)),
@@ -43,6 +82,12 @@ namespace maplibre_jni
 
     GLBackend::~GLBackend()
     {
+        if (offscreen)
+        {
+            // GL objects must be deleted while the context is current
+            mbgl::gfx::BackendScope scope(*this);
+            offscreen.reset();
+        }
         contextStrategy->destroy();
 
         if (canvasRef)
@@ -63,9 +108,85 @@ namespace maplibre_jni
 
     void GLBackend::setSize(mbgl::Size newSize)
     {
-        // Update both our local size and the Renderable's size
+        // The Renderable's size is what frames are rendered at
         size = newSize;
-        this->mbgl::gfx::Renderable::size = newSize;
+        this->mbgl::gfx::Renderable::size = getRenderSize();
+    }
+
+    void GLBackend::setRenderScale(float scale)
+    {
+        renderScale = std::clamp(scale, 0.1f, 1.0f);
+        this->mbgl::gfx::Renderable::size = getRenderSize();
+    }
+
+    mbgl::Size GLBackend::getRenderSize() const
+    {
+        if (renderScale >= 1.0f)
+        {
+            return size;
+        }
+        return {std::max(1u, static_cast<uint32_t>(std::lround(size.width * renderScale))),
+                std::max(1u, static_cast<uint32_t>(std::lround(size.height * renderScale)))};
+    }
+
+    void GLBackend::bindRenderTarget()
+    {
+        renderedOffscreen = renderScale < 1.0f;
+        if (!renderedOffscreen)
+        {
+            setFramebufferBinding(0);
+            setViewport(0, 0, size);
+            return;
+        }
+
+        const mbgl::Size renderSize = getRenderSize();
+        if (!offscreen || offscreen->framebuffer.size.width < renderSize.width ||
+            offscreen->framebuffer.size.height < renderSize.height)
+        {
+            // Sized for the whole window so later scale steps reuse it
+            offscreen.reset();
+            offscreen = std::make_unique<OffscreenTarget>(
+                static_cast<mbgl::gl::Context &>(getContext()),
+                mbgl::Size{roundUpToBucket(size.width), roundUpToBucket(size.height)});
+        }
+
+        setFramebufferBinding(offscreen->framebuffer.framebuffer.get());
+        setViewport(0, 0, renderSize);
+    }
+
+    void GLBackend::present()
+    {
+        if (renderedOffscreen && offscreen)
+        {
+            using namespace mbgl::platform;
+            const mbgl::Size renderSize = getRenderSize();
+
+            // The blit is clipped by the scissor box like any other draw
+            setScissorTest(false);
+            MBGL_CHECK_ERROR(glBindFramebuffer(READ_FRAMEBUFFER_ENUM, offscreen->framebuffer.framebuffer.get()));
+            MBGL_CHECK_ERROR(glBindFramebuffer(DRAW_FRAMEBUFFER_ENUM, 0));
+            MBGL_CHECK_ERROR(glBlitFramebuffer(0, 0, renderSize.width, renderSize.height,
+                                               0, 0, size.width, size.height,
+                                               COLOR_BUFFER_BIT_ENUM, LINEAR_ENUM));
+            MBGL_CHECK_ERROR(glBindFramebuffer(FRAMEBUFFER_ENUM, 0));
+            assumeFramebufferBinding(0);
+        }
+
+        if (swapBehaviour == mbgl::gfx::Renderable::SwapBehaviour::Flush)
+        {
+            static_cast<mbgl::gl::Context &>(getContext()).finish();
+        }
+
+        // A scaled frame was blitted over the whole window
+        if (renderedOffscreen || frameDamage.empty())
+        {
+            swapBuffers();
+        }
+        else
+        {
+            contextStrategy->swapBuffersWithDamage(frameDamage, size.height);
+        }
+        frameDamage.clear();
     }
 
     void GLBackend::activate()
@@ -109,15 +230,10 @@ namespace maplibre_jni
 
 void GLRenderableResource::bind()
 {
-    backend.setFramebufferBinding(0);
-    backend.setViewport(0, 0, backend.getSize());
+    backend.bindRenderTarget();
 }
 
 void GLRenderableResource::swap()
 {
-    const auto& swapBehaviour = backend.getSwapBehavior();
-    if (swapBehaviour == mbgl::gfx::Renderable::SwapBehaviour::Flush) {
-        static_cast<mbgl::gl::Context&>(backend.getContext()).finish();
-    }
-    backend.swapBuffers();
+    backend.present();
 }
\ No newline at end of file
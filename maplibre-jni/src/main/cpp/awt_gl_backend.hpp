@@ -1,10 +1,12 @@
 #pragma once
 
+#include "damage_tracker.hpp"
 #include <mbgl/gl/renderer_backend.hpp>
 #include <mbgl/gfx/renderable.hpp>
 #include <mbgl/util/size.hpp>
 #include <jni.h>
 #include <memory>
+#include <vector>
 
 namespace maplibre_jni
 {
@@ -15,13 +17,35 @@ namespace maplibre_jni
     {
     public:
         GLBackend(JNIEnv *env, jobject canvas, int width, int height,
-                  std::unique_ptr<GLContextStrategy> strategy);
+                  std::unique_ptr<GLContextStrategy> strategy,
+                  mbgl::gfx::ContextMode contextMode = mbgl::gfx::ContextMode::Unique);
         ~GLBackend() override;
 
         mbgl::gfx::Renderable &getDefaultRenderable() override;
         void setSize(mbgl::Size size);
         mbgl::Size getSize() const { return size; }
 
+        // Parse tiles on this pool instead of mbgl's background pool
+        // Only takes effect for Renderers created afterwards
+        void setWorkerPool(std::shared_ptr<mbgl::Scheduler> pool)
+        {
+            threadPool = mbgl::TaggedScheduler(std::move(pool), mbgl::util::SimpleIdentity{});
+        }
+
+        // Fraction of the window size frames are rendered at; below 1 they are drawn into an
+        // offscreen framebuffer and scaled up to the window when presented
+        void setRenderScale(float scale);
+        float getRenderScale() const { return renderScale; }
+        mbgl::Size getRenderSize() const;
+
+        // Bind the framebuffer the next frame renders into
+        void bindRenderTarget();
+        // Copy an offscreen frame to the window and swap
+        void present();
+
+        // Regions the next present changes; empty presents the whole window
+        void setFrameDamage(std::vector<DamageRect> damage) { frameDamage = std::move(damage); }
+
     protected:
         void activate() override;
         void deactivate() override;
@@ -34,6 +58,8 @@ namespace maplibre_jni
         void setSwapBehavior(mbgl::gfx::Renderable::SwapBehaviour behaviour) { swapBehaviour = behaviour; }
 
     private:
+        struct OffscreenTarget;
+
         JNIEnv *getEnv();
 
         JavaVM *javaVM = nullptr;
@@ -41,6 +67,12 @@ namespace maplibre_jni
         mbgl::Size size;
         std::unique_ptr<GLContextStrategy> contextStrategy;
         mbgl::gfx::Renderable::SwapBehaviour swapBehaviour = mbgl::gfx::Renderable::SwapBehaviour::NoFlush;
+
+        float renderScale = 1.0f;
+        // Allocated on the first scaled frame and kept for later interactions
+        std::unique_ptr<OffscreenTarget> offscreen;
+        bool renderedOffscreen = false;
+        std::vector<DamageRect> frameDamage;
     };
 
 } // namespace maplibre_jni
\ No newline at end of file
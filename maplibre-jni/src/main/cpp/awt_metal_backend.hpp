@@ -6,6 +6,7 @@
 #include <mbgl/gfx/renderable.hpp>
 #include <mbgl/util/size.hpp>
 #include <jni.h>
+#include <memory>
 
 namespace maplibre_jni
 {
@@ -29,6 +30,12 @@ namespace maplibre_jni
         void setSize(mbgl::Size size);
         mbgl::Size getSize() const;
 
+        // Scheduler for tile workers; must be set before the Renderer is created
+        void setWorkerPool(std::shared_ptr<mbgl::Scheduler> pool)
+        {
+            threadPool = mbgl::TaggedScheduler(std::move(pool), mbgl::util::SimpleIdentity{});
+        }
+
     private:
         void setupMetalLayer(JNIEnv *env, jobject canvas);
         void releaseNativeWindow();
@@ -1,9 +1,14 @@
 #ifdef USE_VULKAN_BACKEND
 
 #include "awt_vulkan_backend.hpp"
+#include "vulkan_pipeline_cache.hpp"
+#include "vulkan_readback_ring.hpp"
+#include "vulkan_swapchain_hooks.hpp"
 #include <mbgl/vulkan/renderable_resource.hpp>
 #include <mbgl/vulkan/context.hpp>
 #include <mbgl/util/logging.hpp>
+#include <algorithm>
+#include <cstring>
 
 #include <jawt.h>
 #include <jawt_md.h>
@@ -105,17 +110,38 @@ public:
 
     std::vector<const char *> getDeviceExtensions() override
     {
-        return {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+        std::vector<const char *> extensions{VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+
+        // Extensions listed here are required when mbgl picks a device, so only ask for
+        // incremental present if every device has it
+        const auto &instance = backend.getInstance();
+        const auto devices = instance->enumeratePhysicalDevices(backend.getDispatcher());
+        incrementalPresent = !devices.empty() &&
+                             std::all_of(devices.begin(), devices.end(), [&](const vk::PhysicalDevice &device)
+                                         {
+                                             const auto properties = device.enumerateDeviceExtensionProperties(nullptr, backend.getDispatcher());
+                                             return std::any_of(properties.begin(), properties.end(), [](const vk::ExtensionProperties &extension)
+                                                                { return std::strcmp(extension.extensionName, VK_KHR_INCREMENTAL_PRESENT_EXTENSION_NAME) == 0; });
+                                         });
+        if (incrementalPresent)
+        {
+            extensions.push_back(VK_KHR_INCREMENTAL_PRESENT_EXTENSION_NAME);
+        }
+        return extensions;
     }
 
+    bool supportsIncrementalPresent() const { return incrementalPresent; }
+
 private:
     maplibre_jni::VulkanBackend &vulkanBackend;
+    bool incrementalPresent = false;
 };
 
 namespace maplibre_jni
 {
 
-    VulkanBackend::VulkanBackend(JNIEnv *env, jobject canvas, int width, int height)
+    VulkanBackend::VulkanBackend(JNIEnv *env, jobject canvas, int width, int height,
+                                 const std::optional<std::string> &shaderCachePath)
         : mbgl::vulkan::RendererBackend(mbgl::gfx::ContextMode::Unique),
           mbgl::vulkan::Renderable(
               mbgl::Size{static_cast<uint32_t>(width), static_cast<uint32_t>(height)},
@@ -130,10 +156,27 @@ namespace maplibre_jni
         setupVulkanSurface(env, canvas);
 #endif
         init();
+
+        if (shaderCachePath)
+        {
+            pipelineCache = std::make_unique<VulkanPipelineCache>(
+                *shaderCachePath + "/vulkan_pipelines.bin", getDeviceProperties(), getDevice().get(), dispatcher);
+            pipelineCache->install(dispatcher);
+        }
     }
 
     VulkanBackend::~VulkanBackend()
     {
+        // Hooks, staging buffers and the cache must go before the device the base class destroys
+        swapchainHooks.reset();
+        readback.reset();
+        if (pipelineCache)
+        {
+            pipelineCache->save();
+            pipelineCache->uninstall(dispatcher);
+            pipelineCache.reset();
+        }
+
 #ifdef __APPLE__
         cleanupMacOSLayer();
 #endif
@@ -155,19 +198,106 @@ namespace maplibre_jni
 
     void VulkanBackend::setSize(mbgl::Size newSize)
     {
-        // Update both our local size and the Renderable's size
-        size = newSize;
-        this->mbgl::vulkan::Renderable::size = newSize;
+        // Only remember the size; rebuilding the swapchain per resize event stalls live resizing
+        pendingSize = newSize;
+    }
+
+    void VulkanBackend::activate()
+    {
+        if (pendingSize)
+        {
+            const mbgl::Size newSize = *pendingSize;
+            pendingSize.reset();
+
+            if (newSize != size)
+            {
+                // Update both our local size and the Renderable's size
+                size = newSize;
+                this->mbgl::vulkan::Renderable::size = newSize;
 
 #ifdef __APPLE__
-        updateMacOSLayerSize(newSize);
+                updateMacOSLayerSize(newSize);
 #endif
 
+                requestSwapchainRebuild();
+            }
+        }
+
+        if (swapchainHooks)
+        {
+            swapchainHooks->waitForFrameSlot();
+        }
+    }
+
+    void VulkanBackend::setPresentOptions(std::optional<vk::PresentModeKHR> presentMode,
+                                          uint32_t maxFramesInFlight,
+                                          uint32_t imageCount)
+    {
+        auto &hooks = getSwapchainHooks();
+        hooks.setPresentMode(presentMode);
+        hooks.setMinImageCount(imageCount);
+        hooks.setMaxFramesInFlight(maxFramesInFlight);
+        requestSwapchainRebuild();
+    }
+
+    void VulkanBackend::setFrameDamage(std::vector<DamageRect> damage)
+    {
+        if (!getResource<VulkanRenderableResource>().supportsIncrementalPresent())
+        {
+            return;
+        }
+
+        auto &hooks = getSwapchainHooks();
+        hooks.setIncrementalPresent(true);
+        hooks.setPresentDamage(std::move(damage));
+    }
+
+    VulkanSwapchainHooks &VulkanBackend::getSwapchainHooks()
+    {
+        if (!swapchainHooks)
+        {
+            swapchainHooks = std::make_unique<VulkanSwapchainHooks>(
+                getPhysicalDevice(), getDevice().get(), getPresentQueue(), dispatcher);
+        }
+        return *swapchainHooks;
+    }
+
+    void VulkanBackend::requestSwapchainRebuild()
+    {
         if (context)
         {
-            auto &contextImpl = static_cast<mbgl::vulkan::Context &>(*context);
-            contextImpl.requestSurfaceUpdate();
+            static_cast<mbgl::vulkan::Context &>(*context).requestSurfaceUpdate();
+        }
+    }
+
+    void VulkanBackend::enableFrameReadback(uint32_t slotCount)
+    {
+        if (readback)
+        {
+            return;
         }
+
+        readback = std::make_unique<VulkanReadbackRing>(*this, slotCount);
+
+        auto &hooks = getSwapchainHooks();
+        hooks.setExtraImageUsage(vk::ImageUsageFlagBits::eTransferSrc);
+
+        // The copy is queued between rendering and present, reusing the present's wait semaphores
+        hooks.setPresentCallback(
+            [this](vk::Image image, vk::Format format, mbgl::Size imageSize, const std::vector<vk::Semaphore> &waits)
+            {
+                VulkanReadbackRing::Capture capture;
+                capture.image = image;
+                capture.format = format;
+                capture.size = imageSize;
+                capture.layout = vk::ImageLayout::ePresentSrcKHR;
+                capture.waitSemaphores = waits;
+                capture.signalSemaphore = true;
+                return readback->capture(capture);
+            });
+
+        // Existing swapchain images lack TRANSFER_SRC usage
+        requestSwapchainRebuild();
     }
 
     JNIEnv *VulkanBackend::getEnv()
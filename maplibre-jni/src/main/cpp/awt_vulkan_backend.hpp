@@ -2,27 +2,63 @@
 
 #ifdef USE_VULKAN_BACKEND
 
+#include "damage_tracker.hpp"
 #include <mbgl/vulkan/renderable_resource.hpp>
 #include <mbgl/vulkan/renderer_backend.hpp>
 #include <mbgl/util/size.hpp>
 #include <jni.h>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
 
 namespace maplibre_jni
 {
 
+    class VulkanPipelineCache;
+    class VulkanReadbackRing;
+    class VulkanSwapchainHooks;
+
     class VulkanBackend final : public mbgl::vulkan::RendererBackend,
                                 public mbgl::vulkan::Renderable
     {
     public:
-        VulkanBackend(JNIEnv *env, jobject canvas, int width, int height);
+        VulkanBackend(JNIEnv *env, jobject canvas, int width, int height,
+                      const std::optional<std::string> &shaderCachePath = std::nullopt);
         ~VulkanBackend() override;
 
         // mbgl::gfx::RendererBackend implementation
         mbgl::gfx::Renderable &getDefaultRenderable() override;
 
         // Size management
+        // The swapchain is rebuilt lazily when the next frame starts, so a burst of resize
+        // events costs one rebuild
         void setSize(mbgl::Size size);
 
+        // Scheduler for tile workers; must be set before the Renderer is created
+        void setWorkerPool(std::shared_ptr<mbgl::Scheduler> pool)
+        {
+            threadPool = mbgl::TaggedScheduler(std::move(pool), mbgl::util::SimpleIdentity{});
+        }
+
+        // Present mode (FIFO when unset), frames the CPU may queue ahead of the GPU (0 for
+        // mbgl's default) and swapchain image count hint (0 for mbgl's default)
+        // Applied with a swapchain rebuild on the next frame
+        void setPresentOptions(std::optional<vk::PresentModeKHR> presentMode,
+                               uint32_t maxFramesInFlight,
+                               uint32_t imageCount);
+
+        // Copy every presented frame into a ring of slotCount host-visible buffers
+        // The swapchain is rebuilt with TRANSFER_SRC usage on the next frame
+        void enableFrameReadback(uint32_t slotCount);
+
+        // Regions the next present changes; empty presents the whole window
+        // Only passed on when the device supports VK_KHR_incremental_present
+        void setFrameDamage(std::vector<DamageRect> damage);
+
+        // Null until enableFrameReadback has been called
+        VulkanReadbackRing *getReadback() { return readback.get(); }
+
         // Platform-specific getters for surface creation
         void *getNativeDisplay() const { return nativeDisplay; }
         void *getNativeWindow() const { return nativeWindow; }
@@ -38,7 +74,7 @@ namespace maplibre_jni
 
     protected:
         // mbgl::vulkan::RendererBackend overrides
-        void activate() override {}
+        void activate() override;
         void deactivate() override {}
         std::vector<const char *> getInstanceExtensions() override;
 
@@ -46,9 +82,20 @@ namespace maplibre_jni
         // JAWT window handle extraction
         void setupVulkanSurface(JNIEnv *env, jobject canvas);
         JNIEnv *getEnv();
+        VulkanSwapchainHooks &getSwapchainHooks();
+        void requestSwapchainRebuild();
 
         mbgl::Size size;
 
+        // Latest size from setSize, applied when the next frame starts
+        std::optional<mbgl::Size> pendingSize;
+
+        // Persisted across runs when a shader cache directory is configured
+        std::unique_ptr<VulkanPipelineCache> pipelineCache;
+
+        std::unique_ptr<VulkanSwapchainHooks> swapchainHooks;
+        std::unique_ptr<VulkanReadbackRing> readback;
+
         // Platform-specific native handles
         void *nativeDisplay = nullptr;
         void *nativeWindow = nullptr;
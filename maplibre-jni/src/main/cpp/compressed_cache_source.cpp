@@ -0,0 +1,705 @@
+#include "compressed_cache_source.hpp"
+#include "jni_helpers.hpp"
+#include <mbgl/actor/scheduler.hpp>
+#include <mbgl/util/async_request.hpp>
+#include <mbgl/util/logging.hpp>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#ifdef MAPLIBRE_JNI_WITH_ZSTD
+#include "mapped_file.hpp"
+#include <algorithm>
+#include <zdict.h>
+#include <zlib.h>
+#include <zstd.h>
+#endif
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        // Marks stored bodies as compressed; zstd frames follow it
+        constexpr char MARKER[] = {'M', 'L', 'Z', '1'};
+        constexpr size_t MARKER_SIZE = sizeof(MARKER);
+
+        bool startsWith(const std::string &data, std::string_view prefix)
+        {
+            return data.size() >= prefix.size() && std::memcmp(data.data(), prefix.data(), prefix.size()) == 0;
+        }
+
+        bool isCompressed(const std::string &data)
+        {
+            return startsWith(data, std::string_view(MARKER, MARKER_SIZE));
+        }
+
+#ifdef MAPLIBRE_JNI_WITH_ZSTD
+        // Smaller bodies gain nothing from compression
+        constexpr size_t MIN_COMPRESSED_SIZE = 64;
+
+        // Largest body inflated from gzip or decompressed from the cache
+        constexpr uint64_t MAX_BODY_SIZE = 256 * 1024 * 1024;
+
+        struct ZstdDeleter
+        {
+            void operator()(ZSTD_CCtx *context) const { ZSTD_freeCCtx(context); }
+            void operator()(ZSTD_DCtx *context) const { ZSTD_freeDCtx(context); }
+            void operator()(ZSTD_CDict *dictionary) const { ZSTD_freeCDict(dictionary); }
+            void operator()(ZSTD_DDict *dictionary) const { ZSTD_freeDDict(dictionary); }
+        };
+
+        // Contexts aren't thread-safe but are worth reusing, so each thread keeps its own
+        ZSTD_CCtx *compressionContext()
+        {
+            thread_local std::unique_ptr<ZSTD_CCtx, ZstdDeleter> context(ZSTD_createCCtx());
+            return context.get();
+        }
+
+        ZSTD_DCtx *decompressionContext()
+        {
+            thread_local std::unique_ptr<ZSTD_DCtx, ZstdDeleter> context(ZSTD_createDCtx());
+            return context.get();
+        }
+
+        bool isGzip(const std::string &data)
+        {
+            return startsWith(data, "\x1f\x8b");
+        }
+
+        // PNG, JPEG and WebP are compressed already
+        bool isImage(const std::string &data)
+        {
+            return startsWith(data, "\x89PNG") || startsWith(data, "\xff\xd8\xff") ||
+                   (startsWith(data, "RIFF") && data.size() >= 12 && data.compare(8, 4, "WEBP") == 0);
+        }
+
+        std::optional<std::string> gunzip(const std::string &data)
+        {
+            z_stream stream{};
+            // 16 added to the window bits: expect a gzip header
+            if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK)
+            {
+                return std::nullopt;
+            }
+
+            std::string result;
+            stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+            stream.avail_in = static_cast<uInt>(data.size());
+            int status = Z_OK;
+            while (status == Z_OK && result.size() < MAX_BODY_SIZE)
+            {
+                const size_t produced = result.size();
+                result.resize(std::max<size_t>(produced * 2, data.size() * 4));
+                stream.next_out = reinterpret_cast<Bytef *>(result.data() + produced);
+                stream.avail_out = static_cast<uInt>(result.size() - produced);
+                status = inflate(&stream, Z_NO_FLUSH);
+                result.resize(result.size() - stream.avail_out);
+            }
+            inflateEnd(&stream);
+
+            if (status != Z_STREAM_END)
+            {
+                return std::nullopt;
+            }
+            return result;
+        }
+#endif
+    } // namespace
+
+#ifdef MAPLIBRE_JNI_WITH_ZSTD
+
+    struct CompressedCacheSource::Codec
+    {
+        struct Entry
+        {
+            std::string urlPrefix;
+            unsigned id = 0;
+            std::unique_ptr<ZSTD_CDict, ZstdDeleter> compression;
+            std::unique_ptr<ZSTD_DDict, ZstdDeleter> decompression;
+        };
+
+        int level = 3;
+        // Longest prefix first, so the first match is the best one
+        std::vector<Entry> dictionaries;
+
+        const Entry *forURL(const std::string &url) const
+        {
+            auto it = std::find_if(dictionaries.begin(), dictionaries.end(), [&](const Entry &entry)
+                                   { return url.compare(0, entry.urlPrefix.size(), entry.urlPrefix) == 0; });
+            return it != dictionaries.end() ? &*it : nullptr;
+        }
+
+        const Entry *forId(unsigned id) const
+        {
+            auto it = std::find_if(dictionaries.begin(), dictionaries.end(), [&](const Entry &entry)
+                                   { return entry.id == id; });
+            return it != dictionaries.end() ? &*it : nullptr;
+        }
+
+        // Body to store for a resource, or nullopt to store the original
+        std::optional<std::string> compress(const std::string &url, const std::string &body) const
+        {
+            std::optional<std::string> inflated;
+            if (isGzip(body))
+            {
+                inflated = gunzip(body);
+                if (!inflated)
+                {
+                    return std::nullopt;
+                }
+            }
+            const std::string &input = inflated ? *inflated : body;
+
+            const size_t bound = ZSTD_compressBound(input.size());
+            std::string result(MARKER_SIZE + bound, '\0');
+            std::memcpy(result.data(), MARKER, MARKER_SIZE);
+            const Entry *dictionary = forURL(url);
+            const size_t size = dictionary
+                                    ? ZSTD_compress_usingCDict(compressionContext(), result.data() + MARKER_SIZE, bound,
+                                                               input.data(), input.size(), dictionary->compression.get())
+                                    : ZSTD_compressCCtx(compressionContext(), result.data() + MARKER_SIZE, bound,
+                                                        input.data(), input.size(), level);
+            if (ZSTD_isError(size) || MARKER_SIZE + size >= body.size())
+            {
+                return std::nullopt;
+            }
+            result.resize(MARKER_SIZE + size);
+            return result;
+        }
+
+        // Original body of a stored one, or nullopt if it can't be decompressed, e.g. because
+        // its dictionary is gone
+        std::optional<std::string> decompress(const std::string &stored) const
+        {
+            const char *frame = stored.data() + MARKER_SIZE;
+            const size_t frameSize = stored.size() - MARKER_SIZE;
+
+            const Entry *dictionary = nullptr;
+            if (const unsigned id = ZSTD_getDictID_fromFrame(frame, frameSize))
+            {
+                dictionary = forId(id);
+                if (!dictionary)
+                {
+                    return std::nullopt;
+                }
+            }
+
+            const unsigned long long contentSize = ZSTD_getFrameContentSize(frame, frameSize);
+            if (contentSize == ZSTD_CONTENTSIZE_UNKNOWN || contentSize == ZSTD_CONTENTSIZE_ERROR || contentSize > MAX_BODY_SIZE)
+            {
+                return std::nullopt;
+            }
+
+            std::string result(static_cast<size_t>(contentSize), '\0');
+            const size_t size = dictionary
+                                    ? ZSTD_decompress_usingDDict(decompressionContext(), result.data(), result.size(),
+                                                                 frame, frameSize, dictionary->decompression.get())
+                                    : ZSTD_decompressDCtx(decompressionContext(), result.data(), result.size(), frame, frameSize);
+            if (ZSTD_isError(size) || size != result.size())
+            {
+                return std::nullopt;
+            }
+            return result;
+        }
+
+        // Whether a response is worth compressing. Style and TileJSON documents stay as they
+        // are: mbgl's offline downloader reads them straight from the database and parses them.
+        bool accepts(const mbgl::Resource &resource, const mbgl::Response &response) const
+        {
+            if (resource.kind != mbgl::Resource::Kind::Tile && resource.kind != mbgl::Resource::Kind::Glyphs &&
+                resource.kind != mbgl::Resource::Kind::SpriteJSON)
+            {
+                return false;
+            }
+            return response.data && !response.error && !response.notModified &&
+                   response.data->size() >= MIN_COMPRESSED_SIZE && !isImage(*response.data);
+        }
+
+        // Response to forward to the database in place of the given one
+        mbgl::Response stored(const mbgl::Resource &resource, const mbgl::Response &response) const
+        {
+            auto body = compress(resource.url, *response.data);
+            if (!body)
+            {
+                return response;
+            }
+            mbgl::Response result = response;
+            result.data = std::make_shared<const std::string>(std::move(*body));
+            return result;
+        }
+    };
+
+#else
+
+    // Without zstd nothing is compressed, and bodies compressed by a build with it can't be read
+    struct CompressedCacheSource::Codec
+    {
+        bool accepts(const mbgl::Resource &, const mbgl::Response &) const
+        {
+            return false;
+        }
+
+        std::optional<std::string> decompress(const std::string &) const
+        {
+            return std::nullopt;
+        }
+
+        mbgl::Response stored(const mbgl::Resource &, const mbgl::Response &response) const
+        {
+            return response;
+        }
+    };
+
+#endif // MAPLIBRE_JNI_WITH_ZSTD
+
+    struct CompressedCacheSource::Task
+    {
+        Callback callback;
+        mbgl::Scheduler *scheduler = nullptr;
+        std::unique_ptr<mbgl::AsyncRequest> upstreamRequest;
+    };
+
+    // Handed to the requester; dropping it cancels the database request and drops the
+    // response if it is still being decompressed
+    class CompressedCacheSource::Request final : public mbgl::AsyncRequest
+    {
+    public:
+        explicit Request(std::shared_ptr<Task> task_)
+            : task(std::move(task_))
+        {
+        }
+
+    private:
+        std::shared_ptr<Task> task;
+    };
+
+    // Forwards to the database one at a time, in the order they were made, so an update
+    // of a resource never overtakes the write it updates. Compression runs on mbgl's
+    // background scheduler; a forward with a completion callback goes to the database from
+    // the thread that made it, since the database binds callbacks to that thread's RunLoop,
+    // and the forwards after it wait until it is in.
+    struct CompressedCacheSource::Writes : std::enable_shared_from_this<Writes>
+    {
+        struct Job
+        {
+            mbgl::Resource resource;
+            mbgl::Response response;
+            std::function<void()> callback;
+            mbgl::Scheduler *scheduler = nullptr;
+        };
+
+        Writes(std::shared_ptr<mbgl::FileSource> upstream_, std::shared_ptr<const Codec> codec_)
+            : upstream(std::move(upstream_)),
+              codec(std::move(codec_))
+        {
+        }
+
+        void push(Job job)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                jobs.push_back(std::move(job));
+                if (draining)
+                {
+                    return;
+                }
+                draining = true;
+            }
+            scheduleDrain();
+        }
+
+        void scheduleDrain()
+        {
+            mbgl::Scheduler::GetBackground()->schedule([self = shared_from_this()]
+                                                       { self->drain(); });
+        }
+
+        void drain()
+        {
+            while (true)
+            {
+                std::optional<Job> next;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (closed || jobs.empty())
+                    {
+                        draining = false;
+                        return;
+                    }
+                    next.emplace(std::move(jobs.front()));
+                    jobs.pop_front();
+                    working = true;
+                }
+                Job &job = *next;
+
+                if (codec->accepts(job.resource, job.response))
+                {
+                    job.response = codec->stored(job.resource, job.response);
+                }
+
+                if (job.callback && job.scheduler)
+                {
+                    auto *scheduler = job.scheduler;
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        parked = std::move(job);
+                        working = false;
+                    }
+                    idle.notify_all();
+                    scheduler->schedule([self = shared_from_this()]
+                                        { self->resumeParked(); });
+                    return;
+                }
+
+                upstream->forward(job.resource, job.response, std::move(job.callback));
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    working = false;
+                }
+                idle.notify_all();
+            }
+        }
+
+        // Runs on the thread that made the parked forward
+        void resumeParked()
+        {
+            std::optional<Job> job;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!parked)
+                {
+                    return;
+                }
+                job = std::move(parked);
+                parked.reset();
+            }
+
+            upstream->forward(job->resource, job->response, std::move(job->callback));
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (closed || jobs.empty())
+                {
+                    draining = false;
+                    return;
+                }
+            }
+            scheduleDrain();
+        }
+
+        // Hands what is still queued to the database in order, without completion callbacks
+        // since their requesters are going away with the source
+        void close()
+        {
+            std::optional<Job> first;
+            std::deque<Job> rest;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                idle.wait(lock, [this]
+                          { return !working; });
+                closed = true;
+                first = std::move(parked);
+                parked.reset();
+                rest.swap(jobs);
+            }
+
+            if (first)
+            {
+                upstream->forward(first->resource, first->response, {});
+            }
+            for (auto &job : rest)
+            {
+                if (codec->accepts(job.resource, job.response))
+                {
+                    job.response = codec->stored(job.resource, job.response);
+                }
+                upstream->forward(job.resource, job.response, {});
+            }
+        }
+
+        const std::shared_ptr<mbgl::FileSource> upstream;
+        const std::shared_ptr<const Codec> codec;
+
+        std::mutex mutex;
+        std::condition_variable idle;
+        std::deque<Job> jobs;
+        // Compressed forward waiting for its own thread to hand it to the database
+        std::optional<Job> parked;
+        // A drain is scheduled, running or waiting on the parked forward
+        bool draining = false;
+        // A job is being compressed or forwarded on the background scheduler
+        bool working = false;
+        bool closed = false;
+    };
+
+    CompressedCacheSource::CompressedCacheSource(std::unique_ptr<mbgl::FileSource> upstream_, const std::optional<Options> &options)
+        : upstream(std::move(upstream_))
+    {
+        auto result = std::make_shared<Codec>();
+#ifdef MAPLIBRE_JNI_WITH_ZSTD
+        if (options)
+        {
+            result->level = std::clamp(options->level, 1, ZSTD_maxCLevel());
+            for (const auto &dictionary : options->dictionaries)
+            {
+                try
+                {
+                    auto file = MappedFile::open(dictionary.path);
+                    Codec::Entry entry;
+                    entry.urlPrefix = dictionary.urlPrefix;
+                    entry.id = ZDICT_getDictID(file->data(), file->size());
+                    if (entry.id == 0)
+                    {
+                        throw std::runtime_error("not a zstd dictionary");
+                    }
+                    entry.compression.reset(ZSTD_createCDict(file->data(), file->size(), result->level));
+                    entry.decompression.reset(ZSTD_createDDict(file->data(), file->size()));
+                    if (!entry.compression || !entry.decompression)
+                    {
+                        throw std::runtime_error("could not load it");
+                    }
+                    result->dictionaries.push_back(std::move(entry));
+                }
+                catch (const std::exception &e)
+                {
+                    mbgl::Log::Error(mbgl::Event::Database, "Skipping cache dictionary " + dictionary.path + ": " + e.what());
+                }
+            }
+            std::stable_sort(result->dictionaries.begin(), result->dictionaries.end(), [](const auto &a, const auto &b)
+                             { return a.urlPrefix.size() > b.urlPrefix.size(); });
+        }
+#else
+        if (options)
+        {
+            mbgl::Log::Warning(mbgl::Event::Database,
+                               "Cache compression requires a build with MAPLIBRE_JNI_WITH_ZSTD; storing uncompressed");
+        }
+#endif
+        codec = std::move(result);
+        if (options && isSupported())
+        {
+            writes = std::make_shared<Writes>(upstream, codec);
+        }
+    }
+
+    CompressedCacheSource::~CompressedCacheSource()
+    {
+        if (writes)
+        {
+            writes->close();
+        }
+    }
+
+    std::unique_ptr<mbgl::AsyncRequest> CompressedCacheSource::request(const mbgl::Resource &resource, Callback callback)
+    {
+        auto task = std::make_shared<Task>();
+        task->callback = std::move(callback);
+        task->scheduler = mbgl::Scheduler::GetCurrent();
+        std::weak_ptr<Task> weak = task;
+
+        task->upstreamRequest = upstream->request(resource, [weak, codec = codec](mbgl::Response response)
+                                                  {
+            auto task = weak.lock();
+            if (!task)
+            {
+                return;
+            }
+            if (!response.data || !isCompressed(*response.data))
+            {
+                task->callback(response);
+                return;
+            }
+
+            mbgl::Scheduler::GetBackground()->schedule([weak, codec, scheduler = task->scheduler, response]() mutable
+                                                       {
+                if (weak.expired())
+                {
+                    return;
+                }
+                if (auto body = codec->decompress(*response.data))
+                {
+                    response.data = std::make_shared<const std::string>(std::move(*body));
+                }
+                else
+                {
+                    // Undecodable entries count as missing, so the resource is fetched again
+                    response = mbgl::Response();
+                    response.error = std::make_unique<mbgl::Response::Error>(
+                        mbgl::Response::Error::Reason::NotFound, "Not found in offline database");
+                }
+
+                auto deliver = [weak, response = std::move(response)]
+                {
+                    if (auto task = weak.lock())
+                    {
+                        task->callback(response);
+                    }
+                };
+                if (scheduler)
+                {
+                    scheduler->schedule(std::move(deliver));
+                }
+                else
+                {
+                    deliver();
+                } }); });
+
+        return std::make_unique<Request>(std::move(task));
+    }
+
+    void CompressedCacheSource::forward(const mbgl::Resource &resource, const mbgl::Response &response, std::function<void()> callback)
+    {
+        if (!writes)
+        {
+            upstream->forward(resource, response, std::move(callback));
+            return;
+        }
+        writes->push({resource, response, std::move(callback), mbgl::Scheduler::GetCurrent()});
+    }
+
+    bool CompressedCacheSource::canRequest(const mbgl::Resource &resource) const
+    {
+        return upstream->canRequest(resource);
+    }
+
+    bool CompressedCacheSource::supportsCacheOnlyRequests() const
+    {
+        return upstream->supportsCacheOnlyRequests();
+    }
+
+    void CompressedCacheSource::pause()
+    {
+        upstream->pause();
+    }
+
+    void CompressedCacheSource::resume()
+    {
+        upstream->resume();
+    }
+
+    void CompressedCacheSource::setProperty(const std::string &key, const mapbox::base::Value &value)
+    {
+        upstream->setProperty(key, value);
+    }
+
+    mapbox::base::Value CompressedCacheSource::getProperty(const std::string &key) const
+    {
+        return upstream->getProperty(key);
+    }
+
+    void CompressedCacheSource::setResourceTransform(mbgl::ResourceTransform transform)
+    {
+        upstream->setResourceTransform(std::move(transform));
+    }
+
+    void CompressedCacheSource::setResourceOptions(mbgl::ResourceOptions options)
+    {
+        upstream->setResourceOptions(std::move(options));
+    }
+
+    mbgl::ResourceOptions CompressedCacheSource::getResourceOptions()
+    {
+        return upstream->getResourceOptions();
+    }
+
+    void CompressedCacheSource::setClientOptions(mbgl::ClientOptions options)
+    {
+        upstream->setClientOptions(std::move(options));
+    }
+
+    mbgl::ClientOptions CompressedCacheSource::getClientOptions()
+    {
+        return upstream->getClientOptions();
+    }
+
+    bool CompressedCacheSource::isSupported()
+    {
+#ifdef MAPLIBRE_JNI_WITH_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    std::string CompressedCacheSource::trainDictionary(const std::vector<std::string> &samples, size_t capacity)
+    {
+#ifdef MAPLIBRE_JNI_WITH_ZSTD
+        std::string joined;
+        std::vector<size_t> sizes;
+        sizes.reserve(samples.size());
+        for (const auto &sample : samples)
+        {
+            // Train on what will be compressed, which for gzipped bodies is the inflated data
+            auto inflated = isGzip(sample) ? gunzip(sample) : std::nullopt;
+            const std::string &body = inflated ? *inflated : sample;
+            joined += body;
+            sizes.push_back(body.size());
+        }
+
+        std::string dictionary(capacity, '\0');
+        const size_t size = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(), joined.data(), sizes.data(),
+                                                  static_cast<unsigned>(sizes.size()));
+        if (ZDICT_isError(size))
+        {
+            throw std::runtime_error(std::string("Could not train dictionary: ") + ZDICT_getErrorName(size));
+        }
+        dictionary.resize(size);
+        return dictionary;
+#else
+        throw std::runtime_error("Cache compression requires a build with MAPLIBRE_JNI_WITH_ZSTD");
+#endif
+    }
+
+} // namespace maplibre_jni
+
+// JNI bindings
+extern "C"
+{
+
+    JNIEXPORT jboolean JNICALL Java_org_maplibre_kmp_native_CacheCompressionOptions_nativeIsSupported(JNIEnv *env, jclass)
+    {
+        return maplibre_jni::CompressedCacheSource::isSupported() ? JNI_TRUE : JNI_FALSE;
+    }
+
+    JNIEXPORT jbyteArray JNICALL Java_org_maplibre_kmp_native_CacheCompressionOptions_nativeTrainDictionary(JNIEnv *env, jclass, jobjectArray samples, jint capacity)
+    {
+        if (!maplibre_jni::CompressedCacheSource::isSupported())
+        {
+            throwJavaException(env, "java/lang/UnsupportedOperationException",
+                               "Cache compression requires a build with MAPLIBRE_JNI_WITH_ZSTD");
+            return nullptr;
+        }
+
+        try
+        {
+            std::vector<std::string> bodies;
+            const jsize count = env->GetArrayLength(samples);
+            bodies.reserve(static_cast<size_t>(count));
+            for (jsize i = 0; i < count; i++)
+            {
+                auto sample = static_cast<jbyteArray>(env->GetObjectArrayElement(samples, i));
+                std::string body(static_cast<size_t>(env->GetArrayLength(sample)), '\0');
+                env->GetByteArrayRegion(sample, 0, static_cast<jsize>(body.size()), reinterpret_cast<jbyte *>(body.data()));
+                env->DeleteLocalRef(sample);
+                bodies.push_back(std::move(body));
+            }
+
+            const std::string dictionary = maplibre_jni::CompressedCacheSource::trainDictionary(bodies, static_cast<size_t>(capacity));
+            jbyteArray result = env->NewByteArray(static_cast<jsize>(dictionary.size()));
+            env->SetByteArrayRegion(result, 0, static_cast<jsize>(dictionary.size()), reinterpret_cast<const jbyte *>(dictionary.data()));
+            return result;
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+            return nullptr;
+        }
+    }
+
+} // extern "C"
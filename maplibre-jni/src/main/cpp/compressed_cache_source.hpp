@@ -0,0 +1,99 @@
+#pragma once
+
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/resource.hpp>
+#include <mbgl/storage/response.hpp>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace maplibre_jni
+{
+
+    // FileSource wrapper that stores ambient cache entries compressed with zstd
+    //
+    // Every map's database is wrapped, since maps share a cache file whatever their options.
+    // Bodies read back behind a short marker are decompressed on mbgl's background scheduler
+    // and delivered on the requesting thread; bodies without it, cached uncompressed or by
+    // an offline download, pass through as they are. Marked bodies that can't be decoded,
+    // because their dictionary isn't loaded or this build lacks zstd, read as missing, so the
+    // resource is fetched again.
+    //
+    // With options, tile, glyph and sprite index bodies forwarded to the database are
+    // compressed, with the dictionary of the longest URL prefix matching the resource if
+    // there is one. Gzipped bodies are stored inflated, which mbgl reads just as well, since
+    // zstd can't shrink them otherwise; images, and the style and TileJSON documents mbgl's
+    // offline downloader parses straight from the database, are stored as they are. All
+    // forwards then go to the database in order, so a 304 refresh never lands before the
+    // write it refreshes.
+    class CompressedCacheSource final : public mbgl::FileSource
+    {
+    public:
+        struct Dictionary
+        {
+            // Resources whose URL starts with this use the dictionary
+            std::string urlPrefix;
+            // Dictionary file made by trainDictionary()
+            std::string path;
+
+            bool operator==(const Dictionary &other) const
+            {
+                return urlPrefix == other.urlPrefix && path == other.path;
+            }
+        };
+
+        struct Options
+        {
+            // zstd compression level, 1 (fastest) to 19
+            int level = 3;
+            std::vector<Dictionary> dictionaries;
+
+            bool operator==(const Options &other) const
+            {
+                return level == other.level && dictionaries == other.dictionaries;
+            }
+        };
+
+        // Whether this build includes zstd
+        static bool isSupported();
+
+        // Dictionary of at most capacity bytes trained on sample bodies of one source. Throws
+        // std::runtime_error if training fails, e.g. for too few samples.
+        static std::string trainDictionary(const std::vector<std::string> &samples, size_t capacity);
+
+        // Without options the source only decodes. Dictionaries that can't be loaded are
+        // logged and left out.
+        CompressedCacheSource(std::unique_ptr<mbgl::FileSource> upstream, const std::optional<Options> &options);
+        ~CompressedCacheSource() override;
+
+        std::unique_ptr<mbgl::AsyncRequest> request(const mbgl::Resource &resource, Callback callback) override;
+
+        void forward(const mbgl::Resource &resource, const mbgl::Response &response, std::function<void()> callback) override;
+        bool canRequest(const mbgl::Resource &resource) const override;
+        bool supportsCacheOnlyRequests() const override;
+        void pause() override;
+        void resume() override;
+        void setProperty(const std::string &key, const mapbox::base::Value &value) override;
+        mapbox::base::Value getProperty(const std::string &key) const override;
+        void setResourceTransform(mbgl::ResourceTransform transform) override;
+        void setResourceOptions(mbgl::ResourceOptions options) override;
+        mbgl::ResourceOptions getResourceOptions() override;
+        void setClientOptions(mbgl::ClientOptions options) override;
+        mbgl::ClientOptions getClientOptions() override;
+
+    private:
+        // Compression level and dictionaries, shared with jobs on the background scheduler
+        struct Codec;
+        struct Task;
+        class Request;
+        // Ordered queue of forwards, when compressing
+        struct Writes;
+
+        std::shared_ptr<mbgl::FileSource> upstream;
+        std::shared_ptr<const Codec> codec;
+        std::shared_ptr<Writes> writes;
+    };
+
+} // namespace maplibre_jni
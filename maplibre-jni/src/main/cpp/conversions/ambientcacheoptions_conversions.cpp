@@ -0,0 +1,119 @@
+#include "ambientcacheoptions_conversions.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace maplibre_jni
+{
+
+    // Static member definitions
+    jclass AmbientCacheOptionsConversions::ambientCacheOptionsClass = nullptr;
+    jfieldID AmbientCacheOptionsConversions::writeBehindField = nullptr;
+    jfieldID AmbientCacheOptionsConversions::flushIntervalMsField = nullptr;
+    jfieldID AmbientCacheOptionsConversions::maxPendingBytesField = nullptr;
+    jfieldID AmbientCacheOptionsConversions::walModeField = nullptr;
+    jfieldID AmbientCacheOptionsConversions::pageSizeField = nullptr;
+    jfieldID AmbientCacheOptionsConversions::cacheSizeKbField = nullptr;
+    bool AmbientCacheOptionsConversions::initialized = false;
+
+    void AmbientCacheOptionsConversions::init(JNIEnv *env)
+    {
+        if (initialized)
+            return;
+
+        // Find the AmbientCacheOptions class
+        jclass localClass = env->FindClass("org/maplibre/kmp/native/AmbientCacheOptions");
+        if (!localClass)
+        {
+            throw std::runtime_error("Could not find AmbientCacheOptions class");
+        }
+
+        // Create global reference
+        ambientCacheOptionsClass = (jclass)env->NewGlobalRef(localClass);
+        env->DeleteLocalRef(localClass);
+
+        // Cache field IDs
+        writeBehindField = env->GetFieldID(ambientCacheOptionsClass, "writeBehind", "Z");
+        if (!writeBehindField)
+        {
+            throw std::runtime_error("Could not find writeBehind field");
+        }
+
+        flushIntervalMsField = env->GetFieldID(ambientCacheOptionsClass, "flushIntervalMs", "J");
+        if (!flushIntervalMsField)
+        {
+            throw std::runtime_error("Could not find flushIntervalMs field");
+        }
+
+        maxPendingBytesField = env->GetFieldID(ambientCacheOptionsClass, "maxPendingBytes", "J");
+        if (!maxPendingBytesField)
+        {
+            throw std::runtime_error("Could not find maxPendingBytes field");
+        }
+
+        walModeField = env->GetFieldID(ambientCacheOptionsClass, "walMode", "Z");
+        if (!walModeField)
+        {
+            throw std::runtime_error("Could not find walMode field");
+        }
+
+        pageSizeField = env->GetFieldID(ambientCacheOptionsClass, "pageSize", "I");
+        if (!pageSizeField)
+        {
+            throw std::runtime_error("Could not find pageSize field");
+        }
+
+        cacheSizeKbField = env->GetFieldID(ambientCacheOptionsClass, "cacheSizeKb", "I");
+        if (!cacheSizeKbField)
+        {
+            throw std::runtime_error("Could not find cacheSizeKb field");
+        }
+
+        initialized = true;
+    }
+
+    void AmbientCacheOptionsConversions::destroy(JNIEnv *env)
+    {
+        if (!initialized)
+            return;
+
+        if (ambientCacheOptionsClass)
+        {
+            env->DeleteGlobalRef(ambientCacheOptionsClass);
+            ambientCacheOptionsClass = nullptr;
+        }
+
+        writeBehindField = nullptr;
+        flushIntervalMsField = nullptr;
+        maxPendingBytesField = nullptr;
+        walModeField = nullptr;
+        pageSizeField = nullptr;
+        cacheSizeKbField = nullptr;
+        initialized = false;
+    }
+
+    WriteBehindCacheSource::Options AmbientCacheOptionsConversions::extract(JNIEnv *env, jobject ambientCacheOptions)
+    {
+        if (!initialized)
+        {
+            init(env);
+        }
+
+        if (!ambientCacheOptions)
+        {
+            throw std::invalid_argument("AmbientCacheOptions object is null");
+        }
+
+        WriteBehindCacheSource::Options options;
+        options.writeBehind = env->GetBooleanField(ambientCacheOptions, writeBehindField) == JNI_TRUE;
+        options.flushInterval = std::chrono::milliseconds(
+            std::max<jlong>(0, env->GetLongField(ambientCacheOptions, flushIntervalMsField)));
+        options.maxPendingBytes = static_cast<uint64_t>(
+            std::max<jlong>(0, env->GetLongField(ambientCacheOptions, maxPendingBytesField)));
+        options.wal = env->GetBooleanField(ambientCacheOptions, walModeField) == JNI_TRUE;
+        options.pageSize = static_cast<uint32_t>(std::max<jint>(0, env->GetIntField(ambientCacheOptions, pageSizeField)));
+        options.cacheSizeKiB = static_cast<uint32_t>(std::max<jint>(0, env->GetIntField(ambientCacheOptions, cacheSizeKbField)));
+
+        return options;
+    }
+
+} // namespace maplibre_jni
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "write_behind_cache_source.hpp"
+#include <jni.h>
+
+namespace maplibre_jni {
+
+class AmbientCacheOptionsConversions {
+public:
+    static void init(JNIEnv* env);
+    static void destroy(JNIEnv* env);
+    
+    // Extract WriteBehindCacheSource::Options from Java AmbientCacheOptions object
+    static WriteBehindCacheSource::Options extract(JNIEnv* env, jobject ambientCacheOptions);
+    
+private:
+    static jclass ambientCacheOptionsClass;
+    static jfieldID writeBehindField;
+    static jfieldID flushIntervalMsField;
+    static jfieldID maxPendingBytesField;
+    static jfieldID walModeField;
+    static jfieldID pageSizeField;
+    static jfieldID cacheSizeKbField;
+    static bool initialized;
+};
+
+} // namespace maplibre_jni
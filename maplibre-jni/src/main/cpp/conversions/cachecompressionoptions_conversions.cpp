@@ -0,0 +1,153 @@
+#include "cachecompressionoptions_conversions.hpp"
+#include "jni_helpers.hpp"
+#include <stdexcept>
+
+namespace maplibre_jni
+{
+
+    // Static member definitions
+    jclass CacheCompressionOptionsConversions::cacheCompressionOptionsClass = nullptr;
+    jfieldID CacheCompressionOptionsConversions::levelField = nullptr;
+    jfieldID CacheCompressionOptionsConversions::dictionariesField = nullptr;
+    jclass CacheCompressionOptionsConversions::dictionaryClass = nullptr;
+    jfieldID CacheCompressionOptionsConversions::urlPrefixField = nullptr;
+    jfieldID CacheCompressionOptionsConversions::pathField = nullptr;
+    jmethodID CacheCompressionOptionsConversions::listSizeMethod = nullptr;
+    jmethodID CacheCompressionOptionsConversions::listGetMethod = nullptr;
+    bool CacheCompressionOptionsConversions::initialized = false;
+
+    void CacheCompressionOptionsConversions::init(JNIEnv *env)
+    {
+        if (initialized)
+            return;
+
+        // Find the CacheCompressionOptions class
+        jclass localClass = env->FindClass("org/maplibre/kmp/native/CacheCompressionOptions");
+        if (!localClass)
+        {
+            throw std::runtime_error("Could not find CacheCompressionOptions class");
+        }
+
+        // Create global reference
+        cacheCompressionOptionsClass = (jclass)env->NewGlobalRef(localClass);
+        env->DeleteLocalRef(localClass);
+
+        // Cache field IDs
+        levelField = env->GetFieldID(cacheCompressionOptionsClass, "level", "I");
+        if (!levelField)
+        {
+            throw std::runtime_error("Could not find level field");
+        }
+
+        dictionariesField = env->GetFieldID(cacheCompressionOptionsClass, "dictionaries", "Ljava/util/List;");
+        if (!dictionariesField)
+        {
+            throw std::runtime_error("Could not find dictionaries field");
+        }
+
+        // Find the nested Dictionary class
+        localClass = env->FindClass("org/maplibre/kmp/native/CacheCompressionOptions$Dictionary");
+        if (!localClass)
+        {
+            throw std::runtime_error("Could not find CacheCompressionOptions.Dictionary class");
+        }
+        dictionaryClass = (jclass)env->NewGlobalRef(localClass);
+        env->DeleteLocalRef(localClass);
+
+        urlPrefixField = env->GetFieldID(dictionaryClass, "urlPrefix", "Ljava/lang/String;");
+        if (!urlPrefixField)
+        {
+            throw std::runtime_error("Could not find urlPrefix field");
+        }
+
+        pathField = env->GetFieldID(dictionaryClass, "path", "Ljava/lang/String;");
+        if (!pathField)
+        {
+            throw std::runtime_error("Could not find path field");
+        }
+
+        // Cache List accessors
+        jclass listClass = env->FindClass("java/util/List");
+        if (!listClass)
+        {
+            throw std::runtime_error("Could not find List class");
+        }
+        listSizeMethod = env->GetMethodID(listClass, "size", "()I");
+        listGetMethod = env->GetMethodID(listClass, "get", "(I)Ljava/lang/Object;");
+        env->DeleteLocalRef(listClass);
+        if (!listSizeMethod || !listGetMethod)
+        {
+            throw std::runtime_error("Could not find List methods");
+        }
+
+        initialized = true;
+    }
+
+    void CacheCompressionOptionsConversions::destroy(JNIEnv *env)
+    {
+        if (!initialized)
+            return;
+
+        if (cacheCompressionOptionsClass)
+        {
+            env->DeleteGlobalRef(cacheCompressionOptionsClass);
+            cacheCompressionOptionsClass = nullptr;
+        }
+        if (dictionaryClass)
+        {
+            env->DeleteGlobalRef(dictionaryClass);
+            dictionaryClass = nullptr;
+        }
+
+        levelField = nullptr;
+        dictionariesField = nullptr;
+        urlPrefixField = nullptr;
+        pathField = nullptr;
+        listSizeMethod = nullptr;
+        listGetMethod = nullptr;
+        initialized = false;
+    }
+
+    CompressedCacheSource::Options CacheCompressionOptionsConversions::extract(JNIEnv *env, jobject cacheCompressionOptions)
+    {
+        if (!initialized)
+        {
+            init(env);
+        }
+
+        if (!cacheCompressionOptions)
+        {
+            throw std::invalid_argument("CacheCompressionOptions object is null");
+        }
+
+        CompressedCacheSource::Options options;
+        options.level = env->GetIntField(cacheCompressionOptions, levelField);
+
+        jobject dictionaries = env->GetObjectField(cacheCompressionOptions, dictionariesField);
+        if (dictionaries)
+        {
+            const jint count = env->CallIntMethod(dictionaries, listSizeMethod);
+            options.dictionaries.reserve(static_cast<size_t>(count));
+            for (jint i = 0; i < count; i++)
+            {
+                jobject dictionaryObj = env->CallObjectMethod(dictionaries, listGetMethod, i);
+
+                CompressedCacheSource::Dictionary dictionary;
+                jstring urlPrefixStr = (jstring)env->GetObjectField(dictionaryObj, urlPrefixField);
+                dictionary.urlPrefix = jstringToString(env, urlPrefixStr);
+                env->DeleteLocalRef(urlPrefixStr);
+
+                jstring pathStr = (jstring)env->GetObjectField(dictionaryObj, pathField);
+                dictionary.path = jstringToString(env, pathStr);
+                env->DeleteLocalRef(pathStr);
+
+                options.dictionaries.push_back(std::move(dictionary));
+                env->DeleteLocalRef(dictionaryObj);
+            }
+            env->DeleteLocalRef(dictionaries);
+        }
+
+        return options;
+    }
+
+} // namespace maplibre_jni
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "compressed_cache_source.hpp"
+#include <jni.h>
+
+namespace maplibre_jni {
+
+class CacheCompressionOptionsConversions {
+public:
+    static void init(JNIEnv* env);
+    static void destroy(JNIEnv* env);
+    
+    // Extract CompressedCacheSource::Options from Java CacheCompressionOptions object
+    static CompressedCacheSource::Options extract(JNIEnv* env, jobject cacheCompressionOptions);
+    
+private:
+    static jclass cacheCompressionOptionsClass;
+    static jfieldID levelField;
+    static jfieldID dictionariesField;
+    static jclass dictionaryClass;
+    static jfieldID urlPrefixField;
+    static jfieldID pathField;
+    static jmethodID listSizeMethod;
+    static jmethodID listGetMethod;
+    static bool initialized;
+};
+
+} // namespace maplibre_jni
@@ -1,5 +1,7 @@
 #include "mapoptions_conversions.hpp"
 #include "size_conversions.hpp"
+#include "tilelodoptions_conversions.hpp"
+#include "workerpooloptions_conversions.hpp"
 #include <mbgl/map/mode.hpp>
 #include <stdexcept>
 
@@ -15,6 +17,8 @@ namespace maplibre_jni
     jfieldID MapOptionsConversions::northOrientationField = nullptr;
     jfieldID MapOptionsConversions::sizeField = nullptr;
     jfieldID MapOptionsConversions::pixelRatioField = nullptr;
+    jfieldID MapOptionsConversions::workerPoolField = nullptr;
+    jfieldID MapOptionsConversions::tileLodField = nullptr;
     jmethodID MapOptionsConversions::constructor = nullptr;
     bool MapOptionsConversions::initialized = false;
 
@@ -77,9 +81,21 @@ namespace maplibre_jni
             throw std::runtime_error("Could not find pixelRatio field");
         }
 
+        workerPoolField = env->GetFieldID(mapOptionsClass, "workerPool", "Lorg/maplibre/kmp/native/WorkerPoolOptions;");
+        if (!workerPoolField)
+        {
+            throw std::runtime_error("Could not find workerPool field");
+        }
+
+        tileLodField = env->GetFieldID(mapOptionsClass, "tileLod", "Lorg/maplibre/kmp/native/TileLodOptions;");
+        if (!tileLodField)
+        {
+            throw std::runtime_error("Could not find tileLod field");
+        }
+
         // Cache constructor
         constructor = env->GetMethodID(mapOptionsClass, "<init>",
-                                       "(Lorg/maplibre/kmp/native/MapMode;Lorg/maplibre/kmp/native/ConstrainMode;Lorg/maplibre/kmp/native/ViewportMode;ZLorg/maplibre/kmp/native/NorthOrientation;Lorg/maplibre/kmp/native/Size;F)V");
+                                       "(Lorg/maplibre/kmp/native/MapMode;Lorg/maplibre/kmp/native/ConstrainMode;Lorg/maplibre/kmp/native/ViewportMode;ZLorg/maplibre/kmp/native/NorthOrientation;Lorg/maplibre/kmp/native/Size;FLorg/maplibre/kmp/native/WorkerPoolOptions;Lorg/maplibre/kmp/native/TileLodOptions;)V");
         if (!constructor)
         {
             throw std::runtime_error("Could not find MapOptions constructor");
@@ -87,6 +103,8 @@ namespace maplibre_jni
 
         // Initialize dependent conversions
         SizeConversions::init(env);
+        WorkerPoolOptionsConversions::init(env);
+        TileLodOptionsConversions::init(env);
 
         initialized = true;
     }
@@ -109,6 +127,8 @@ namespace maplibre_jni
         northOrientationField = nullptr;
         sizeField = nullptr;
         pixelRatioField = nullptr;
+        workerPoolField = nullptr;
+        tileLodField = nullptr;
         constructor = nullptr;
         initialized = false;
     }
@@ -194,6 +214,52 @@ namespace maplibre_jni
         return options;
     }
 
+    std::optional<WorkerPoolOptions> MapOptionsConversions::extractWorkerPool(JNIEnv *env, jobject mapOptions)
+    {
+        if (!initialized)
+        {
+            init(env);
+        }
+
+        if (!mapOptions)
+        {
+            return std::nullopt;
+        }
+
+        jobject workerPoolObj = env->GetObjectField(mapOptions, workerPoolField);
+        if (!workerPoolObj)
+        {
+            return std::nullopt;
+        }
+
+        WorkerPoolOptions options = WorkerPoolOptionsConversions::extract(env, workerPoolObj);
+        env->DeleteLocalRef(workerPoolObj);
+        return options;
+    }
+
+    std::optional<TileLodController::Options> MapOptionsConversions::extractTileLod(JNIEnv *env, jobject mapOptions)
+    {
+        if (!initialized)
+        {
+            init(env);
+        }
+
+        if (!mapOptions)
+        {
+            return std::nullopt;
+        }
+
+        jobject tileLodObj = env->GetObjectField(mapOptions, tileLodField);
+        if (!tileLodObj)
+        {
+            return std::nullopt;
+        }
+
+        TileLodController::Options options = TileLodOptionsConversions::extract(env, tileLodObj);
+        env->DeleteLocalRef(tileLodObj);
+        return options;
+    }
+
     jobject MapOptionsConversions::create(JNIEnv *env, const mbgl::MapOptions &mapOptions)
     {
         if (!initialized)
@@ -228,7 +294,8 @@ namespace maplibre_jni
         jobject result = env->NewObject(mapOptionsClass, constructor,
                                         mapMode, constrainMode, viewportMode,
                                         mapOptions.crossSourceCollisions(),
-                                        northOrientation, size, mapOptions.pixelRatio());
+                                        northOrientation, size, mapOptions.pixelRatio(),
+                                        static_cast<jobject>(nullptr), static_cast<jobject>(nullptr));
 
         // Clean up local references
         env->DeleteLocalRef(mapModeClass);
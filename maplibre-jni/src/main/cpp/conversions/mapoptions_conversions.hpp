@@ -1,7 +1,10 @@
 #pragma once
 
 #include <jni.h>
+#include "tile_lod_controller.hpp"
+#include "worker_pool.hpp"
 #include <mbgl/map/map_options.hpp>
+#include <optional>
 
 namespace maplibre_jni {
 
@@ -13,6 +16,12 @@ public:
     // Extract mbgl::MapOptions from Java MapOptions object
     static mbgl::MapOptions extract(JNIEnv* env, jobject mapOptions);
     
+    // Extract the worker pool options, which mbgl::MapOptions has no place for
+    static std::optional<WorkerPoolOptions> extractWorkerPool(JNIEnv* env, jobject mapOptions);
+    
+    // Extract the tile level-of-detail options, applied to the Map after it is created
+    static std::optional<TileLodController::Options> extractTileLod(JNIEnv* env, jobject mapOptions);
+    
     // Create Java MapOptions object from mbgl::MapOptions
     static jobject create(JNIEnv* env, const mbgl::MapOptions& mapOptions);
     
@@ -25,6 +34,8 @@ private:
     static jfieldID northOrientationField;
     static jfieldID sizeField;
     static jfieldID pixelRatioField;
+    static jfieldID workerPoolField;
+    static jfieldID tileLodField;
     static jmethodID constructor;
     static bool initialized;
 };
@@ -1,5 +1,10 @@
 #include "resourceoptions_conversions.hpp"
 #include "tileserveroptions_conversions.hpp"
+#include "urlrewriterule_conversions.hpp"
+#include "ambientcacheoptions_conversions.hpp"
+#include "cachecompressionoptions_conversions.hpp"
+#include "jvm_file_source.hpp"
+#include "resource_context.hpp"
 #include <stdexcept>
 
 namespace maplibre_jni
@@ -12,6 +17,12 @@ namespace maplibre_jni
     jfieldID ResourceOptionsConversions::cachePathField = nullptr;
     jfieldID ResourceOptionsConversions::assetPathField = nullptr;
     jfieldID ResourceOptionsConversions::maximumCacheSizeField = nullptr;
+    jfieldID ResourceOptionsConversions::fileSourceField = nullptr;
+    jfieldID ResourceOptionsConversions::urlRewriteRulesField = nullptr;
+    jfieldID ResourceOptionsConversions::ambientCacheField = nullptr;
+    jfieldID ResourceOptionsConversions::cacheCompressionField = nullptr;
+    jfieldID ResourceOptionsConversions::recordSessionField = nullptr;
+    jfieldID ResourceOptionsConversions::nativePtrField = nullptr;
     jmethodID ResourceOptionsConversions::constructor = nullptr;
     bool ResourceOptionsConversions::initialized = false;
 
@@ -62,9 +73,51 @@ namespace maplibre_jni
             throw std::runtime_error("Could not find maximumCacheSize field");
         }
 
+        fileSourceField = env->GetFieldID(resourceOptionsClass, "fileSource", "Lorg/maplibre/kmp/native/JvmFileSource;");
+        if (!fileSourceField)
+        {
+            throw std::runtime_error("Could not find fileSource field");
+        }
+
+        urlRewriteRulesField = env->GetFieldID(resourceOptionsClass, "urlRewriteRules", "Ljava/util/List;");
+        if (!urlRewriteRulesField)
+        {
+            throw std::runtime_error("Could not find urlRewriteRules field");
+        }
+
+        ambientCacheField = env->GetFieldID(resourceOptionsClass, "ambientCache", "Lorg/maplibre/kmp/native/AmbientCacheOptions;");
+        if (!ambientCacheField)
+        {
+            throw std::runtime_error("Could not find ambientCache field");
+        }
+
+        cacheCompressionField = env->GetFieldID(resourceOptionsClass, "cacheCompression", "Lorg/maplibre/kmp/native/CacheCompressionOptions;");
+        if (!cacheCompressionField)
+        {
+            throw std::runtime_error("Could not find cacheCompression field");
+        }
+
+        recordSessionField = env->GetFieldID(resourceOptionsClass, "recordSession", "Z");
+        if (!recordSessionField)
+        {
+            throw std::runtime_error("Could not find recordSession field");
+        }
+
+        jclass fileSourceClass = env->FindClass("org/maplibre/kmp/native/JvmFileSource");
+        if (!fileSourceClass)
+        {
+            throw std::runtime_error("Could not find JvmFileSource class");
+        }
+        nativePtrField = env->GetFieldID(fileSourceClass, "nativePtr", "J");
+        env->DeleteLocalRef(fileSourceClass);
+        if (!nativePtrField)
+        {
+            throw std::runtime_error("Could not find JvmFileSource nativePtr field");
+        }
+
         // Cache constructor
         constructor = env->GetMethodID(resourceOptionsClass, "<init>",
-                                       "(Ljava/lang/String;Lorg/maplibre/kmp/native/TileServerOptions;Ljava/lang/String;Ljava/lang/String;J)V");
+                                       "(Ljava/lang/String;Lorg/maplibre/kmp/native/TileServerOptions;Ljava/lang/String;Ljava/lang/String;JLorg/maplibre/kmp/native/JvmFileSource;Ljava/util/List;Lorg/maplibre/kmp/native/AmbientCacheOptions;Lorg/maplibre/kmp/native/CacheCompressionOptions;Z)V");
         if (!constructor)
         {
             throw std::runtime_error("Could not find ResourceOptions constructor");
@@ -72,6 +125,9 @@ namespace maplibre_jni
 
         // Initialize dependent conversions
         TileServerOptionsConversions::init(env);
+        UrlRewriteRuleConversions::init(env);
+        AmbientCacheOptionsConversions::init(env);
+        CacheCompressionOptionsConversions::init(env);
 
         initialized = true;
     }
@@ -92,6 +148,12 @@ namespace maplibre_jni
         cachePathField = nullptr;
         assetPathField = nullptr;
         maximumCacheSizeField = nullptr;
+        fileSourceField = nullptr;
+        urlRewriteRulesField = nullptr;
+        ambientCacheField = nullptr;
+        cacheCompressionField = nullptr;
+        recordSessionField = nullptr;
+        nativePtrField = nullptr;
         constructor = nullptr;
         initialized = false;
     }
@@ -153,8 +215,42 @@ namespace maplibre_jni
         jlong maximumCacheSize = env->GetLongField(resourceOptions, maximumCacheSizeField);
         options.withMaximumCacheSize(static_cast<uint64_t>(maximumCacheSize));
 
-        // Note: platformContext is not supported for desktop JVM
-        // It would be set to nullptr which is appropriate for desktop platforms
+        // The platform context is otherwise unused on desktop, so it carries the binding's own
+        // settings to the file source factories
+        const void *fileSource = nullptr;
+        jobject fileSourceObj = env->GetObjectField(resourceOptions, fileSourceField);
+        if (fileSourceObj)
+        {
+            fileSource = JvmFileSource::contextOf(env->GetLongField(fileSourceObj, nativePtrField));
+            env->DeleteLocalRef(fileSourceObj);
+        }
+
+        jobject urlRewriteRulesObj = env->GetObjectField(resourceOptions, urlRewriteRulesField);
+        const auto urlRewriteRules = UrlRewriteRuleConversions::extractList(env, urlRewriteRulesObj);
+        if (urlRewriteRulesObj)
+        {
+            env->DeleteLocalRef(urlRewriteRulesObj);
+        }
+
+        std::optional<WriteBehindCacheSource::Options> ambientCache;
+        jobject ambientCacheObj = env->GetObjectField(resourceOptions, ambientCacheField);
+        if (ambientCacheObj)
+        {
+            ambientCache = AmbientCacheOptionsConversions::extract(env, ambientCacheObj);
+            env->DeleteLocalRef(ambientCacheObj);
+        }
+
+        std::optional<CompressedCacheSource::Options> cacheCompression;
+        jobject cacheCompressionObj = env->GetObjectField(resourceOptions, cacheCompressionField);
+        if (cacheCompressionObj)
+        {
+            cacheCompression = CacheCompressionOptionsConversions::extract(env, cacheCompressionObj);
+            env->DeleteLocalRef(cacheCompressionObj);
+        }
+
+        const bool recordSession = env->GetBooleanField(resourceOptions, recordSessionField) == JNI_TRUE;
+
+        options.withPlatformContext(ResourceContext::intern(fileSource, urlRewriteRules, ambientCache, cacheCompression, recordSession));
 
         return options;
     }
@@ -174,16 +270,26 @@ namespace maplibre_jni
         // Create TileServerOptions object
         jobject tileServerOptions = TileServerOptionsConversions::create(env, resourceOptions.tileServerOptions());
 
+        // The Kotlin JvmFileSource, rewrite rules and cache settings can't be recovered from the
+        // platform context
+        jclass collectionsClass = env->FindClass("java/util/Collections");
+        jmethodID emptyListMethod = env->GetStaticMethodID(collectionsClass, "emptyList", "()Ljava/util/List;");
+        jobject urlRewriteRules = env->CallStaticObjectMethod(collectionsClass, emptyListMethod);
+
         // Create ResourceOptions object
         jobject result = env->NewObject(resourceOptionsClass, constructor,
                                         apiKey, tileServerOptions, cachePath, assetPath,
-                                        static_cast<jlong>(resourceOptions.maximumCacheSize()));
+                                        static_cast<jlong>(resourceOptions.maximumCacheSize()),
+                                        static_cast<jobject>(nullptr), urlRewriteRules, static_cast<jobject>(nullptr),
+                                        static_cast<jobject>(nullptr), JNI_FALSE);
 
         // Clean up local references
         env->DeleteLocalRef(apiKey);
         env->DeleteLocalRef(tileServerOptions);
         env->DeleteLocalRef(cachePath);
         env->DeleteLocalRef(assetPath);
+        env->DeleteLocalRef(urlRewriteRules);
+        env->DeleteLocalRef(collectionsClass);
 
         return result;
     }
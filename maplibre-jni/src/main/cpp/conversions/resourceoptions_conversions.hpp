@@ -23,6 +23,12 @@ private:
     static jfieldID cachePathField;
     static jfieldID assetPathField;
     static jfieldID maximumCacheSizeField;
+    static jfieldID fileSourceField;
+    static jfieldID urlRewriteRulesField;
+    static jfieldID ambientCacheField;
+    static jfieldID cacheCompressionField;
+    static jfieldID recordSessionField;
+    static jfieldID nativePtrField;
     static jmethodID constructor;
     static bool initialized;
 };
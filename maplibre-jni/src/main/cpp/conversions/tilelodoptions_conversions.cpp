@@ -0,0 +1,121 @@
+#include "tilelodoptions_conversions.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace maplibre_jni
+{
+
+    // Static member definitions
+    jclass TileLodOptionsConversions::tileLodOptionsClass = nullptr;
+    jfieldID TileLodOptionsConversions::minRadiusField = nullptr;
+    jfieldID TileLodOptionsConversions::scaleField = nullptr;
+    jfieldID TileLodOptionsConversions::pitchThresholdField = nullptr;
+    jfieldID TileLodOptionsConversions::zoomShiftField = nullptr;
+    jfieldID TileLodOptionsConversions::prefetchZoomDeltaField = nullptr;
+    jfieldID TileLodOptionsConversions::adaptiveTargetFrameTimeMsField = nullptr;
+    bool TileLodOptionsConversions::initialized = false;
+
+    void TileLodOptionsConversions::init(JNIEnv *env)
+    {
+        if (initialized)
+            return;
+
+        // Find the TileLodOptions class
+        jclass localClass = env->FindClass("org/maplibre/kmp/native/TileLodOptions");
+        if (!localClass)
+        {
+            throw std::runtime_error("Could not find TileLodOptions class");
+        }
+
+        // Create global reference
+        tileLodOptionsClass = (jclass)env->NewGlobalRef(localClass);
+        env->DeleteLocalRef(localClass);
+
+        // Cache field IDs
+        minRadiusField = env->GetFieldID(tileLodOptionsClass, "minRadius", "D");
+        if (!minRadiusField)
+        {
+            throw std::runtime_error("Could not find minRadius field");
+        }
+
+        scaleField = env->GetFieldID(tileLodOptionsClass, "scale", "D");
+        if (!scaleField)
+        {
+            throw std::runtime_error("Could not find scale field");
+        }
+
+        pitchThresholdField = env->GetFieldID(tileLodOptionsClass, "pitchThreshold", "D");
+        if (!pitchThresholdField)
+        {
+            throw std::runtime_error("Could not find pitchThreshold field");
+        }
+
+        zoomShiftField = env->GetFieldID(tileLodOptionsClass, "zoomShift", "D");
+        if (!zoomShiftField)
+        {
+            throw std::runtime_error("Could not find zoomShift field");
+        }
+
+        prefetchZoomDeltaField = env->GetFieldID(tileLodOptionsClass, "prefetchZoomDelta", "I");
+        if (!prefetchZoomDeltaField)
+        {
+            throw std::runtime_error("Could not find prefetchZoomDelta field");
+        }
+
+        adaptiveTargetFrameTimeMsField = env->GetFieldID(tileLodOptionsClass, "adaptiveTargetFrameTimeMs", "D");
+        if (!adaptiveTargetFrameTimeMsField)
+        {
+            throw std::runtime_error("Could not find adaptiveTargetFrameTimeMs field");
+        }
+
+        initialized = true;
+    }
+
+    void TileLodOptionsConversions::destroy(JNIEnv *env)
+    {
+        if (!initialized)
+            return;
+
+        if (tileLodOptionsClass)
+        {
+            env->DeleteGlobalRef(tileLodOptionsClass);
+            tileLodOptionsClass = nullptr;
+        }
+
+        minRadiusField = nullptr;
+        scaleField = nullptr;
+        pitchThresholdField = nullptr;
+        zoomShiftField = nullptr;
+        prefetchZoomDeltaField = nullptr;
+        adaptiveTargetFrameTimeMsField = nullptr;
+        initialized = false;
+    }
+
+    TileLodController::Options TileLodOptionsConversions::extract(JNIEnv *env, jobject tileLodOptions)
+    {
+        if (!initialized)
+        {
+            init(env);
+        }
+
+        if (!tileLodOptions)
+        {
+            throw std::invalid_argument("TileLodOptions object is null");
+        }
+
+        // Kotlin takes the pitch threshold in degrees like the rest of the camera API
+        constexpr double DEG2RAD = 0.017453292519943295;
+
+        TileLodController::Options options;
+        options.settings.minRadius = env->GetDoubleField(tileLodOptions, minRadiusField);
+        options.settings.scale = env->GetDoubleField(tileLodOptions, scaleField);
+        options.settings.pitchThreshold = env->GetDoubleField(tileLodOptions, pitchThresholdField) * DEG2RAD;
+        options.settings.zoomShift = env->GetDoubleField(tileLodOptions, zoomShiftField);
+        options.settings.prefetchZoomDelta = static_cast<uint8_t>(
+            std::clamp<jint>(env->GetIntField(tileLodOptions, prefetchZoomDeltaField), 0, 255));
+        options.adaptiveTargetFrameMs = env->GetDoubleField(tileLodOptions, adaptiveTargetFrameTimeMsField);
+
+        return options;
+    }
+
+} // namespace maplibre_jni
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "tile_lod_controller.hpp"
+#include <jni.h>
+
+namespace maplibre_jni {
+
+class TileLodOptionsConversions {
+public:
+    static void init(JNIEnv* env);
+    static void destroy(JNIEnv* env);
+    
+    // Extract TileLodController::Options from Java TileLodOptions object
+    static TileLodController::Options extract(JNIEnv* env, jobject tileLodOptions);
+    
+private:
+    static jclass tileLodOptionsClass;
+    static jfieldID minRadiusField;
+    static jfieldID scaleField;
+    static jfieldID pitchThresholdField;
+    static jfieldID zoomShiftField;
+    static jfieldID prefetchZoomDeltaField;
+    static jfieldID adaptiveTargetFrameTimeMsField;
+    static bool initialized;
+};
+
+} // namespace maplibre_jni
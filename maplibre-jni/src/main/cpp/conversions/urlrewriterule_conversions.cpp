@@ -0,0 +1,158 @@
+#include "urlrewriterule_conversions.hpp"
+#include "jni_helpers.hpp"
+#include <stdexcept>
+
+namespace maplibre_jni
+{
+
+    // Static member definitions
+    jclass UrlRewriteRuleConversions::urlRewriteRuleClass = nullptr;
+    jfieldID UrlRewriteRuleConversions::patternField = nullptr;
+    jfieldID UrlRewriteRuleConversions::replacementField = nullptr;
+    jfieldID UrlRewriteRuleConversions::typeField = nullptr;
+    jfieldID UrlRewriteRuleConversions::kindMaskField = nullptr;
+    jmethodID UrlRewriteRuleConversions::listSizeMethod = nullptr;
+    jmethodID UrlRewriteRuleConversions::listGetMethod = nullptr;
+    bool UrlRewriteRuleConversions::initialized = false;
+
+    void UrlRewriteRuleConversions::init(JNIEnv *env)
+    {
+        if (initialized)
+            return;
+
+        // Find the UrlRewriteRule class
+        jclass localClass = env->FindClass("org/maplibre/kmp/native/UrlRewriteRule");
+        if (!localClass)
+        {
+            throw std::runtime_error("Could not find UrlRewriteRule class");
+        }
+
+        // Create global reference
+        urlRewriteRuleClass = (jclass)env->NewGlobalRef(localClass);
+        env->DeleteLocalRef(localClass);
+
+        // Cache field IDs
+        patternField = env->GetFieldID(urlRewriteRuleClass, "pattern", "Ljava/lang/String;");
+        if (!patternField)
+        {
+            throw std::runtime_error("Could not find pattern field");
+        }
+
+        replacementField = env->GetFieldID(urlRewriteRuleClass, "replacement", "Ljava/lang/String;");
+        if (!replacementField)
+        {
+            throw std::runtime_error("Could not find replacement field");
+        }
+
+        typeField = env->GetFieldID(urlRewriteRuleClass, "type", "Lorg/maplibre/kmp/native/UrlRewriteRule$Type;");
+        if (!typeField)
+        {
+            throw std::runtime_error("Could not find type field");
+        }
+
+        kindMaskField = env->GetFieldID(urlRewriteRuleClass, "kindMask", "I");
+        if (!kindMaskField)
+        {
+            throw std::runtime_error("Could not find kindMask field");
+        }
+
+        // Cache List accessors
+        jclass listClass = env->FindClass("java/util/List");
+        if (!listClass)
+        {
+            throw std::runtime_error("Could not find List class");
+        }
+        listSizeMethod = env->GetMethodID(listClass, "size", "()I");
+        listGetMethod = env->GetMethodID(listClass, "get", "(I)Ljava/lang/Object;");
+        env->DeleteLocalRef(listClass);
+        if (!listSizeMethod || !listGetMethod)
+        {
+            throw std::runtime_error("Could not find List methods");
+        }
+
+        initialized = true;
+    }
+
+    void UrlRewriteRuleConversions::destroy(JNIEnv *env)
+    {
+        if (!initialized)
+            return;
+
+        if (urlRewriteRuleClass)
+        {
+            env->DeleteGlobalRef(urlRewriteRuleClass);
+            urlRewriteRuleClass = nullptr;
+        }
+
+        patternField = nullptr;
+        replacementField = nullptr;
+        typeField = nullptr;
+        kindMaskField = nullptr;
+        listSizeMethod = nullptr;
+        listGetMethod = nullptr;
+        initialized = false;
+    }
+
+    UrlRewriter::Rule UrlRewriteRuleConversions::extract(JNIEnv *env, jobject urlRewriteRule)
+    {
+        if (!initialized)
+        {
+            init(env);
+        }
+
+        if (!urlRewriteRule)
+        {
+            throw std::invalid_argument("UrlRewriteRule object is null");
+        }
+
+        UrlRewriter::Rule rule;
+
+        jstring patternStr = (jstring)env->GetObjectField(urlRewriteRule, patternField);
+        rule.pattern = jstringToString(env, patternStr);
+        env->DeleteLocalRef(patternStr);
+
+        jstring replacementStr = (jstring)env->GetObjectField(urlRewriteRule, replacementField);
+        rule.replacement = jstringToString(env, replacementStr);
+        env->DeleteLocalRef(replacementStr);
+
+        // Extract type enum
+        jobject typeObj = env->GetObjectField(urlRewriteRule, typeField);
+        if (typeObj)
+        {
+            jclass enumClass = env->GetObjectClass(typeObj);
+            jfieldID nativeValueField = env->GetFieldID(enumClass, "nativeValue", "I");
+            rule.type = static_cast<UrlRewriter::Rule::Type>(env->GetIntField(typeObj, nativeValueField));
+            env->DeleteLocalRef(typeObj);
+            env->DeleteLocalRef(enumClass);
+        }
+
+        rule.kinds = static_cast<uint32_t>(env->GetIntField(urlRewriteRule, kindMaskField));
+
+        return rule;
+    }
+
+    std::vector<UrlRewriter::Rule> UrlRewriteRuleConversions::extractList(JNIEnv *env, jobject rules)
+    {
+        if (!initialized)
+        {
+            init(env);
+        }
+
+        std::vector<UrlRewriter::Rule> result;
+        if (!rules)
+        {
+            return result;
+        }
+
+        const jint count = env->CallIntMethod(rules, listSizeMethod);
+        result.reserve(static_cast<size_t>(count));
+        for (jint i = 0; i < count; i++)
+        {
+            jobject ruleObj = env->CallObjectMethod(rules, listGetMethod, i);
+            result.push_back(extract(env, ruleObj));
+            env->DeleteLocalRef(ruleObj);
+        }
+        return result;
+    }
+
+} // namespace maplibre_jni
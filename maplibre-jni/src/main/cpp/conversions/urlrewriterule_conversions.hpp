@@ -0,0 +1,31 @@
+#pragma once
+
+#include "url_rewriter.hpp"
+#include <jni.h>
+#include <vector>
+
+namespace maplibre_jni {
+
+class UrlRewriteRuleConversions {
+public:
+    static void init(JNIEnv* env);
+    static void destroy(JNIEnv* env);
+    
+    // Extract a rule from a Java UrlRewriteRule object
+    static UrlRewriter::Rule extract(JNIEnv* env, jobject urlRewriteRule);
+
+    // Extract every rule of a Java List<UrlRewriteRule>, in order
+    static std::vector<UrlRewriter::Rule> extractList(JNIEnv* env, jobject rules);
+    
+private:
+    static jclass urlRewriteRuleClass;
+    static jfieldID patternField;
+    static jfieldID replacementField;
+    static jfieldID typeField;
+    static jfieldID kindMaskField;
+    static jmethodID listSizeMethod;
+    static jmethodID listGetMethod;
+    static bool initialized;
+};
+
+} // namespace maplibre_jni
@@ -0,0 +1,138 @@
+#include "workerpooloptions_conversions.hpp"
+#include <stdexcept>
+
+namespace maplibre_jni
+{
+
+    // Static member definitions
+    jclass WorkerPoolOptionsConversions::workerPoolOptionsClass = nullptr;
+    jfieldID WorkerPoolOptionsConversions::threadsField = nullptr;
+    jfieldID WorkerPoolOptionsConversions::nameField = nullptr;
+    jfieldID WorkerPoolOptionsConversions::priorityField = nullptr;
+    jfieldID WorkerPoolOptionsConversions::cpuAffinityField = nullptr;
+    jfieldID WorkerPoolOptionsConversions::sharedField = nullptr;
+    bool WorkerPoolOptionsConversions::initialized = false;
+
+    void WorkerPoolOptionsConversions::init(JNIEnv *env)
+    {
+        if (initialized)
+            return;
+
+        // Find the WorkerPoolOptions class
+        jclass localClass = env->FindClass("org/maplibre/kmp/native/WorkerPoolOptions");
+        if (!localClass)
+        {
+            throw std::runtime_error("Could not find WorkerPoolOptions class");
+        }
+
+        // Create global reference
+        workerPoolOptionsClass = (jclass)env->NewGlobalRef(localClass);
+        env->DeleteLocalRef(localClass);
+
+        // Cache field IDs
+        threadsField = env->GetFieldID(workerPoolOptionsClass, "threads", "I");
+        if (!threadsField)
+        {
+            throw std::runtime_error("Could not find threads field");
+        }
+
+        nameField = env->GetFieldID(workerPoolOptionsClass, "name", "Ljava/lang/String;");
+        if (!nameField)
+        {
+            throw std::runtime_error("Could not find name field");
+        }
+
+        priorityField = env->GetFieldID(workerPoolOptionsClass, "priority", "Lorg/maplibre/kmp/native/WorkerPriority;");
+        if (!priorityField)
+        {
+            throw std::runtime_error("Could not find priority field");
+        }
+
+        cpuAffinityField = env->GetFieldID(workerPoolOptionsClass, "cpuAffinity", "[I");
+        if (!cpuAffinityField)
+        {
+            throw std::runtime_error("Could not find cpuAffinity field");
+        }
+
+        sharedField = env->GetFieldID(workerPoolOptionsClass, "shared", "Z");
+        if (!sharedField)
+        {
+            throw std::runtime_error("Could not find shared field");
+        }
+
+        initialized = true;
+    }
+
+    void WorkerPoolOptionsConversions::destroy(JNIEnv *env)
+    {
+        if (!initialized)
+            return;
+
+        if (workerPoolOptionsClass)
+        {
+            env->DeleteGlobalRef(workerPoolOptionsClass);
+            workerPoolOptionsClass = nullptr;
+        }
+
+        threadsField = nullptr;
+        nameField = nullptr;
+        priorityField = nullptr;
+        cpuAffinityField = nullptr;
+        sharedField = nullptr;
+        initialized = false;
+    }
+
+    WorkerPoolOptions WorkerPoolOptionsConversions::extract(JNIEnv *env, jobject workerPoolOptions)
+    {
+        if (!initialized)
+        {
+            init(env);
+        }
+
+        if (!workerPoolOptions)
+        {
+            throw std::invalid_argument("WorkerPoolOptions object is null");
+        }
+
+        WorkerPoolOptions options;
+
+        options.threads = static_cast<uint32_t>(env->GetIntField(workerPoolOptions, threadsField));
+
+        // Extract name string
+        jstring nameStr = (jstring)env->GetObjectField(workerPoolOptions, nameField);
+        if (nameStr)
+        {
+            const char *chars = env->GetStringUTFChars(nameStr, nullptr);
+            options.name = chars;
+            env->ReleaseStringUTFChars(nameStr, chars);
+            env->DeleteLocalRef(nameStr);
+        }
+
+        // Extract priority enum
+        jobject priorityObj = env->GetObjectField(workerPoolOptions, priorityField);
+        if (priorityObj)
+        {
+            jclass enumClass = env->GetObjectClass(priorityObj);
+            jfieldID nativeValueField = env->GetFieldID(enumClass, "nativeValue", "I");
+            jint priority = env->GetIntField(priorityObj, nativeValueField);
+            options.priority = static_cast<WorkerPoolOptions::Priority>(priority);
+            env->DeleteLocalRef(priorityObj);
+            env->DeleteLocalRef(enumClass);
+        }
+
+        // Extract CPU affinity array
+        jintArray cpuArray = (jintArray)env->GetObjectField(workerPoolOptions, cpuAffinityField);
+        if (cpuArray)
+        {
+            const jsize count = env->GetArrayLength(cpuArray);
+            options.cpuAffinity.resize(static_cast<size_t>(count));
+            env->GetIntArrayRegion(cpuArray, 0, count, reinterpret_cast<jint *>(options.cpuAffinity.data()));
+            env->DeleteLocalRef(cpuArray);
+        }
+
+        options.shared = env->GetBooleanField(workerPoolOptions, sharedField) == JNI_TRUE;
+
+        return options;
+    }
+
+} // namespace maplibre_jni
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "worker_pool.hpp"
+#include <jni.h>
+
+namespace maplibre_jni {
+
+class WorkerPoolOptionsConversions {
+public:
+    static void init(JNIEnv* env);
+    static void destroy(JNIEnv* env);
+    
+    // Extract WorkerPoolOptions from Java WorkerPoolOptions object
+    static WorkerPoolOptions extract(JNIEnv* env, jobject workerPoolOptions);
+    
+private:
+    static jclass workerPoolOptionsClass;
+    static jfieldID threadsField;
+    static jfieldID nameField;
+    static jfieldID priorityField;
+    static jfieldID cpuAffinityField;
+    static jfieldID sharedField;
+    static bool initialized;
+};
+
+} // namespace maplibre_jni
@@ -0,0 +1,90 @@
+#include "damage_tracker.hpp"
+#include <algorithm>
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        // Presentation engines handle a few rectangles well; beyond that use their bounding box
+        constexpr size_t MAX_REGIONS = 16;
+
+        // Once most of the frame is damaged a full present is no more expensive
+        constexpr double MAX_AREA_FRACTION = 0.5;
+    } // namespace
+
+    void DamageTracker::addRegion(const DamageRect &rect)
+    {
+        if (rect.width > 0 && rect.height > 0)
+        {
+            regions.push_back(rect);
+        }
+    }
+
+    void DamageTracker::markFull()
+    {
+        full = true;
+    }
+
+    void DamageTracker::markUpdate()
+    {
+        if (regions.empty())
+        {
+            full = true;
+        }
+    }
+
+    std::vector<DamageRect> DamageTracker::takeFrameDamage(mbgl::Size size)
+    {
+        std::vector<DamageRect> damage;
+        damage.swap(regions);
+        const bool wasFull = full;
+        full = false;
+        if (wasFull)
+        {
+            return {};
+        }
+
+        const auto width = static_cast<int32_t>(size.width);
+        const auto height = static_cast<int32_t>(size.height);
+        std::vector<DamageRect> clipped;
+        double area = 0;
+        for (const auto &rect : damage)
+        {
+            const int32_t left = std::max(rect.x, 0);
+            const int32_t top = std::max(rect.y, 0);
+            const int32_t right = std::min(rect.x + rect.width, width);
+            const int32_t bottom = std::min(rect.y + rect.height, height);
+            if (right > left && bottom > top)
+            {
+                clipped.push_back({left, top, right - left, bottom - top});
+                area += static_cast<double>(right - left) * (bottom - top);
+            }
+        }
+
+        if (clipped.size() > MAX_REGIONS)
+        {
+            DamageRect bounds = clipped.front();
+            int32_t right = bounds.x + bounds.width;
+            int32_t bottom = bounds.y + bounds.height;
+            for (const auto &rect : clipped)
+            {
+                bounds.x = std::min(bounds.x, rect.x);
+                bounds.y = std::min(bounds.y, rect.y);
+                right = std::max(right, rect.x + rect.width);
+                bottom = std::max(bottom, rect.y + rect.height);
+            }
+            bounds.width = right - bounds.x;
+            bounds.height = bottom - bounds.y;
+            clipped = {bounds};
+            area = static_cast<double>(bounds.width) * bounds.height;
+        }
+
+        if (area > MAX_AREA_FRACTION * width * height)
+        {
+            return {};
+        }
+        return clipped;
+    }
+
+} // namespace maplibre_jni
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <mbgl/util/size.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace maplibre_jni
+{
+
+    // Framebuffer region in pixels, origin at the top left
+    struct DamageRect
+    {
+        int32_t x = 0;
+        int32_t y = 0;
+        int32_t width = 0;
+        int32_t height = 0;
+    };
+
+    // Collects the regions the next presented frame changes
+    //
+    // Damage comes only from application hints. mbgl redraws the whole frame and does not report
+    // which tiles, annotations or feature states changed, so none of that is derived here: a
+    // frame presents just the hinted regions only if every change since the last present was a
+    // style or annotation update made while hints were pending. Camera, size and scale changes,
+    // tile arrivals, fades, placement changes and updates without hints all present the whole
+    // framebuffer. Presenting less than changed leaves stale pixels on screen, so hints must
+    // be complete.
+    class DamageTracker
+    {
+    public:
+        void addRegion(const DamageRect &rect);
+
+        // The next frame changes everything, regardless of hints
+        void markFull();
+
+        // A style or annotation update: covered by the hints declared since the last present, if
+        // there are any
+        void markUpdate();
+
+        // Damage of the frame about to be presented, clipped to size; empty means the whole
+        // frame. Resets the tracker for the following frame.
+        std::vector<DamageRect> takeFrameDamage(mbgl::Size size);
+
+    private:
+        std::vector<DamageRect> regions;
+        bool full = false;
+    };
+
+} // namespace maplibre_jni
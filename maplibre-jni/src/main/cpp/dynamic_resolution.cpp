@@ -0,0 +1,77 @@
+#include "dynamic_resolution.hpp"
+#include <algorithm>
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        constexpr float SCALE_STEP = 0.125f;
+
+        // Frames to average after a change before judging the new scale
+        constexpr uint32_t SETTLE_FRAMES = 3;
+
+        constexpr double SMOOTHING = 0.3;
+        constexpr double SLOW_FACTOR = 1.1;
+        constexpr double FAST_FACTOR = 0.6;
+    } // namespace
+
+    void DynamicResolutionController::setOptions(const Options &options_)
+    {
+        options = options_;
+        options.minScale = std::clamp(options.minScale, SCALE_STEP, 1.0f);
+        interactionScale = std::max(interactionScale, options.minScale);
+        averageMs = 0;
+        framesAtScale = 0;
+    }
+
+    bool DynamicResolutionController::setInteractionActive(bool active_)
+    {
+        const float previous = getScale();
+        active = active_;
+        averageMs = 0;
+        framesAtScale = 0;
+        return getScale() != previous;
+    }
+
+    bool DynamicResolutionController::addFrameTime(double frameMs)
+    {
+        if (!options.enabled || !active)
+        {
+            return false;
+        }
+
+        averageMs = averageMs > 0 ? averageMs * (1.0 - SMOOTHING) + frameMs * SMOOTHING : frameMs;
+        if (++framesAtScale < SETTLE_FRAMES)
+        {
+            return false;
+        }
+
+        float scale = interactionScale;
+        if (averageMs > options.targetFrameMs * SLOW_FACTOR)
+        {
+            scale = std::max(options.minScale, interactionScale - SCALE_STEP);
+        }
+        else if (averageMs < options.targetFrameMs * FAST_FACTOR)
+        {
+            scale = std::min(1.0f, interactionScale + SCALE_STEP);
+        }
+        if (scale == interactionScale)
+        {
+            return false;
+        }
+
+        // Fill cost grows with the pixel count, so carry the estimate over instead of starting cold
+        const double ratio = static_cast<double>(scale) / interactionScale;
+        averageMs *= ratio * ratio;
+        interactionScale = scale;
+        framesAtScale = 0;
+        return true;
+    }
+
+    float DynamicResolutionController::getScale() const
+    {
+        return options.enabled && active ? interactionScale : 1.0f;
+    }
+
+} // namespace maplibre_jni
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+namespace maplibre_jni
+{
+
+    // Picks the scale frames are rendered at while an interaction (pan, zoom, rotate) is running
+    //
+    // Frame times are smoothed and the scale moves one step at a time: down when frames take
+    // longer than the target, up when there is clear headroom. The scale reached during one
+    // gesture is where the next one starts, and outside interactions frames are always full size.
+    class DynamicResolutionController
+    {
+    public:
+        struct Options
+        {
+            bool enabled = false;
+            float minScale = 0.5f;
+            double targetFrameMs = 33.0;
+        };
+
+        void setOptions(const Options &options);
+
+        // Returns true if the scale changed
+        bool setInteractionActive(bool active);
+
+        // Record how long a frame at the current scale took; returns true if the scale changed
+        bool addFrameTime(double frameMs);
+
+        float getScale() const;
+
+    private:
+        Options options;
+        bool active = false;
+        float interactionScale = 1.0f;
+        double averageMs = 0;
+        uint32_t framesAtScale = 0;
+    };
+
+} // namespace maplibre_jni
@@ -1,5 +1,10 @@
 #include "egl_context_strategy.hpp"
+#include "program_binary_cache.hpp"
 #include <mbgl/util/logging.hpp>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <jawt.h>
 #include <jawt_md.h>
 
@@ -10,6 +15,51 @@
 namespace maplibre_jni
 {
 
+    namespace
+    {
+        void setProgramBinary(const void *key, EGLsizeiANDROID keySize, const void *value, EGLsizeiANDROID valueSize)
+        {
+            ProgramBinaryCache::get().store(key, static_cast<size_t>(keySize), value, static_cast<size_t>(valueSize));
+        }
+
+        EGLsizeiANDROID getProgramBinary(const void *key, EGLsizeiANDROID keySize, void *value, EGLsizeiANDROID valueSize)
+        {
+            return static_cast<EGLsizeiANDROID>(
+                ProgramBinaryCache::get().load(key, static_cast<size_t>(keySize), value, static_cast<size_t>(valueSize)));
+        }
+
+        // A context is current on at most one thread, so shared contexts are per rendering thread
+        struct SharedContext
+        {
+            EGLConfig config = nullptr;
+            EGLContext context = EGL_NO_CONTEXT;
+            uint32_t users = 0;
+        };
+
+        // Displays are process-wide, so initialization and the shared contexts are counted across
+        // strategies; terminating a display releases every context and surface created on it
+        struct DisplayEntry
+        {
+            uint32_t users = 0;
+            std::unordered_map<std::thread::id, SharedContext> sharedContexts;
+        };
+
+        std::mutex displayMutex;
+        std::unordered_map<EGLDisplay, DisplayEntry> displays;
+
+        // glGetString without pulling in GL headers
+        using GetStringProc = const unsigned char *(*)(unsigned int);
+        constexpr unsigned int GL_VENDOR_ENUM = 0x1F00;
+        constexpr unsigned int GL_RENDERER_ENUM = 0x1F01;
+        constexpr unsigned int GL_VERSION_ENUM = 0x1F02;
+    } // namespace
+
+    EGLContextStrategy::EGLContextStrategy(std::optional<std::string> programCachePath_, bool shareContext_)
+        : programCachePath(std::move(programCachePath_)),
+          shareContext(shareContext_)
+    {
+    }
+
     EGLContextStrategy::~EGLContextStrategy()
     {
         destroy();
@@ -41,15 +91,32 @@ namespace maplibre_jni
             return;
         }
 
-        EGLint major, minor;
-        if (!eglInitialize(eglDisplay, &major, &minor))
+        std::unique_lock<std::mutex> lock(displayMutex);
+        DisplayEntry &entry = displays[eglDisplay];
+        if (entry.users == 0)
         {
-            mbgl::Log::Error(mbgl::Event::OpenGL, "Failed to initialize EGL");
-            return;
-        }
+            EGLint major, minor;
+            if (!eglInitialize(eglDisplay, &major, &minor))
+            {
+                displays.erase(eglDisplay);
+                eglDisplay = EGL_NO_DISPLAY;
+                mbgl::Log::Error(mbgl::Event::OpenGL, "Failed to initialize EGL");
+                return;
+            }
 
-        mbgl::Log::Info(mbgl::Event::OpenGL,
-                        std::string("EGL initialized: ") + std::to_string(major) + "." + std::to_string(minor));
+            mbgl::Log::Info(mbgl::Event::OpenGL,
+                            std::string("EGL initialized: ") + std::to_string(major) + "." + std::to_string(minor));
+
+            installProgramBinaryCache();
+        }
+        entry.users++;
+        SharedContext *shared = nullptr;
+        if (shareContext)
+        {
+            // Maps render on the thread that creates them, so that thread owns the context
+            sharedThread = std::this_thread::get_id();
+            shared = &entry.sharedContexts[sharedThread];
+        }
 
         // Bind to OpenGL ES API
         if (!eglBindAPI(EGL_OPENGL_ES_API))
@@ -71,7 +138,12 @@ namespace maplibre_jni
             EGL_NONE};
 
         EGLint numConfigs;
-        if (!eglChooseConfig(eglDisplay, configAttribs, &eglConfig, 1, &numConfigs) || numConfigs == 0)
+        if (shared && shared->context != EGL_NO_CONTEXT)
+        {
+            // Surfaces must use the shared context's config
+            eglConfig = shared->config;
+        }
+        else if (!eglChooseConfig(eglDisplay, configAttribs, &eglConfig, 1, &numConfigs) || numConfigs == 0)
         {
             mbgl::Log::Error(mbgl::Event::OpenGL, "Failed to choose EGL config");
             return;
@@ -95,12 +167,29 @@ namespace maplibre_jni
             EGL_CONTEXT_CLIENT_VERSION, 2,
             EGL_NONE};
 
-        eglContext = eglCreateContext(eglDisplay, eglConfig, EGL_NO_CONTEXT, contextAttribs);
-        if (eglContext == EGL_NO_CONTEXT)
+        if (shared && shared->context != EGL_NO_CONTEXT)
         {
-            mbgl::Log::Error(mbgl::Event::OpenGL, "Failed to create EGL context");
-            return;
+            eglContext = shared->context;
         }
+        else
+        {
+            eglContext = eglCreateContext(eglDisplay, eglConfig, EGL_NO_CONTEXT, contextAttribs);
+            if (eglContext == EGL_NO_CONTEXT)
+            {
+                mbgl::Log::Error(mbgl::Event::OpenGL, "Failed to create EGL context");
+                return;
+            }
+            if (shared)
+            {
+                shared->context = eglContext;
+                shared->config = eglConfig;
+            }
+        }
+        if (shared)
+        {
+            shared->users++;
+        }
+        lock.unlock();
 
         if (!eglMakeCurrent(eglDisplay, eglSurface, eglSurface, eglContext))
         {
@@ -108,18 +197,108 @@ namespace maplibre_jni
             return;
         }
 
+        // The render host's timer paces the pass over shared surfaces; waiting for vsync on a
+        // swap as well would delay every map after it by up to a frame
+        if (shareContext)
+        {
+            eglSwapInterval(eglDisplay, 0);
+        }
+
+        validateProgramBinaryCache();
+
+        const char *extensions = eglQueryString(eglDisplay, EGL_EXTENSIONS);
+        if (extensions && std::strstr(extensions, "EGL_KHR_swap_buffers_with_damage"))
+        {
+            swapWithDamage = reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>(
+                eglGetProcAddress("eglSwapBuffersWithDamageKHR"));
+        }
+        else if (extensions && std::strstr(extensions, "EGL_EXT_swap_buffers_with_damage"))
+        {
+            // Same signature as the KHR entry point
+            swapWithDamage = reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>(
+                eglGetProcAddress("eglSwapBuffersWithDamageEXT"));
+        }
+
         mbgl::Log::Info(mbgl::Event::OpenGL, "EGL context created successfully");
     }
 
+    void EGLContextStrategy::installProgramBinaryCache()
+    {
+        if (!programCachePath)
+        {
+            return;
+        }
+
+        const char *extensions = eglQueryString(eglDisplay, EGL_EXTENSIONS);
+        if (!extensions || !std::strstr(extensions, "EGL_ANDROID_blob_cache"))
+        {
+            mbgl::Log::Info(mbgl::Event::OpenGL, "EGL_ANDROID_blob_cache not supported, program binaries are not cached");
+            return;
+        }
+
+        auto setBlobCacheFuncs = reinterpret_cast<PFNEGLSETBLOBCACHEFUNCSANDROIDPROC>(
+            eglGetProcAddress("eglSetBlobCacheFuncsANDROID"));
+        if (!setBlobCacheFuncs)
+        {
+            return;
+        }
+
+        ProgramBinaryCache::get().open(*programCachePath);
+        if (ProgramBinaryCache::get().isOpen())
+        {
+            setBlobCacheFuncs(eglDisplay, setProgramBinary, getProgramBinary);
+        }
+    }
+
+    void EGLContextStrategy::validateProgramBinaryCache()
+    {
+        if (!programCachePath || !ProgramBinaryCache::get().isOpen())
+        {
+            return;
+        }
+
+        // Binaries from an unidentified driver could be stale, and the driver has no way to
+        // reject them, so the cache stays off rather than serving them unchecked
+        auto getString = reinterpret_cast<GetStringProc>(eglGetProcAddress("glGetString"));
+        if (!getString)
+        {
+            mbgl::Log::Warning(mbgl::Event::OpenGL, "glGetString not available, program binary cache disabled");
+            ProgramBinaryCache::get().close();
+            return;
+        }
+
+        // Binaries are only valid for the exact driver that produced them
+        std::string driverKey;
+        for (unsigned int name : {GL_VENDOR_ENUM, GL_RENDERER_ENUM, GL_VERSION_ENUM})
+        {
+            const unsigned char *value = getString(name);
+            driverKey += value ? reinterpret_cast<const char *>(value) : "";
+            driverKey += '\n';
+        }
+        ProgramBinaryCache::get().validateDriver(driverKey);
+    }
+
     void EGLContextStrategy::destroy()
     {
         if (eglDisplay != EGL_NO_DISPLAY)
         {
+            std::lock_guard<std::mutex> lock(displayMutex);
+            DisplayEntry &entry = displays[eglDisplay];
+
             eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
 
             if (eglContext != EGL_NO_CONTEXT)
             {
-                eglDestroyContext(eglDisplay, eglContext);
+                auto shared = entry.sharedContexts.find(sharedThread);
+                if (!shareContext || shared == entry.sharedContexts.end() || shared->second.context != eglContext)
+                {
+                    eglDestroyContext(eglDisplay, eglContext);
+                }
+                else if (--shared->second.users == 0)
+                {
+                    eglDestroyContext(eglDisplay, eglContext);
+                    entry.sharedContexts.erase(shared);
+                }
                 eglContext = EGL_NO_CONTEXT;
             }
 
@@ -129,9 +308,18 @@ namespace maplibre_jni
                 eglSurface = EGL_NO_SURFACE;
             }
 
-            eglTerminate(eglDisplay);
+            if (entry.users <= 1)
+            {
+                eglTerminate(eglDisplay);
+                displays.erase(eglDisplay);
+            }
+            else
+            {
+                entry.users--;
+            }
             eglDisplay = EGL_NO_DISPLAY;
         }
+        swapWithDamage = nullptr;
     }
 
     void EGLContextStrategy::makeCurrent()
@@ -161,6 +349,31 @@ namespace maplibre_jni
         }
     }
 
+    void EGLContextStrategy::swapBuffersWithDamage(const std::vector<DamageRect> &rects, uint32_t surfaceHeight)
+    {
+        if (!swapWithDamage || rects.empty() || eglDisplay == EGL_NO_DISPLAY || eglSurface == EGL_NO_SURFACE)
+        {
+            swapBuffers();
+            return;
+        }
+
+        // EGL rectangles are x, y, width, height with the origin at the bottom left
+        std::vector<EGLint> eglRects;
+        eglRects.reserve(rects.size() * 4);
+        for (const auto &rect : rects)
+        {
+            eglRects.push_back(rect.x);
+            eglRects.push_back(static_cast<EGLint>(surfaceHeight) - rect.y - rect.height);
+            eglRects.push_back(rect.width);
+            eglRects.push_back(rect.height);
+        }
+
+        if (!swapWithDamage(eglDisplay, eglSurface, eglRects.data(), static_cast<EGLint>(rects.size())))
+        {
+            swapBuffers();
+        }
+    }
+
     void *EGLContextStrategy::getProcAddress(const char *name)
     {
         return reinterpret_cast<void *>(eglGetProcAddress(name));
@@ -3,6 +3,9 @@
 #include "gl_context_strategy.hpp"
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
+#include <optional>
+#include <string>
+#include <thread>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -14,7 +17,12 @@ namespace maplibre_jni
     class EGLContextStrategy : public GLContextStrategy
     {
     public:
-        EGLContextStrategy() = default;
+        // programCachePath enables the persistent program binary cache (EGL_ANDROID_blob_cache)
+        // shareContext renders through one context per display and creating thread, shared by all
+        // strategies that ask for it there, each with its own window surface. Shared surfaces present without waiting
+        // for vsync, since the caller paces the pass over them.
+        explicit EGLContextStrategy(std::optional<std::string> programCachePath = std::nullopt,
+                                    bool shareContext = false);
         ~EGLContextStrategy() override;
 
         void create(JNIEnv *env, jobject canvas) override;
@@ -23,6 +31,7 @@ namespace maplibre_jni
         void makeCurrent() override;
         void releaseCurrent() override;
         void swapBuffers() override;
+        void swapBuffersWithDamage(const std::vector<DamageRect> &rects, uint32_t surfaceHeight) override;
 
         void *getProcAddress(const char *name) override;
 
@@ -30,6 +39,15 @@ namespace maplibre_jni
         void extractNativeHandles(JNIEnv *env, jobject canvas,
                                   void *&nativeDisplay, void *&nativeWindow);
 
+        // Must run before the first context is created on the display
+        void installProgramBinaryCache();
+        void validateProgramBinaryCache();
+
+        std::optional<std::string> programCachePath;
+        bool shareContext = false;
+        // Thread whose shared context this strategy uses
+        std::thread::id sharedThread;
+
         void *nativeDisplay = nullptr;
         void *nativeWindow = nullptr;
 
@@ -42,6 +60,9 @@ namespace maplibre_jni
         EGLContext eglContext = EGL_NO_CONTEXT;
         EGLSurface eglSurface = EGL_NO_SURFACE;
         EGLConfig eglConfig = nullptr;
+
+        // EGL_KHR_swap_buffers_with_damage or the EXT variant, when the display has one
+        PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC swapWithDamage = nullptr;
     };
 
 } // namespace maplibre_jni
@@ -0,0 +1,210 @@
+#include "feature_encoder.hpp"
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        class Writer
+        {
+        public:
+            explicit Writer(std::vector<uint8_t> &out_) : out(out_) {}
+
+            size_t position() const { return out.size(); }
+
+            template <typename T>
+            void put(T value)
+            {
+                const size_t offset = out.size();
+                out.resize(offset + sizeof(T));
+                std::memcpy(out.data() + offset, &value, sizeof(T));
+            }
+
+            template <typename T>
+            void putAt(size_t offset, T value)
+            {
+                std::memcpy(out.data() + offset, &value, sizeof(T));
+            }
+
+            void putString(const std::string &value)
+            {
+                put<int32_t>(static_cast<int32_t>(value.size()));
+                out.insert(out.end(), value.begin(), value.end());
+            }
+
+            void putValue(const mbgl::Value &value)
+            {
+                value.match(
+                    [&](const mapbox::feature::null_value_t &) { put<uint8_t>(FeatureEncoder::VALUE_NULL); },
+                    [&](bool v)
+                    {
+                        put<uint8_t>(FeatureEncoder::VALUE_BOOL);
+                        put<uint8_t>(v ? 1 : 0);
+                    },
+                    [&](uint64_t v)
+                    {
+                        put<uint8_t>(FeatureEncoder::VALUE_UINT);
+                        put<uint64_t>(v);
+                    },
+                    [&](int64_t v)
+                    {
+                        put<uint8_t>(FeatureEncoder::VALUE_INT);
+                        put<int64_t>(v);
+                    },
+                    [&](double v)
+                    {
+                        put<uint8_t>(FeatureEncoder::VALUE_DOUBLE);
+                        put<double>(v);
+                    },
+                    [&](const std::string &v)
+                    {
+                        put<uint8_t>(FeatureEncoder::VALUE_STRING);
+                        putString(v);
+                    },
+                    [&](const mapbox::feature::value::array_ptr_type &array)
+                    {
+                        put<uint8_t>(FeatureEncoder::VALUE_ARRAY);
+                        put<int32_t>(array ? static_cast<int32_t>(array->size()) : 0);
+                        if (array)
+                        {
+                            for (const auto &element : *array)
+                            {
+                                putValue(element);
+                            }
+                        }
+                    },
+                    [&](const mapbox::feature::value::object_ptr_type &object)
+                    {
+                        put<uint8_t>(FeatureEncoder::VALUE_OBJECT);
+                        put<int32_t>(object ? static_cast<int32_t>(object->size()) : 0);
+                        if (object)
+                        {
+                            for (const auto &[key, element] : *object)
+                            {
+                                putString(key);
+                                putValue(element);
+                            }
+                        }
+                    });
+            }
+
+        private:
+            std::vector<uint8_t> &out;
+        };
+
+        // Codes follow the order of the mapbox::geometry::geometry variant
+        struct GeometryTypeVisitor
+        {
+            uint8_t operator()(const mapbox::geometry::empty &) const { return 0; }
+            uint8_t operator()(const mapbox::geometry::point<double> &) const { return 1; }
+            uint8_t operator()(const mapbox::geometry::line_string<double> &) const { return 2; }
+            uint8_t operator()(const mapbox::geometry::polygon<double> &) const { return 3; }
+            uint8_t operator()(const mapbox::geometry::multi_point<double> &) const { return 4; }
+            uint8_t operator()(const mapbox::geometry::multi_line_string<double> &) const { return 5; }
+            uint8_t operator()(const mapbox::geometry::multi_polygon<double> &) const { return 6; }
+            uint8_t operator()(const mapbox::geometry::geometry_collection<double> &) const { return 7; }
+        };
+    } // namespace
+
+    void FeatureEncoder::encode(const std::vector<mbgl::Feature> &features, std::vector<uint8_t> &out)
+    {
+        out.clear();
+        out.resize(HEADER_SIZE + features.size() * FEATURE_RECORD_SIZE);
+
+        Writer writer(out);
+
+        // Features from the same source layer share one source table entry
+        std::unordered_map<std::string, uint16_t> sourceIndices;
+        std::vector<const mbgl::Feature *> sourceEntries;
+
+        for (size_t i = 0; i < features.size(); ++i)
+        {
+            const auto &feature = features[i];
+            const size_t record = HEADER_SIZE + i * FEATURE_RECORD_SIZE;
+
+            // Id
+            uint8_t idType = ID_NULL;
+            int64_t idBits = 0;
+            feature.id.match(
+                [&](const mapbox::feature::null_value_t &) {},
+                [&](uint64_t v)
+                {
+                    idType = ID_UINT;
+                    std::memcpy(&idBits, &v, sizeof(v));
+                },
+                [&](int64_t v)
+                {
+                    idType = ID_INT;
+                    idBits = v;
+                },
+                [&](double v)
+                {
+                    idType = ID_DOUBLE;
+                    std::memcpy(&idBits, &v, sizeof(v));
+                },
+                [&](const std::string &v)
+                {
+                    idType = ID_STRING;
+                    idBits = static_cast<int64_t>(writer.position());
+                    writer.putString(v);
+                });
+
+            // Source table index
+            std::string sourceKey = feature.source;
+            sourceKey.push_back('\0');
+            sourceKey.append(feature.sourceLayer);
+            auto [it, inserted] = sourceIndices.try_emplace(std::move(sourceKey), static_cast<uint16_t>(sourceEntries.size()));
+            if (inserted)
+            {
+                if (sourceEntries.size() > std::numeric_limits<uint16_t>::max())
+                {
+                    throw std::runtime_error("Too many distinct sources in query result");
+                }
+                sourceEntries.push_back(&feature);
+            }
+
+            // Properties
+            const size_t propertiesOffset = writer.position();
+            for (const auto &[key, value] : feature.properties)
+            {
+                writer.putString(key);
+                writer.putValue(value);
+            }
+
+            const uint8_t geometryType = mapbox::util::apply_visitor(GeometryTypeVisitor{}, feature.geometry);
+
+            writer.putAt<int64_t>(record, idBits);
+            writer.putAt<int32_t>(record + 8, static_cast<int32_t>(propertiesOffset));
+            writer.putAt<int32_t>(record + 12, static_cast<int32_t>(feature.properties.size()));
+            writer.putAt<uint16_t>(record + 16, it->second);
+            writer.putAt<uint8_t>(record + 18, idType);
+            writer.putAt<uint8_t>(record + 19, geometryType);
+            writer.putAt<int32_t>(record + 20, 0);
+        }
+
+        // Source table
+        const size_t sourceTableOffset = writer.position();
+        for (const auto *feature : sourceEntries)
+        {
+            writer.putString(feature->source);
+            writer.putString(feature->sourceLayer);
+        }
+
+        if (out.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max()))
+        {
+            throw std::runtime_error("Query result too large to encode");
+        }
+
+        // Header
+        writer.putAt<int32_t>(0, static_cast<int32_t>(features.size()));
+        writer.putAt<int32_t>(4, static_cast<int32_t>(sourceEntries.size()));
+        writer.putAt<int32_t>(8, static_cast<int32_t>(sourceTableOffset));
+        writer.putAt<int32_t>(12, 0);
+    }
+
+} // namespace maplibre_jni
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <mbgl/util/feature.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace maplibre_jni
+{
+
+    // Encodes query results into the compact binary layout read by FeatureQueryResult.kt
+    //
+    // All values use native byte order. Offsets are absolute from the start of the buffer.
+    //
+    //   header   : i32 featureCount, i32 sourceCount, i32 sourceTableOffset, i32 reserved
+    //   records  : featureCount fixed-size records (see FEATURE_RECORD_SIZE)
+    //                i64 id (integer, double bits, or string offset depending on idType)
+    //                i32 propertiesOffset, i32 propertyCount
+    //                u16 sourceIndex, u8 idType, u8 geometryType, i32 reserved
+    //   data     : strings (i32 byteLength + UTF-8) and properties (key string + tagged value)
+    //   sources  : sourceCount pairs of strings (source, sourceLayer)
+    class FeatureEncoder
+    {
+    public:
+        static constexpr size_t HEADER_SIZE = 16;
+        static constexpr size_t FEATURE_RECORD_SIZE = 24;
+
+        enum IdType : uint8_t
+        {
+            ID_NULL = 0,
+            ID_UINT = 1,
+            ID_INT = 2,
+            ID_DOUBLE = 3,
+            ID_STRING = 4,
+        };
+
+        enum ValueTag : uint8_t
+        {
+            VALUE_NULL = 0,
+            VALUE_BOOL = 1,
+            VALUE_UINT = 2,
+            VALUE_INT = 3,
+            VALUE_DOUBLE = 4,
+            VALUE_STRING = 5,
+            VALUE_ARRAY = 6,
+            VALUE_OBJECT = 7,
+        };
+
+        // Encode the features into out, replacing its contents
+        // The vector's capacity is kept so repeated queries do not reallocate
+        static void encode(const std::vector<mbgl::Feature> &features, std::vector<uint8_t> &out);
+    };
+
+} // namespace maplibre_jni
@@ -0,0 +1,159 @@
+#include "file_sources.hpp"
+#include "archive_asset_source.hpp"
+#include "compressed_cache_source.hpp"
+#include "jvm_file_source.hpp"
+#include "prioritized_request_source.hpp"
+#include "resource_context.hpp"
+#include "session_log.hpp"
+#include "session_recorder_source.hpp"
+#include "shared_response_source.hpp"
+#include "style_bundle_source.hpp"
+#include "url_rewrite_source.hpp"
+#include "write_behind_cache_source.hpp"
+#include <mbgl/storage/file_source_manager.hpp>
+#include <mbgl/util/logging.hpp>
+#include <mutex>
+
+namespace maplibre_jni
+{
+
+    void installFileSources()
+    {
+        static std::once_flag installed;
+        std::call_once(installed, []
+                       {
+                           auto *manager = mbgl::FileSourceManager::get();
+
+                           // The resource loader reaches the network through the manager, so
+                           // its requests pass through the priority queue. Maps whose
+                           // ResourceOptions carry a JvmFileSource fetch through it instead, and
+                           // URL rewrite rules apply to whichever source fetches.
+                           auto network = manager->unRegisterFileSourceFactory(mbgl::FileSourceType::Network);
+                           if (network)
+                           {
+                               manager->registerFileSourceFactory(
+                                   mbgl::FileSourceType::Network,
+                                   [network](const mbgl::ResourceOptions &resourceOptions, const mbgl::ClientOptions &clientOptions)
+                                       -> std::unique_ptr<mbgl::FileSource>
+                                   {
+                                       const auto *context = ResourceContext::find(resourceOptions.platformContext());
+
+                                       std::unique_ptr<mbgl::FileSource> upstream;
+                                       auto channel = context ? JvmFileSource::channelFor(context->fileSource) : nullptr;
+                                       if (channel)
+                                       {
+                                           upstream = std::make_unique<JvmFileSource>(std::move(channel), resourceOptions, clientOptions);
+                                       }
+                                       else
+                                       {
+                                           upstream = network(resourceOptions, clientOptions);
+                                       }
+                                       if (!upstream)
+                                       {
+                                           return nullptr;
+                                       }
+                                       if (context && context->urlRewriter)
+                                       {
+                                           upstream = std::make_unique<UrlRewriteSource>(std::move(upstream), context->urlRewriter);
+                                       }
+                                       return std::make_unique<PrioritizedRequestSource>(std::move(upstream), resourceOptions.platformContext());
+                                   });
+                           }
+
+                           // Maps with the same ResourceOptions share one resource loader, so
+                           // wrapping it shares requests between them. With recordSession,
+                           // each map's requests are logged before they are shared.
+                           auto resourceLoader = manager->unRegisterFileSourceFactory(mbgl::FileSourceType::ResourceLoader);
+                           if (resourceLoader)
+                           {
+                               manager->registerFileSourceFactory(
+                                   mbgl::FileSourceType::ResourceLoader,
+                                   [resourceLoader](const mbgl::ResourceOptions &resourceOptions, const mbgl::ClientOptions &clientOptions)
+                                       -> std::unique_ptr<mbgl::FileSource>
+                                   {
+                                       auto upstream = resourceLoader(resourceOptions, clientOptions);
+                                       if (!upstream)
+                                       {
+                                           return nullptr;
+                                       }
+                                       upstream = std::make_unique<SharedResponseSource>(std::move(upstream));
+
+                                       const auto *context = ResourceContext::find(resourceOptions.platformContext());
+                                       const auto &cachePath = resourceOptions.cachePath();
+                                       if (context && context->recordSession && !cachePath.empty() && cachePath != ":memory:")
+                                       {
+                                           upstream = std::make_unique<SessionRecorderSource>(std::move(upstream), SessionLog::pathFor(cachePath));
+                                       }
+                                       return upstream;
+                                   });
+                           }
+
+                           // Maps with ambient cache settings get them applied to the database
+                           // before mbgl opens it, and their cache writes compressed and queued;
+                           // writes are compressed as the queue hands them to the database. Every
+                           // map decodes compressed entries, since the cache file may be shared.
+                           auto database = manager->unRegisterFileSourceFactory(mbgl::FileSourceType::Database);
+                           if (database)
+                           {
+                               manager->registerFileSourceFactory(
+                                   mbgl::FileSourceType::Database,
+                                   [database](const mbgl::ResourceOptions &resourceOptions, const mbgl::ClientOptions &clientOptions)
+                                       -> std::unique_ptr<mbgl::FileSource>
+                                   {
+                                       const auto *context = ResourceContext::find(resourceOptions.platformContext());
+                                       if (context && context->ambientCache)
+                                       {
+                                           WriteBehindCacheSource::prepareDatabase(resourceOptions.cachePath(), *context->ambientCache);
+                                       }
+                                       auto upstream = database(resourceOptions, clientOptions);
+                                       if (!upstream)
+                                       {
+                                           return nullptr;
+                                       }
+                                       upstream = std::make_unique<CompressedCacheSource>(
+                                           std::move(upstream), context ? context->cacheCompression : std::nullopt);
+                                       if (context && context->ambientCache && context->ambientCache->writeBehind)
+                                       {
+                                           upstream = std::make_unique<WriteBehindCacheSource>(std::move(upstream), *context->ambientCache);
+                                       }
+                                       return upstream;
+                                   });
+                           }
+
+                           // Asset paths naming a JAR or ZIP archive are served from the archive
+                           // in place; directories are left to mbgl's asset source. Entries of
+                           // open style bundles are served whatever the asset path.
+                           auto asset = manager->unRegisterFileSourceFactory(mbgl::FileSourceType::Asset);
+                           if (asset)
+                           {
+                               manager->registerFileSourceFactory(
+                                   mbgl::FileSourceType::Asset,
+                                   [asset](const mbgl::ResourceOptions &resourceOptions, const mbgl::ClientOptions &clientOptions)
+                                       -> std::unique_ptr<mbgl::FileSource>
+                                   {
+                                       std::unique_ptr<mbgl::FileSource> upstream;
+                                       if (auto location = ArchiveAssetSource::parseAssetPath(resourceOptions.assetPath()))
+                                       {
+                                           try
+                                           {
+                                               upstream = std::make_unique<ArchiveAssetSource>(*location, resourceOptions, clientOptions);
+                                           }
+                                           catch (const std::exception &e)
+                                           {
+                                               mbgl::Log::Error(mbgl::Event::General, std::string("Could not open asset archive: ") + e.what());
+                                           }
+                                       }
+                                       if (!upstream)
+                                       {
+                                           upstream = asset(resourceOptions, clientOptions);
+                                       }
+                                       if (!upstream)
+                                       {
+                                           return nullptr;
+                                       }
+                                       return std::make_unique<StyleBundleSource>(std::move(upstream));
+                                   });
+                           } });
+    }
+
+} // namespace maplibre_jni
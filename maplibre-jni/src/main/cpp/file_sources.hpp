@@ -0,0 +1,12 @@
+#pragma once
+
+namespace maplibre_jni
+{
+
+    // Register the binding's file source layers with mbgl's FileSourceManager
+    //
+    // Must run before the first Map is created, since FileSourceManager caches the sources it
+    // builds. Safe to call more than once; only the first call has an effect.
+    void installFileSources();
+
+} // namespace maplibre_jni
@@ -0,0 +1,75 @@
+#include "frame_budget.hpp"
+#include <algorithm>
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        constexpr double SMOOTHING = 0.2;
+
+        // Leave the over-budget state only once frames are clearly back under the target
+        constexpr double RECOVERY_FACTOR = 0.8;
+
+        // Longest a deferrable frame waits, so new tiles and fades still show up promptly
+        constexpr int MAX_DEFERRED_TICKS = 2;
+
+        double smooth(double average, double value, uint64_t count)
+        {
+            return count == 1 ? value : average * (1.0 - SMOOTHING) + value * SMOOTHING;
+        }
+    } // namespace
+
+    void FrameBudgetGovernor::setTargetFrameMs(double targetFrameMs_)
+    {
+        targetFrameMs = std::max(0.0, targetFrameMs_);
+        overBudget = false;
+        lastFrameOverBudget = false;
+    }
+
+    bool FrameBudgetGovernor::shouldRenderDeferrable()
+    {
+        if (targetFrameMs <= 0 || (!lastFrameOverBudget && !overBudget) || deferredInRow >= MAX_DEFERRED_TICKS)
+        {
+            return true;
+        }
+        deferredInRow++;
+        stats.deferredFrames++;
+        return false;
+    }
+
+    void FrameBudgetGovernor::addFrameTime(double frameMs)
+    {
+        stats.renderedFrames++;
+        stats.lastFrameMs = frameMs;
+        stats.averageFrameMs = smooth(stats.averageFrameMs, frameMs, stats.renderedFrames);
+
+        if (deferredInRow > 0)
+        {
+            stats.batchedFrames++;
+            stats.averageBatchedFrameMs = smooth(stats.averageBatchedFrameMs, frameMs, stats.batchedFrames);
+            deferredInRow = 0;
+        }
+
+        if (targetFrameMs <= 0)
+        {
+            return;
+        }
+
+        lastFrameOverBudget = frameMs > targetFrameMs;
+        if (lastFrameOverBudget)
+        {
+            stats.overBudgetFrames++;
+        }
+
+        if (stats.averageFrameMs > targetFrameMs)
+        {
+            overBudget = true;
+        }
+        else if (stats.averageFrameMs < targetFrameMs * RECOVERY_FACTOR)
+        {
+            overBudget = false;
+        }
+    }
+
+} // namespace maplibre_jni
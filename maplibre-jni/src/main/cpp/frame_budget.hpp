@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+namespace maplibre_jni
+{
+
+    // Tracks frame times against a time budget and decides when deferrable frames may render
+    //
+    // A frame that only shows newly loaded tiles or continues a fade may wait a few ticks while
+    // frames run over budget, so the tile uploads of several ticks land in one frame. The frame
+    // that renders held-back work is counted as a batched frame, so callers can check that
+    // batching saves more time than the longer frame costs.
+    class FrameBudgetGovernor
+    {
+    public:
+        struct Stats
+        {
+            uint64_t renderedFrames = 0;
+            // Ticks where a deferrable frame was held back
+            uint64_t deferredFrames = 0;
+            // Rendered frames that included held-back work
+            uint64_t batchedFrames = 0;
+            uint64_t overBudgetFrames = 0;
+            double lastFrameMs = 0;
+            double averageFrameMs = 0;
+            double averageBatchedFrameMs = 0;
+        };
+
+        // Target time per frame; 0 disables the budget
+        void setTargetFrameMs(double targetFrameMs);
+        double getTargetFrameMs() const { return targetFrameMs; }
+
+        // Whether a frame that only shows new tiles or a fade should render on this tick
+        bool shouldRenderDeferrable();
+
+        void addFrameTime(double frameMs);
+
+        // True while the average frame time is over budget
+        bool isOverBudget() const { return overBudget; }
+
+        Stats getStats() const { return stats; }
+
+    private:
+        double targetFrameMs = 0;
+        bool overBudget = false;
+        bool lastFrameOverBudget = false;
+        int deferredInRow = 0;
+        Stats stats;
+    };
+
+} // namespace maplibre_jni
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "damage_tracker.hpp"
 #include <jni.h>
+#include <vector>
 
 namespace maplibre_jni
 {
@@ -20,6 +22,15 @@ namespace maplibre_jni
         virtual void releaseCurrent() = 0;
         virtual void swapBuffers() = 0;
 
+        // Swap telling the compositor only these regions changed (top-left origin, surface
+        // height needed to flip them); platforms without damage support swap everything
+        virtual void swapBuffersWithDamage(const std::vector<DamageRect> &rects, uint32_t surfaceHeight)
+        {
+            (void)rects;
+            (void)surfaceHeight;
+            swapBuffers();
+        }
+
         // GL function loading
         virtual void *getProcAddress(const char *name) = 0;
     };
@@ -10,6 +10,9 @@ namespace maplibre_jni
     class GLXContextStrategy : public GLContextStrategy
     {
     public:
+        // GLX has no blob cache hook, so compiled programs are left to Mesa's own shader
+        // cache. Its location is read from MESA_SHADER_CACHE_DIR when the driver loads; set
+        // it in the environment before the process starts to keep it next to the ambient cache.
         GLXContextStrategy() = default;
         ~GLXContextStrategy() override;
 
@@ -0,0 +1,186 @@
+#include "org_maplibre_kmp_native_HeadlessMaplibreMap.h"
+#include "jni_helpers.hpp"
+
+#ifdef USE_VULKAN_BACKEND
+#include "headless_renderer.hpp"
+#include "headless_vulkan_backend.hpp"
+#include "vulkan_readback_ring.hpp"
+#include "map_observer.hpp"
+#include "awt_backend_factory.hpp"
+#include "file_sources.hpp"
+#include "worker_pool.hpp"
+#include "conversions/size_conversions.hpp"
+#include "conversions/cameraoptions_conversions.hpp"
+#include "conversions/mapoptions_conversions.hpp"
+#include "conversions/clientoptions_conversions.hpp"
+#include "conversions/resourceoptions_conversions.hpp"
+#include <mbgl/map/map.hpp>
+#include <mbgl/map/map_options.hpp>
+#include <mbgl/storage/resource_options.hpp>
+#include <mbgl/style/style.hpp>
+#include <mbgl/util/client_options.hpp>
+#include <memory>
+
+// Owns a map rendered without a Canvas; see MapWrapper in maplibre_map.cpp
+struct HeadlessMapWrapper
+{
+    // Declared first so it is destroyed last, after the Map that renders through it
+    std::unique_ptr<maplibre_jni::HeadlessRenderer> renderer;
+    std::unique_ptr<maplibre_jni::JniMapObserver> observer;
+    std::unique_ptr<mbgl::Map> map;
+};
+#endif
+
+extern "C"
+{
+
+    JNIEXPORT jboolean JNICALL Java_org_maplibre_kmp_native_HeadlessMaplibreMap_nativeIsSupported(JNIEnv *env, jclass)
+    {
+#ifdef USE_VULKAN_BACKEND
+        return JNI_TRUE;
+#else
+        return JNI_FALSE;
+#endif
+    }
+
+    JNIEXPORT jlong JNICALL Java_org_maplibre_kmp_native_HeadlessMaplibreMap_nativeNew(JNIEnv *env, jclass, jint width, jint height, jfloat pixelRatio, jobject mapObserverObj, jobject mapOptionsObj, jobject resourceOptionsObj, jobject clientOptionsObj)
+    {
+#ifdef USE_VULKAN_BACKEND
+        try
+        {
+            maplibre_jni::installFileSources();
+
+            mbgl::ResourceOptions resourceOptions = maplibre_jni::ResourceOptionsConversions::extract(env, resourceOptionsObj);
+            mbgl::MapOptions mapOptions = maplibre_jni::MapOptionsConversions::extract(env, mapOptionsObj);
+            mbgl::ClientOptions clientOptions = maplibre_jni::ClientOptionsConversions::extract(env, clientOptionsObj);
+
+            std::shared_ptr<mbgl::Scheduler> workerPool;
+            if (auto workerPoolOptions = maplibre_jni::MapOptionsConversions::extractWorkerPool(env, mapOptionsObj))
+            {
+                workerPool = maplibre_jni::acquireWorkerPool(*workerPoolOptions);
+            }
+
+            auto wrapper = std::make_unique<HeadlessMapWrapper>();
+            wrapper->renderer = maplibre_jni::HeadlessRenderer::create(
+                width, height, pixelRatio, std::nullopt, maplibre_jni::shaderCachePathFor(resourceOptions), std::move(workerPool));
+            wrapper->observer = std::make_unique<maplibre_jni::JniMapObserver>(env, mapObserverObj);
+            wrapper->map = std::make_unique<mbgl::Map>(
+                *wrapper->renderer,
+                *wrapper->observer,
+                mapOptions,
+                resourceOptions,
+                clientOptions);
+
+            return toJavaPointer(wrapper.release());
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+            return 0;
+        }
+#else
+        throwJavaException(env, "java/lang/UnsupportedOperationException",
+                           "Headless rendering requires the Vulkan backend");
+        return 0;
+#endif
+    }
+
+#ifdef USE_VULKAN_BACKEND
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_HeadlessMaplibreMap_nativeDestroy(JNIEnv *env, jclass, jlong ptr)
+    {
+        delete fromJavaPointer<HeadlessMapWrapper>(ptr);
+    }
+
+    JNIEXPORT jboolean JNICALL Java_org_maplibre_kmp_native_HeadlessMaplibreMap_nativeTick(JNIEnv *env, jclass, jlong ptr)
+    {
+        try
+        {
+            auto *wrapper = fromJavaPointer<HeadlessMapWrapper>(ptr);
+            return wrapper->renderer->tick() ? JNI_TRUE : JNI_FALSE;
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+            return JNI_FALSE;
+        }
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_HeadlessMaplibreMap_nativeSetSize(JNIEnv *env, jclass, jlong ptr, jobject size)
+    {
+        try
+        {
+            auto *wrapper = fromJavaPointer<HeadlessMapWrapper>(ptr);
+            mbgl::Size mbglSize = maplibre_jni::SizeConversions::extract(env, size);
+            wrapper->map->setSize(mbglSize);
+            wrapper->renderer->updateSize(mbglSize.width, mbglSize.height);
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+        }
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_HeadlessMaplibreMap_nativeLoadStyleURL(JNIEnv *env, jclass, jlong ptr, jstring jUrl)
+    {
+        auto *wrapper = fromJavaPointer<HeadlessMapWrapper>(ptr);
+        wrapper->map->getStyle().loadURL(jstringToString(env, jUrl));
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_HeadlessMaplibreMap_nativeLoadStyleJSON(JNIEnv *env, jclass, jlong ptr, jstring jJson)
+    {
+        auto *wrapper = fromJavaPointer<HeadlessMapWrapper>(ptr);
+        wrapper->map->getStyle().loadJSON(jstringToString(env, jJson));
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_HeadlessMaplibreMap_nativeJumpTo(JNIEnv *env, jclass, jlong ptr, jobject cameraOptions)
+    {
+        auto *wrapper = fromJavaPointer<HeadlessMapWrapper>(ptr);
+        mbgl::CameraOptions options = maplibre_jni::CameraOptionsConversions::extract(env, cameraOptions);
+        wrapper->map->jumpTo(options);
+    }
+
+    JNIEXPORT jint JNICALL Java_org_maplibre_kmp_native_HeadlessMaplibreMap_nativeReadPixels(JNIEnv *env, jclass, jlong ptr, jobject buffer)
+    {
+        try
+        {
+            auto *wrapper = fromJavaPointer<HeadlessMapWrapper>(ptr);
+            auto *dst = static_cast<uint8_t *>(env->GetDirectBufferAddress(buffer));
+            if (!dst)
+            {
+                throwJavaException(env, "java/lang/IllegalArgumentException", "Buffer must be a direct ByteBuffer");
+                return 0;
+            }
+            const auto capacity = static_cast<size_t>(env->GetDirectBufferCapacity(buffer));
+            return static_cast<jint>(wrapper->renderer->readPixels(dst, capacity));
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+            return 0;
+        }
+    }
+
+    JNIEXPORT jobject JNICALL Java_org_maplibre_kmp_native_HeadlessMaplibreMap_nativeAcquireFrame(JNIEnv *env, jclass, jlong ptr, jlongArray info)
+    {
+        try
+        {
+            auto *wrapper = fromJavaPointer<HeadlessMapWrapper>(ptr);
+            return maplibre_jni::acquireFrameForJava(env, wrapper->renderer->getBackend()->getReadback(), info);
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+            return nullptr;
+        }
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_HeadlessMaplibreMap_nativeReleaseFrame(JNIEnv *env, jclass, jlong ptr, jint slot, jlong number)
+    {
+        auto *wrapper = fromJavaPointer<HeadlessMapWrapper>(ptr);
+        wrapper->renderer->getBackend()->getReadback().release(static_cast<uint32_t>(slot), static_cast<uint64_t>(number));
+    }
+
+#endif // USE_VULKAN_BACKEND
+
+} // extern "C"
@@ -0,0 +1,237 @@
+#ifdef USE_VULKAN_BACKEND
+
+#include "headless_renderer.hpp"
+#include "headless_vulkan_backend.hpp"
+#include "renderer_host.hpp"
+
+#include <mbgl/actor/scheduler.hpp>
+#include <mbgl/gfx/backend_scope.hpp>
+#include <mbgl/renderer/renderer.hpp>
+#include <mbgl/renderer/renderer_observer.hpp>
+#include <mbgl/renderer/update_parameters.hpp>
+#include <mbgl/util/logging.hpp>
+#include <mbgl/util/run_loop.hpp>
+
+#include <atomic>
+
+namespace maplibre_jni
+{
+
+    class HeadlessRenderer::Impl : public mbgl::RendererObserver
+    {
+    public:
+        Impl(int width,
+             int height,
+             float pixelRatio,
+             const std::optional<std::string> &localFontFamily,
+             const std::optional<std::string> &shaderCachePath,
+             std::shared_ptr<mbgl::Scheduler> workerPool)
+            : host(RendererHost::forCurrentThread()),
+              backend(std::make_unique<HeadlessVulkanBackend>(
+                  mbgl::Size{static_cast<uint32_t>(width), static_cast<uint32_t>(height)}, shaderCachePath))
+        {
+            if (workerPool)
+            {
+                backend->setWorkerPool(std::move(workerPool));
+            }
+            renderer = std::make_unique<mbgl::Renderer>(*backend, pixelRatio, localFontFamily);
+            renderer->setObserver(this);
+
+            mbgl::Log::Info(mbgl::Event::General, "HeadlessRenderer initialized");
+        }
+
+        ~Impl()
+        {
+            // Clean up in reverse order
+            renderer.reset();
+            backend.reset();
+            host.reset();
+        }
+
+        bool tick()
+        {
+            host->getRunLoop().runOnce();
+
+            if (dirty.exchange(false))
+            {
+                mbgl::gfx::BackendScope scope(*backend);
+                if (updateParameters)
+                {
+                    renderer->render(updateParameters);
+                    backend->captureFrame();
+                    frameCount++;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        void updateSize(int width, int height)
+        {
+            backend->setSize(mbgl::Size{static_cast<uint32_t>(width), static_cast<uint32_t>(height)});
+            dirty = true;
+        }
+
+        size_t readPixels(uint8_t *dst, size_t capacity)
+        {
+            return backend->readPixels(dst, capacity);
+        }
+
+        void reset()
+        {
+            renderer.reset();
+        }
+
+        void setObserver(mbgl::RendererObserver &observer)
+        {
+            externalObserver = &observer;
+        }
+
+        void update(std::shared_ptr<mbgl::UpdateParameters> parameters)
+        {
+            updateParameters = std::move(parameters);
+            dirty = true;
+        }
+
+        const mbgl::TaggedScheduler &getThreadPool() const
+        {
+            return backend->getThreadPool();
+        }
+
+        HeadlessVulkanBackend *getBackend()
+        {
+            return backend.get();
+        }
+
+        mbgl::Renderer *getRenderer()
+        {
+            return renderer.get();
+        }
+
+        uint64_t getFrameCount() const
+        {
+            return frameCount;
+        }
+
+        // RendererObserver implementation
+        void onInvalidate() override
+        {
+            dirty = true;
+            if (externalObserver)
+            {
+                externalObserver->onInvalidate();
+            }
+        }
+
+        void onResourceError(std::exception_ptr err) override
+        {
+            if (externalObserver)
+            {
+                externalObserver->onResourceError(err);
+            }
+        }
+
+        void onDidFinishRenderingFrame(RenderMode mode, bool repaintNeeded, bool placementChanged, const mbgl::gfx::RenderingStats &stats) override
+        {
+            if (repaintNeeded)
+            {
+                dirty = true;
+            }
+            if (externalObserver)
+            {
+                externalObserver->onDidFinishRenderingFrame(mode, repaintNeeded, placementChanged, stats);
+            }
+        }
+
+        void onStyleImageMissing(const std::string &image, const StyleImageMissingCallback &callback) override
+        {
+            if (externalObserver)
+            {
+                externalObserver->onStyleImageMissing(image, callback);
+            }
+        }
+
+    private:
+        // Owns the RunLoop shared with the other maps on this thread
+        std::shared_ptr<RendererHost> host;
+        std::unique_ptr<HeadlessVulkanBackend> backend;
+        std::unique_ptr<mbgl::Renderer> renderer;
+
+        std::atomic<bool> dirty{false};
+        uint64_t frameCount = 0;
+        std::shared_ptr<mbgl::UpdateParameters> updateParameters;
+
+        mbgl::RendererObserver *externalObserver = nullptr;
+    };
+
+    HeadlessRenderer::HeadlessRenderer() = default;
+
+    HeadlessRenderer::~HeadlessRenderer() = default;
+
+    std::unique_ptr<HeadlessRenderer> HeadlessRenderer::create(
+        int width,
+        int height,
+        float pixelRatio,
+        const std::optional<std::string> &localFontFamily,
+        const std::optional<std::string> &shaderCachePath,
+        std::shared_ptr<mbgl::Scheduler> workerPool)
+    {
+        auto renderer = std::unique_ptr<HeadlessRenderer>(new HeadlessRenderer());
+        renderer->impl = std::make_unique<Impl>(width, height, pixelRatio, localFontFamily, shaderCachePath, std::move(workerPool));
+        return renderer;
+    }
+
+    bool HeadlessRenderer::tick()
+    {
+        return impl->tick();
+    }
+
+    void HeadlessRenderer::updateSize(int width, int height)
+    {
+        impl->updateSize(width, height);
+    }
+
+    size_t HeadlessRenderer::readPixels(uint8_t *dst, size_t capacity)
+    {
+        return impl->readPixels(dst, capacity);
+    }
+
+    void HeadlessRenderer::reset()
+    {
+        impl->reset();
+    }
+
+    void HeadlessRenderer::setObserver(mbgl::RendererObserver &observer)
+    {
+        impl->setObserver(observer);
+    }
+
+    void HeadlessRenderer::update(std::shared_ptr<mbgl::UpdateParameters> parameters)
+    {
+        impl->update(std::move(parameters));
+    }
+
+    const mbgl::TaggedScheduler &HeadlessRenderer::getThreadPool() const
+    {
+        return impl->getThreadPool();
+    }
+
+    HeadlessVulkanBackend *HeadlessRenderer::getBackend()
+    {
+        return impl->getBackend();
+    }
+
+    mbgl::Renderer *HeadlessRenderer::getRenderer()
+    {
+        return impl->getRenderer();
+    }
+
+    uint64_t HeadlessRenderer::getFrameCount() const
+    {
+        return impl->getFrameCount();
+    }
+
+} // namespace maplibre_jni
+
+#endif // USE_VULKAN_BACKEND
@@ -0,0 +1,68 @@
+#pragma once
+
+#ifdef USE_VULKAN_BACKEND
+
+#include <mbgl/actor/scheduler.hpp>
+#include <mbgl/renderer/renderer_frontend.hpp>
+#include <mbgl/util/size.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace mbgl {
+class Renderer;
+}
+
+namespace maplibre_jni {
+
+class HeadlessVulkanBackend;
+
+// Renderer frontend for maps without a Canvas
+// Frames are rendered offscreen by HeadlessVulkanBackend and read back through its staging ring.
+// All calls must come from the thread that created it, which owns the RunLoop.
+class HeadlessRenderer : public mbgl::RendererFrontend {
+public:
+    static std::unique_ptr<HeadlessRenderer> create(
+        int width,
+        int height,
+        float pixelRatio,
+        const std::optional<std::string>& localFontFamily = std::nullopt,
+        const std::optional<std::string>& shaderCachePath = std::nullopt,
+        // Pool tiles are parsed on; null uses mbgl's background pool
+        std::shared_ptr<mbgl::Scheduler> workerPool = nullptr
+    );
+
+    ~HeadlessRenderer() override;
+
+    // Process events and render if needed
+    // Returns true if a frame was rendered and queued for readback
+    bool tick();
+
+    void updateSize(int width, int height);
+
+    // Copy the latest frame (RGBA8, premultiplied) into dst if it fits; returns its size in bytes
+    size_t readPixels(uint8_t* dst, size_t capacity);
+
+    // RendererFrontend implementation
+    void reset() override;
+    void setObserver(mbgl::RendererObserver& observer) override;
+    void update(std::shared_ptr<mbgl::UpdateParameters> parameters) override;
+    const mbgl::TaggedScheduler& getThreadPool() const override;
+
+    HeadlessVulkanBackend* getBackend();
+    mbgl::Renderer* getRenderer();
+    uint64_t getFrameCount() const;
+
+protected:
+    HeadlessRenderer();
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+} // namespace maplibre_jni
+
+#endif // USE_VULKAN_BACKEND
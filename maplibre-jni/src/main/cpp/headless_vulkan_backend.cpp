@@ -0,0 +1,98 @@
+#ifdef USE_VULKAN_BACKEND
+
+#include "headless_vulkan_backend.hpp"
+#include "vulkan_pipeline_cache.hpp"
+#include "vulkan_readback_ring.hpp"
+#include <mbgl/vulkan/context.hpp>
+#include <mbgl/util/logging.hpp>
+
+namespace
+{
+    // Without a platform surface SurfaceRenderableResource allocates its own RGBA8 color images
+    // and its render pass leaves them in TRANSFER_SRC_OPTIMAL, ready to be copied
+    class HeadlessVulkanRenderableResource final : public mbgl::vulkan::SurfaceRenderableResource
+    {
+    public:
+        explicit HeadlessVulkanRenderableResource(maplibre_jni::HeadlessVulkanBackend &backend_)
+            : mbgl::vulkan::SurfaceRenderableResource(backend_) {}
+
+        void createPlatformSurface() override
+        {
+            // Intentionally empty: no VkSurfaceKHR
+        }
+
+        void bind() override {}
+
+        std::vector<const char *> getDeviceExtensions() override
+        {
+            return {};
+        }
+    };
+} // namespace
+
+namespace maplibre_jni
+{
+
+    HeadlessVulkanBackend::HeadlessVulkanBackend(mbgl::Size size_, const std::optional<std::string> &shaderCachePath)
+        : mbgl::vulkan::RendererBackend(mbgl::gfx::ContextMode::Unique),
+          mbgl::vulkan::Renderable(size_, std::make_unique<HeadlessVulkanRenderableResource>(*this))
+    {
+        init();
+
+        if (shaderCachePath)
+        {
+            pipelineCache = std::make_unique<VulkanPipelineCache>(
+                *shaderCachePath + "/vulkan_pipelines.bin", getDeviceProperties(), getDevice().get(), dispatcher);
+            pipelineCache->install(dispatcher);
+        }
+
+        readback = std::make_unique<VulkanReadbackRing>(*this, READBACK_SLOTS);
+
+        mbgl::Log::Info(mbgl::Event::General, "Headless Vulkan backend initialized on " +
+                                                  std::string(getDeviceProperties().deviceName.data()));
+    }
+
+    HeadlessVulkanBackend::~HeadlessVulkanBackend()
+    {
+        // Staging buffers and the pipeline cache must go before the device the base class destroys
+        readback.reset();
+        if (pipelineCache)
+        {
+            pipelineCache->save();
+            pipelineCache->uninstall(dispatcher);
+            pipelineCache.reset();
+        }
+    }
+
+    mbgl::gfx::Renderable &HeadlessVulkanBackend::getDefaultRenderable()
+    {
+        return *this;
+    }
+
+    void HeadlessVulkanBackend::setSize(mbgl::Size newSize)
+    {
+        size = newSize;
+
+        if (context)
+        {
+            auto &contextImpl = static_cast<mbgl::vulkan::Context &>(*context);
+            contextImpl.requestSurfaceUpdate();
+        }
+    }
+
+    void HeadlessVulkanBackend::captureFrame()
+    {
+        VulkanReadbackRing::Capture capture;
+        capture.image = getResource<HeadlessVulkanRenderableResource>().getAcquiredImage();
+        capture.size = size;
+        readback->capture(capture);
+    }
+
+    size_t HeadlessVulkanBackend::readPixels(uint8_t *dst, size_t capacity)
+    {
+        return readback->readLatest(dst, capacity);
+    }
+
+} // namespace maplibre_jni
+
+#endif // USE_VULKAN_BACKEND
@@ -0,0 +1,64 @@
+#pragma once
+
+#ifdef USE_VULKAN_BACKEND
+
+#include <mbgl/vulkan/renderable_resource.hpp>
+#include <mbgl/vulkan/renderer_backend.hpp>
+#include <mbgl/util/size.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace maplibre_jni
+{
+
+    class VulkanPipelineCache;
+    class VulkanReadbackRing;
+
+    // Vulkan backend that renders into device-local offscreen images instead of a window surface
+    //
+    // No VkSurfaceKHR or swapchain is created, so it runs without a display (e.g. lavapipe in
+    // batch workers). Every rendered frame is copied into a host-visible staging ring.
+    class HeadlessVulkanBackend final : public mbgl::vulkan::RendererBackend,
+                                        public mbgl::vulkan::Renderable
+    {
+    public:
+        static constexpr uint32_t READBACK_SLOTS = 3;
+
+        HeadlessVulkanBackend(mbgl::Size size, const std::optional<std::string> &shaderCachePath = std::nullopt);
+        ~HeadlessVulkanBackend() override;
+
+        // mbgl::gfx::RendererBackend implementation
+        mbgl::gfx::Renderable &getDefaultRenderable() override;
+
+        void setSize(mbgl::Size size);
+        mbgl::Size getSize() const { return size; }
+
+        void setWorkerPool(std::shared_ptr<mbgl::Scheduler> pool)
+        {
+            threadPool = mbgl::TaggedScheduler(std::move(pool), mbgl::util::SimpleIdentity{});
+        }
+
+        // Queue a copy of the frame that was just rendered
+        void captureFrame();
+
+        // Copy the latest captured frame into dst if it fits; returns its size in bytes
+        size_t readPixels(uint8_t *dst, size_t capacity);
+
+        VulkanReadbackRing &getReadback() { return *readback; }
+
+    protected:
+        // mbgl::vulkan::RendererBackend overrides
+        void activate() override {}
+        void deactivate() override {}
+
+    private:
+        std::unique_ptr<VulkanPipelineCache> pipelineCache;
+        std::unique_ptr<VulkanReadbackRing> readback;
+    };
+
+} // namespace maplibre_jni
+
+#endif // USE_VULKAN_BACKEND
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <jni.h>
+#include <optional>
 #include <string>
+#include <vector>
 
 template<typename T>
 inline T* fromJavaPointer(jlong ptr) {
@@ -18,4 +20,30 @@ inline void throwJavaException(JNIEnv* env, const char* className, const std::st
     if (exClass != nullptr) {
         env->ThrowNew(exClass, msg.c_str());
     }
-}
\ No newline at end of file
+}
+
+inline std::string jstringToString(JNIEnv* env, jstring str) {
+    if (str == nullptr) {
+        return {};
+    }
+    const char* chars = env->GetStringUTFChars(str, nullptr);
+    std::string result(chars);
+    env->ReleaseStringUTFChars(str, chars);
+    return result;
+}
+
+// Converts a nullable String[] to an optional vector (null stays nullopt)
+inline std::optional<std::vector<std::string>> jstringArrayToVector(JNIEnv* env, jobjectArray array) {
+    if (array == nullptr) {
+        return std::nullopt;
+    }
+    const jsize length = env->GetArrayLength(array);
+    std::vector<std::string> result;
+    result.reserve(length);
+    for (jsize i = 0; i < length; ++i) {
+        auto element = static_cast<jstring>(env->GetObjectArrayElement(array, i));
+        result.push_back(jstringToString(env, element));
+        env->DeleteLocalRef(element);
+    }
+    return result;
+}
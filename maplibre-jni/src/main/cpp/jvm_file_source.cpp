@@ -0,0 +1,715 @@
+#include "jvm_file_source.hpp"
+#include "jni_helpers.hpp"
+#include <mbgl/actor/scheduler.hpp>
+#include <mbgl/storage/response.hpp>
+#include <mbgl/util/async_request.hpp>
+#include <mbgl/util/chrono.hpp>
+#include <mbgl/util/logging.hpp>
+#include <mbgl/util/mapbox.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        constexpr const char *DISPATCH_THREAD_NAME = "MapLibre JvmFileSource";
+        constexpr const char *RELEASED_MESSAGE = "JvmFileSource was released";
+
+        // Schemes the other sources of the resource loader serve
+        constexpr const char *LOCAL_SCHEMES[] = {"asset://", "file://", "mbtiles://", "pmtiles://"};
+
+        std::atomic<uintptr_t> nextContext{1};
+
+        // Resolves tile server URLs the same way mbgl's online file source does
+        std::string normalizeURL(const mbgl::Resource &resource, const mbgl::ResourceOptions &options)
+        {
+            const auto &server = options.tileServerOptions();
+            switch (resource.kind)
+            {
+            case mbgl::Resource::Kind::Style:
+                return mbgl::util::mapbox::normalizeStyleURL(server, resource.url, options.apiKey());
+            case mbgl::Resource::Kind::Source:
+                return mbgl::util::mapbox::normalizeSourceURL(server, resource.url, options.apiKey());
+            case mbgl::Resource::Kind::Tile:
+                return mbgl::util::mapbox::normalizeTileURL(server, resource.url, options.apiKey());
+            case mbgl::Resource::Kind::Glyphs:
+                return mbgl::util::mapbox::normalizeGlyphsURL(server, resource.url, options.apiKey());
+            case mbgl::Resource::Kind::SpriteImage:
+            case mbgl::Resource::Kind::SpriteJSON:
+                return mbgl::util::mapbox::normalizeSpriteURL(server, resource.url, options.apiKey());
+            default:
+                return resource.url;
+            }
+        }
+    } // namespace
+
+    struct JvmFileSource::Entry
+    {
+        explicit Entry(mbgl::Resource resource_)
+            : resource(std::move(resource_))
+        {
+        }
+
+        uint64_t id = 0;
+        mbgl::Resource resource;
+        Callback callback;
+        // RunLoop of the requesting thread, where the response is delivered
+        mbgl::Scheduler *scheduler = nullptr;
+        // Set once the handler has been told about the request
+        bool delivered = false;
+    };
+
+    class JvmFileSource::Channel : public std::enable_shared_from_this<Channel>
+    {
+    public:
+        Channel(JNIEnv *env, jobject upcalls_)
+            : contextId(nextContext++)
+        {
+            env->GetJavaVM(&jvm);
+
+            upcalls = env->NewGlobalRef(upcalls_);
+            jclass upcallsClass = env->GetObjectClass(upcalls_);
+            onRequestsMethod = env->GetMethodID(upcallsClass, "onRequests", "([J[Ljava/lang/String;[I[Ljava/lang/String;[J)V");
+            onCancelledMethod = env->GetMethodID(upcallsClass, "onCancelled", "([J)V");
+            env->DeleteLocalRef(upcallsClass);
+            if (!onRequestsMethod || !onCancelledMethod)
+            {
+                env->DeleteGlobalRef(upcalls);
+                throw std::runtime_error("Could not find JvmFileSource upcall methods");
+            }
+
+            jclass localStringClass = env->FindClass("java/lang/String");
+            stringClass = (jclass)env->NewGlobalRef(localStringClass);
+            env->DeleteLocalRef(localStringClass);
+        }
+
+        ~Channel()
+        {
+            if (thread.joinable())
+            {
+                thread.detach();
+            }
+        }
+
+        void start()
+        {
+            std::weak_ptr<Channel> weak = shared_from_this();
+            thread = std::thread([weak]
+                                 {
+                                     if (auto self = weak.lock())
+                                     {
+                                         self->run(std::move(self));
+                                     } });
+        }
+
+        void *context() const
+        {
+            return reinterpret_cast<void *>(contextId);
+        }
+
+        // Adds a request; false once the channel is closed
+        bool enqueue(const std::shared_ptr<Entry> &entry)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (closing)
+                {
+                    return false;
+                }
+                entry->id = nextRequestId++;
+                active.emplace(entry->id, entry);
+                pending.push_back(entry);
+            }
+            scheduleWake();
+            return true;
+        }
+
+        // Called when the map drops a request
+        void cancel(uint64_t id)
+        {
+            bool notify = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto it = active.find(id);
+                if (it == active.end())
+                {
+                    return;
+                }
+                if (it->second->delivered)
+                {
+                    cancelled.push_back(id);
+                    // The handler may still be writing the body, so it is released only
+                    // once the handler has been told
+                    if (auto body = bodies.find(id); body != bodies.end())
+                    {
+                        cancelledBodies.push_back(std::move(body->second));
+                        bodies.erase(body);
+                    }
+                    notify = true;
+                }
+                else
+                {
+                    pending.erase(std::remove(pending.begin(), pending.end(), it->second), pending.end());
+                }
+                active.erase(it);
+            }
+            if (notify)
+            {
+                scheduleWake();
+            }
+        }
+
+        // Buffer the response body is written into, or nullptr once the request is gone. It is
+        // kept until the request is answered, or until the handler has been told the map
+        // cancelled it.
+        jobject allocateBody(JNIEnv *env, uint64_t id, size_t size)
+        {
+            auto body = std::make_shared<std::string>(size, '\0');
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!active.count(id))
+                {
+                    return nullptr;
+                }
+                bodies[id] = body;
+            }
+            return env->NewDirectByteBuffer(body->data(), static_cast<jlong>(size));
+        }
+
+        bool isOutstanding(uint64_t id)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return active.count(id) != 0;
+        }
+
+        std::shared_ptr<std::string> takeBody(uint64_t id)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = bodies.find(id);
+            if (it == bodies.end())
+            {
+                return nullptr;
+            }
+            auto body = std::move(it->second);
+            bodies.erase(it);
+            return body;
+        }
+
+        // Answers a request from any thread; requests already cancelled are ignored
+        void respond(uint64_t id, const mbgl::Response &response)
+        {
+            std::shared_ptr<Entry> entry;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                bodies.erase(id);
+                auto it = active.find(id);
+                if (it == active.end())
+                {
+                    return;
+                }
+                entry = std::move(it->second);
+                active.erase(it);
+            }
+            deliver(entry, response);
+        }
+
+        // Stops the dispatch thread and fails every outstanding request
+        void close(JNIEnv *env)
+        {
+            auto self = shared_from_this();
+            std::unordered_map<uint64_t, std::shared_ptr<Entry>> outstanding;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (closing)
+                {
+                    return;
+                }
+                closing = true;
+                outstanding = std::move(active);
+                active.clear();
+                pending.clear();
+                bodies.clear();
+                cancelledBodies.clear();
+            }
+            cv.notify_all();
+
+            if (thread.joinable())
+            {
+                if (thread.get_id() == std::this_thread::get_id())
+                {
+                    thread.detach();
+                }
+                else
+                {
+                    thread.join();
+                }
+            }
+
+            mbgl::Response response;
+            response.error = std::make_unique<mbgl::Response::Error>(mbgl::Response::Error::Reason::Connection, RELEASED_MESSAGE);
+            for (const auto &[id, entry] : outstanding)
+            {
+                deliver(entry, response);
+            }
+
+            env->DeleteGlobalRef(upcalls);
+            env->DeleteGlobalRef(stringClass);
+        }
+
+        static void deliver(const std::shared_ptr<Entry> &entry, const mbgl::Response &response)
+        {
+            if (!entry->scheduler)
+            {
+                entry->callback(response);
+                return;
+            }
+
+            // Only the requester's AsyncRequest keeps the entry alive once it is answered
+            std::weak_ptr<Entry> weak = entry;
+            entry->scheduler->schedule([weak, response]
+                                       {
+                                           if (auto target = weak.lock())
+                                           {
+                                               target->callback(response);
+                                           } });
+        }
+
+    private:
+        // Wakes the dispatch thread at the end of the current RunLoop turn, so everything a
+        // map requests in one turn reaches the handler in one upcall
+        void scheduleWake()
+        {
+            mbgl::Scheduler *scheduler = mbgl::Scheduler::GetCurrent();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (scheduler && !wakeScheduled.insert(scheduler).second)
+                {
+                    return;
+                }
+                if (!scheduler)
+                {
+                    wake = true;
+                }
+            }
+            if (!scheduler)
+            {
+                cv.notify_one();
+                return;
+            }
+
+            std::weak_ptr<Channel> weak = shared_from_this();
+            scheduler->schedule([weak, scheduler]
+                                {
+                                    if (auto self = weak.lock())
+                                    {
+                                        {
+                                            std::lock_guard<std::mutex> lock(self->mutex);
+                                            self->wakeScheduled.erase(scheduler);
+                                            self->wake = true;
+                                        }
+                                        self->cv.notify_one();
+                                    } });
+        }
+
+        void run(std::shared_ptr<Channel> self)
+        {
+            JNIEnv *env = nullptr;
+            JavaVMAttachArgs args{JNI_VERSION_1_6, const_cast<char *>(DISPATCH_THREAD_NAME), nullptr};
+            if (jvm->AttachCurrentThreadAsDaemon(reinterpret_cast<void **>(&env), &args) != JNI_OK)
+            {
+                mbgl::Log::Error(mbgl::Event::HttpRequest, "Could not attach the JvmFileSource dispatch thread");
+                return;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true)
+            {
+                // The channel must not keep itself alive while it waits
+                std::weak_ptr<Channel> weak = self;
+                self.reset();
+                cv.wait(lock, [&]
+                        { return closing || (wake && (!pending.empty() || !cancelled.empty())); });
+                self = weak.lock();
+                if (closing || !self)
+                {
+                    break;
+                }
+                wake = false;
+
+                std::vector<std::shared_ptr<Entry>> requests;
+                requests.swap(pending);
+                std::vector<uint64_t> cancelledIds;
+                cancelledIds.swap(cancelled);
+                std::vector<std::shared_ptr<std::string>> releasedBodies;
+                releasedBodies.swap(cancelledBodies);
+                for (const auto &entry : requests)
+                {
+                    entry->delivered = true;
+                }
+
+                lock.unlock();
+                if (!cancelledIds.empty())
+                {
+                    dispatchCancellations(env, cancelledIds);
+                }
+                releasedBodies.clear();
+                if (!requests.empty())
+                {
+                    dispatchRequests(env, requests);
+                }
+                lock.lock();
+            }
+            lock.unlock();
+
+            jvm->DetachCurrentThread();
+        }
+
+        void dispatchRequests(JNIEnv *env, const std::vector<std::shared_ptr<Entry>> &requests)
+        {
+            const auto count = static_cast<jsize>(requests.size());
+            std::vector<jlong> ids(count);
+            std::vector<jint> kinds(count);
+            std::vector<jlong> priorModified(count);
+
+            jobjectArray urls = env->NewObjectArray(count, stringClass, nullptr);
+            jobjectArray priorEtags = env->NewObjectArray(count, stringClass, nullptr);
+            for (jsize i = 0; i < count; i++)
+            {
+                const auto &resource = requests[i]->resource;
+                ids[i] = static_cast<jlong>(requests[i]->id);
+                kinds[i] = static_cast<jint>(resource.kind);
+                priorModified[i] = resource.priorModified ? resource.priorModified->time_since_epoch().count() : 0;
+
+                jstring url = env->NewStringUTF(resource.url.c_str());
+                env->SetObjectArrayElement(urls, i, url);
+                env->DeleteLocalRef(url);
+                if (resource.priorEtag)
+                {
+                    jstring etag = env->NewStringUTF(resource.priorEtag->c_str());
+                    env->SetObjectArrayElement(priorEtags, i, etag);
+                    env->DeleteLocalRef(etag);
+                }
+            }
+
+            jlongArray idArray = env->NewLongArray(count);
+            env->SetLongArrayRegion(idArray, 0, count, ids.data());
+            jintArray kindArray = env->NewIntArray(count);
+            env->SetIntArrayRegion(kindArray, 0, count, kinds.data());
+            jlongArray modifiedArray = env->NewLongArray(count);
+            env->SetLongArrayRegion(modifiedArray, 0, count, priorModified.data());
+
+            env->CallVoidMethod(upcalls, onRequestsMethod, idArray, urls, kindArray, priorEtags, modifiedArray);
+            if (env->ExceptionCheck())
+            {
+                env->ExceptionDescribe();
+                env->ExceptionClear();
+
+                // Nothing will answer these, so the map is told instead of waiting forever
+                mbgl::Response response;
+                response.error = std::make_unique<mbgl::Response::Error>(mbgl::Response::Error::Reason::Other, "JvmFileSource handler failed");
+                for (const auto &entry : requests)
+                {
+                    respond(entry->id, response);
+                }
+            }
+
+            env->DeleteLocalRef(idArray);
+            env->DeleteLocalRef(urls);
+            env->DeleteLocalRef(kindArray);
+            env->DeleteLocalRef(priorEtags);
+            env->DeleteLocalRef(modifiedArray);
+        }
+
+        void dispatchCancellations(JNIEnv *env, const std::vector<uint64_t> &ids)
+        {
+            const auto count = static_cast<jsize>(ids.size());
+            std::vector<jlong> values(ids.begin(), ids.end());
+            jlongArray idArray = env->NewLongArray(count);
+            env->SetLongArrayRegion(idArray, 0, count, values.data());
+
+            env->CallVoidMethod(upcalls, onCancelledMethod, idArray);
+            if (env->ExceptionCheck())
+            {
+                env->ExceptionDescribe();
+                env->ExceptionClear();
+            }
+            env->DeleteLocalRef(idArray);
+        }
+
+        const uintptr_t contextId;
+        JavaVM *jvm = nullptr;
+        jobject upcalls = nullptr;
+        jclass stringClass = nullptr;
+        jmethodID onRequestsMethod = nullptr;
+        jmethodID onCancelledMethod = nullptr;
+        std::thread thread;
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool closing = false;
+        bool wake = false;
+        std::unordered_set<mbgl::Scheduler *> wakeScheduled;
+        uint64_t nextRequestId = 1;
+        std::unordered_map<uint64_t, std::shared_ptr<Entry>> active;
+        // Not yet handed to the handler, in request order
+        std::vector<std::shared_ptr<Entry>> pending;
+        std::vector<uint64_t> cancelled;
+        std::unordered_map<uint64_t, std::shared_ptr<std::string>> bodies;
+        // Bodies of cancelled requests, released after the cancellations are dispatched
+        std::vector<std::shared_ptr<std::string>> cancelledBodies;
+    };
+
+    namespace
+    {
+        std::mutex channelsMutex;
+        std::unordered_map<const void *, std::shared_ptr<JvmFileSource::Channel>> channels;
+
+        void registerChannel(const std::shared_ptr<JvmFileSource::Channel> &channel)
+        {
+            std::lock_guard<std::mutex> lock(channelsMutex);
+            channels[channel->context()] = channel;
+        }
+
+        void unregisterChannel(const JvmFileSource::Channel &channel)
+        {
+            std::lock_guard<std::mutex> lock(channelsMutex);
+            channels.erase(channel.context());
+        }
+    } // namespace
+
+    // Handed to the requester; tells the handler when the map no longer needs the response
+    class JvmFileSource::Request final : public mbgl::AsyncRequest
+    {
+    public:
+        Request(std::shared_ptr<Channel> channel_, std::shared_ptr<Entry> entry_)
+            : channel(std::move(channel_)),
+              entry(std::move(entry_))
+        {
+        }
+
+        ~Request() override
+        {
+            channel->cancel(entry->id);
+        }
+
+    private:
+        std::shared_ptr<Channel> channel;
+        std::shared_ptr<Entry> entry;
+    };
+
+    JvmFileSource::JvmFileSource(std::shared_ptr<Channel> channel_, const mbgl::ResourceOptions &resourceOptions_,
+                                 const mbgl::ClientOptions &clientOptions_)
+        : channel(std::move(channel_)),
+          resourceOptions(resourceOptions_.clone()),
+          clientOptions(clientOptions_.clone())
+    {
+    }
+
+    JvmFileSource::~JvmFileSource() = default;
+
+    std::shared_ptr<JvmFileSource::Channel> JvmFileSource::channelFor(const void *context)
+    {
+        if (!context)
+        {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lock(channelsMutex);
+        auto it = channels.find(context);
+        return it != channels.end() ? it->second : nullptr;
+    }
+
+    void *JvmFileSource::contextOf(jlong channel)
+    {
+        return channel ? fromJavaPointer<Channel>(channel)->context() : nullptr;
+    }
+
+    std::unique_ptr<mbgl::AsyncRequest> JvmFileSource::request(const mbgl::Resource &resource, Callback callback)
+    {
+        auto entry = std::make_shared<Entry>(resource);
+        entry->resource.url = normalizeURL(resource, resourceOptions);
+        entry->callback = std::move(callback);
+        entry->scheduler = mbgl::Scheduler::GetCurrent();
+
+        if (!channel->enqueue(entry))
+        {
+            mbgl::Response response;
+            response.error = std::make_unique<mbgl::Response::Error>(mbgl::Response::Error::Reason::Connection, RELEASED_MESSAGE);
+            Channel::deliver(entry, response);
+        }
+        return std::make_unique<Request>(channel, std::move(entry));
+    }
+
+    bool JvmFileSource::canRequest(const mbgl::Resource &resource) const
+    {
+        if (!resource.hasLoadingMethod(mbgl::Resource::LoadingMethod::Network))
+        {
+            return false;
+        }
+        return std::none_of(std::begin(LOCAL_SCHEMES), std::end(LOCAL_SCHEMES), [&](const char *scheme)
+                            { return resource.url.rfind(scheme, 0) == 0; });
+    }
+
+    void JvmFileSource::setResourceOptions(mbgl::ResourceOptions options)
+    {
+        resourceOptions = std::move(options);
+    }
+
+    mbgl::ResourceOptions JvmFileSource::getResourceOptions()
+    {
+        return resourceOptions.clone();
+    }
+
+    void JvmFileSource::setClientOptions(mbgl::ClientOptions options)
+    {
+        clientOptions = std::move(options);
+    }
+
+    mbgl::ClientOptions JvmFileSource::getClientOptions()
+    {
+        return clientOptions.clone();
+    }
+
+} // namespace maplibre_jni
+
+// JNI bindings
+extern "C"
+{
+
+    JNIEXPORT jlong JNICALL Java_org_maplibre_kmp_native_JvmFileSource_nativeNew(JNIEnv *env, jclass, jobject upcalls)
+    {
+        try
+        {
+            auto channel = std::make_shared<maplibre_jni::JvmFileSource::Channel>(env, upcalls);
+            channel->start();
+            maplibre_jni::registerChannel(channel);
+            return toJavaPointer(channel.get());
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+            return 0;
+        }
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_JvmFileSource_nativeDestroy(JNIEnv *env, jclass, jlong ptr)
+    {
+        auto *channel = fromJavaPointer<maplibre_jni::JvmFileSource::Channel>(ptr);
+        auto self = channel->shared_from_this();
+        maplibre_jni::unregisterChannel(*channel);
+        self->close(env);
+    }
+
+    JNIEXPORT jobject JNICALL Java_org_maplibre_kmp_native_JvmFileSource_nativeAllocateBody(JNIEnv *env, jclass, jlong ptr, jlong id, jint size)
+    {
+        try
+        {
+            auto *channel = fromJavaPointer<maplibre_jni::JvmFileSource::Channel>(ptr);
+            return channel->allocateBody(env, static_cast<uint64_t>(id), static_cast<size_t>(size));
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+            return nullptr;
+        }
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_JvmFileSource_nativeComplete(JNIEnv *env, jclass, jlong ptr, jlong id,
+                                                                                    jobject body, jint offset, jint length,
+                                                                                    jstring etag, jlong modified, jlong expires,
+                                                                                    jboolean mustRevalidate, jboolean notModified)
+    {
+        try
+        {
+            auto *channel = fromJavaPointer<maplibre_jni::JvmFileSource::Channel>(ptr);
+            // A cancelled request's body may already be released, so it must not be read
+            if (!channel->isOutstanding(static_cast<uint64_t>(id)))
+            {
+                return;
+            }
+            auto allocated = channel->takeBody(static_cast<uint64_t>(id));
+
+            mbgl::Response response;
+            if (body)
+            {
+                auto *address = static_cast<char *>(env->GetDirectBufferAddress(body));
+                if (!address)
+                {
+                    throwJavaException(env, "java/lang/IllegalArgumentException", "Response body must be a direct ByteBuffer");
+                    return;
+                }
+                const char *start = address + offset;
+                if (allocated && start == allocated->data() && static_cast<size_t>(length) <= allocated->size())
+                {
+                    // Written in place; shrinking the string keeps its storage
+                    allocated->resize(static_cast<size_t>(length));
+                    response.data = std::move(allocated);
+                }
+                else
+                {
+                    response.data = std::make_shared<std::string>(start, static_cast<size_t>(length));
+                }
+            }
+            else if (!notModified)
+            {
+                response.noContent = true;
+            }
+
+            response.notModified = notModified == JNI_TRUE;
+            response.mustRevalidate = mustRevalidate == JNI_TRUE;
+            if (etag)
+            {
+                response.etag = jstringToString(env, etag);
+            }
+            if (modified > 0)
+            {
+                response.modified = mbgl::Timestamp(mbgl::Seconds(modified));
+            }
+            if (expires > 0)
+            {
+                response.expires = mbgl::Timestamp(mbgl::Seconds(expires));
+            }
+
+            channel->respond(static_cast<uint64_t>(id), response);
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+        }
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_JvmFileSource_nativeFail(JNIEnv *env, jclass, jlong ptr, jlong id,
+                                                                                jint reason, jstring message, jlong retryAfter)
+    {
+        try
+        {
+            auto *channel = fromJavaPointer<maplibre_jni::JvmFileSource::Channel>(ptr);
+
+            std::optional<mbgl::Timestamp> retry;
+            if (retryAfter > 0)
+            {
+                retry = mbgl::Timestamp(mbgl::Seconds(retryAfter));
+            }
+
+            mbgl::Response response;
+            response.error = std::make_unique<mbgl::Response::Error>(static_cast<mbgl::Response::Error::Reason>(reason),
+                                                                     jstringToString(env, message), retry);
+            channel->respond(static_cast<uint64_t>(id), response);
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+        }
+    }
+
+} // extern "C"
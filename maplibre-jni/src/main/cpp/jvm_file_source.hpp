@@ -0,0 +1,55 @@
+#pragma once
+
+#include <jni.h>
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/resource.hpp>
+#include <mbgl/storage/resource_options.hpp>
+#include <mbgl/util/client_options.hpp>
+#include <memory>
+
+namespace maplibre_jni
+{
+
+    // Network FileSource whose requests are served by a Kotlin JvmFileSource.Handler
+    //
+    // Each Kotlin JvmFileSource owns a Channel with its own dispatch thread. Requests made during
+    // one RunLoop turn are handed to the handler in a single upcall as parallel arrays, and
+    // requests cancelled by the map are reported the same way. The handler answers from any
+    // thread; a body written into a buffer from allocateBody becomes the response data as is,
+    // other direct buffers are copied once. Responses are delivered on the requesting thread.
+    //
+    // Maps select a channel through the ResourceContext of their ResourceOptions, which
+    // installFileSources() checks when the network source is created.
+    class JvmFileSource final : public mbgl::FileSource
+    {
+    public:
+        class Channel;
+
+        JvmFileSource(std::shared_ptr<Channel> channel, const mbgl::ResourceOptions &resourceOptions,
+                      const mbgl::ClientOptions &clientOptions);
+        ~JvmFileSource() override;
+
+        // Channel identified by contextOf(), or nullptr once it is released
+        static std::shared_ptr<Channel> channelFor(const void *context);
+
+        // Identifies the channel behind a Kotlin JvmFileSource's native pointer in a ResourceContext
+        static void *contextOf(jlong channel);
+
+        std::unique_ptr<mbgl::AsyncRequest> request(const mbgl::Resource &resource, Callback callback) override;
+
+        bool canRequest(const mbgl::Resource &resource) const override;
+        void setResourceOptions(mbgl::ResourceOptions options) override;
+        mbgl::ResourceOptions getResourceOptions() override;
+        void setClientOptions(mbgl::ClientOptions options) override;
+        mbgl::ClientOptions getClientOptions() override;
+
+    private:
+        struct Entry;
+        class Request;
+
+        std::shared_ptr<Channel> channel;
+        mbgl::ResourceOptions resourceOptions;
+        mbgl::ClientOptions clientOptions;
+    };
+
+} // namespace maplibre_jni
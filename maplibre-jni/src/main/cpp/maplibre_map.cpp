@@ -2,13 +2,27 @@
 #include "jni_helpers.hpp"
 #include "awt_canvas_renderer.hpp"
 #include "map_observer.hpp"
+#include "feature_encoder.hpp"
+#include "resource_preloader.hpp"
+#include "session_log.hpp"
+#include "style_bundle.hpp"
+#include "awt_backend_factory.hpp"
+#include "file_sources.hpp"
+#include "worker_pool.hpp"
+#include "prioritized_request_source.hpp"
+#include "trajectory_prefetcher.hpp"
+#include "tile_lod_controller.hpp"
 
 #if defined(USE_EGL_BACKEND) || defined(USE_WGL_BACKEND)
 #include "awt_gl_backend.hpp"
 #endif
+#ifdef USE_VULKAN_BACKEND
+#include "vulkan_readback_ring.hpp"
+#endif
 #include "conversions/size_conversions.hpp"
 #include "conversions/cameraoptions_conversions.hpp"
 #include "conversions/mapoptions_conversions.hpp"
+#include "conversions/tilelodoptions_conversions.hpp"
 #include "conversions/clientoptions_conversions.hpp"
 #include "conversions/resourceoptions_conversions.hpp"
 #include "conversions/screencoordinate_conversions.hpp"
@@ -24,7 +38,16 @@
 #include <mbgl/annotation/annotation.hpp>
 #include <mbgl/storage/file_source_manager.hpp>
 #include <mbgl/storage/database_file_source.hpp>
+#include <mbgl/renderer/renderer.hpp>
+#include <mbgl/renderer/query.hpp>
+#include <mbgl/util/constants.hpp>
+#include <mbgl/util/projection.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <memory>
+#include <optional>
 
 // Wrapper struct to manage objects whose lifetime must match the Map's lifetime
 struct MapWrapper
@@ -33,20 +56,224 @@ struct MapWrapper
     std::unique_ptr<maplibre_jni::JniMapObserver> observer;
     std::unique_ptr<maplibre_jni::AwtCanvasRenderer> renderer;
 
+    // Resource loader shared with the Map, used for preloading
+    std::shared_ptr<mbgl::FileSource> resourceLoader;
+    // Platform context of the map's resource options, which its request queue stats are kept under
+    const void *requestContext = nullptr;
+    std::unique_ptr<maplibre_jni::ResourcePreloader> preloader;
+    std::unique_ptr<maplibre_jni::TrajectoryPrefetcher> trajectoryPrefetcher;
+
+    // Bundle the current style was loaded from, kept open while the map requests its entries
+    std::shared_ptr<maplibre_jni::StyleBundle> styleBundle;
+
+    // Encoded result of the last feature query, reused across queries
+    std::vector<uint8_t> queryResult;
+
+    // Identifies the last query so repeated hover picks on an unchanged frame skip the native query
+    std::string lastQueryKey;
+    uint64_t lastQueryFrame = 0;
+
+    // Latest size from setSize, applied to the map and renderer at the start of the next tick
+    std::optional<mbgl::Size> pendingSize;
+
+    // Prefetch delta to restore once frames are back within the frame budget
+    std::optional<uint8_t> budgetPrefetchZoomDelta;
+
+    // Tile level-of-detail settings, adapted to load when enabled
+    maplibre_jni::TileLodController tileLod;
+
+    // Camera last reported to the network request queue
+    std::optional<maplibre_jni::PrioritizedRequestSource::Viewport> requestViewport;
+
     MapWrapper(mbgl::Map *m, maplibre_jni::JniMapObserver *o, maplibre_jni::AwtCanvasRenderer *r)
         : map(m), observer(o), renderer(r) {}
+
+    ~MapWrapper()
+    {
+        maplibre_jni::PrioritizedRequestSource::removeViewport(this);
+    }
 };
 
+namespace
+{
+    // Copies the last encoded query result into the direct buffer if it fits
+    // Returns the encoded size either way so the caller can grow its buffer and copy again
+    jint copyQueryResult(JNIEnv *env, MapWrapper *wrapper, jobject buffer)
+    {
+        const auto size = static_cast<jlong>(wrapper->queryResult.size());
+        auto *address = static_cast<uint8_t *>(env->GetDirectBufferAddress(buffer));
+        if (!address)
+        {
+            throw std::runtime_error("Query buffer must be a direct ByteBuffer");
+        }
+        if (size <= env->GetDirectBufferCapacity(buffer))
+        {
+            std::memcpy(address, wrapper->queryResult.data(), wrapper->queryResult.size());
+        }
+        return static_cast<jint>(size);
+    }
+
+    // Runs the query unless the same query was already answered for the current frame
+    template <typename Query>
+    jint runFeatureQuery(JNIEnv *env, MapWrapper *wrapper, std::string key, jobject buffer, Query &&query)
+    {
+        auto *renderer = wrapper->renderer->getRenderer();
+        if (!renderer)
+        {
+            throw std::runtime_error("Renderer is not available");
+        }
+
+        const uint64_t frame = wrapper->renderer->getFrameCount();
+        if (key != wrapper->lastQueryKey || frame != wrapper->lastQueryFrame)
+        {
+            maplibre_jni::FeatureEncoder::encode(query(*renderer), wrapper->queryResult);
+            wrapper->lastQueryKey = std::move(key);
+            wrapper->lastQueryFrame = frame;
+        }
+        return copyQueryResult(env, wrapper, buffer);
+    }
+
+    std::vector<uint16_t> glyphRangeStarts(JNIEnv *env, jintArray array)
+    {
+        std::vector<uint16_t> starts;
+        if (array)
+        {
+            const jsize length = env->GetArrayLength(array);
+            std::vector<jint> values(length);
+            env->GetIntArrayRegion(array, 0, length, values.data());
+            for (jint value : values)
+            {
+                starts.push_back(static_cast<uint16_t>(value));
+            }
+        }
+        if (starts.empty())
+        {
+            // Basic Latin and Latin-1
+            starts.push_back(0);
+        }
+        return starts;
+    }
+
+    // The visible area in the world coordinates the request queue ranks tiles by
+    maplibre_jni::PrioritizedRequestSource::Viewport requestViewportOf(const mbgl::Map &map)
+    {
+        const auto camera = map.getCameraOptions();
+        const auto &options = map.getMapOptions();
+        const double zoom = camera.zoom.value_or(0);
+        const double pitch = camera.pitch.value_or(0) * mbgl::util::DEG2RAD;
+
+        const auto center = mbgl::Projection::project(camera.center.value_or(mbgl::LatLng{}), 1.0 / mbgl::util::tileSize_D);
+        const double worldSize = mbgl::util::tileSize_D * std::pow(2.0, zoom);
+        const double width = options.size().width / options.pixelRatio();
+        const double height = options.size().height / options.pixelRatio();
+        // Pitched maps see further toward the horizon
+        const double pitchFactor = 1.0 / std::max(std::cos(pitch), 0.25);
+
+        maplibre_jni::PrioritizedRequestSource::Viewport viewport;
+        viewport.centerX = center.x;
+        viewport.centerY = center.y;
+        viewport.radius = std::hypot(width, height) / 2.0 / worldSize * pitchFactor;
+        viewport.zoom = zoom;
+        return viewport;
+    }
+
+    maplibre_jni::ResourcePreloader &getPreloader(MapWrapper *wrapper)
+    {
+        if (!wrapper->preloader)
+        {
+            wrapper->preloader = std::make_unique<maplibre_jni::ResourcePreloader>(
+                wrapper->resourceLoader, wrapper->map->getMapOptions().pixelRatio());
+        }
+        return *wrapper->preloader;
+    }
+
+    void applyTileLod(mbgl::Map &map, const maplibre_jni::TileLodController::Settings &settings)
+    {
+        map.setTileLodMinRadius(settings.minRadius);
+        map.setTileLodScale(settings.scale);
+        map.setTileLodPitchThreshold(settings.pitchThreshold);
+        map.setTileLodZoomShift(settings.zoomShift);
+        map.setPrefetchZoomDelta(settings.prefetchZoomDelta);
+    }
+
+    void configureTileLod(MapWrapper *wrapper, const maplibre_jni::TileLodController::Options &options)
+    {
+        // The new settings carry their own prefetch delta, so the one saved by the frame budget is stale
+        wrapper->budgetPrefetchZoomDelta.reset();
+        wrapper->tileLod.setBase(options.settings);
+        wrapper->tileLod.setAdaptive(options.adaptiveTargetFrameMs);
+        applyTileLod(*wrapper->map, wrapper->tileLod.getSettings());
+    }
+
+    maplibre_jni::TrajectoryPrefetcher &getTrajectoryPrefetcher(MapWrapper *wrapper)
+    {
+        if (!wrapper->trajectoryPrefetcher)
+        {
+            wrapper->trajectoryPrefetcher = std::make_unique<maplibre_jni::TrajectoryPrefetcher>(
+                wrapper->resourceLoader, wrapper->map->getMapOptions().pixelRatio());
+        }
+        return *wrapper->trajectoryPrefetcher;
+    }
+
+    // Starts loading the tiles along an animation from the current camera to target
+    void prefetchTrajectory(MapWrapper *wrapper, const mbgl::CameraOptions &target, maplibre_jni::TrajectoryPrefetcher::Animation animation)
+    {
+        auto &prefetcher = getTrajectoryPrefetcher(wrapper);
+        if (prefetcher.getByteBudget() == 0)
+        {
+            return;
+        }
+
+        const auto current = wrapper->map->getCameraOptions();
+        maplibre_jni::TrajectoryPrefetcher::Camera start{current.center.value_or(mbgl::LatLng{}), current.zoom.value_or(0)};
+        maplibre_jni::TrajectoryPrefetcher::Camera end{target.center.value_or(start.center), target.zoom.value_or(start.zoom)};
+
+        const auto &options = wrapper->map->getMapOptions();
+        const mbgl::Size viewSize{static_cast<uint32_t>(options.size().width / options.pixelRatio()),
+                                  static_cast<uint32_t>(options.size().height / options.pixelRatio())};
+        prefetcher.prefetch(wrapper->map->getStyle(), animation, start, end, viewSize);
+    }
+
+    std::string layerKey(const std::optional<std::vector<std::string>> &ids)
+    {
+        // Listed ids each end in a NUL, so no list, even an empty one, has the key "*"
+        if (!ids)
+        {
+            return "*";
+        }
+        std::string key;
+        for (const auto &id : *ids)
+        {
+            key.append(id);
+            key.push_back('\0');
+        }
+        return key;
+    }
+} // namespace
+
 extern "C"
 {
 
-    JNIEXPORT jlong JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeNew(JNIEnv *env, jclass, jobject canvasObj, jint width, jint height, jfloat pixelRatio, jobject mapObserverObj, jobject mapOptionsObj, jobject resourceOptionsObj, jobject clientOptionsObj)
+    JNIEXPORT jlong JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeNew(JNIEnv *env, jclass, jobject canvasObj, jint width, jint height, jfloat pixelRatio, jobject mapObserverObj, jobject mapOptionsObj, jobject resourceOptionsObj, jobject clientOptionsObj, jboolean sharedContext)
     {
         try
         {
+            maplibre_jni::installFileSources();
+
+            // Extract ResourceOptions from Java object
+            mbgl::ResourceOptions resourceOptions = maplibre_jni::ResourceOptionsConversions::extract(env, resourceOptionsObj);
+
+            std::shared_ptr<mbgl::Scheduler> workerPool;
+            if (auto workerPoolOptions = maplibre_jni::MapOptionsConversions::extractWorkerPool(env, mapOptionsObj))
+            {
+                workerPool = maplibre_jni::acquireWorkerPool(*workerPoolOptions);
+            }
+
             // Create the renderer from the Canvas
             auto renderer = maplibre_jni::AwtCanvasRenderer::create(
-                env, canvasObj, width, height, pixelRatio, std::nullopt);
+                env, canvasObj, width, height, pixelRatio, std::nullopt, maplibre_jni::shaderCachePathFor(resourceOptions),
+                sharedContext == JNI_TRUE ? mbgl::gfx::ContextMode::Shared : mbgl::gfx::ContextMode::Unique,
+                std::move(workerPool));
 
             // Create the JniMapObserver from the Java MapObserver object
             auto *observer = new maplibre_jni::JniMapObserver(env, mapObserverObj);
@@ -54,9 +281,6 @@ extern "C"
             // Extract MapOptions from Java object
             mbgl::MapOptions mapOptions = maplibre_jni::MapOptionsConversions::extract(env, mapOptionsObj);
 
-            // Extract ResourceOptions from Java object
-            mbgl::ResourceOptions resourceOptions = maplibre_jni::ResourceOptionsConversions::extract(env, resourceOptionsObj);
-
             // Extract ClientOptions from Java object
             mbgl::ClientOptions clientOptions = maplibre_jni::ClientOptionsConversions::extract(env, clientOptionsObj);
 
@@ -84,6 +308,13 @@ extern "C"
 
             // Create wrapper to manage map, observer, and renderer lifetime
             auto *wrapper = new MapWrapper(map, observer, renderer.release());
+            wrapper->resourceLoader = resourceLoader;
+            wrapper->requestContext = resourceOptions.platformContext();
+
+            if (auto tileLod = maplibre_jni::MapOptionsConversions::extractTileLod(env, mapOptionsObj))
+            {
+                configureTileLod(wrapper, *tileLod);
+            }
 
             return toJavaPointer(wrapper);
         }
@@ -111,6 +342,7 @@ extern "C"
         auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
         const char *url = env->GetStringUTFChars(jUrl, nullptr);
         wrapper->map->getStyle().loadURL(std::string(url));
+        wrapper->styleBundle.reset();
         env->ReleaseStringUTFChars(jUrl, url);
     }
 
@@ -119,9 +351,25 @@ extern "C"
         auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
         const char *json = env->GetStringUTFChars(jJson, nullptr);
         wrapper->map->getStyle().loadJSON(std::string(json));
+        wrapper->styleBundle.reset();
         env->ReleaseStringUTFChars(jJson, json);
     }
 
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeLoadStyleBundle(JNIEnv *env, jclass, jlong ptr, jstring jPath)
+    {
+        try
+        {
+            auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
+            auto bundle = maplibre_jni::StyleBundle::open(jstringToString(env, jPath));
+            wrapper->map->getStyle().loadJSON(std::string(bundle->style()));
+            wrapper->styleBundle = std::move(bundle);
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+        }
+    }
+
     JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeJumpTo(JNIEnv *env, jclass, jlong ptr, jobject cameraOptions)
     {
         auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
@@ -137,6 +385,7 @@ extern "C"
         mbgl::AnimationOptions animationOptions;
         animationOptions.duration = mbgl::Duration(std::chrono::milliseconds(duration));
 
+        prefetchTrajectory(wrapper, options, maplibre_jni::TrajectoryPrefetcher::Animation::Ease);
         wrapper->map->easeTo(options, animationOptions);
     }
 
@@ -148,6 +397,7 @@ extern "C"
         mbgl::AnimationOptions animationOptions;
         animationOptions.duration = mbgl::Duration(std::chrono::milliseconds(duration));
 
+        prefetchTrajectory(wrapper, options, maplibre_jni::TrajectoryPrefetcher::Animation::Fly);
         wrapper->map->flyTo(options, animationOptions);
     }
 
@@ -164,9 +414,17 @@ extern "C"
         {
             auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
             mbgl::Size mbglSize = maplibre_jni::SizeConversions::extract(env, size);
-            wrapper->map->setSize(mbglSize);
 
-            wrapper->renderer->updateSize(mbglSize.width, mbglSize.height);
+            // Resizing re-lays out the transform and forces a full frame, so only the last
+            // size requested before a frame is applied
+            if (mbglSize == wrapper->map->getMapOptions().size())
+            {
+                wrapper->pendingSize.reset();
+            }
+            else
+            {
+                wrapper->pendingSize = mbglSize;
+            }
         }
         catch (const std::exception &e)
         {
@@ -179,7 +437,49 @@ extern "C"
         try
         {
             auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
-            return wrapper->renderer->tick() ? JNI_TRUE : JNI_FALSE;
+            if (wrapper->pendingSize)
+            {
+                const mbgl::Size size = *wrapper->pendingSize;
+                wrapper->pendingSize.reset();
+                wrapper->map->setSize(size);
+                wrapper->renderer->updateSize(size.width, size.height);
+            }
+            const bool rendered = wrapper->renderer->tick();
+
+            // Lets the request queue rank tile requests against where the map looks now
+            const auto viewport = requestViewportOf(*wrapper->map);
+            if (wrapper->requestViewport != viewport)
+            {
+                wrapper->requestViewport = viewport;
+                maplibre_jni::PrioritizedRequestSource::setViewport(wrapper, viewport);
+            }
+
+            if (wrapper->tileLod.isAdaptive())
+            {
+                // Adaptive LOD also stops prefetching under load, in place of the budget switch below
+                if (wrapper->tileLod.update(std::chrono::steady_clock::now(),
+                                            wrapper->renderer->getFrameBudget().getStats(),
+                                            maplibre_jni::PrioritizedRequestSource::getStats(wrapper->requestContext)))
+                {
+                    applyTileLod(*wrapper->map, wrapper->tileLod.getSettings());
+                }
+            }
+            else
+            {
+                // Prefetched lower-zoom tiles are extra uploads, so skip them while over budget
+                const bool overBudget = wrapper->renderer->getFrameBudget().isOverBudget();
+                if (overBudget && !wrapper->budgetPrefetchZoomDelta)
+                {
+                    wrapper->budgetPrefetchZoomDelta = wrapper->map->getPrefetchZoomDelta();
+                    wrapper->map->setPrefetchZoomDelta(0);
+                }
+                else if (!overBudget && wrapper->budgetPrefetchZoomDelta)
+                {
+                    wrapper->map->setPrefetchZoomDelta(*wrapper->budgetPrefetchZoomDelta);
+                    wrapper->budgetPrefetchZoomDelta.reset();
+                }
+            }
+            return rendered ? JNI_TRUE : JNI_FALSE;
         }
         catch (const std::exception &e)
         {
@@ -216,6 +516,174 @@ extern "C"
         }
     }
 
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeSetDynamicResolution(JNIEnv *env, jclass, jlong ptr, jboolean enabled, jfloat minScale, jdouble targetFrameMs)
+    {
+        try
+        {
+            auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
+            if (wrapper && wrapper->renderer)
+            {
+                maplibre_jni::DynamicResolutionController::Options options;
+                options.enabled = enabled == JNI_TRUE;
+                options.minScale = minScale;
+                options.targetFrameMs = targetFrameMs;
+                wrapper->renderer->setDynamicResolution(options);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+        }
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeAddDamageRegion(JNIEnv *env, jclass, jlong ptr, jint x, jint y, jint width, jint height)
+    {
+        try
+        {
+            auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
+            wrapper->renderer->addDamageRegion({x, y, width, height});
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+        }
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeSetFrameBudget(JNIEnv *env, jclass, jlong ptr, jdouble targetFrameMs)
+    {
+        try
+        {
+            auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
+            wrapper->renderer->setFrameBudget(targetFrameMs);
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+        }
+    }
+
+    JNIEXPORT jobject JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeGetFrameStats(JNIEnv *env, jclass, jlong ptr)
+    {
+        try
+        {
+            auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
+            const auto &budget = wrapper->renderer->getFrameBudget();
+            const auto stats = budget.getStats();
+
+            jclass statsClass = env->FindClass("org/maplibre/kmp/native/FrameStats");
+            jmethodID constructor = env->GetMethodID(statsClass, "<init>", "(JJJJDDDZ)V");
+            jobject result = env->NewObject(statsClass, constructor,
+                                            static_cast<jlong>(stats.renderedFrames),
+                                            static_cast<jlong>(stats.deferredFrames),
+                                            static_cast<jlong>(stats.batchedFrames),
+                                            static_cast<jlong>(stats.overBudgetFrames),
+                                            static_cast<jdouble>(stats.lastFrameMs),
+                                            static_cast<jdouble>(stats.averageFrameMs),
+                                            static_cast<jdouble>(stats.averageBatchedFrameMs),
+                                            budget.isOverBudget() ? JNI_TRUE : JNI_FALSE);
+            env->DeleteLocalRef(statsClass);
+            return result;
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+            return nullptr;
+        }
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeSetTileLodOptions(JNIEnv *env, jclass, jlong ptr, jobject tileLodOptions)
+    {
+        try
+        {
+            auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
+            configureTileLod(wrapper, maplibre_jni::TileLodOptionsConversions::extract(env, tileLodOptions));
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+        }
+    }
+
+    JNIEXPORT jint JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeGetTileLodLevel(JNIEnv *env, jclass, jlong ptr)
+    {
+        auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
+        return static_cast<jint>(wrapper->tileLod.getLevel());
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeSetTrajectoryPrefetchBudget(JNIEnv *env, jclass, jlong ptr, jlong bytes)
+    {
+        try
+        {
+            auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
+            auto &prefetcher = getTrajectoryPrefetcher(wrapper);
+            prefetcher.setByteBudget(static_cast<uint64_t>(std::max<jlong>(bytes, 0)));
+            if (bytes <= 0)
+            {
+                prefetcher.cancel();
+            }
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+        }
+    }
+
+    JNIEXPORT jobject JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeGetRequestQueueStats(JNIEnv *env, jclass, jlong ptr)
+    {
+        try
+        {
+            auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
+            const auto stats = maplibre_jni::PrioritizedRequestSource::getStats(wrapper->requestContext);
+
+            jclass statsClass = env->FindClass("org/maplibre/kmp/native/RequestQueueStats");
+            jmethodID constructor = env->GetMethodID(statsClass, "<init>", "(IIJJJ)V");
+            jobject result = env->NewObject(statsClass, constructor,
+                                            static_cast<jint>(stats.queued),
+                                            static_cast<jint>(stats.inFlight),
+                                            static_cast<jlong>(stats.cancelled),
+                                            static_cast<jlong>(stats.completed),
+                                            static_cast<jlong>(stats.bytes));
+            env->DeleteLocalRef(statsClass);
+            return result;
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+            return nullptr;
+        }
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeSetVulkanPresentOptions(JNIEnv *env, jclass, jlong ptr, jint presentMode, jint maxFramesInFlight, jint imageCount)
+    {
+        try
+        {
+            auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
+            if (wrapper && wrapper->renderer)
+            {
+#ifdef USE_VULKAN_BACKEND
+                // Only applies to the Vulkan backend
+                auto *backend = dynamic_cast<maplibre_jni::VulkanBackend *>(
+                    wrapper->renderer->getRendererBackend());
+                if (backend)
+                {
+                    backend->setPresentOptions(static_cast<vk::PresentModeKHR>(presentMode),
+                                               static_cast<uint32_t>(maxFramesInFlight),
+                                               static_cast<uint32_t>(imageCount));
+                }
+#else
+                // No-op for Metal and OpenGL
+                (void)presentMode;
+                (void)maxFramesInFlight;
+                (void)imageCount;
+#endif
+            }
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+        }
+    }
+
     JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeMoveBy(JNIEnv *env, jclass, jlong ptr, jobject screenCoordinate)
     {
         try
@@ -285,6 +753,7 @@ extern "C"
         {
             auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
             wrapper->map->setGestureInProgress(inProgress == JNI_TRUE);
+            wrapper->renderer->setInteractionActive(inProgress == JNI_TRUE);
         }
         catch (const std::exception &e)
         {
@@ -377,4 +846,216 @@ extern "C"
             return JNI_FALSE;
         }
     }
+
+    JNIEXPORT jint JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeQueryRenderedFeaturesAtPoint(JNIEnv *env, jclass, jlong ptr, jdouble x, jdouble y, jobjectArray layerIds, jobject buffer)
+    {
+        try
+        {
+            auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
+            auto layers = jstringArrayToVector(env, layerIds);
+            std::string key = "p:" + std::to_string(x) + "," + std::to_string(y) + ":" + layerKey(layers);
+            return runFeatureQuery(env, wrapper, std::move(key), buffer, [&](mbgl::Renderer &renderer)
+                                   { return renderer.queryRenderedFeatures(mbgl::ScreenCoordinate{x, y},
+                                                                           mbgl::RenderedQueryOptions{std::move(layers)}); });
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+            return 0;
+        }
+    }
+
+    JNIEXPORT jint JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeQueryRenderedFeaturesInBox(JNIEnv *env, jclass, jlong ptr, jdouble minX, jdouble minY, jdouble maxX, jdouble maxY, jobjectArray layerIds, jobject buffer)
+    {
+        try
+        {
+            auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
+            auto layers = jstringArrayToVector(env, layerIds);
+            std::string key = "b:" + std::to_string(minX) + "," + std::to_string(minY) + "," +
+                              std::to_string(maxX) + "," + std::to_string(maxY) + ":" + layerKey(layers);
+            return runFeatureQuery(env, wrapper, std::move(key), buffer, [&](mbgl::Renderer &renderer)
+                                   { return renderer.queryRenderedFeatures(mbgl::ScreenBox{{minX, minY}, {maxX, maxY}},
+                                                                           mbgl::RenderedQueryOptions{std::move(layers)}); });
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+            return 0;
+        }
+    }
+
+    JNIEXPORT jint JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeQuerySourceFeatures(JNIEnv *env, jclass, jlong ptr, jstring jSourceId, jobjectArray sourceLayerIds, jobject buffer)
+    {
+        try
+        {
+            auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
+            std::string sourceId = jstringToString(env, jSourceId);
+            auto sourceLayers = jstringArrayToVector(env, sourceLayerIds);
+            std::string key = "s:" + sourceId + ":" + layerKey(sourceLayers);
+            return runFeatureQuery(env, wrapper, std::move(key), buffer, [&](mbgl::Renderer &renderer)
+                                   { return renderer.querySourceFeatures(sourceId,
+                                                                         mbgl::SourceQueryOptions{std::move(sourceLayers)}); });
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+            return 0;
+        }
+    }
+
+    JNIEXPORT jint JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeCopyQueryResult(JNIEnv *env, jclass, jlong ptr, jobject buffer)
+    {
+        try
+        {
+            return copyQueryResult(env, fromJavaPointer<MapWrapper>(ptr), buffer);
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+            return 0;
+        }
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativePreloadStyleURL(JNIEnv *env, jclass, jlong ptr, jstring jUrl, jintArray rangeStarts)
+    {
+        try
+        {
+            auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
+            getPreloader(wrapper).preloadStyleURL(jstringToString(env, jUrl), glyphRangeStarts(env, rangeStarts));
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+        }
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativePreloadStyleJSON(JNIEnv *env, jclass, jlong ptr, jstring jJson, jintArray rangeStarts)
+    {
+        try
+        {
+            auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
+            getPreloader(wrapper).preloadStyleJSON(jstringToString(env, jJson), glyphRangeStarts(env, rangeStarts));
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+        }
+    }
+
+    JNIEXPORT jint JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeWarmUpCache(JNIEnv *env, jclass, jlong ptr, jstring jPath, jint maxRequests)
+    {
+        try
+        {
+            auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
+            // Without a path, replay the session recorded next to this map's cache
+            const std::string path = jPath ? jstringToString(env, jPath)
+                                           : maplibre_jni::SessionLog::pathFor(wrapper->resourceLoader->getResourceOptions().cachePath());
+            return static_cast<jint>(getPreloader(wrapper).preloadSession(path, static_cast<size_t>(std::max<jint>(0, maxRequests))));
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+            return 0;
+        }
+    }
+
+    JNIEXPORT jobject JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeGetPreloadProgress(JNIEnv *env, jclass, jlong ptr)
+    {
+        try
+        {
+            auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
+            maplibre_jni::ResourcePreloader::Progress progress;
+            if (wrapper->preloader)
+            {
+                progress = wrapper->preloader->getProgress();
+            }
+
+            jclass progressClass = env->FindClass("org/maplibre/kmp/native/PreloadProgress");
+            jmethodID constructor = env->GetMethodID(progressClass, "<init>", "(III)V");
+            jobject result = env->NewObject(progressClass, constructor,
+                                            static_cast<jint>(progress.requested),
+                                            static_cast<jint>(progress.completed),
+                                            static_cast<jint>(progress.failed));
+            env->DeleteLocalRef(progressClass);
+            return result;
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+            return nullptr;
+        }
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeCancelPreload(JNIEnv *env, jclass, jlong ptr)
+    {
+        try
+        {
+            auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
+            if (wrapper->preloader)
+            {
+                wrapper->preloader->cancel();
+            }
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+        }
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeEnableFrameReadback(JNIEnv *env, jclass, jlong ptr, jint slotCount)
+    {
+        try
+        {
+#ifdef USE_VULKAN_BACKEND
+            auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
+            auto *backend = dynamic_cast<maplibre_jni::VulkanBackend *>(wrapper->renderer->getRendererBackend());
+            if (backend)
+            {
+                backend->enableFrameReadback(static_cast<uint32_t>(slotCount));
+            }
+#else
+            (void)ptr;
+            (void)slotCount;
+            throwJavaException(env, "java/lang/UnsupportedOperationException",
+                               "Frame readback requires the Vulkan backend");
+#endif
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+        }
+    }
+
+    JNIEXPORT jobject JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeAcquireFrame(JNIEnv *env, jclass, jlong ptr, jlongArray info)
+    {
+        try
+        {
+#ifdef USE_VULKAN_BACKEND
+            auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
+            auto *backend = dynamic_cast<maplibre_jni::VulkanBackend *>(wrapper->renderer->getRendererBackend());
+            if (backend && backend->getReadback())
+            {
+                return maplibre_jni::acquireFrameForJava(env, *backend->getReadback(), info);
+            }
+#endif
+            return nullptr;
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+            return nullptr;
+        }
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_MaplibreMap_nativeReleaseFrame(JNIEnv *env, jclass, jlong ptr, jint slot, jlong number)
+    {
+#ifdef USE_VULKAN_BACKEND
+        auto *wrapper = fromJavaPointer<MapWrapper>(ptr);
+        auto *backend = dynamic_cast<maplibre_jni::VulkanBackend *>(wrapper->renderer->getRendererBackend());
+        if (backend && backend->getReadback())
+        {
+            backend->getReadback()->release(static_cast<uint32_t>(slot), static_cast<uint64_t>(number));
+        }
+#endif
+    }
 }
@@ -0,0 +1,108 @@
+#include "mapped_file.hpp"
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace maplibre_jni
+{
+
+    std::unique_ptr<MappedFile> MappedFile::open(const std::string &path)
+    {
+        auto file = std::unique_ptr<MappedFile>(new MappedFile());
+
+#ifdef _WIN32
+        HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error("Could not open " + path);
+        }
+        file->fileHandle = handle;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(handle, &fileSize))
+        {
+            throw std::runtime_error("Could not stat " + path);
+        }
+        file->length = static_cast<size_t>(fileSize.QuadPart);
+        if (file->length == 0)
+        {
+            return file;
+        }
+
+        HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping)
+        {
+            throw std::runtime_error("Could not map " + path);
+        }
+        file->mappingHandle = mapping;
+
+        file->bytes = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!file->bytes)
+        {
+            throw std::runtime_error("Could not map " + path);
+        }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Could not open " + path);
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("Could not stat " + path);
+        }
+        file->length = static_cast<size_t>(info.st_size);
+        if (file->length == 0)
+        {
+            ::close(fd);
+            return file;
+        }
+
+        void *address = mmap(nullptr, file->length, PROT_READ, MAP_PRIVATE, fd, 0);
+        // The mapping stays valid after the descriptor is closed
+        ::close(fd);
+        if (address == MAP_FAILED)
+        {
+            throw std::runtime_error("Could not map " + path);
+        }
+        file->bytes = static_cast<const uint8_t *>(address);
+#endif
+
+        return file;
+    }
+
+    MappedFile::~MappedFile()
+    {
+#ifdef _WIN32
+        if (bytes)
+        {
+            UnmapViewOfFile(bytes);
+        }
+        if (mappingHandle)
+        {
+            CloseHandle(static_cast<HANDLE>(mappingHandle));
+        }
+        if (fileHandle)
+        {
+            CloseHandle(static_cast<HANDLE>(fileHandle));
+        }
+#else
+        if (bytes)
+        {
+            munmap(const_cast<uint8_t *>(bytes), length);
+        }
+#endif
+    }
+
+} // namespace maplibre_jni
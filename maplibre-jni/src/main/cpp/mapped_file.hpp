@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace maplibre_jni
+{
+
+    // Read-only memory mapping of a whole file
+    class MappedFile
+    {
+    public:
+        // Throws std::runtime_error if the file can't be opened or mapped
+        static std::unique_ptr<MappedFile> open(const std::string &path);
+
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        const uint8_t *data() const { return bytes; }
+        size_t size() const { return length; }
+
+    private:
+        MappedFile() = default;
+
+        const uint8_t *bytes = nullptr;
+        size_t length = 0;
+
+#ifdef _WIN32
+        void *fileHandle = nullptr;
+        void *mappingHandle = nullptr;
+#endif
+    };
+
+} // namespace maplibre_jni
@@ -0,0 +1,606 @@
+#include "prioritized_request_source.hpp"
+#include <mbgl/actor/scheduler.hpp>
+#include <mbgl/storage/response.hpp>
+#include <mbgl/util/async_request.hpp>
+#include <mbgl/util/tileset.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        using Viewport = PrioritizedRequestSource::Viewport;
+
+        // Matches the network layer's own default, so its queue stays empty
+        constexpr uint32_t DEFAULT_MAX_CONCURRENT_REQUESTS = 20;
+        constexpr const char *MAX_CONCURRENT_REQUESTS_KEY = "max-concurrent-requests";
+
+        // Tiles within this fraction of the viewport radius count as central
+        constexpr double CENTER_DISTANCE = 0.5;
+        // Running tile requests are cancelled once the tile is this far outside every viewport;
+        // the margin keeps small pans from cancelling edge tiles only to request them again
+        constexpr double CANCEL_DISTANCE = 1.5;
+
+        constexpr double HALF_SQRT2 = 0.7071067811865476;
+
+        enum Tier : int
+        {
+            // Styles, sources, sprites and glyphs
+            Critical = 0,
+            Center = 1,
+            Edge = 2,
+            // Parent, prefetch, off-screen and low priority tiles
+            Background = 3,
+        };
+
+        struct Rank
+        {
+            int tier = Critical;
+            // Distance from the tile to the nearest viewport center, in viewport radii
+            double distance = 0;
+
+            bool operator<(const Rank &other) const
+            {
+                return tier != other.tier ? tier < other.tier : distance < other.distance;
+            }
+        };
+
+        // What a queue has learned about the tiles of one URL template
+        struct TileTemplate
+        {
+            // Unknown until a tile's URL tells the schemes apart
+            std::optional<mbgl::Tileset::Scheme> scheme;
+            // Deepest zoom requested; once the camera is past the source's maxzoom this is
+            // where the overscaled tiles it shows come from
+            int8_t deepestZoom = 0;
+        };
+
+        std::optional<mbgl::Tileset::Scheme> schemeOf(const mbgl::Resource &resource)
+        {
+            const auto &tile = *resource.tileData;
+            const auto xyz = mbgl::Resource::tile(tile.urlTemplate, tile.pixelRatio, tile.x, tile.y, tile.z, mbgl::Tileset::Scheme::XYZ).url;
+            const auto tms = mbgl::Resource::tile(tile.urlTemplate, tile.pixelRatio, tile.x, tile.y, tile.z, mbgl::Tileset::Scheme::TMS).url;
+            if (xyz == tms)
+            {
+                return std::nullopt;
+            }
+            // A URL from neither, e.g. after a resource transform, is taken as XYZ
+            return resource.url == tms ? mbgl::Tileset::Scheme::TMS : mbgl::Tileset::Scheme::XYZ;
+        }
+
+        Rank rankOf(const mbgl::Resource &resource, const TileTemplate *tileTemplate, const std::vector<Viewport> &viewports)
+        {
+            if (!resource.tileData)
+            {
+                return {Critical, 0};
+            }
+
+            const bool lowPriority = resource.priority == mbgl::Resource::Priority::Low;
+            if (viewports.empty())
+            {
+                return {lowPriority ? Background : Center, 0};
+            }
+
+            const auto &tile = *resource.tileData;
+            const double tiles = std::ldexp(1.0, tile.z);
+            const double tileX = (tile.x + 0.5) / tiles;
+            // Viewports count rows from the north; TMS tiles count them from the south
+            const bool tms = tileTemplate && tileTemplate->scheme == mbgl::Tileset::Scheme::TMS;
+            const double row = tms ? tiles - 1 - tile.y : tile.y;
+            const double tileY = (row + 0.5) / tiles;
+            const double tileRadius = HALF_SQRT2 / tiles;
+
+            // Past the source's maxzoom the deepest tiles are overscaled for the camera
+            const bool deepest = tileTemplate && tile.z >= tileTemplate->deepestZoom;
+
+            double distance = std::numeric_limits<double>::infinity();
+            bool parent = !deepest;
+            for (const auto &viewport : viewports)
+            {
+                // The world wraps horizontally
+                double dx = std::abs(tileX - viewport.centerX);
+                dx = std::min(dx, 1.0 - dx);
+                const double dy = std::abs(tileY - viewport.centerY);
+                const double edgeDistance = std::max(0.0, std::hypot(dx, dy) - tileRadius);
+                distance = std::min(distance, edgeDistance / std::max(viewport.radius, 1e-12));
+
+                // Sources with 256 pixel tiles load one zoom level above the camera's zoom
+                if (tile.z + 1 >= std::floor(viewport.zoom))
+                {
+                    parent = false;
+                }
+            }
+
+            if (lowPriority || parent || distance > 1.0)
+            {
+                return {Background, distance};
+            }
+            return {distance <= CENTER_DISTANCE ? Center : Edge, distance};
+        }
+    } // namespace
+
+    struct PrioritizedRequestSource::Entry
+    {
+        enum class State
+        {
+            Queued,
+            Active,
+            Done,
+            Removed,
+        };
+
+        explicit Entry(mbgl::Resource resource_)
+            : resource(std::move(resource_))
+        {
+        }
+
+        mbgl::Resource resource;
+        // Owned by the queue; null for resources other than tiles
+        const TileTemplate *tileTemplate = nullptr;
+        Callback callback;
+        // RunLoop of the requesting thread; upstream requests start and stop there
+        mbgl::Scheduler *scheduler = nullptr;
+        uint64_t sequence = 0;
+        State state = State::Queued;
+        // Bumped each time the entry is started, so stale start and cancel tasks can be ignored
+        uint64_t generation = 0;
+        std::unique_ptr<mbgl::AsyncRequest> upstreamRequest;
+    };
+
+    struct PrioritizedRequestSource::Registry
+    {
+        std::mutex mutex;
+        std::unordered_map<const void *, Viewport> viewports;
+        std::vector<std::weak_ptr<Queue>> queues;
+
+        std::vector<Viewport> snapshotViewports()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<Viewport> result;
+            result.reserve(viewports.size());
+            for (const auto &entry : viewports)
+            {
+                result.push_back(entry.second);
+            }
+            return result;
+        }
+
+        std::vector<std::shared_ptr<Queue>> liveQueues()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<std::shared_ptr<Queue>> result;
+            queues.erase(std::remove_if(queues.begin(), queues.end(),
+                                        [&](const std::weak_ptr<Queue> &weak)
+                                        {
+                                            auto queue = weak.lock();
+                                            if (queue)
+                                            {
+                                                result.push_back(std::move(queue));
+                                            }
+                                            return !queue;
+                                        }),
+                         queues.end());
+            return result;
+        }
+    };
+
+    struct PrioritizedRequestSource::Queue : std::enable_shared_from_this<Queue>
+    {
+        Queue(std::unique_ptr<mbgl::FileSource> upstream_, const void *context_)
+            : upstream(std::move(upstream_)),
+              context(context_)
+        {
+        }
+
+        // Start the best waiting requests while there is room
+        void dispatch()
+        {
+            const auto viewports = registry().snapshotViewports();
+
+            std::vector<std::pair<std::shared_ptr<Entry>, uint64_t>> starting;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                while (inFlight < maxConcurrentRequests)
+                {
+                    std::shared_ptr<Entry> best;
+                    Rank bestRank;
+                    for (const auto &entry : entries)
+                    {
+                        if (entry->state != Entry::State::Queued)
+                        {
+                            continue;
+                        }
+                        const Rank rank = rankOf(entry->resource, entry->tileTemplate, viewports);
+                        if (!best || rank < bestRank || (!(bestRank < rank) && entry->sequence < best->sequence))
+                        {
+                            best = entry;
+                            bestRank = rank;
+                        }
+                    }
+                    if (!best)
+                    {
+                        break;
+                    }
+
+                    best->state = Entry::State::Active;
+                    best->generation++;
+                    inFlight++;
+                    starting.emplace_back(best, best->generation);
+                }
+            }
+
+            for (auto &[entry, generation] : starting)
+            {
+                runOnRequestThread(entry, [generation](Queue &queue, const std::shared_ptr<Entry> &target)
+                                   { queue.start(target, generation); });
+            }
+        }
+
+        // Requeue running requests for tiles no viewport shows while visible ones wait
+        void reprioritize()
+        {
+            const auto viewports = registry().snapshotViewports();
+
+            std::vector<std::pair<std::shared_ptr<Entry>, uint64_t>> cancelled;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                const bool visibleWaiting = std::any_of(entries.begin(), entries.end(), [&](const auto &entry)
+                                                        { return entry->state == Entry::State::Queued &&
+                                                                 rankOf(entry->resource, entry->tileTemplate, viewports).tier <= Edge; });
+                if (!visibleWaiting)
+                {
+                    return;
+                }
+
+                for (const auto &entry : entries)
+                {
+                    if (entry->state == Entry::State::Active && entry->resource.tileData &&
+                        rankOf(entry->resource, entry->tileTemplate, viewports).distance > CANCEL_DISTANCE)
+                    {
+                        entry->state = Entry::State::Queued;
+                        inFlight--;
+                        cancelled.emplace_back(entry, entry->generation);
+                    }
+                }
+            }
+
+            cancelledCount += cancelled.size();
+            for (auto &[entry, generation] : cancelled)
+            {
+                runOnRequestThread(entry, [generation](Queue &queue, const std::shared_ptr<Entry> &target)
+                                   { queue.stop(target, generation); });
+            }
+
+            if (!cancelled.empty())
+            {
+                dispatch();
+            }
+        }
+
+        void start(const std::shared_ptr<Entry> &entry, uint64_t generation)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (entry->state != Entry::State::Active || entry->generation != generation)
+                {
+                    return;
+                }
+            }
+
+            std::weak_ptr<Queue> weakQueue = shared_from_this();
+            std::weak_ptr<Entry> weakEntry = entry;
+            auto request = upstream->request(entry->resource, [weakQueue, weakEntry](const mbgl::Response &response)
+                                             {
+                                                 auto queue = weakQueue.lock();
+                                                 auto target = weakEntry.lock();
+                                                 if (queue && target)
+                                                 {
+                                                     queue->onResponse(target, response);
+                                                 } });
+
+            // Whatever is replaced is cancelled outside the lock
+            std::unique_ptr<mbgl::AsyncRequest> replaced;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (entry->state == Entry::State::Removed)
+                {
+                    replaced = std::move(request);
+                }
+                else
+                {
+                    replaced = std::move(entry->upstreamRequest);
+                    entry->upstreamRequest = std::move(request);
+                }
+            }
+        }
+
+        void stop(const std::shared_ptr<Entry> &entry, uint64_t generation)
+        {
+            std::unique_ptr<mbgl::AsyncRequest> released;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (entry->state == Entry::State::Queued && entry->generation == generation)
+                {
+                    released = std::move(entry->upstreamRequest);
+                }
+            }
+        }
+
+        void onResponse(const std::shared_ptr<Entry> &entry, const mbgl::Response &response)
+        {
+            bool finished = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (entry->state == Entry::State::Removed)
+                {
+                    return;
+                }
+                if (entry->state == Entry::State::Active)
+                {
+                    inFlight--;
+                    finished = true;
+                }
+                // The upstream request stays alive for refreshes once its resource expires
+                entry->state = Entry::State::Done;
+            }
+
+            if (finished)
+            {
+                completedCount++;
+            }
+            if (response.data)
+            {
+                bytesCount += response.data->size();
+            }
+
+            entry->callback(response);
+
+            if (finished)
+            {
+                dispatch();
+            }
+        }
+
+        template <typename Task>
+        void runOnRequestThread(const std::shared_ptr<Entry> &entry, Task task)
+        {
+            if (entry->scheduler == mbgl::Scheduler::GetCurrent())
+            {
+                task(*this, entry);
+                return;
+            }
+
+            std::weak_ptr<Queue> weakQueue = shared_from_this();
+            std::weak_ptr<Entry> weakEntry = entry;
+            entry->scheduler->schedule([weakQueue, weakEntry, task]
+                                       {
+                                           auto queue = weakQueue.lock();
+                                           auto target = weakEntry.lock();
+                                           if (queue && target)
+                                           {
+                                               task(*queue, target);
+                                           } });
+        }
+
+        std::unique_ptr<mbgl::FileSource> upstream;
+        const void *const context;
+
+        // Totals reported for the queue's context
+        std::atomic<uint64_t> cancelledCount{0};
+        std::atomic<uint64_t> completedCount{0};
+        std::atomic<uint64_t> bytesCount{0};
+
+        std::mutex mutex;
+        std::vector<std::shared_ptr<Entry>> entries;
+        uint32_t inFlight = 0;
+        uint32_t maxConcurrentRequests = DEFAULT_MAX_CONCURRENT_REQUESTS;
+        uint64_t nextSequence = 0;
+        // By URL template; node-based, so entries can point into it
+        std::unordered_map<std::string, TileTemplate> tileTemplates;
+    };
+
+    // Handed to the requester; removes the entry and cancels any upstream request
+    class PrioritizedRequestSource::Request final : public mbgl::AsyncRequest
+    {
+    public:
+        Request(std::shared_ptr<Queue> queue_, std::shared_ptr<Entry> entry_)
+            : queue(std::move(queue_)),
+              entry(std::move(entry_))
+        {
+        }
+
+        ~Request() override
+        {
+            std::unique_ptr<mbgl::AsyncRequest> released;
+            bool wasActive = false;
+            {
+                std::lock_guard<std::mutex> lock(queue->mutex);
+                wasActive = entry->state == Entry::State::Active;
+                if (wasActive)
+                {
+                    queue->inFlight--;
+                }
+                entry->state = Entry::State::Removed;
+                released = std::move(entry->upstreamRequest);
+                auto &entries = queue->entries;
+                entries.erase(std::remove(entries.begin(), entries.end(), entry), entries.end());
+            }
+            released.reset();
+
+            if (wasActive)
+            {
+                queue->dispatch();
+            }
+        }
+
+    private:
+        std::shared_ptr<Queue> queue;
+        std::shared_ptr<Entry> entry;
+    };
+
+    PrioritizedRequestSource::Registry &PrioritizedRequestSource::registry()
+    {
+        static Registry instance;
+        return instance;
+    }
+
+    PrioritizedRequestSource::PrioritizedRequestSource(std::unique_ptr<mbgl::FileSource> upstream, const void *context)
+        : queue(std::make_shared<Queue>(std::move(upstream), context))
+    {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        registry().queues.push_back(queue);
+    }
+
+    PrioritizedRequestSource::~PrioritizedRequestSource() = default;
+
+    void PrioritizedRequestSource::setViewport(const void *owner, const Viewport &viewport)
+    {
+        {
+            std::lock_guard<std::mutex> lock(registry().mutex);
+            registry().viewports[owner] = viewport;
+        }
+        for (const auto &queue : registry().liveQueues())
+        {
+            queue->reprioritize();
+        }
+    }
+
+    void PrioritizedRequestSource::removeViewport(const void *owner)
+    {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        registry().viewports.erase(owner);
+    }
+
+    PrioritizedRequestSource::Stats PrioritizedRequestSource::getStats(const void *context)
+    {
+        Stats stats;
+        for (const auto &queue : registry().liveQueues())
+        {
+            if (queue->context != context)
+            {
+                continue;
+            }
+            stats.cancelled += queue->cancelledCount;
+            stats.completed += queue->completedCount;
+            stats.bytes += queue->bytesCount;
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            stats.inFlight += queue->inFlight;
+            stats.queued += static_cast<uint32_t>(std::count_if(queue->entries.begin(), queue->entries.end(), [](const auto &entry)
+                                                                { return entry->state == Entry::State::Queued; }));
+        }
+        return stats;
+    }
+
+    std::unique_ptr<mbgl::AsyncRequest> PrioritizedRequestSource::request(const mbgl::Resource &resource, Callback callback)
+    {
+        // Without a RunLoop there is nowhere to start the request later
+        mbgl::Scheduler *scheduler = mbgl::Scheduler::GetCurrent();
+        if (!scheduler)
+        {
+            return queue->upstream->request(resource, std::move(callback));
+        }
+
+        auto entry = std::make_shared<Entry>(resource);
+        entry->callback = std::move(callback);
+        entry->scheduler = scheduler;
+        {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            if (resource.tileData)
+            {
+                const auto &tile = *resource.tileData;
+                auto &tileTemplate = queue->tileTemplates[tile.urlTemplate];
+                if (!tileTemplate.scheme)
+                {
+                    tileTemplate.scheme = schemeOf(resource);
+                }
+                tileTemplate.deepestZoom = std::max(tileTemplate.deepestZoom, tile.z);
+                entry->tileTemplate = &tileTemplate;
+            }
+            entry->sequence = queue->nextSequence++;
+            queue->entries.push_back(entry);
+        }
+
+        queue->dispatch();
+        return std::make_unique<Request>(queue, std::move(entry));
+    }
+
+    void PrioritizedRequestSource::forward(const mbgl::Resource &resource, const mbgl::Response &response, std::function<void()> callback)
+    {
+        queue->upstream->forward(resource, response, std::move(callback));
+    }
+
+    bool PrioritizedRequestSource::canRequest(const mbgl::Resource &resource) const
+    {
+        return queue->upstream->canRequest(resource);
+    }
+
+    bool PrioritizedRequestSource::supportsCacheOnlyRequests() const
+    {
+        return queue->upstream->supportsCacheOnlyRequests();
+    }
+
+    void PrioritizedRequestSource::pause()
+    {
+        queue->upstream->pause();
+    }
+
+    void PrioritizedRequestSource::resume()
+    {
+        queue->upstream->resume();
+    }
+
+    void PrioritizedRequestSource::setProperty(const std::string &key, const mapbox::base::Value &value)
+    {
+        if (key == MAX_CONCURRENT_REQUESTS_KEY)
+        {
+            if (const auto *limit = value.getUint())
+            {
+                std::lock_guard<std::mutex> lock(queue->mutex);
+                queue->maxConcurrentRequests = static_cast<uint32_t>(std::max<uint64_t>(*limit, 1));
+            }
+        }
+        queue->upstream->setProperty(key, value);
+        queue->dispatch();
+    }
+
+    mapbox::base::Value PrioritizedRequestSource::getProperty(const std::string &key) const
+    {
+        return queue->upstream->getProperty(key);
+    }
+
+    void PrioritizedRequestSource::setResourceTransform(mbgl::ResourceTransform transform)
+    {
+        queue->upstream->setResourceTransform(std::move(transform));
+    }
+
+    void PrioritizedRequestSource::setResourceOptions(mbgl::ResourceOptions options)
+    {
+        queue->upstream->setResourceOptions(std::move(options));
+    }
+
+    mbgl::ResourceOptions PrioritizedRequestSource::getResourceOptions()
+    {
+        return queue->upstream->getResourceOptions();
+    }
+
+    void PrioritizedRequestSource::setClientOptions(mbgl::ClientOptions options)
+    {
+        queue->upstream->setClientOptions(std::move(options));
+    }
+
+    mbgl::ClientOptions PrioritizedRequestSource::getClientOptions()
+    {
+        return queue->upstream->getClientOptions();
+    }
+
+} // namespace maplibre_jni
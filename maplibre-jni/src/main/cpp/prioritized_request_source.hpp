@@ -0,0 +1,88 @@
+#pragma once
+
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/resource.hpp>
+#include <cstdint>
+#include <memory>
+
+namespace maplibre_jni
+{
+
+    // FileSource wrapper that orders network requests by what the maps currently show
+    //
+    // At most maxConcurrentRequests requests run upstream at once; the rest wait here instead of
+    // in the network layer's first-come queue. Waiting requests start in tiers: styles, sprites
+    // and glyphs first, then tiles near the center of any map's viewport, tiles at its edges, and
+    // finally parent, prefetch and off-screen tiles. When a viewport moves while visible tiles
+    // are waiting, running requests for tiles that left every viewport are cancelled and queued
+    // again behind them. Maps report their camera through setViewport.
+    class PrioritizedRequestSource final : public mbgl::FileSource
+    {
+    public:
+        // Camera of one map in world coordinates, where the world spans [0, 1] on both axes
+        struct Viewport
+        {
+            double centerX = 0;
+            double centerY = 0;
+            // Distance from the center to the farthest visible point
+            double radius = 0;
+            double zoom = 0;
+
+            bool operator==(const Viewport &other) const
+            {
+                return centerX == other.centerX && centerY == other.centerY && radius == other.radius &&
+                       zoom == other.zoom;
+            }
+        };
+
+        // Totals of the sources serving one resource context
+        struct Stats
+        {
+            uint32_t queued = 0;
+            uint32_t inFlight = 0;
+            // Running requests cancelled because their tile left the viewports
+            uint64_t cancelled = 0;
+            uint64_t completed = 0;
+            // Response bytes received
+            uint64_t bytes = 0;
+        };
+
+        // context is the platform context of the resource options the source serves, which
+        // its stats are kept under
+        PrioritizedRequestSource(std::unique_ptr<mbgl::FileSource> upstream, const void *context);
+        ~PrioritizedRequestSource() override;
+
+        static void setViewport(const void *owner, const Viewport &viewport);
+        static void removeViewport(const void *owner);
+        // Totals of the sources serving one resource context, i.e. the maps sharing its options
+        static Stats getStats(const void *context);
+
+        std::unique_ptr<mbgl::AsyncRequest> request(const mbgl::Resource &resource, Callback callback) override;
+
+        void forward(const mbgl::Resource &resource, const mbgl::Response &response, std::function<void()> callback) override;
+        bool canRequest(const mbgl::Resource &resource) const override;
+        bool supportsCacheOnlyRequests() const override;
+        void pause() override;
+        void resume() override;
+        // Also takes "max-concurrent-requests" as its own limit
+        void setProperty(const std::string &key, const mapbox::base::Value &value) override;
+        mapbox::base::Value getProperty(const std::string &key) const override;
+        void setResourceTransform(mbgl::ResourceTransform transform) override;
+        void setResourceOptions(mbgl::ResourceOptions options) override;
+        mbgl::ResourceOptions getResourceOptions() override;
+        void setClientOptions(mbgl::ClientOptions options) override;
+        mbgl::ClientOptions getClientOptions() override;
+
+    private:
+        struct Entry;
+        struct Queue;
+        struct Registry;
+        class Request;
+
+        // Viewports and live queues shared by every prioritized source
+        static Registry &registry();
+
+        std::shared_ptr<Queue> queue;
+    };
+
+} // namespace maplibre_jni
@@ -0,0 +1,165 @@
+#include "program_binary_cache.hpp"
+#include <mbgl/util/logging.hpp>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        constexpr const char *DRIVER_STAMP = "driver";
+
+        uint64_t fnv1a(const void *data, size_t length)
+        {
+            const auto *bytes = static_cast<const uint8_t *>(data);
+            uint64_t hash = 14695981039346656037ull;
+            for (size_t i = 0; i < length; ++i)
+            {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+    } // namespace
+
+    ProgramBinaryCache &ProgramBinaryCache::get()
+    {
+        static ProgramBinaryCache instance;
+        return instance;
+    }
+
+    void ProgramBinaryCache::open(const std::string &directory_)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!directory.empty())
+        {
+            return;
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(directory_, error);
+        if (error)
+        {
+            mbgl::Log::Warning(mbgl::Event::OpenGL, "Program binary cache disabled: " + error.message());
+            return;
+        }
+        directory = directory_;
+    }
+
+    bool ProgramBinaryCache::isOpen() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return !directory.empty();
+    }
+
+    void ProgramBinaryCache::close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        directory.clear();
+    }
+
+    void ProgramBinaryCache::validateDriver(const std::string &driverKey)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (directory.empty())
+        {
+            return;
+        }
+
+        const auto stampPath = std::filesystem::path(directory) / DRIVER_STAMP;
+        std::ifstream in(stampPath, std::ios::binary);
+        const std::string stamp((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (stamp == driverKey)
+        {
+            return;
+        }
+        in.close();
+
+        // Binaries from another driver build are useless at best, so start over
+        std::error_code error;
+        for (const auto &entry : std::filesystem::directory_iterator(directory, error))
+        {
+            std::filesystem::remove(entry.path(), error);
+        }
+        std::ofstream(stampPath, std::ios::binary | std::ios::trunc) << driverKey;
+
+        mbgl::Log::Info(mbgl::Event::OpenGL, "Program binary cache reset for " + driverKey);
+    }
+
+    std::string ProgramBinaryCache::entryPath(const void *key, size_t keySize) const
+    {
+        char name[17];
+        std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(fnv1a(key, keySize)));
+        return (std::filesystem::path(directory) / name).string();
+    }
+
+    void ProgramBinaryCache::store(const void *key, size_t keySize, const void *value, size_t valueSize)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (directory.empty())
+        {
+            return;
+        }
+
+        // Entry layout: u64 keySize, key, value
+        const std::string path = entryPath(key, keySize);
+        const std::string temp = path + ".tmp";
+        {
+            std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+            const uint64_t size = keySize;
+            out.write(reinterpret_cast<const char *>(&size), sizeof(size));
+            out.write(static_cast<const char *>(key), static_cast<std::streamsize>(keySize));
+            out.write(static_cast<const char *>(value), static_cast<std::streamsize>(valueSize));
+            if (!out)
+            {
+                return;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temp, path, error);
+    }
+
+    size_t ProgramBinaryCache::load(const void *key, size_t keySize, void *value, size_t valueSize)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (directory.empty())
+        {
+            return 0;
+        }
+
+        std::ifstream in(entryPath(key, keySize), std::ios::binary);
+        if (!in)
+        {
+            return 0;
+        }
+
+        uint64_t storedKeySize = 0;
+        in.read(reinterpret_cast<char *>(&storedKeySize), sizeof(storedKeySize));
+        if (!in || storedKeySize != keySize)
+        {
+            return 0;
+        }
+
+        // Hash collisions are possible, so the full key is compared
+        std::vector<char> storedKey(keySize);
+        in.read(storedKey.data(), static_cast<std::streamsize>(keySize));
+        if (!in || std::memcmp(storedKey.data(), key, keySize) != 0)
+        {
+            return 0;
+        }
+
+        const std::vector<char> binary((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (binary.size() <= valueSize)
+        {
+            std::memcpy(value, binary.data(), binary.size());
+        }
+        return binary.size();
+    }
+
+} // namespace maplibre_jni
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace maplibre_jni
+{
+
+    // Persistent key/value store for driver program binaries
+    //
+    // Drivers that implement EGL_ANDROID_blob_cache (ANGLE, Mesa) hand us their compiled
+    // program binaries through plain C callbacks without a user pointer, so the cache is a
+    // process-wide singleton. Entries live in one file per key under a directory next to the
+    // ambient cache, and are discarded when the GL vendor, renderer or version changes.
+    class ProgramBinaryCache
+    {
+    public:
+        static ProgramBinaryCache &get();
+
+        // Use directory for entries; the first call wins for the lifetime of the process
+        void open(const std::string &directory);
+        bool isOpen() const;
+        // Stop storing and loading entries, e.g. when the driver can't be identified
+        void close();
+
+        // Drop all entries if they were written by a different driver
+        void validateDriver(const std::string &driverKey);
+
+        void store(const void *key, size_t keySize, const void *value, size_t valueSize);
+
+        // Returns the stored size; value is only written when valueSize is large enough
+        size_t load(const void *key, size_t keySize, void *value, size_t valueSize);
+
+    private:
+        ProgramBinaryCache() = default;
+
+        std::string entryPath(const void *key, size_t keySize) const;
+
+        mutable std::mutex mutex;
+        std::string directory;
+    };
+
+} // namespace maplibre_jni
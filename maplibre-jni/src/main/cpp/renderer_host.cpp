@@ -0,0 +1,25 @@
+#include "renderer_host.hpp"
+
+namespace maplibre_jni
+{
+
+    std::shared_ptr<RendererHost> RendererHost::forCurrentThread()
+    {
+        thread_local std::weak_ptr<RendererHost> current;
+        auto host = current.lock();
+        if (!host)
+        {
+            host = std::shared_ptr<RendererHost>(new RendererHost());
+            current = host;
+        }
+        return host;
+    }
+
+    RendererHost::RendererHost()
+        : runLoop(std::make_unique<mbgl::util::RunLoop>(mbgl::util::RunLoop::Type::New))
+    {
+    }
+
+    RendererHost::~RendererHost() = default;
+
+} // namespace maplibre_jni
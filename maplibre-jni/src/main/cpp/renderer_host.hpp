@@ -0,0 +1,34 @@
+#pragma once
+
+#include <mbgl/util/run_loop.hpp>
+#include <memory>
+
+namespace maplibre_jni
+{
+
+    // State shared by every AwtCanvasRenderer on one thread
+    //
+    // mbgl binds objects to the RunLoop that is current when they are created, and a new RunLoop
+    // makes itself current for its thread. With one loop per map, every map replaced the previous
+    // map's loop as the current one, and destroying any of them left the rest without a current
+    // loop. Renderers on a thread therefore share one loop through this host, which lives as long
+    // as any of them does.
+    class RendererHost
+    {
+    public:
+        static std::shared_ptr<RendererHost> forCurrentThread();
+
+        ~RendererHost();
+
+        RendererHost(const RendererHost &) = delete;
+        RendererHost &operator=(const RendererHost &) = delete;
+
+        mbgl::util::RunLoop &getRunLoop() { return *runLoop; }
+
+    private:
+        RendererHost();
+
+        std::unique_ptr<mbgl::util::RunLoop> runLoop;
+    };
+
+} // namespace maplibre_jni
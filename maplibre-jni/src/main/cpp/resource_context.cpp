@@ -0,0 +1,60 @@
+#include "resource_context.hpp"
+#include <algorithm>
+#include <mutex>
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        std::mutex contextsMutex;
+        std::vector<std::unique_ptr<ResourceContext>> contexts;
+    } // namespace
+
+    void *ResourceContext::intern(const void *fileSource, const std::vector<UrlRewriter::Rule> &urlRewriteRules,
+                                  const std::optional<WriteBehindCacheSource::Options> &ambientCache,
+                                  const std::optional<CompressedCacheSource::Options> &cacheCompression,
+                                  bool recordSession)
+    {
+        if (!fileSource && urlRewriteRules.empty() && !ambientCache && !cacheCompression && !recordSession)
+        {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(contextsMutex);
+        auto it = std::find_if(contexts.begin(), contexts.end(), [&](const auto &context)
+                               { return context->fileSource == fileSource && context->urlRewriteRules == urlRewriteRules &&
+                                        context->ambientCache == ambientCache && context->cacheCompression == cacheCompression &&
+                                        context->recordSession == recordSession; });
+        if (it != contexts.end())
+        {
+            return it->get();
+        }
+
+        auto context = std::make_unique<ResourceContext>();
+        context->fileSource = fileSource;
+        context->urlRewriteRules = urlRewriteRules;
+        context->ambientCache = ambientCache;
+        context->cacheCompression = cacheCompression;
+        context->recordSession = recordSession;
+        if (!urlRewriteRules.empty())
+        {
+            context->urlRewriter = std::make_shared<UrlRewriter>(urlRewriteRules);
+        }
+        contexts.push_back(std::move(context));
+        return contexts.back().get();
+    }
+
+    const ResourceContext *ResourceContext::find(const void *platformContext)
+    {
+        if (!platformContext)
+        {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lock(contextsMutex);
+        auto it = std::find_if(contexts.begin(), contexts.end(), [&](const auto &context)
+                               { return context.get() == platformContext; });
+        return it != contexts.end() ? it->get() : nullptr;
+    }
+
+} // namespace maplibre_jni
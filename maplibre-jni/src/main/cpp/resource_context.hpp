@@ -0,0 +1,44 @@
+#pragma once
+
+#include "compressed_cache_source.hpp"
+#include "url_rewriter.hpp"
+#include "write_behind_cache_source.hpp"
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace maplibre_jni
+{
+
+    // Binding settings that reach the file source factories along with mbgl::ResourceOptions
+    //
+    // Desktop mbgl never reads the platform context of ResourceOptions, and FileSourceManager
+    // includes it in the key it caches file sources under, so it points at one of these.
+    // Contexts are interned: equal settings give the same pointer, and therefore maps with
+    // otherwise equal options keep sharing file sources. Interned contexts live until exit.
+    struct ResourceContext
+    {
+        // Platform context of a JvmFileSource channel; nullptr uses mbgl's online source
+        const void *fileSource = nullptr;
+        std::vector<UrlRewriter::Rule> urlRewriteRules;
+        // Compiled from urlRewriteRules; nullptr without rules
+        std::shared_ptr<const UrlRewriter> urlRewriter;
+        // Ambient cache settings; nullopt leaves the database source as mbgl makes it
+        std::optional<WriteBehindCacheSource::Options> ambientCache;
+        // Compression of ambient cache entries; nullopt stores them as mbgl does
+        std::optional<CompressedCacheSource::Options> cacheCompression;
+        // Record requested resources to a session log next to the cache
+        bool recordSession = false;
+
+        // Platform context for these settings, or nullptr when they are the defaults. Throws
+        // std::invalid_argument for rules that don't compile.
+        static void *intern(const void *fileSource, const std::vector<UrlRewriter::Rule> &urlRewriteRules,
+                            const std::optional<WriteBehindCacheSource::Options> &ambientCache,
+                            const std::optional<CompressedCacheSource::Options> &cacheCompression,
+                            bool recordSession);
+
+        // Context behind a platform context, or nullptr
+        static const ResourceContext *find(const void *platformContext);
+    };
+
+} // namespace maplibre_jni
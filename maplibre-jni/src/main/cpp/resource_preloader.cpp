@@ -0,0 +1,210 @@
+#include "resource_preloader.hpp"
+#include "session_log.hpp"
+#include <mbgl/storage/response.hpp>
+#include <mbgl/util/logging.hpp>
+#include <mbgl/util/rapidjson.hpp>
+#include <algorithm>
+#include <optional>
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        // MapLibre's fallback when a symbol layer doesn't set text-font
+        const mbgl::FontStack defaultFontStack = {"Open Sans Regular", "Arial Unicode MS Regular"};
+
+        std::optional<mbgl::FontStack> fontStackFromJSON(const mbgl::JSValue &value)
+        {
+            if (!value.IsArray() || value.Empty())
+            {
+                return std::nullopt;
+            }
+
+            // ["literal", ["Font A", "Font B"]]
+            if (value.Size() == 2 && value[0].IsString() &&
+                std::string(value[0].GetString()) == "literal")
+            {
+                return fontStackFromJSON(value[1]);
+            }
+
+            mbgl::FontStack fontStack;
+            for (const auto &font : value.GetArray())
+            {
+                if (!font.IsString())
+                {
+                    // Data-driven font expressions can't be resolved before rendering
+                    return std::nullopt;
+                }
+                fontStack.emplace_back(font.GetString(), font.GetStringLength());
+            }
+            return fontStack;
+        }
+    } // namespace
+
+    ResourcePreloader::ResourcePreloader(std::shared_ptr<mbgl::FileSource> fileSource_, float pixelRatio_)
+        : fileSource(std::move(fileSource_)),
+          pixelRatio(pixelRatio_)
+    {
+    }
+
+    ResourcePreloader::~ResourcePreloader()
+    {
+        cancel();
+    }
+
+    void ResourcePreloader::preloadStyleURL(const std::string &url, const std::vector<uint16_t> &rangeStarts)
+    {
+        retired.clear();
+
+        const uint64_t id = nextRequestId++;
+        progress.requested++;
+        requests[id] = fileSource->request(
+            mbgl::Resource::style(url),
+            [this, id, rangeStarts](const mbgl::Response &response)
+            {
+                if (!response.error && response.data && !answered.count(id))
+                {
+                    preloadStyleJSON(*response.data, rangeStarts);
+                }
+                onResponse(id, response);
+            });
+    }
+
+    void ResourcePreloader::preloadStyleJSON(const std::string &json, const std::vector<uint16_t> &rangeStarts)
+    {
+        mbgl::JSDocument document;
+        document.Parse<0>(json.c_str());
+        if (document.HasParseError() || !document.IsObject())
+        {
+            mbgl::Log::Warning(mbgl::Event::General, "Preloader could not parse style JSON");
+            return;
+        }
+
+        // Glyphs: every literal font stack used by a layer, for each requested range
+        if (document.HasMember("glyphs") && document["glyphs"].IsString())
+        {
+            const std::string glyphURL = document["glyphs"].GetString();
+
+            std::vector<mbgl::FontStack> fontStacks;
+            if (document.HasMember("layers") && document["layers"].IsArray())
+            {
+                for (const auto &layer : document["layers"].GetArray())
+                {
+                    if (!layer.IsObject() || !layer.HasMember("layout") || !layer["layout"].IsObject())
+                    {
+                        continue;
+                    }
+                    const auto &layout = layer["layout"];
+                    if (!layout.HasMember("text-field"))
+                    {
+                        continue;
+                    }
+
+                    std::optional<mbgl::FontStack> fontStack =
+                        layout.HasMember("text-font") ? fontStackFromJSON(layout["text-font"]) : defaultFontStack;
+                    if (fontStack && std::find(fontStacks.begin(), fontStacks.end(), *fontStack) == fontStacks.end())
+                    {
+                        fontStacks.push_back(std::move(*fontStack));
+                    }
+                }
+            }
+
+            for (const auto &fontStack : fontStacks)
+            {
+                for (uint16_t start : rangeStarts)
+                {
+                    const uint16_t rangeStart = start & 0xFF00;
+                    preload(mbgl::Resource::glyphs(glyphURL, fontStack, {rangeStart, static_cast<uint16_t>(rangeStart + 255)}));
+                }
+            }
+        }
+
+        // Sprites: either a single base URL or an array of {id, url}
+        if (document.HasMember("sprite"))
+        {
+            std::vector<std::string> spriteURLs;
+            const auto &sprite = document["sprite"];
+            if (sprite.IsString())
+            {
+                spriteURLs.emplace_back(sprite.GetString());
+            }
+            else if (sprite.IsArray())
+            {
+                for (const auto &entry : sprite.GetArray())
+                {
+                    if (entry.IsObject() && entry.HasMember("url") && entry["url"].IsString())
+                    {
+                        spriteURLs.emplace_back(entry["url"].GetString());
+                    }
+                }
+            }
+
+            for (const auto &spriteURL : spriteURLs)
+            {
+                preload(mbgl::Resource::spriteJSON(spriteURL, pixelRatio));
+                preload(mbgl::Resource::spriteImage(spriteURL, pixelRatio));
+            }
+        }
+    }
+
+    size_t ResourcePreloader::preloadSession(const std::string &path, size_t maxRequests)
+    {
+        auto resources = SessionLog::read(path).resources(maxRequests);
+        for (auto &resource : resources)
+        {
+            preload(std::move(resource));
+        }
+        return resources.size();
+    }
+
+    void ResourcePreloader::preload(mbgl::Resource resource)
+    {
+        retired.clear();
+
+        const uint64_t id = nextRequestId++;
+        progress.requested++;
+        requests[id] = fileSource->request(
+            resource,
+            [this, id](const mbgl::Response &response)
+            {
+                onResponse(id, response);
+            });
+    }
+
+    void ResourcePreloader::cancel()
+    {
+        requests.clear();
+        retired.clear();
+        answered.clear();
+    }
+
+    void ResourcePreloader::onResponse(uint64_t id, const mbgl::Response &response)
+    {
+        // A stale cache hit is answered first and revalidated afterwards; count it once
+        if (answered.insert(id).second)
+        {
+            if (response.error && response.error->reason != mbgl::Response::Error::Reason::NotFound)
+            {
+                progress.failed++;
+            }
+            else
+            {
+                progress.completed++;
+            }
+        }
+
+        // Keep the request alive until the cache has a fresh copy
+        if (response.error || response.isFresh())
+        {
+            auto it = requests.find(id);
+            if (it != requests.end())
+            {
+                retired.push_back(std::move(it->second));
+                requests.erase(it);
+            }
+            answered.erase(id);
+        }
+    }
+
+} // namespace maplibre_jni
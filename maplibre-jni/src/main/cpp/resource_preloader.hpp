@@ -0,0 +1,69 @@
+#pragma once
+
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/resource.hpp>
+#include <mbgl/util/async_request.hpp>
+#include <mbgl/util/font_stack.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace maplibre_jni
+{
+
+    // Warms the ambient cache with the glyph ranges and sprite sheets a style needs
+    //
+    // All requests are issued at once through the resource loader, so they run in parallel
+    // and land in the on-disk cache keyed by their normalized (TileServerOptions) URLs.
+    // Callbacks arrive on the calling thread's RunLoop, i.e. during AwtCanvasRenderer::tick.
+    class ResourcePreloader
+    {
+    public:
+        struct Progress
+        {
+            uint32_t requested = 0;
+            uint32_t completed = 0;
+            uint32_t failed = 0;
+        };
+
+        ResourcePreloader(std::shared_ptr<mbgl::FileSource> fileSource, float pixelRatio);
+        ~ResourcePreloader();
+
+        // Fetch the style, then preload the glyph ranges of its font stacks and its sprites
+        void preloadStyleURL(const std::string &url, const std::vector<uint16_t> &rangeStarts);
+
+        // Preload the glyph ranges and sprites referenced by an in-memory style
+        void preloadStyleJSON(const std::string &json, const std::vector<uint16_t> &rangeStarts);
+
+        // Preload up to maxRequests resources of a SessionLog file at low priority, those most
+        // sessions requested first, and return how many were issued. Throws
+        // std::runtime_error if the log can't be read.
+        size_t preloadSession(const std::string &path, size_t maxRequests);
+
+        // Issue a single low-level preload request
+        void preload(mbgl::Resource resource);
+
+        Progress getProgress() const { return progress; }
+
+        // Drop all outstanding requests
+        void cancel();
+
+    private:
+        void onResponse(uint64_t id, const mbgl::Response &response);
+
+        std::shared_ptr<mbgl::FileSource> fileSource;
+        float pixelRatio;
+        uint64_t nextRequestId = 0;
+        std::unordered_map<uint64_t, std::unique_ptr<mbgl::AsyncRequest>> requests;
+        std::unordered_set<uint64_t> answered;
+
+        // Requests can't be destroyed from inside their own callback, so finished ones wait here
+        std::vector<std::unique_ptr<mbgl::AsyncRequest>> retired;
+        Progress progress;
+    };
+
+} // namespace maplibre_jni
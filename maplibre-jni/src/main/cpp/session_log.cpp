@@ -0,0 +1,381 @@
+#include "session_log.hpp"
+#include "jni_helpers.hpp"
+#include <mbgl/util/tileset.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        constexpr char MAGIC[] = {'M', 'L', 'S', 'E', 'S', 'S'};
+        constexpr uint16_t VERSION = 1;
+
+        // How an entry is stored
+        enum Form : uint8_t
+        {
+            // Any resource, by URL
+            Plain = 0,
+            // Tile whose URL is its template expanded in the XYZ or TMS scheme, by coordinates
+            XYZTile = 1,
+            TMSTile = 2,
+            // Tile whose URL doesn't follow from its template, e.g. after a resource transform
+            TileWithURL = 3,
+        };
+
+        std::string keyOf(mbgl::Resource::Kind kind, const std::string &url)
+        {
+            return std::to_string(static_cast<int>(kind)) + ':' + url;
+        }
+
+        void putVarint(std::string &out, uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<char>(value));
+        }
+
+        // Reads the fields of a log, throwing on truncated or malformed data
+        class Reader
+        {
+        public:
+            Reader(const std::string &data_, const std::string &path_)
+                : data(data_),
+                  path(path_)
+            {
+            }
+
+            uint8_t byte()
+            {
+                if (position >= data.size())
+                {
+                    fail();
+                }
+                return static_cast<uint8_t>(data[position++]);
+            }
+
+            uint64_t varint()
+            {
+                uint64_t value = 0;
+                for (int shift = 0; shift < 64; shift += 7)
+                {
+                    const uint8_t next = byte();
+                    value |= static_cast<uint64_t>(next & 0x7f) << shift;
+                    if (!(next & 0x80))
+                    {
+                        return value;
+                    }
+                }
+                fail();
+            }
+
+            std::string string()
+            {
+                const uint64_t length = varint();
+                if (length > data.size() - position)
+                {
+                    fail();
+                }
+                std::string result = data.substr(position, static_cast<size_t>(length));
+                position += static_cast<size_t>(length);
+                return result;
+            }
+
+            const std::string &stringAt(const std::vector<std::string> &strings)
+            {
+                const uint64_t i = varint();
+                if (i >= strings.size())
+                {
+                    fail();
+                }
+                return strings[static_cast<size_t>(i)];
+            }
+
+            [[noreturn]] void fail() const
+            {
+                throw std::runtime_error(path + " is not a valid session log");
+            }
+
+        private:
+            const std::string &data;
+            const std::string &path;
+            size_t position = 0;
+        };
+    } // namespace
+
+    std::string SessionLog::pathFor(const std::string &cachePath)
+    {
+        return cachePath + ".session";
+    }
+
+    SessionLog SessionLog::read(const std::string &path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+        {
+            throw std::runtime_error("Could not open " + path);
+        }
+        const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        Reader reader(data, path);
+        for (char expected : MAGIC)
+        {
+            if (reader.byte() != static_cast<uint8_t>(expected))
+            {
+                reader.fail();
+            }
+        }
+        const uint8_t versionLow = reader.byte();
+        const uint16_t version = static_cast<uint16_t>(versionLow | (reader.byte() << 8));
+        if (version != VERSION)
+        {
+            throw std::runtime_error(path + " has unsupported session log version " + std::to_string(version));
+        }
+
+        std::vector<std::string> strings(static_cast<size_t>(std::min<uint64_t>(reader.varint(), data.size())));
+        for (auto &string : strings)
+        {
+            string = reader.string();
+        }
+
+        SessionLog log;
+        const uint64_t count = reader.varint();
+        for (uint64_t i = 0; i < count; i++)
+        {
+            Entry entry;
+            const uint8_t kind = reader.byte();
+            if (kind > mbgl::Resource::Kind::Image)
+            {
+                reader.fail();
+            }
+            entry.kind = static_cast<mbgl::Resource::Kind>(kind);
+            const uint8_t form = reader.byte();
+            entry.weight = static_cast<uint32_t>(std::min<uint64_t>(reader.varint(), UINT32_MAX));
+
+            if (form == Plain)
+            {
+                entry.url = reader.stringAt(strings);
+            }
+            else if (form == XYZTile || form == TMSTile || form == TileWithURL)
+            {
+                mbgl::Resource::TileData tile;
+                tile.urlTemplate = reader.stringAt(strings);
+                tile.pixelRatio = reader.byte();
+                tile.z = static_cast<int8_t>(reader.byte());
+                tile.x = static_cast<int32_t>(reader.varint());
+                tile.y = static_cast<int32_t>(reader.varint());
+                if (form == TileWithURL)
+                {
+                    entry.url = reader.stringAt(strings);
+                }
+                else
+                {
+                    const auto scheme = form == XYZTile ? mbgl::Tileset::Scheme::XYZ : mbgl::Tileset::Scheme::TMS;
+                    entry.url = mbgl::Resource::tile(tile.urlTemplate, tile.pixelRatio, tile.x, tile.y, tile.z, scheme).url;
+                }
+                entry.tileData = std::move(tile);
+            }
+            else
+            {
+                reader.fail();
+            }
+            log.add(std::move(entry));
+        }
+        return log;
+    }
+
+    void SessionLog::write(const std::string &path) const
+    {
+        std::vector<std::string> strings;
+        std::unordered_map<std::string, uint64_t> stringIndex;
+        auto intern = [&](const std::string &string)
+        {
+            auto [it, inserted] = stringIndex.try_emplace(string, strings.size());
+            if (inserted)
+            {
+                strings.push_back(string);
+            }
+            return it->second;
+        };
+
+        std::string body;
+        putVarint(body, entries.size());
+        for (const auto &entry : entries)
+        {
+            body.push_back(static_cast<char>(entry.kind));
+            if (!entry.tileData)
+            {
+                body.push_back(static_cast<char>(Plain));
+                putVarint(body, entry.weight);
+                putVarint(body, intern(entry.url));
+                continue;
+            }
+
+            const auto &tile = *entry.tileData;
+            Form form = TileWithURL;
+            for (auto scheme : {mbgl::Tileset::Scheme::XYZ, mbgl::Tileset::Scheme::TMS})
+            {
+                if (mbgl::Resource::tile(tile.urlTemplate, tile.pixelRatio, tile.x, tile.y, tile.z, scheme).url == entry.url)
+                {
+                    form = scheme == mbgl::Tileset::Scheme::XYZ ? XYZTile : TMSTile;
+                    break;
+                }
+            }
+            body.push_back(static_cast<char>(form));
+            putVarint(body, entry.weight);
+            putVarint(body, intern(tile.urlTemplate));
+            body.push_back(static_cast<char>(tile.pixelRatio));
+            body.push_back(static_cast<char>(tile.z));
+            putVarint(body, static_cast<uint32_t>(tile.x));
+            putVarint(body, static_cast<uint32_t>(tile.y));
+            if (form == TileWithURL)
+            {
+                putVarint(body, intern(entry.url));
+            }
+        }
+
+        std::string header(MAGIC, sizeof(MAGIC));
+        header.push_back(static_cast<char>(VERSION & 0xff));
+        header.push_back(static_cast<char>(VERSION >> 8));
+        putVarint(header, strings.size());
+        for (const auto &string : strings)
+        {
+            putVarint(header, string.size());
+            header += string;
+        }
+
+        const std::string tempPath = path + ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            out.write(header.data(), static_cast<std::streamsize>(header.size()));
+            out.write(body.data(), static_cast<std::streamsize>(body.size()));
+            out.close();
+            if (!out)
+            {
+                std::error_code ignored;
+                std::filesystem::remove(tempPath, ignored);
+                throw std::runtime_error("Could not write " + tempPath);
+            }
+        }
+        std::filesystem::rename(tempPath, path);
+    }
+
+    bool SessionLog::add(const mbgl::Resource &resource)
+    {
+        const auto [it, inserted] = index.try_emplace(keyOf(resource.kind, resource.url), entries.size());
+        if (inserted)
+        {
+            entries.push_back({resource.kind, resource.url, resource.tileData, 1});
+        }
+        return inserted;
+    }
+
+    void SessionLog::add(Entry entry)
+    {
+        const auto [it, inserted] = index.try_emplace(keyOf(entry.kind, entry.url), entries.size());
+        if (inserted)
+        {
+            entries.push_back(std::move(entry));
+        }
+        else
+        {
+            auto &existing = entries[it->second].weight;
+            existing = static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(existing) + entry.weight, UINT32_MAX));
+        }
+    }
+
+    void SessionLog::merge(const SessionLog &other)
+    {
+        for (const auto &entry : other.entries)
+        {
+            add(entry);
+        }
+    }
+
+    void SessionLog::truncate(size_t maxEntries)
+    {
+        if (entries.size() <= maxEntries)
+        {
+            return;
+        }
+
+        std::vector<size_t> order(entries.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                         { return entries[a].weight > entries[b].weight; });
+        order.resize(maxEntries);
+        std::sort(order.begin(), order.end());
+
+        std::vector<Entry> kept;
+        kept.reserve(maxEntries);
+        index.clear();
+        for (size_t i : order)
+        {
+            index.emplace(keyOf(entries[i].kind, entries[i].url), kept.size());
+            kept.push_back(std::move(entries[i]));
+        }
+        entries = std::move(kept);
+    }
+
+    std::vector<mbgl::Resource> SessionLog::resources(size_t maxRequests) const
+    {
+        std::vector<const Entry *> order;
+        order.reserve(entries.size());
+        for (const auto &entry : entries)
+        {
+            order.push_back(&entry);
+        }
+        std::stable_sort(order.begin(), order.end(), [](const Entry *a, const Entry *b)
+                         { return a->weight > b->weight; });
+        order.resize(std::min(order.size(), maxRequests));
+
+        std::vector<mbgl::Resource> result;
+        result.reserve(order.size());
+        for (const Entry *entry : order)
+        {
+            mbgl::Resource resource(entry->kind, entry->url, entry->tileData);
+            resource.priority = mbgl::Resource::Priority::Low;
+            result.push_back(std::move(resource));
+        }
+        return result;
+    }
+
+} // namespace maplibre_jni
+
+// JNI bindings
+extern "C"
+{
+
+    JNIEXPORT jint JNICALL Java_org_maplibre_kmp_native_SessionLog_nativeMerge(JNIEnv *env, jclass, jobjectArray inputs, jstring output, jint maxEntries)
+    {
+        try
+        {
+            maplibre_jni::SessionLog merged;
+            const jsize count = env->GetArrayLength(inputs);
+            for (jsize i = 0; i < count; i++)
+            {
+                auto input = static_cast<jstring>(env->GetObjectArrayElement(inputs, i));
+                const std::string path = jstringToString(env, input);
+                env->DeleteLocalRef(input);
+                merged.merge(maplibre_jni::SessionLog::read(path));
+            }
+            merged.truncate(static_cast<size_t>(std::max<jint>(0, maxEntries)));
+            merged.write(jstringToString(env, output));
+            return static_cast<jint>(merged.size());
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+            return 0;
+        }
+    }
+
+} // extern "C"
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <mbgl/storage/resource.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace maplibre_jni
+{
+
+    // Resources a session requested, for warming the ambient cache before the next one
+    //
+    // Each distinct resource is kept once, in the order first requested, with a weight: 1 in
+    // a recorded session, and the number of sessions that requested it once logs are merged
+    // into a deployment-wide aggregate. The file stores URL templates and URLs once in a
+    // string table and tiles as varint coordinates against their template, so a morning's
+    // worth of panning takes a few bytes per tile.
+    class SessionLog
+    {
+    public:
+        struct Entry
+        {
+            mbgl::Resource::Kind kind = mbgl::Resource::Kind::Unknown;
+            std::string url;
+            std::optional<mbgl::Resource::TileData> tileData;
+            uint32_t weight = 1;
+        };
+
+        // Log file recorded for the ambient cache at cachePath
+        static std::string pathFor(const std::string &cachePath);
+
+        // Throws std::runtime_error if the file can't be read or isn't a session log
+        static SessionLog read(const std::string &path);
+
+        // Writes next to path and renames into place. Throws std::runtime_error on failure.
+        void write(const std::string &path) const;
+
+        // Adds a resource unless it is already logged; returns whether it was added
+        bool add(const mbgl::Resource &resource);
+
+        // Adds the entries of another log, summing the weights of those in both
+        void merge(const SessionLog &other);
+
+        // Keeps the maxEntries heaviest entries, in their current order
+        void truncate(size_t maxEntries);
+
+        // Up to maxRequests low-priority resources, heaviest first
+        std::vector<mbgl::Resource> resources(size_t maxRequests) const;
+
+        size_t size() const { return entries.size(); }
+        bool empty() const { return entries.empty(); }
+
+    private:
+        void add(Entry entry);
+
+        std::vector<Entry> entries;
+        // Index into entries by kind and URL
+        std::unordered_map<std::string, size_t> index;
+    };
+
+} // namespace maplibre_jni
@@ -0,0 +1,208 @@
+#include "session_recorder_source.hpp"
+#include "session_log.hpp"
+#include <mbgl/actor/scheduler.hpp>
+#include <mbgl/util/async_request.hpp>
+#include <mbgl/util/logging.hpp>
+#include <chrono>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        // Shortest time between two writes of a growing log
+        constexpr auto WRITE_INTERVAL = std::chrono::seconds(10);
+
+        // Local resources are as fast as the cache already
+        bool isRemote(const std::string &url)
+        {
+            for (std::string_view scheme : {"asset://", "file://", "mbtiles://"})
+            {
+                if (url.compare(0, scheme.size(), scheme) == 0)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    } // namespace
+
+    struct SessionRecorderSource::Recording
+    {
+        std::string path;
+
+        std::mutex mutex;
+        SessionLog log;
+        bool dirty = false;
+        bool writeScheduled = false;
+        Clock::time_point lastWrite;
+
+        // Serializes writes of the file
+        std::mutex fileMutex;
+
+        void save()
+        {
+            std::lock_guard<std::mutex> fileLock(fileMutex);
+            SessionLog snapshot;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                writeScheduled = false;
+                if (!dirty)
+                {
+                    return;
+                }
+                snapshot = log;
+                dirty = false;
+                lastWrite = Clock::now();
+            }
+
+            try
+            {
+                snapshot.write(path);
+            }
+            catch (const std::exception &e)
+            {
+                mbgl::Log::Warning(mbgl::Event::General, std::string("Could not record session: ") + e.what());
+            }
+        }
+    };
+
+    std::shared_ptr<SessionRecorderSource::Recording> SessionRecorderSource::recordingFor(const std::string &path)
+    {
+        // Maps on the same ambient cache log into one recording instead of replacing each
+        // other's file; it lives as long as any of their sources
+        static std::mutex registryMutex;
+        static std::unordered_map<std::string, std::weak_ptr<Recording>> registry;
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        std::erase_if(registry, [](const auto &entry)
+                      { return entry.second.expired(); });
+
+        auto &entry = registry[path];
+        auto recording = entry.lock();
+        if (!recording)
+        {
+            recording = std::make_shared<Recording>();
+            recording->path = path;
+            recording->lastWrite = Clock::now();
+            entry = recording;
+        }
+        return recording;
+    }
+
+    SessionRecorderSource::SessionRecorderSource(std::unique_ptr<mbgl::FileSource> upstream_, const std::string &path)
+        : upstream(std::move(upstream_)),
+          recording(recordingFor(path))
+    {
+    }
+
+    SessionRecorderSource::~SessionRecorderSource()
+    {
+        recording->save();
+    }
+
+    void SessionRecorderSource::record(const mbgl::Resource &resource)
+    {
+        if (resource.priority == mbgl::Resource::Priority::Low || resource.kind == mbgl::Resource::Kind::Unknown ||
+            !resource.hasLoadingMethod(mbgl::Resource::LoadingMethod::Network) || !isRemote(resource.url))
+        {
+            return;
+        }
+
+        bool schedule = false;
+        {
+            std::lock_guard<std::mutex> lock(recording->mutex);
+            if (recording->log.size() >= MAX_ENTRIES || !recording->log.add(resource))
+            {
+                return;
+            }
+            recording->dirty = true;
+            if (!recording->writeScheduled && Clock::now() - recording->lastWrite >= WRITE_INTERVAL)
+            {
+                recording->writeScheduled = true;
+                schedule = true;
+            }
+        }
+        if (schedule)
+        {
+            mbgl::Scheduler::GetBackground()->schedule([weak = std::weak_ptr<Recording>(recording)]
+                                                       {
+                                                           if (auto recording = weak.lock())
+                                                           {
+                                                               recording->save();
+                                                           } });
+        }
+    }
+
+    std::unique_ptr<mbgl::AsyncRequest> SessionRecorderSource::request(const mbgl::Resource &resource, Callback callback)
+    {
+        record(resource);
+        return upstream->request(resource, std::move(callback));
+    }
+
+    void SessionRecorderSource::forward(const mbgl::Resource &resource, const mbgl::Response &response, std::function<void()> callback)
+    {
+        upstream->forward(resource, response, std::move(callback));
+    }
+
+    bool SessionRecorderSource::canRequest(const mbgl::Resource &resource) const
+    {
+        return upstream->canRequest(resource);
+    }
+
+    bool SessionRecorderSource::supportsCacheOnlyRequests() const
+    {
+        return upstream->supportsCacheOnlyRequests();
+    }
+
+    void SessionRecorderSource::pause()
+    {
+        upstream->pause();
+    }
+
+    void SessionRecorderSource::resume()
+    {
+        upstream->resume();
+    }
+
+    void SessionRecorderSource::setProperty(const std::string &key, const mapbox::base::Value &value)
+    {
+        upstream->setProperty(key, value);
+    }
+
+    mapbox::base::Value SessionRecorderSource::getProperty(const std::string &key) const
+    {
+        return upstream->getProperty(key);
+    }
+
+    void SessionRecorderSource::setResourceTransform(mbgl::ResourceTransform transform)
+    {
+        upstream->setResourceTransform(std::move(transform));
+    }
+
+    void SessionRecorderSource::setResourceOptions(mbgl::ResourceOptions options)
+    {
+        upstream->setResourceOptions(std::move(options));
+    }
+
+    mbgl::ResourceOptions SessionRecorderSource::getResourceOptions()
+    {
+        return upstream->getResourceOptions();
+    }
+
+    void SessionRecorderSource::setClientOptions(mbgl::ClientOptions options)
+    {
+        upstream->setClientOptions(std::move(options));
+    }
+
+    mbgl::ClientOptions SessionRecorderSource::getClientOptions()
+    {
+        return upstream->getClientOptions();
+    }
+
+} // namespace maplibre_jni
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/resource.hpp>
+#include <mbgl/storage/response.hpp>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace maplibre_jni
+{
+
+    // FileSource wrapper that records what maps request to a SessionLog for the next launch
+    //
+    // Each remote resource a map requests at regular priority is logged once, up to
+    // MAX_ENTRIES. Low-priority requests, i.e. trajectory prefetches and cache warm-ups, are
+    // left out, so replaying a log doesn't keep its entries alive by itself. While the log
+    // grows it is written on mbgl's background scheduler at most every few seconds, and once
+    // more when the source is destroyed; each session replaces the previous session's log.
+    // Sources recording to the same path share one log, so every map on an ambient cache
+    // contributes to it.
+    class SessionRecorderSource final : public mbgl::FileSource
+    {
+    public:
+        static constexpr size_t MAX_ENTRIES = 20000;
+
+        SessionRecorderSource(std::unique_ptr<mbgl::FileSource> upstream, const std::string &path);
+        // Writes the log if it changed since the last write
+        ~SessionRecorderSource() override;
+
+        std::unique_ptr<mbgl::AsyncRequest> request(const mbgl::Resource &resource, Callback callback) override;
+
+        void forward(const mbgl::Resource &resource, const mbgl::Response &response, std::function<void()> callback) override;
+        bool canRequest(const mbgl::Resource &resource) const override;
+        bool supportsCacheOnlyRequests() const override;
+        void pause() override;
+        void resume() override;
+        void setProperty(const std::string &key, const mapbox::base::Value &value) override;
+        mapbox::base::Value getProperty(const std::string &key) const override;
+        void setResourceTransform(mbgl::ResourceTransform transform) override;
+        void setResourceOptions(mbgl::ResourceOptions options) override;
+        mbgl::ResourceOptions getResourceOptions() override;
+        void setClientOptions(mbgl::ClientOptions options) override;
+        mbgl::ClientOptions getClientOptions() override;
+
+    private:
+        // Log and file state, shared with writes on the background scheduler
+        struct Recording;
+
+        static std::shared_ptr<Recording> recordingFor(const std::string &path);
+
+        void record(const mbgl::Resource &resource);
+
+        std::unique_ptr<mbgl::FileSource> upstream;
+        std::shared_ptr<Recording> recording;
+    };
+
+} // namespace maplibre_jni
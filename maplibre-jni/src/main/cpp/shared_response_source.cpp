@@ -0,0 +1,281 @@
+#include "shared_response_source.hpp"
+#include <mbgl/actor/scheduler.hpp>
+#include <mbgl/util/async_request.hpp>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        struct Waiter
+        {
+            mbgl::FileSource::Callback callback;
+            // RunLoop of the requesting thread
+            mbgl::Scheduler *scheduler = nullptr;
+            std::atomic<bool> cancelled{false};
+        };
+
+        void deliver(const std::shared_ptr<Waiter> &waiter, const mbgl::Response &response, bool replay)
+        {
+            if (!replay && (!waiter->scheduler || waiter->scheduler == mbgl::Scheduler::GetCurrent()))
+            {
+                if (!waiter->cancelled)
+                {
+                    waiter->callback(response);
+                }
+                return;
+            }
+
+            // Other threads, and replays that must not run inside request(), go through the loop
+            std::weak_ptr<Waiter> weak = waiter;
+            waiter->scheduler->schedule([weak, response]
+                                        {
+                                            auto target = weak.lock();
+                                            if (target && !target->cancelled)
+                                            {
+                                                target->callback(response);
+                                            } });
+        }
+
+        std::optional<std::string> sharingKey(const mbgl::Resource &resource)
+        {
+            if (resource.priorEtag || resource.priorModified || resource.priorData || resource.dataRange)
+            {
+                return std::nullopt;
+            }
+            return std::to_string(static_cast<int>(resource.kind)) + ':' +
+                   std::to_string(static_cast<int>(resource.loadingMethod)) + ':' +
+                   std::to_string(static_cast<int>(resource.storagePolicy)) + ':' +
+                   std::to_string(static_cast<int>(resource.usage)) + ':' + resource.url;
+        }
+    } // namespace
+
+    struct SharedResponseSource::Flight
+    {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<Waiter>> waiters;
+        // Last response with a body or an error, kept up to date by later revalidations;
+        // never a bare 304, which would leave a joining requester without data
+        std::optional<mbgl::Response> latest;
+        std::unique_ptr<mbgl::AsyncRequest> upstreamRequest;
+    };
+
+    struct SharedResponseSource::Registry
+    {
+        std::mutex mutex;
+        std::unordered_map<std::string, std::weak_ptr<Flight>> flights;
+    };
+
+    // Handed to each requester; the shared upstream request is cancelled with the last one
+    class SharedResponseSource::Request final : public mbgl::AsyncRequest
+    {
+    public:
+        Request(std::shared_ptr<Registry> registry_,
+                      std::string key_,
+                      std::shared_ptr<Flight> flight_,
+                      std::shared_ptr<Waiter> waiter_)
+            : registry(std::move(registry_)),
+              key(std::move(key_)),
+              flight(std::move(flight_)),
+              waiter(std::move(waiter_))
+        {
+        }
+
+        ~Request() override
+        {
+            waiter->cancelled = true;
+
+            std::unique_ptr<mbgl::AsyncRequest> released;
+            {
+                std::lock_guard<std::mutex> lock(flight->mutex);
+                auto &waiters = flight->waiters;
+                waiters.erase(std::remove(waiters.begin(), waiters.end(), waiter), waiters.end());
+                if (waiters.empty())
+                {
+                    released = std::move(flight->upstreamRequest);
+                }
+            }
+
+            if (released)
+            {
+                std::lock_guard<std::mutex> lock(registry->mutex);
+                auto it = registry->flights.find(key);
+                if (it != registry->flights.end() && it->second.lock() == flight)
+                {
+                    registry->flights.erase(it);
+                }
+            }
+            // Cancel upstream outside the locks; its destructor may call back into the loader
+            released.reset();
+        }
+
+    private:
+        std::shared_ptr<Registry> registry;
+        std::string key;
+        std::shared_ptr<Flight> flight;
+        std::shared_ptr<Waiter> waiter;
+    };
+
+    SharedResponseSource::SharedResponseSource(std::unique_ptr<mbgl::FileSource> upstream_)
+        : upstream(std::move(upstream_)),
+          registry(std::make_shared<Registry>())
+    {
+    }
+
+    SharedResponseSource::~SharedResponseSource() = default;
+
+    std::unique_ptr<mbgl::AsyncRequest> SharedResponseSource::request(const mbgl::Resource &resource, Callback callback)
+    {
+        auto key = sharingKey(resource);
+        if (!key)
+        {
+            return upstream->request(resource, std::move(callback));
+        }
+
+        auto waiter = std::make_shared<Waiter>();
+        waiter->callback = std::move(callback);
+        waiter->scheduler = mbgl::Scheduler::GetCurrent();
+
+        std::shared_ptr<Flight> flight;
+        bool joined = false;
+        {
+            std::lock_guard<std::mutex> lock(registry->mutex);
+            auto &slot = registry->flights[*key];
+            flight = slot.lock();
+            joined = flight != nullptr;
+            if (!flight)
+            {
+                flight = std::make_shared<Flight>();
+                slot = flight;
+            }
+        }
+
+        std::optional<mbgl::Response> replay;
+        {
+            std::lock_guard<std::mutex> lock(flight->mutex);
+            flight->waiters.push_back(waiter);
+            replay = flight->latest;
+        }
+
+        if (joined)
+        {
+            // Without a RunLoop the replay has nowhere to go; the next response still arrives
+            if (replay && waiter->scheduler)
+            {
+                deliver(waiter, *replay, true);
+            }
+            return std::make_unique<Request>(registry, std::move(*key), std::move(flight), std::move(waiter));
+        }
+
+        std::weak_ptr<Flight> weakFlight = flight;
+        auto upstreamRequest = upstream->request(resource, [weakFlight](const mbgl::Response &response)
+                                                 {
+                                                     auto current = weakFlight.lock();
+                                                     if (!current)
+                                                     {
+                                                         return;
+                                                     }
+
+                                                     std::vector<std::shared_ptr<Waiter>> waiters;
+                                                     {
+                                                         std::lock_guard<std::mutex> lock(current->mutex);
+                                                         if (!response.notModified)
+                                                         {
+                                                             current->latest = response;
+                                                         }
+                                                         else if (current->latest)
+                                                         {
+                                                             // Refresh the validity of the kept body
+                                                             auto &latest = *current->latest;
+                                                             latest.expires = response.expires;
+                                                             latest.mustRevalidate = response.mustRevalidate;
+                                                             if (response.modified)
+                                                             {
+                                                                 latest.modified = response.modified;
+                                                             }
+                                                             if (response.etag)
+                                                             {
+                                                                 latest.etag = response.etag;
+                                                             }
+                                                         }
+                                                         waiters = current->waiters;
+                                                     }
+                                                     for (const auto &target : waiters)
+                                                     {
+                                                         deliver(target, response, false);
+                                                     } });
+        {
+            std::lock_guard<std::mutex> lock(flight->mutex);
+            flight->upstreamRequest = std::move(upstreamRequest);
+        }
+        return std::make_unique<Request>(registry, std::move(*key), std::move(flight), std::move(waiter));
+    }
+
+    void SharedResponseSource::forward(const mbgl::Resource &resource, const mbgl::Response &response, std::function<void()> callback)
+    {
+        upstream->forward(resource, response, std::move(callback));
+    }
+
+    bool SharedResponseSource::canRequest(const mbgl::Resource &resource) const
+    {
+        return upstream->canRequest(resource);
+    }
+
+    bool SharedResponseSource::supportsCacheOnlyRequests() const
+    {
+        return upstream->supportsCacheOnlyRequests();
+    }
+
+    void SharedResponseSource::pause()
+    {
+        upstream->pause();
+    }
+
+    void SharedResponseSource::resume()
+    {
+        upstream->resume();
+    }
+
+    void SharedResponseSource::setProperty(const std::string &key, const mapbox::base::Value &value)
+    {
+        upstream->setProperty(key, value);
+    }
+
+    mapbox::base::Value SharedResponseSource::getProperty(const std::string &key) const
+    {
+        return upstream->getProperty(key);
+    }
+
+    void SharedResponseSource::setResourceTransform(mbgl::ResourceTransform transform)
+    {
+        upstream->setResourceTransform(std::move(transform));
+    }
+
+    void SharedResponseSource::setResourceOptions(mbgl::ResourceOptions options)
+    {
+        upstream->setResourceOptions(std::move(options));
+    }
+
+    mbgl::ResourceOptions SharedResponseSource::getResourceOptions()
+    {
+        return upstream->getResourceOptions();
+    }
+
+    void SharedResponseSource::setClientOptions(mbgl::ClientOptions options)
+    {
+        upstream->setClientOptions(std::move(options));
+    }
+
+    mbgl::ClientOptions SharedResponseSource::getClientOptions()
+    {
+        return upstream->getClientOptions();
+    }
+
+} // namespace maplibre_jni
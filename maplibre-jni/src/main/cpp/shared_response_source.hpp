@@ -0,0 +1,50 @@
+#pragma once
+
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/resource.hpp>
+#include <mbgl/storage/response.hpp>
+#include <memory>
+
+namespace maplibre_jni
+{
+
+    // FileSource wrapper that lets maps share requests for the same resource
+    //
+    // FileSourceManager hands every map with the same ResourceOptions the same resource loader,
+    // so wrapping it makes one request per URL serve all of those maps: while any map holds a
+    // request for a tile, glyph range or sprite, other maps asking for it join that request and
+    // immediately receive its latest body or error, with the expiry of any revalidation since
+    // (a 304 alone carries no data to replay). Response bodies are shared pointers, so joined
+    // maps also share the bytes. Requests carrying revalidation data or a byte range are not
+    // shared. Each response is delivered on the RunLoop of the thread that made the request.
+    class SharedResponseSource final : public mbgl::FileSource
+    {
+    public:
+        explicit SharedResponseSource(std::unique_ptr<mbgl::FileSource> upstream);
+        ~SharedResponseSource() override;
+
+        std::unique_ptr<mbgl::AsyncRequest> request(const mbgl::Resource &resource, Callback callback) override;
+
+        void forward(const mbgl::Resource &resource, const mbgl::Response &response, std::function<void()> callback) override;
+        bool canRequest(const mbgl::Resource &resource) const override;
+        bool supportsCacheOnlyRequests() const override;
+        void pause() override;
+        void resume() override;
+        void setProperty(const std::string &key, const mapbox::base::Value &value) override;
+        mapbox::base::Value getProperty(const std::string &key) const override;
+        void setResourceTransform(mbgl::ResourceTransform transform) override;
+        void setResourceOptions(mbgl::ResourceOptions options) override;
+        mbgl::ResourceOptions getResourceOptions() override;
+        void setClientOptions(mbgl::ClientOptions options) override;
+        mbgl::ClientOptions getClientOptions() override;
+
+    private:
+        struct Flight;
+        struct Registry;
+        class Request;
+
+        std::unique_ptr<mbgl::FileSource> upstream;
+        std::shared_ptr<Registry> registry;
+    };
+
+} // namespace maplibre_jni
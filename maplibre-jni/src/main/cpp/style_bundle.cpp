@@ -0,0 +1,619 @@
+#include "style_bundle.hpp"
+#include "jni_helpers.hpp"
+#include <mbgl/style/parser.hpp>
+#include <mbgl/util/rapidjson.hpp>
+#include <mbgl/util/url.hpp>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        constexpr char MAGIC[8] = {'M', 'L', 'B', 'U', 'N', 'D', 'L', 'E'};
+        constexpr uint32_t FORMAT_VERSION = 1;
+
+        constexpr std::string_view URL_PREFIX = "asset://bundle-";
+        constexpr size_t ID_DIGITS = 16;
+
+        struct Header
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t entryCount;
+            uint64_t id;
+            uint64_t styleOffset;
+            uint64_t styleLength;
+            // Records followed by the names they point into
+            uint64_t indexOffset;
+            uint64_t indexLength;
+            uint64_t indexChecksum;
+        };
+
+        // FNV-1a, enough to catch truncated or partially written bundles
+        uint64_t checksum(const uint8_t *data, size_t length)
+        {
+            uint64_t hash = 14695981039346656037ull;
+            for (size_t i = 0; i < length; ++i)
+            {
+                hash ^= data[i];
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        std::mutex bundlesMutex;
+        std::unordered_map<uint64_t, std::weak_ptr<StyleBundle>> bundlesById;
+        std::unordered_map<std::string, std::weak_ptr<StyleBundle>> bundlesByPath;
+
+        std::string spriteName(const std::string &spriteId)
+        {
+            return "sprites/" + spriteId;
+        }
+
+        std::string tileTemplate(const std::string &root, const std::string &source)
+        {
+            return root + "tiles/" + mbgl::util::percentEncode(source) + "/{z}/{x}/{y}";
+        }
+
+        void setMember(mbgl::JSValue &object, const char *name, mbgl::JSValue value, mbgl::JSDocument::AllocatorType &allocator)
+        {
+            auto member = object.FindMember(name);
+            if (member != object.MemberEnd())
+            {
+                member->value = value;
+            }
+            else
+            {
+                object.AddMember(rapidjson::StringRef(name), value, allocator);
+            }
+        }
+
+        void setString(mbgl::JSValue &value, const std::string &string, mbgl::JSDocument::AllocatorType &allocator)
+        {
+            value.SetString(string.c_str(), static_cast<rapidjson::SizeType>(string.size()), allocator);
+        }
+
+        // Resolves "bundle://" URLs anywhere in the style
+        void resolveBundleURLs(mbgl::JSValue &value, const std::string &root, mbgl::JSDocument::AllocatorType &allocator)
+        {
+            if (value.IsString())
+            {
+                const std::string_view string(value.GetString(), value.GetStringLength());
+                if (string.substr(0, StyleBundleWriter::BUNDLE_SCHEME.size()) == StyleBundleWriter::BUNDLE_SCHEME)
+                {
+                    setString(value, root + std::string(string.substr(StyleBundleWriter::BUNDLE_SCHEME.size())), allocator);
+                }
+            }
+            else if (value.IsArray())
+            {
+                for (auto &element : value.GetArray())
+                {
+                    resolveBundleURLs(element, root, allocator);
+                }
+            }
+            else if (value.IsObject())
+            {
+                for (auto member = value.MemberBegin(); member != value.MemberEnd(); ++member)
+                {
+                    resolveBundleURLs(member->value, root, allocator);
+                }
+            }
+        }
+    } // namespace
+
+    // Index entry; the index starts 8-byte aligned so records are read in place
+    struct StyleBundle::Record
+    {
+        uint64_t offset;
+        uint64_t length;
+        // Within the names that follow the records
+        uint32_t nameOffset;
+        uint32_t nameLength;
+    };
+
+    static_assert(sizeof(Header) == 64, "Header layout is part of the format");
+
+    std::shared_ptr<StyleBundle> StyleBundle::open(const std::string &path)
+    {
+        std::lock_guard<std::mutex> lock(bundlesMutex);
+        if (auto existing = bundlesByPath[path].lock())
+        {
+            return existing;
+        }
+
+        auto bundle = std::shared_ptr<StyleBundle>(new StyleBundle(path, MappedFile::open(path)));
+        bundle->validate();
+        bundlesByPath[path] = bundle;
+        bundlesById[bundle->id] = bundle;
+        return bundle;
+    }
+
+    std::shared_ptr<StyleBundle> StyleBundle::find(uint64_t id)
+    {
+        std::lock_guard<std::mutex> lock(bundlesMutex);
+        auto it = bundlesById.find(id);
+        return it != bundlesById.end() ? it->second.lock() : nullptr;
+    }
+
+    std::string StyleBundle::rootURL(uint64_t id)
+    {
+        char digits[ID_DIGITS + 1];
+        std::snprintf(digits, sizeof(digits), "%016llx", static_cast<unsigned long long>(id));
+        return std::string(URL_PREFIX) + digits + "/";
+    }
+
+    std::optional<std::pair<uint64_t, std::string>> StyleBundle::parseURL(const std::string &url)
+    {
+        if (url.size() < URL_PREFIX.size() + ID_DIGITS + 1 || url.compare(0, URL_PREFIX.size(), URL_PREFIX) != 0 ||
+            url[URL_PREFIX.size() + ID_DIGITS] != '/')
+        {
+            return std::nullopt;
+        }
+
+        uint64_t id = 0;
+        for (size_t i = URL_PREFIX.size(); i < URL_PREFIX.size() + ID_DIGITS; i++)
+        {
+            const char c = url[i];
+            const int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+            if (digit < 0)
+            {
+                return std::nullopt;
+            }
+            id = (id << 4) | static_cast<uint64_t>(digit);
+        }
+
+        // Drop any query; entry names never have one
+        std::string name = url.substr(URL_PREFIX.size() + ID_DIGITS + 1);
+        name.erase(std::min(name.find('?'), name.size()));
+        return std::make_pair(id, mbgl::util::percentDecode(name));
+    }
+
+    StyleBundle::StyleBundle(std::string path_, std::unique_ptr<MappedFile> file_)
+        : path(std::move(path_)),
+          file(std::move(file_))
+    {
+    }
+
+    void StyleBundle::validate()
+    {
+        const uint8_t *data = file->data();
+        const uint64_t size = file->size();
+        Header header;
+        if (size < sizeof(Header))
+        {
+            throw std::runtime_error(path + " is not a style bundle");
+        }
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+        {
+            throw std::runtime_error(path + " is not a style bundle");
+        }
+        if (header.version != FORMAT_VERSION)
+        {
+            throw std::runtime_error(path + " is a style bundle of an unsupported version");
+        }
+
+        const uint64_t recordsLength = static_cast<uint64_t>(header.entryCount) * sizeof(Record);
+        if (header.indexOffset % alignof(Record) != 0 || header.indexOffset > size ||
+            header.indexLength != size - header.indexOffset || header.indexLength < recordsLength ||
+            header.styleOffset > header.indexOffset || header.styleLength > header.indexOffset - header.styleOffset ||
+            header.indexChecksum != checksum(data + header.indexOffset, header.indexLength))
+        {
+            throw std::runtime_error(path + " is a corrupt style bundle");
+        }
+
+        id = header.id;
+        dataEnd = header.indexOffset;
+        records = reinterpret_cast<const Record *>(data + header.indexOffset);
+        count = header.entryCount;
+        names = reinterpret_cast<const char *>(data + header.indexOffset + recordsLength);
+        namesLength = header.indexLength - recordsLength;
+        styleJSON = std::string_view(reinterpret_cast<const char *>(data + header.styleOffset), header.styleLength);
+    }
+
+    std::string_view StyleBundle::style() const
+    {
+        return styleJSON;
+    }
+
+    std::optional<std::string_view> StyleBundle::get(std::string_view name) const
+    {
+        auto nameOf = [this](const Record &record)
+        {
+            if (static_cast<uint64_t>(record.nameOffset) + record.nameLength > namesLength)
+            {
+                return std::string_view();
+            }
+            return std::string_view(names + record.nameOffset, record.nameLength);
+        };
+
+        const Record *end = records + count;
+        const Record *record = std::lower_bound(records, end, name, [&](const Record &candidate, std::string_view target)
+                                                { return nameOf(candidate) < target; });
+        if (record == end || nameOf(*record) != name || record->offset > dataEnd ||
+            record->length > dataEnd - record->offset)
+        {
+            return std::nullopt;
+        }
+        return std::string_view(reinterpret_cast<const char *>(file->data() + record->offset), record->length);
+    }
+
+    StyleBundleWriter::StyleBundleWriter(const std::string &path_)
+        : path(path_),
+          tempPath(path_ + ".tmp")
+    {
+        std::random_device random;
+        id = (static_cast<uint64_t>(random()) << 32) ^ random();
+
+        const std::filesystem::path target(path);
+        if (target.has_parent_path())
+        {
+            std::filesystem::create_directories(target.parent_path());
+        }
+        out.open(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            throw std::runtime_error("Could not create " + tempPath);
+        }
+
+        // Filled in by finish
+        const Header header{};
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        offset = sizeof(header);
+    }
+
+    StyleBundleWriter::~StyleBundleWriter()
+    {
+        if (!finished)
+        {
+            out.close();
+            std::error_code ignored;
+            std::filesystem::remove(tempPath, ignored);
+        }
+    }
+
+    StyleBundleWriter::Range StyleBundleWriter::write(const uint8_t *data, size_t length)
+    {
+        if (finished)
+        {
+            throw std::runtime_error("Style bundle " + path + " is already finished");
+        }
+        out.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(length));
+        if (!out)
+        {
+            throw std::runtime_error("Could not write " + tempPath);
+        }
+        const Range range{offset, length};
+        offset += length;
+        return range;
+    }
+
+    void StyleBundleWriter::add(const std::string &name, const uint8_t *data, size_t length)
+    {
+        if (name.size() > UINT32_MAX)
+        {
+            throw std::runtime_error("Entry name too long");
+        }
+        entries[name] = write(data, length);
+    }
+
+    void StyleBundleWriter::addTile(const std::string &source, uint8_t z, uint32_t x, uint32_t y, const uint8_t *data, size_t length)
+    {
+        add("tiles/" + source + "/" + std::to_string(z) + "/" + std::to_string(x) + "/" + std::to_string(y), data, length);
+
+        auto it = tileSources.find(source);
+        if (it == tileSources.end())
+        {
+            tileSources.emplace(source, std::make_pair(z, z));
+        }
+        else
+        {
+            it->second.first = std::min(it->second.first, z);
+            it->second.second = std::max(it->second.second, z);
+        }
+    }
+
+    void StyleBundleWriter::addGlyphs(const std::string &fontStack, uint16_t rangeStart, const uint8_t *data, size_t length)
+    {
+        if (rangeStart % 256 != 0)
+        {
+            throw std::runtime_error("Glyph ranges start at a multiple of 256");
+        }
+        add("glyphs/" + fontStack + "/" + std::to_string(rangeStart) + "-" + std::to_string(rangeStart + 255) + ".pbf", data, length);
+        hasGlyphs = true;
+    }
+
+    void StyleBundleWriter::addSprite(const std::string &spriteId, uint32_t pixelRatio, const uint8_t *json, size_t jsonLength,
+                                      const uint8_t *image, size_t imageLength)
+    {
+        const std::string name = spriteName(spriteId) + (pixelRatio > 1 ? "@" + std::to_string(pixelRatio) + "x" : "");
+        add(name + ".json", json, jsonLength);
+        add(name + ".png", image, imageLength);
+        spriteIds.insert(spriteId);
+    }
+
+    std::string StyleBundleWriter::rewriteStyle(const std::string &json) const
+    {
+        mbgl::JSDocument document;
+        document.Parse<0>(json.c_str());
+        if (document.HasParseError() || !document.IsObject())
+        {
+            throw std::runtime_error("Invalid style JSON");
+        }
+
+        auto &allocator = document.GetAllocator();
+        const std::string root = StyleBundle::rootURL(id);
+        resolveBundleURLs(document, root, allocator);
+
+        auto sources = document.FindMember("sources");
+        if (sources != document.MemberEnd() && sources->value.IsObject())
+        {
+            for (auto source = sources->value.MemberBegin(); source != sources->value.MemberEnd(); ++source)
+            {
+                const std::string sourceId(source->name.GetString(), source->name.GetStringLength());
+                auto tiles = tileSources.find(sourceId);
+                if (tiles == tileSources.end() || !source->value.IsObject())
+                {
+                    continue;
+                }
+
+                // Inline the TileJSON; the bundled tiles are stored in the XYZ scheme
+                auto &object = source->value;
+                object.RemoveMember("url");
+                object.RemoveMember("scheme");
+                mbgl::JSValue urls(rapidjson::kArrayType);
+                mbgl::JSValue url;
+                setString(url, tileTemplate(root, sourceId), allocator);
+                urls.PushBack(url, allocator);
+                setMember(object, "tiles", std::move(urls), allocator);
+                if (!object.HasMember("minzoom"))
+                {
+                    object.AddMember("minzoom", static_cast<unsigned>(tiles->second.first), allocator);
+                }
+                if (!object.HasMember("maxzoom"))
+                {
+                    object.AddMember("maxzoom", static_cast<unsigned>(tiles->second.second), allocator);
+                }
+            }
+        }
+
+        if (hasGlyphs)
+        {
+            mbgl::JSValue glyphs;
+            setString(glyphs, root + "glyphs/{fontstack}/{range}.pbf", allocator);
+            setMember(document, "glyphs", std::move(glyphs), allocator);
+        }
+
+        auto sprite = document.FindMember("sprite");
+        if (sprite != document.MemberEnd())
+        {
+            if (sprite->value.IsString() && spriteIds.count("default"))
+            {
+                setString(sprite->value, root + mbgl::util::percentEncode(spriteName("default")), allocator);
+            }
+            else if (sprite->value.IsArray())
+            {
+                for (auto &element : sprite->value.GetArray())
+                {
+                    if (!element.IsObject())
+                    {
+                        continue;
+                    }
+                    auto elementId = element.FindMember("id");
+                    auto elementUrl = element.FindMember("url");
+                    if (elementId == element.MemberEnd() || elementUrl == element.MemberEnd() || !elementId->value.IsString())
+                    {
+                        continue;
+                    }
+                    const std::string spriteId(elementId->value.GetString(), elementId->value.GetStringLength());
+                    if (spriteIds.count(spriteId))
+                    {
+                        setString(elementUrl->value, root + mbgl::util::percentEncode(spriteName(spriteId)), allocator);
+                    }
+                }
+            }
+        }
+
+        rapidjson::StringBuffer buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        document.Accept(writer);
+        return std::string(buffer.GetString(), buffer.GetSize());
+    }
+
+    void StyleBundleWriter::finish(const std::string &styleJSON)
+    {
+        const std::string style = rewriteStyle(styleJSON);
+
+        // Run the full style parser so only styles MapLibre accepts get bundled
+        mbgl::style::Parser parser;
+        if (auto error = parser.parse(style))
+        {
+            try
+            {
+                std::rethrow_exception(error);
+            }
+            catch (const std::exception &e)
+            {
+                throw std::runtime_error(std::string("Invalid style: ") + e.what());
+            }
+        }
+
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = FORMAT_VERSION;
+        header.entryCount = static_cast<uint32_t>(entries.size());
+        header.id = id;
+        const Range styleRange = write(reinterpret_cast<const uint8_t *>(style.data()), style.size());
+        header.styleOffset = styleRange.offset;
+        header.styleLength = styleRange.length;
+
+        const uint8_t padding[alignof(StyleBundle::Record)] = {};
+        write(padding, (alignof(StyleBundle::Record) - offset % alignof(StyleBundle::Record)) % alignof(StyleBundle::Record));
+
+        // std::map iterates in name order, which is the order the reader searches in
+        std::vector<uint8_t> index(entries.size() * sizeof(StyleBundle::Record));
+        std::string names;
+        size_t i = 0;
+        for (const auto &[name, range] : entries)
+        {
+            if (names.size() + name.size() > UINT32_MAX)
+            {
+                throw std::runtime_error("Style bundle " + path + " has too many entry names");
+            }
+            const StyleBundle::Record record{range.offset, range.length, static_cast<uint32_t>(names.size()),
+                                             static_cast<uint32_t>(name.size())};
+            std::memcpy(index.data() + i++ * sizeof(record), &record, sizeof(record));
+            names += name;
+        }
+        index.insert(index.end(), names.begin(), names.end());
+
+        const Range indexRange = write(index.data(), index.size());
+        header.indexOffset = indexRange.offset;
+        header.indexLength = indexRange.length;
+        header.indexChecksum = checksum(index.data(), index.size());
+
+        out.seekp(0);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.close();
+        if (!out)
+        {
+            throw std::runtime_error("Could not write " + tempPath);
+        }
+        std::filesystem::rename(tempPath, path);
+        finished = true;
+    }
+
+} // namespace maplibre_jni
+
+namespace
+{
+    // Hands the contents of a Java byte array to use, without a copy where the JVM allows
+    template <typename Use>
+    void withBytes(JNIEnv *env, jbyteArray array, Use &&use)
+    {
+        jbyte *bytes = env->GetByteArrayElements(array, nullptr);
+        if (!bytes)
+        {
+            throw std::runtime_error("Could not access byte array");
+        }
+        try
+        {
+            use(reinterpret_cast<const uint8_t *>(bytes), static_cast<size_t>(env->GetArrayLength(array)));
+        }
+        catch (...)
+        {
+            env->ReleaseByteArrayElements(array, bytes, JNI_ABORT);
+            throw;
+        }
+        env->ReleaseByteArrayElements(array, bytes, JNI_ABORT);
+    }
+} // namespace
+
+// JNI bindings
+extern "C"
+{
+
+    JNIEXPORT jlong JNICALL Java_org_maplibre_kmp_native_StyleBundleWriter_nativeNew(JNIEnv *env, jclass, jstring path)
+    {
+        try
+        {
+            return toJavaPointer(new maplibre_jni::StyleBundleWriter(jstringToString(env, path)));
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+            return 0;
+        }
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_StyleBundleWriter_nativeDestroy(JNIEnv *env, jclass, jlong ptr)
+    {
+        delete fromJavaPointer<maplibre_jni::StyleBundleWriter>(ptr);
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_StyleBundleWriter_nativeAdd(JNIEnv *env, jclass, jlong ptr, jstring name, jbyteArray data)
+    {
+        try
+        {
+            auto *writer = fromJavaPointer<maplibre_jni::StyleBundleWriter>(ptr);
+            const std::string entryName = jstringToString(env, name);
+            withBytes(env, data, [&](const uint8_t *bytes, size_t length)
+                      { writer->add(entryName, bytes, length); });
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+        }
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_StyleBundleWriter_nativeAddTile(JNIEnv *env, jclass, jlong ptr, jstring source, jint z, jint x, jint y, jbyteArray data)
+    {
+        try
+        {
+            auto *writer = fromJavaPointer<maplibre_jni::StyleBundleWriter>(ptr);
+            const std::string sourceId = jstringToString(env, source);
+            withBytes(env, data, [&](const uint8_t *bytes, size_t length)
+                      { writer->addTile(sourceId, static_cast<uint8_t>(z), static_cast<uint32_t>(x), static_cast<uint32_t>(y), bytes, length); });
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+        }
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_StyleBundleWriter_nativeAddGlyphs(JNIEnv *env, jclass, jlong ptr, jstring fontStack, jint rangeStart, jbyteArray data)
+    {
+        try
+        {
+            auto *writer = fromJavaPointer<maplibre_jni::StyleBundleWriter>(ptr);
+            const std::string stack = jstringToString(env, fontStack);
+            withBytes(env, data, [&](const uint8_t *bytes, size_t length)
+                      { writer->addGlyphs(stack, static_cast<uint16_t>(rangeStart), bytes, length); });
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+        }
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_StyleBundleWriter_nativeAddSprite(JNIEnv *env, jclass, jlong ptr, jstring spriteId, jint pixelRatio, jbyteArray json, jbyteArray image)
+    {
+        try
+        {
+            auto *writer = fromJavaPointer<maplibre_jni::StyleBundleWriter>(ptr);
+            const std::string id = jstringToString(env, spriteId);
+            withBytes(env, json, [&](const uint8_t *jsonBytes, size_t jsonLength)
+                      { withBytes(env, image, [&](const uint8_t *imageBytes, size_t imageLength)
+                                  { writer->addSprite(id, static_cast<uint32_t>(pixelRatio), jsonBytes, jsonLength, imageBytes, imageLength); }); });
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+        }
+    }
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_StyleBundleWriter_nativeFinish(JNIEnv *env, jclass, jlong ptr, jstring styleJSON)
+    {
+        try
+        {
+            fromJavaPointer<maplibre_jni::StyleBundleWriter>(ptr)->finish(jstringToString(env, styleJSON));
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/IllegalArgumentException", e.what());
+        }
+    }
+
+} // extern "C"
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "mapped_file.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace maplibre_jni
+{
+
+    // Self-contained offline map: a style with its sprites, glyphs, tiles and data in one file
+    //
+    // The file holds a header, the entry payloads, the style, and an index of entries sorted by
+    // name. Opening maps the file and checks the header and index, nothing more; entries are
+    // only touched when a map asks for them. The style refers to the other entries through URLs
+    // under rootURL(), which the asset file source resolves with a binary search of the index,
+    // so a bundled map needs no network, no ambient cache and no files besides the bundle.
+    class StyleBundle
+    {
+    public:
+        // Bundle at path, shared with every other live opener of the same bundle. Throws
+        // std::runtime_error if the file can't be mapped or isn't a valid bundle.
+        static std::shared_ptr<StyleBundle> open(const std::string &path);
+
+        // Open bundle with the given id, or nullptr once it is closed
+        static std::shared_ptr<StyleBundle> find(uint64_t id);
+
+        // Prefix of the URLs that refer to the entries of the bundle with the given id
+        static std::string rootURL(uint64_t id);
+
+        // Bundle id and decoded entry name of a URL under a bundle root
+        static std::optional<std::pair<uint64_t, std::string>> parseURL(const std::string &url);
+
+        StyleBundle(const StyleBundle &) = delete;
+        StyleBundle &operator=(const StyleBundle &) = delete;
+
+        uint64_t getId() const { return id; }
+
+        std::string_view style() const;
+
+        // Bytes of the named entry, pointing into the mapping, or nullopt if there is none
+        std::optional<std::string_view> get(std::string_view name) const;
+
+    private:
+        friend class StyleBundleWriter;
+        struct Record;
+
+        StyleBundle(std::string path, std::unique_ptr<MappedFile> file);
+
+        void validate();
+
+        std::string path;
+        std::unique_ptr<MappedFile> file;
+        uint64_t id = 0;
+        const Record *records = nullptr;
+        size_t count = 0;
+        const char *names = nullptr;
+        uint64_t namesLength = 0;
+        // Entries and the style lie before the index
+        uint64_t dataEnd = 0;
+        std::string_view styleJSON;
+    };
+
+    // Writes a StyleBundle
+    //
+    // Entries may be added in any order; adding a name again replaces the earlier entry. finish()
+    // rewrites the style to point at the bundle: sources with tiles, the glyphs template and the
+    // sprites are redirected to what was added for them, and any string starting with
+    // "bundle://" is resolved against the bundle root, e.g. a GeoJSON source's data URL.
+    // The file is written next to the target and renamed on finish, so readers never see a
+    // partial bundle.
+    class StyleBundleWriter
+    {
+    public:
+        static constexpr std::string_view BUNDLE_SCHEME = "bundle://";
+
+        // Throws std::runtime_error if the file can't be created
+        explicit StyleBundleWriter(const std::string &path);
+        // Removes the partial file unless finish() succeeded
+        ~StyleBundleWriter();
+
+        StyleBundleWriter(const StyleBundleWriter &) = delete;
+        StyleBundleWriter &operator=(const StyleBundleWriter &) = delete;
+
+        void add(const std::string &name, const uint8_t *data, size_t length);
+
+        // Tile z/x/y of a vector, raster or raster-dem source, in the XYZ scheme
+        void addTile(const std::string &source, uint8_t z, uint32_t x, uint32_t y, const uint8_t *data, size_t length);
+
+        // Glyph PBF for the 256 code points from rangeStart, a multiple of 256
+        void addGlyphs(const std::string &fontStack, uint16_t rangeStart, const uint8_t *data, size_t length);
+
+        // Sprite sheet with the given id ("default" for a style with a single sprite URL)
+        void addSprite(const std::string &spriteId, uint32_t pixelRatio, const uint8_t *json, size_t jsonLength,
+                       const uint8_t *image, size_t imageLength);
+
+        // Rewrites and validates the style, then writes the index and renames the file into place.
+        // Throws std::runtime_error if the style is invalid or the file can't be written.
+        void finish(const std::string &styleJSON);
+
+    private:
+        struct Range
+        {
+            uint64_t offset = 0;
+            uint64_t length = 0;
+        };
+
+        Range write(const uint8_t *data, size_t length);
+        std::string rewriteStyle(const std::string &json) const;
+
+        std::string path;
+        std::string tempPath;
+        std::ofstream out;
+        uint64_t id = 0;
+        uint64_t offset = 0;
+        bool finished = false;
+
+        std::map<std::string, Range> entries;
+        // Zoom range of the tiles added to each source
+        std::map<std::string, std::pair<uint8_t, uint8_t>> tileSources;
+        std::set<std::string> spriteIds;
+        bool hasGlyphs = false;
+    };
+
+} // namespace maplibre_jni
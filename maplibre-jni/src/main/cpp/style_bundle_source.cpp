@@ -0,0 +1,109 @@
+#include "style_bundle_source.hpp"
+#include "style_bundle.hpp"
+#include <mbgl/actor/scheduler.hpp>
+#include <mbgl/storage/response.hpp>
+#include <mbgl/util/async_request.hpp>
+#include <utility>
+
+namespace maplibre_jni
+{
+
+    struct StyleBundleSource::Task
+    {
+        Callback callback;
+    };
+
+    // Handed to the requester; dropping it discards the response
+    class StyleBundleSource::Request final : public mbgl::AsyncRequest
+    {
+    public:
+        explicit Request(std::shared_ptr<Task> task_)
+            : task(std::move(task_))
+        {
+        }
+
+    private:
+        std::shared_ptr<Task> task;
+    };
+
+    StyleBundleSource::StyleBundleSource(std::unique_ptr<mbgl::FileSource> upstream_)
+        : upstream(std::move(upstream_))
+    {
+    }
+
+    StyleBundleSource::~StyleBundleSource() = default;
+
+    std::unique_ptr<mbgl::AsyncRequest> StyleBundleSource::request(const mbgl::Resource &resource, Callback callback)
+    {
+        auto location = StyleBundle::parseURL(resource.url);
+        if (!location)
+        {
+            return upstream->request(resource, std::move(callback));
+        }
+
+        mbgl::Response response;
+        auto bundle = StyleBundle::find(location->first);
+        auto data = bundle ? bundle->get(location->second) : std::nullopt;
+        if (data)
+        {
+            response.data = std::make_shared<std::string>(*data);
+        }
+        else if (bundle && (resource.kind == mbgl::Resource::Kind::Tile || resource.kind == mbgl::Resource::Kind::Glyphs))
+        {
+            response.noContent = true;
+        }
+        else
+        {
+            response.error = std::make_unique<mbgl::Response::Error>(
+                mbgl::Response::Error::Reason::NotFound,
+                bundle ? "Style bundle has no entry " + location->second : "Style bundle is no longer open");
+        }
+
+        // Answer on the requesting thread's next RunLoop turn, as mbgl's own sources do
+        auto task = std::make_shared<Task>();
+        task->callback = std::move(callback);
+        std::weak_ptr<Task> weak = task;
+        auto deliver = [weak, response = std::move(response)]
+        {
+            if (auto task = weak.lock())
+            {
+                task->callback(response);
+            }
+        };
+        if (auto *scheduler = mbgl::Scheduler::GetCurrent())
+        {
+            scheduler->schedule(std::move(deliver));
+        }
+        else
+        {
+            deliver();
+        }
+        return std::make_unique<Request>(std::move(task));
+    }
+
+    bool StyleBundleSource::canRequest(const mbgl::Resource &resource) const
+    {
+        return StyleBundle::parseURL(resource.url) || upstream->canRequest(resource);
+    }
+
+    void StyleBundleSource::setResourceOptions(mbgl::ResourceOptions options)
+    {
+        upstream->setResourceOptions(std::move(options));
+    }
+
+    mbgl::ResourceOptions StyleBundleSource::getResourceOptions()
+    {
+        return upstream->getResourceOptions();
+    }
+
+    void StyleBundleSource::setClientOptions(mbgl::ClientOptions options)
+    {
+        upstream->setClientOptions(std::move(options));
+    }
+
+    mbgl::ClientOptions StyleBundleSource::getClientOptions()
+    {
+        return upstream->getClientOptions();
+    }
+
+} // namespace maplibre_jni
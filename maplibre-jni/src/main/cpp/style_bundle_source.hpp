@@ -0,0 +1,39 @@
+#pragma once
+
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/resource.hpp>
+#include <mbgl/storage/resource_options.hpp>
+#include <mbgl/util/client_options.hpp>
+#include <memory>
+
+namespace maplibre_jni
+{
+
+    // Asset FileSource wrapper serving the entries of open StyleBundles
+    //
+    // URLs under a bundle root are looked up in the bundle's index and copied out of its
+    // mapping; every other asset URL goes to the wrapped source. Tiles and glyph ranges the
+    // bundle doesn't have are answered as empty, so areas outside the bundled extent render
+    // blank instead of raising errors.
+    class StyleBundleSource final : public mbgl::FileSource
+    {
+    public:
+        explicit StyleBundleSource(std::unique_ptr<mbgl::FileSource> upstream);
+        ~StyleBundleSource() override;
+
+        std::unique_ptr<mbgl::AsyncRequest> request(const mbgl::Resource &resource, Callback callback) override;
+
+        bool canRequest(const mbgl::Resource &resource) const override;
+        void setResourceOptions(mbgl::ResourceOptions options) override;
+        mbgl::ResourceOptions getResourceOptions() override;
+        void setClientOptions(mbgl::ClientOptions options) override;
+        mbgl::ClientOptions getClientOptions() override;
+
+    private:
+        struct Task;
+        class Request;
+
+        std::unique_ptr<mbgl::FileSource> upstream;
+    };
+
+} // namespace maplibre_jni
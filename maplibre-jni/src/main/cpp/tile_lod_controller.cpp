@@ -0,0 +1,129 @@
+#include "tile_lod_controller.hpp"
+#include <algorithm>
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        constexpr auto WINDOW = std::chrono::seconds(1);
+        constexpr int CALM_WINDOWS_TO_RELAX = 2;
+
+        // Frames are calm well below the target, so levels don't flip back and forth
+        constexpr double CALM_FRAME_FACTOR = 0.7;
+
+        // Seconds the waiting requests would take at the measured throughput
+        constexpr double BUSY_DRAIN_SECONDS = 2.0;
+        constexpr double CALM_DRAIN_SECONDS = 0.5;
+
+        constexpr double DEGREE = 0.017453292519943295;
+    } // namespace
+
+    void TileLodController::setBase(const Settings &settings)
+    {
+        base = settings;
+        base.minRadius = std::max(1.0, base.minRadius);
+        base.scale = std::max(0.01, base.scale);
+    }
+
+    void TileLodController::setAdaptive(double targetFrameMs_)
+    {
+        targetFrameMs = std::max(0.0, targetFrameMs_);
+        level = 0;
+        calmWindows = 0;
+        windowStarted = false;
+    }
+
+    bool TileLodController::update(std::chrono::steady_clock::time_point now,
+                                   const FrameBudgetGovernor::Stats &frames,
+                                   const PrioritizedRequestSource::Stats &network)
+    {
+        if (!isAdaptive())
+        {
+            return false;
+        }
+
+        // Totals restart when the map's request sources are replaced
+        if (!windowStarted || network.completed < windowCompleted || network.bytes < windowBytes)
+        {
+            windowStarted = true;
+            windowStart = now;
+            windowFrames = frames.renderedFrames;
+            windowCompleted = network.completed;
+            windowBytes = network.bytes;
+            return false;
+        }
+
+        const std::chrono::duration<double> elapsed = now - windowStart;
+        if (elapsed < WINDOW)
+        {
+            return false;
+        }
+
+        const uint64_t renderedFrames = frames.renderedFrames - windowFrames;
+        const uint64_t completed = network.completed - windowCompleted;
+        const uint64_t bytes = network.bytes - windowBytes;
+        windowStart = now;
+        windowFrames = frames.renderedFrames;
+        windowCompleted = network.completed;
+        windowBytes = network.bytes;
+
+        // An idle map renders nothing, which says nothing about frame cost
+        const bool framesBusy = renderedFrames > 0 && frames.averageFrameMs > targetFrameMs;
+        const bool framesCalm = renderedFrames == 0 || frames.averageFrameMs < targetFrameMs * CALM_FRAME_FACTOR;
+
+        double drainSeconds = 0;
+        if (network.queued > 0)
+        {
+            if (completed == 0 || bytes == 0)
+            {
+                drainSeconds = BUSY_DRAIN_SECONDS;
+            }
+            else
+            {
+                const double bytesPerRequest = static_cast<double>(bytes) / completed;
+                const double bytesPerSecond = bytes / elapsed.count();
+                drainSeconds = network.queued * bytesPerRequest / bytesPerSecond;
+            }
+        }
+        const bool networkBusy = drainSeconds >= BUSY_DRAIN_SECONDS;
+        const bool networkCalm = drainSeconds < CALM_DRAIN_SECONDS;
+
+        const int previous = level;
+        if (framesBusy || networkBusy)
+        {
+            level = std::min(level + 1, MAX_LEVEL);
+            calmWindows = 0;
+        }
+        else if (framesCalm && networkCalm)
+        {
+            if (++calmWindows >= CALM_WINDOWS_TO_RELAX)
+            {
+                level = std::max(level - 1, 0);
+                calmWindows = 0;
+            }
+        }
+        else
+        {
+            calmWindows = 0;
+        }
+        return level != previous;
+    }
+
+    TileLodController::Settings TileLodController::getSettings() const
+    {
+        if (level == 0)
+        {
+            return base;
+        }
+
+        Settings settings = base;
+        settings.minRadius = std::max(1.0, base.minRadius - 0.5 * level);
+        settings.scale = base.scale * (1.0 + 0.25 * level);
+        settings.pitchThreshold = std::max(15.0 * DEGREE, base.pitchThreshold - 5.0 * DEGREE * level);
+        settings.zoomShift = base.zoomShift - 0.25 * level;
+        settings.prefetchZoomDelta = 0;
+        return settings;
+    }
+
+} // namespace maplibre_jni
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "frame_budget.hpp"
+#include "prioritized_request_source.hpp"
+#include <chrono>
+#include <cstdint>
+
+namespace maplibre_jni
+{
+
+    // Tile level-of-detail settings for one map, optionally tuned from load
+    //
+    // The base settings are applied as given. In adaptive mode the controller looks at each
+    // second of frame times and network queue progress and moves a pressure level up when
+    // frames run over the target or the queue would take long to drain, and back down after
+    // two calm seconds in a row. Each level shrinks the full-detail radius, lowers the pitch at
+    // which distant tiles lose detail, scales their distance up, shifts the zoom down and stops
+    // prefetching, so far-field detail is traded for frame rate and fewer requests.
+    class TileLodController
+    {
+    public:
+        struct Settings
+        {
+            // Radius around the camera, in tiles, always loaded at full detail
+            double minRadius = 3.0;
+            // Factor applied to tile distances; above 1 drops detail sooner
+            double scale = 1.0;
+            // Pitch in radians above which distant tiles lose detail
+            double pitchThreshold = 1.0471975511965976;
+            // Zoom offset for distant tiles; negative trades detail for speed
+            double zoomShift = 0.0;
+            uint8_t prefetchZoomDelta = 4;
+
+            bool operator==(const Settings &other) const
+            {
+                return minRadius == other.minRadius && scale == other.scale &&
+                       pitchThreshold == other.pitchThreshold && zoomShift == other.zoomShift &&
+                       prefetchZoomDelta == other.prefetchZoomDelta;
+            }
+            bool operator!=(const Settings &other) const { return !(*this == other); }
+        };
+
+        static constexpr int MAX_LEVEL = 4;
+
+        // Settings as configured through MapOptions or MaplibreMap.setTileLodOptions
+        struct Options
+        {
+            Settings settings;
+            // Frame time the adaptive mode aims for; 0 keeps the settings fixed
+            double adaptiveTargetFrameMs = 0;
+        };
+
+        void setBase(const Settings &settings);
+        const Settings &getBase() const { return base; }
+
+        // Target of 0 turns adaptation off and returns to the base settings
+        void setAdaptive(double targetFrameMs);
+        bool isAdaptive() const { return targetFrameMs > 0; }
+
+        // Re-evaluates the level once a second from this map's frames and the request queue
+        // stats of its resource context; true when getSettings() changed
+        bool update(std::chrono::steady_clock::time_point now,
+                    const FrameBudgetGovernor::Stats &frames,
+                    const PrioritizedRequestSource::Stats &network);
+
+        // Base settings adjusted for the current pressure level
+        Settings getSettings() const;
+        int getLevel() const { return level; }
+
+    private:
+        Settings base;
+        double targetFrameMs = 0;
+        int level = 0;
+        int calmWindows = 0;
+
+        bool windowStarted = false;
+        std::chrono::steady_clock::time_point windowStart;
+        uint64_t windowFrames = 0;
+        uint64_t windowCompleted = 0;
+        uint64_t windowBytes = 0;
+    };
+
+} // namespace maplibre_jni
@@ -0,0 +1,375 @@
+#include "trajectory_prefetcher.hpp"
+#include <mbgl/storage/response.hpp>
+#include <mbgl/util/constants.hpp>
+#include <mbgl/util/logging.hpp>
+#include <mbgl/util/projection.hpp>
+#include <mbgl/style/sources/raster_source.hpp>
+#include <mbgl/style/sources/vector_source.hpp>
+#include <mbgl/util/rapidjson.hpp>
+#include <mbgl/util/tileset.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        constexpr uint64_t DEFAULT_BYTE_BUDGET = 8 * 1024 * 1024;
+        // Requests handed to the loader at once; more start as these finish, until the budget is spent
+        constexpr size_t MAX_OUTSTANDING = 8;
+        constexpr size_t MAX_TILES = 512;
+
+        constexpr size_t EASE_SAMPLES = 8;
+        constexpr size_t FLY_SAMPLES = 24;
+        // Curvature mbgl's flyTo uses when none is given
+        constexpr double FLY_RHO = 1.42;
+
+        struct WorldPoint
+        {
+            double x = 0;
+            double y = 0;
+        };
+
+        WorldPoint project(const mbgl::LatLng &latLng)
+        {
+            const auto point = mbgl::Projection::project(latLng, 1.0 / mbgl::util::tileSize_D);
+            return {point.x, point.y};
+        }
+
+        // Zoom and path fraction along mbgl's flyTo curve (van Wijk and Nuij), for k in [0, 1]
+        struct FlyCurve
+        {
+            FlyCurve(double startZoom, double endZoom, double pathPixels, double viewPixels)
+                : w0(viewPixels),
+                  w1(viewPixels / std::pow(2.0, endZoom - startZoom)),
+                  u1(pathPixels)
+            {
+                const double rho2 = FLY_RHO * FLY_RHO;
+                auto r = [&](int i)
+                {
+                    const double b = (w1 * w1 - w0 * w0 + (i ? -1 : 1) * rho2 * rho2 * u1 * u1) /
+                                     (2 * (i ? w1 : w0) * rho2 * u1);
+                    return std::log(std::sqrt(b * b + 1) - b);
+                };
+                r0 = r(0);
+                const double r1 = r(1);
+                close = std::abs(u1) < 1e-6 || !std::isfinite(r0) || !std::isfinite(r1);
+                length = (close ? std::abs(std::log(w1 / w0)) : r1 - r0) / FLY_RHO;
+            }
+
+            double zoomOffset(double k) const
+            {
+                const double s = k * length;
+                const double w = close ? std::exp((w1 < w0 ? -1 : 1) * FLY_RHO * s)
+                                       : std::cosh(r0) / std::cosh(r0 + FLY_RHO * s);
+                return -std::log2(w);
+            }
+
+            double pathFraction(double k) const
+            {
+                if (close || k >= 1.0)
+                {
+                    return k >= 1.0 ? 1.0 : 0.0;
+                }
+                const double s = k * length;
+                return w0 * ((std::cosh(r0) * std::tanh(r0 + FLY_RHO * s) - std::sinh(r0)) / (FLY_RHO * FLY_RHO)) / u1;
+            }
+
+            double w0;
+            double w1;
+            double u1;
+            double r0 = 0;
+            double length = 0;
+            bool close = false;
+        };
+    } // namespace
+
+    TrajectoryPrefetcher::TrajectoryPrefetcher(std::shared_ptr<mbgl::FileSource> fileSource_, float pixelRatio_)
+        : fileSource(std::move(fileSource_)),
+          pixelRatio(pixelRatio_),
+          byteBudget(DEFAULT_BYTE_BUDGET)
+    {
+    }
+
+    TrajectoryPrefetcher::~TrajectoryPrefetcher()
+    {
+        cancel();
+    }
+
+    void TrajectoryPrefetcher::prefetch(mbgl::style::Style &style, Animation animation, const Camera &start, const Camera &end, mbgl::Size viewSize_)
+    {
+        cancel();
+        progress = {};
+        if (byteBudget == 0 || viewSize_.isEmpty())
+        {
+            return;
+        }
+        viewSize = viewSize_;
+
+        // mbgl animates across the antimeridian when that is shorter
+        const WorldPoint from = project(start.center);
+        WorldPoint to = project(end.center);
+        if (to.x - from.x > 0.5)
+        {
+            to.x -= 1.0;
+        }
+        else if (from.x - to.x > 0.5)
+        {
+            to.x += 1.0;
+        }
+
+        const size_t sampleCount = animation == Animation::Fly ? FLY_SAMPLES : EASE_SAMPLES;
+        const double worldPixels = mbgl::util::tileSize_D * std::pow(2.0, start.zoom);
+        const FlyCurve curve(start.zoom, end.zoom,
+                             std::hypot(to.x - from.x, to.y - from.y) * worldPixels,
+                             std::max(viewSize.width, viewSize.height));
+
+        // The first sample is the current view, which the map is already loading
+        for (size_t i = 1; i <= sampleCount; i++)
+        {
+            const double k = static_cast<double>(i) / sampleCount;
+            const double fraction = animation == Animation::Fly ? curve.pathFraction(k) : k;
+            Sample sample;
+            sample.x = from.x + (to.x - from.x) * fraction;
+            sample.x -= std::floor(sample.x);
+            sample.y = std::clamp(from.y + (to.y - from.y) * fraction, 0.0, 1.0);
+            sample.zoom = animation == Animation::Fly ? start.zoom + curve.zoomOffset(k)
+                                                      : start.zoom + (end.zoom - start.zoom) * k;
+            samples.push_back(sample);
+        }
+
+        for (const auto *styleSource : style.getSources())
+        {
+            TileSource source;
+            const mbgl::variant<std::string, mbgl::Tileset> *urlOrTileset = nullptr;
+            switch (styleSource->getType())
+            {
+                case mbgl::style::SourceType::Vector:
+                    urlOrTileset = &static_cast<const mbgl::style::VectorSource *>(styleSource)->getURLOrTileset();
+                    break;
+                case mbgl::style::SourceType::Raster:
+                case mbgl::style::SourceType::RasterDEM:
+                {
+                    // raster-dem sources are raster sources to mbgl as well
+                    const auto *raster = static_cast<const mbgl::style::RasterSource *>(styleSource);
+                    urlOrTileset = &raster->getURLOrTileset();
+                    source.tileSize = std::max<uint16_t>(1, raster->getTileSize());
+                    source.raster = true;
+                    break;
+                }
+                default:
+                    continue;
+            }
+
+            if (urlOrTileset->is<mbgl::Tileset>())
+            {
+                const auto &tileset = urlOrTileset->get<mbgl::Tileset>();
+                if (!tileset.tiles.empty())
+                {
+                    source.urlTemplate = tileset.tiles.front();
+                    source.minZoom = tileset.zoomRange.min;
+                    source.maxZoom = tileset.zoomRange.max;
+                    source.tms = tileset.scheme == mbgl::Tileset::Scheme::TMS;
+                    addSource(source);
+                }
+                continue;
+            }
+
+            const auto &url = urlOrTileset->get<std::string>();
+            auto known = tileJSONs.find(url);
+            if (known == tileJSONs.end())
+            {
+                loadTileJSON(url, source);
+                continue;
+            }
+            TileSource resolved = known->second;
+            resolved.tileSize = source.tileSize;
+            resolved.raster = source.raster;
+            addSource(resolved);
+        }
+    }
+
+    void TrajectoryPrefetcher::cancel()
+    {
+        requests.clear();
+        tileJSONRequests.clear();
+        retired.clear();
+        answered.clear();
+        pending.clear();
+        seenTiles.clear();
+        samples.clear();
+    }
+
+    template <typename JSON>
+    void TrajectoryPrefetcher::readTileset(const JSON &json, TileSource &source)
+    {
+        if (json.HasMember("tiles") && json["tiles"].IsArray() && !json["tiles"].Empty() && json["tiles"][0].IsString())
+        {
+            source.urlTemplate = json["tiles"][0].GetString();
+        }
+        if (json.HasMember("minzoom") && json["minzoom"].IsNumber())
+        {
+            source.minZoom = static_cast<uint8_t>(std::clamp(json["minzoom"].GetDouble(), 0.0, 30.0));
+        }
+        if (json.HasMember("maxzoom") && json["maxzoom"].IsNumber())
+        {
+            source.maxZoom = static_cast<uint8_t>(std::clamp(json["maxzoom"].GetDouble(), 0.0, 30.0));
+        }
+        if (json.HasMember("scheme") && json["scheme"].IsString())
+        {
+            source.tms = std::string(json["scheme"].GetString()) == "tms";
+        }
+    }
+
+    void TrajectoryPrefetcher::loadTileJSON(const std::string &url, TileSource source)
+    {
+        // The map has fetched this TileJSON already, so it normally comes from the cache
+        const uint64_t id = nextRequestId++;
+        tileJSONRequests[id] = fileSource->request(
+            mbgl::Resource::source(url),
+            [this, id, url, source](const mbgl::Response &response) mutable
+            {
+                auto it = tileJSONRequests.find(id);
+                if (it == tileJSONRequests.end())
+                {
+                    return;
+                }
+                retired.push_back(std::move(it->second));
+                tileJSONRequests.erase(it);
+
+                if (response.error || !response.data)
+                {
+                    return;
+                }
+
+                mbgl::JSDocument document;
+                document.Parse<0>(response.data->c_str());
+                if (document.HasParseError() || !document.IsObject())
+                {
+                    mbgl::Log::Warning(mbgl::Event::General, "Prefetcher could not parse TileJSON");
+                    return;
+                }
+                readTileset(document, source);
+                if (!source.urlTemplate.empty())
+                {
+                    tileJSONs[url] = source;
+                    addSource(source);
+                }
+            });
+    }
+
+    void TrajectoryPrefetcher::addSource(const TileSource &source)
+    {
+        const auto scheme = source.tms ? mbgl::Tileset::Scheme::TMS : mbgl::Tileset::Scheme::XYZ;
+
+        for (size_t index = 0; index < samples.size() && seenTiles.size() < MAX_TILES; index++)
+        {
+            const Sample &sample = samples[index];
+
+            // Same zoom choice as mbgl's coveringZoomLevel
+            const double tileZoom = sample.zoom + std::log2(mbgl::util::tileSize_D / source.tileSize);
+            const double coveringZoom = source.raster ? std::round(tileZoom) : std::floor(tileZoom);
+            const int z = static_cast<int>(std::clamp(coveringZoom, static_cast<double>(source.minZoom), static_cast<double>(source.maxZoom)));
+            const int32_t tiles = 1 << z;
+
+            // Tiles covering the unrotated viewport, nearest to the center first
+            const double tilePixels = mbgl::util::tileSize_D * std::pow(2.0, sample.zoom) / tiles;
+            const double halfWidth = viewSize.width / 2.0 / tilePixels;
+            const double halfHeight = viewSize.height / 2.0 / tilePixels;
+            const double centerX = sample.x * tiles;
+            const double centerY = sample.y * tiles;
+            const auto x0 = static_cast<int32_t>(std::floor(centerX - halfWidth));
+            const auto x1 = static_cast<int32_t>(std::floor(centerX + halfWidth));
+            const auto y0 = std::max(0, static_cast<int32_t>(std::floor(centerY - halfHeight)));
+            const auto y1 = std::min(tiles - 1, static_cast<int32_t>(std::floor(centerY + halfHeight)));
+
+            struct Cover
+            {
+                int32_t x;
+                int32_t y;
+                double distance;
+            };
+            std::vector<Cover> cover;
+            for (int32_t y = y0; y <= y1; y++)
+            {
+                for (int32_t x = x0; x <= x1; x++)
+                {
+                    cover.push_back({x, y, std::hypot(x + 0.5 - centerX, y + 0.5 - centerY)});
+                }
+            }
+            std::sort(cover.begin(), cover.end(), [](const Cover &a, const Cover &b)
+                      { return a.distance < b.distance; });
+
+            for (const auto &tile : cover)
+            {
+                const int32_t x = ((tile.x % tiles) + tiles) % tiles;
+                std::string key = source.urlTemplate + '/' + std::to_string(z) + '/' + std::to_string(x) + '/' + std::to_string(tile.y);
+                if (seenTiles.size() >= MAX_TILES || !seenTiles.insert(std::move(key)).second)
+                {
+                    continue;
+                }
+
+                PendingTile pendingTile{
+                    mbgl::Resource::tile(source.urlTemplate, pixelRatio, x, tile.y, static_cast<int8_t>(z), scheme),
+                    index};
+                // Ranks behind visible tiles in the network queue
+                pendingTile.resource.priority = mbgl::Resource::Priority::Low;
+                pending.push_back(std::move(pendingTile));
+            }
+        }
+
+        // Sources whose TileJSON arrived later are merged into path order
+        std::stable_sort(pending.begin(), pending.end(), [](const PendingTile &a, const PendingTile &b)
+                         { return a.sample < b.sample; });
+        issueMore();
+    }
+
+    void TrajectoryPrefetcher::issueMore()
+    {
+        while (requests.size() < MAX_OUTSTANDING && !pending.empty() && progress.bytes < byteBudget)
+        {
+            const uint64_t id = nextRequestId++;
+            progress.requested++;
+            requests[id] = fileSource->request(
+                pending.front().resource,
+                [this, id](const mbgl::Response &response)
+                {
+                    onResponse(id, response);
+                });
+            pending.pop_front();
+        }
+
+        if (progress.bytes >= byteBudget)
+        {
+            pending.clear();
+        }
+    }
+
+    void TrajectoryPrefetcher::onResponse(uint64_t id, const mbgl::Response &response)
+    {
+        // A stale cache hit is answered first and revalidated afterwards; count it once
+        if (answered.insert(id).second)
+        {
+            progress.completed++;
+        }
+        if (response.data)
+        {
+            progress.bytes += response.data->size();
+        }
+
+        // Keep the request alive until the cache has a fresh copy
+        if (response.error || response.isFresh())
+        {
+            auto it = requests.find(id);
+            if (it != requests.end())
+            {
+                retired.push_back(std::move(it->second));
+                requests.erase(it);
+            }
+            answered.erase(id);
+            issueMore();
+        }
+    }
+
+} // namespace maplibre_jni
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/resource.hpp>
+#include <mbgl/style/style.hpp>
+#include <mbgl/util/async_request.hpp>
+#include <mbgl/util/geo.hpp>
+#include <mbgl/util/size.hpp>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace maplibre_jni
+{
+
+    // Requests the tiles a camera animation will show before the animation reaches them
+    //
+    // easeTo and flyTo paths are known when the animation starts, so the path is sampled and
+    // the tiles covering the viewport at each sample are requested through the resource loader,
+    // in path order and at the zoom level each source would load there. Requests are marked low
+    // priority, which ranks them behind visible tiles in the network queue, and stop once the
+    // byte budget has been received. Responses land in the ambient cache, or are joined directly
+    // by the map's own request if it asks for a tile that is still in flight.
+    class TrajectoryPrefetcher
+    {
+    public:
+        enum class Animation
+        {
+            Ease,
+            Fly,
+        };
+
+        struct Camera
+        {
+            mbgl::LatLng center;
+            double zoom = 0;
+        };
+
+        struct Progress
+        {
+            uint32_t requested = 0;
+            uint32_t completed = 0;
+            uint64_t bytes = 0;
+        };
+
+        TrajectoryPrefetcher(std::shared_ptr<mbgl::FileSource> fileSource, float pixelRatio);
+        ~TrajectoryPrefetcher();
+
+        // Bytes one animation may prefetch; 0 disables prefetching
+        void setByteBudget(uint64_t bytes) { byteBudget = bytes; }
+        uint64_t getByteBudget() const { return byteBudget; }
+
+        // Prefetch the path from start to end for a map of the given logical size, replacing any
+        // previous animation's prefetch. Tile sources are read from the style's current sources;
+        // TileJSON they reference by URL is fetched and parsed once and then remembered.
+        void prefetch(mbgl::style::Style &style, Animation animation, const Camera &start, const Camera &end, mbgl::Size viewSize);
+
+        Progress getProgress() const { return progress; }
+
+        void cancel();
+
+    private:
+        struct TileSource
+        {
+            // mbgl only ever loads from the first template, so that is the one kept
+            std::string urlTemplate;
+            uint16_t tileSize = 512;
+            uint8_t minZoom = 0;
+            uint8_t maxZoom = 22;
+            bool tms = false;
+            // Raster tiles are picked at the rounded zoom, vector tiles at the floored one
+            bool raster = false;
+        };
+
+        struct PendingTile
+        {
+            mbgl::Resource resource;
+            size_t sample = 0;
+        };
+
+        template <typename JSON>
+        static void readTileset(const JSON &json, TileSource &source);
+
+        void addSource(const TileSource &source);
+        void loadTileJSON(const std::string &url, TileSource source);
+        void issueMore();
+        void onResponse(uint64_t id, const mbgl::Response &response);
+
+        std::shared_ptr<mbgl::FileSource> fileSource;
+        float pixelRatio;
+        // Tile source settings of each TileJSON URL parsed so far
+        std::unordered_map<std::string, TileSource> tileJSONs;
+        uint64_t byteBudget;
+
+        // Camera at each path sample, with the center in world coordinates spanning [0, 1]
+        struct Sample
+        {
+            double x = 0;
+            double y = 0;
+            double zoom = 0;
+        };
+        std::vector<Sample> samples;
+        mbgl::Size viewSize;
+
+        std::deque<PendingTile> pending;
+        std::unordered_set<std::string> seenTiles;
+        uint64_t nextRequestId = 0;
+        std::unordered_map<uint64_t, std::unique_ptr<mbgl::AsyncRequest>> requests;
+        std::unordered_map<uint64_t, std::unique_ptr<mbgl::AsyncRequest>> tileJSONRequests;
+        std::unordered_set<uint64_t> answered;
+        // Requests can't be destroyed from inside their own callback, so finished ones wait here
+        std::vector<std::unique_ptr<mbgl::AsyncRequest>> retired;
+        Progress progress;
+    };
+
+} // namespace maplibre_jni
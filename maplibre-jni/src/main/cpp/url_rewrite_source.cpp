@@ -0,0 +1,100 @@
+#include "url_rewrite_source.hpp"
+#include <mbgl/storage/response.hpp>
+#include <mbgl/util/async_request.hpp>
+#include <utility>
+
+namespace maplibre_jni
+{
+
+    UrlRewriteSource::UrlRewriteSource(std::unique_ptr<mbgl::FileSource> upstream_, std::shared_ptr<const UrlRewriter> rewriter_)
+        : upstream(std::move(upstream_)),
+          rewriter(std::move(rewriter_))
+    {
+    }
+
+    UrlRewriteSource::~UrlRewriteSource() = default;
+
+    mbgl::Resource UrlRewriteSource::rewritten(const mbgl::Resource &resource) const
+    {
+        mbgl::Resource result = resource;
+        if (auto url = rewriter->rewrite(resource.url, resource.kind))
+        {
+            result.url = std::move(*url);
+        }
+        return result;
+    }
+
+    std::unique_ptr<mbgl::AsyncRequest> UrlRewriteSource::request(const mbgl::Resource &resource, Callback callback)
+    {
+        auto url = rewriter->rewrite(resource.url, resource.kind);
+        if (!url)
+        {
+            return upstream->request(resource, std::move(callback));
+        }
+
+        mbgl::Resource target = resource;
+        target.url = std::move(*url);
+        return upstream->request(target, std::move(callback));
+    }
+
+    void UrlRewriteSource::forward(const mbgl::Resource &resource, const mbgl::Response &response, std::function<void()> callback)
+    {
+        upstream->forward(rewritten(resource), response, std::move(callback));
+    }
+
+    bool UrlRewriteSource::canRequest(const mbgl::Resource &resource) const
+    {
+        return upstream->canRequest(rewritten(resource));
+    }
+
+    bool UrlRewriteSource::supportsCacheOnlyRequests() const
+    {
+        return upstream->supportsCacheOnlyRequests();
+    }
+
+    void UrlRewriteSource::pause()
+    {
+        upstream->pause();
+    }
+
+    void UrlRewriteSource::resume()
+    {
+        upstream->resume();
+    }
+
+    void UrlRewriteSource::setProperty(const std::string &key, const mapbox::base::Value &value)
+    {
+        upstream->setProperty(key, value);
+    }
+
+    mapbox::base::Value UrlRewriteSource::getProperty(const std::string &key) const
+    {
+        return upstream->getProperty(key);
+    }
+
+    void UrlRewriteSource::setResourceTransform(mbgl::ResourceTransform transform)
+    {
+        upstream->setResourceTransform(std::move(transform));
+    }
+
+    void UrlRewriteSource::setResourceOptions(mbgl::ResourceOptions options)
+    {
+        upstream->setResourceOptions(std::move(options));
+    }
+
+    mbgl::ResourceOptions UrlRewriteSource::getResourceOptions()
+    {
+        return upstream->getResourceOptions();
+    }
+
+    void UrlRewriteSource::setClientOptions(mbgl::ClientOptions options)
+    {
+        upstream->setClientOptions(std::move(options));
+    }
+
+    mbgl::ClientOptions UrlRewriteSource::getClientOptions()
+    {
+        return upstream->getClientOptions();
+    }
+
+} // namespace maplibre_jni
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "url_rewriter.hpp"
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/resource.hpp>
+#include <memory>
+
+namespace maplibre_jni
+{
+
+    // FileSource wrapper that rewrites request URLs before they reach the network
+    //
+    // Only the network sees rewritten URLs: the resource loader has already looked the
+    // original URL up in the ambient cache and stores the response under it, so tokens that
+    // change between requests don't defeat caching. Rewriting happens before tile server URLs
+    // are resolved, so rules can also map custom schemes.
+    class UrlRewriteSource final : public mbgl::FileSource
+    {
+    public:
+        UrlRewriteSource(std::unique_ptr<mbgl::FileSource> upstream, std::shared_ptr<const UrlRewriter> rewriter);
+        ~UrlRewriteSource() override;
+
+        std::unique_ptr<mbgl::AsyncRequest> request(const mbgl::Resource &resource, Callback callback) override;
+
+        void forward(const mbgl::Resource &resource, const mbgl::Response &response, std::function<void()> callback) override;
+        bool canRequest(const mbgl::Resource &resource) const override;
+        bool supportsCacheOnlyRequests() const override;
+        void pause() override;
+        void resume() override;
+        void setProperty(const std::string &key, const mapbox::base::Value &value) override;
+        mapbox::base::Value getProperty(const std::string &key) const override;
+        void setResourceTransform(mbgl::ResourceTransform transform) override;
+        void setResourceOptions(mbgl::ResourceOptions options) override;
+        mbgl::ResourceOptions getResourceOptions() override;
+        void setClientOptions(mbgl::ClientOptions options) override;
+        mbgl::ClientOptions getClientOptions() override;
+
+    private:
+        // The resource with its URL rewritten, or the resource itself if no rule matches
+        mbgl::Resource rewritten(const mbgl::Resource &resource) const;
+
+        std::unique_ptr<mbgl::FileSource> upstream;
+        std::shared_ptr<const UrlRewriter> rewriter;
+    };
+
+} // namespace maplibre_jni
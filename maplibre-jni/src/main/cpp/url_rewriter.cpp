@@ -0,0 +1,295 @@
+#include "url_rewriter.hpp"
+#include "jni_helpers.hpp"
+#include <algorithm>
+#include <cctype>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        using TokenMap = std::unordered_map<std::string, std::string>;
+
+        std::mutex tokensMutex;
+        std::shared_ptr<const TokenMap> tokens = std::make_shared<TokenMap>();
+
+        std::shared_ptr<const TokenMap> currentTokens()
+        {
+            std::lock_guard<std::mutex> lock(tokensMutex);
+            return tokens;
+        }
+
+        struct Segment
+        {
+            enum class Type
+            {
+                Literal,
+                Group,
+                Token,
+            };
+
+            Type type = Type::Literal;
+            // Literal text or token name
+            std::string text;
+            size_t group = 0;
+        };
+
+        bool isTokenChar(char c)
+        {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-' || c == '.';
+        }
+
+        std::vector<Segment> parseReplacement(const std::string &replacement)
+        {
+            std::vector<Segment> segments;
+            auto appendLiteral = [&](char c)
+            {
+                if (segments.empty() || segments.back().type != Segment::Type::Literal)
+                {
+                    segments.push_back({Segment::Type::Literal, {}, 0});
+                }
+                segments.back().text += c;
+            };
+
+            for (size_t i = 0; i < replacement.size(); i++)
+            {
+                const char c = replacement[i];
+                if (c == '$' && i + 1 < replacement.size())
+                {
+                    const char next = replacement[i + 1];
+                    if (std::isdigit(static_cast<unsigned char>(next)))
+                    {
+                        segments.push_back({Segment::Type::Group, {}, static_cast<size_t>(next - '0')});
+                        i++;
+                        continue;
+                    }
+                    if (next == '$')
+                    {
+                        appendLiteral('$');
+                        i++;
+                        continue;
+                    }
+                }
+                else if (c == '{')
+                {
+                    size_t end = i + 1;
+                    while (end < replacement.size() && isTokenChar(replacement[end]))
+                    {
+                        end++;
+                    }
+                    if (end > i + 1 && end < replacement.size() && replacement[end] == '}')
+                    {
+                        segments.push_back({Segment::Type::Token, replacement.substr(i + 1, end - i - 1), 0});
+                        i = end;
+                        continue;
+                    }
+                }
+                appendLiteral(c);
+            }
+            return segments;
+        }
+
+        // Characters every match of the regex starts with; empty when that can't be known cheaply
+        std::string literalPrefix(const std::string &pattern)
+        {
+            // Top-level alternatives may start differently
+            int depth = 0;
+            bool inClass = false;
+            for (size_t i = 0; i < pattern.size(); i++)
+            {
+                const char c = pattern[i];
+                if (c == '\\')
+                {
+                    i++;
+                }
+                else if (inClass)
+                {
+                    inClass = c != ']';
+                }
+                else if (c == '[')
+                {
+                    inClass = true;
+                }
+                else if (c == '(')
+                {
+                    depth++;
+                }
+                else if (c == ')')
+                {
+                    depth--;
+                }
+                else if (c == '|' && depth == 0)
+                {
+                    return {};
+                }
+            }
+
+            std::string prefix;
+            for (size_t i = !pattern.empty() && pattern[0] == '^' ? 1 : 0; i < pattern.size(); i++)
+            {
+                char c = pattern[i];
+                if (c == '\\')
+                {
+                    // Escaped punctuation is literal; \d, \w and the like are classes
+                    if (i + 1 >= pattern.size() || std::isalnum(static_cast<unsigned char>(pattern[i + 1])))
+                    {
+                        break;
+                    }
+                    c = pattern[++i];
+                }
+                else if (std::string_view("$.|?*+()[]{}^").find(c) != std::string_view::npos)
+                {
+                    // A quantifier may make the previous character optional
+                    if ((c == '?' || c == '*' || c == '{') && !prefix.empty())
+                    {
+                        prefix.pop_back();
+                    }
+                    break;
+                }
+                prefix += c;
+            }
+            return prefix;
+        }
+    } // namespace
+
+    struct UrlRewriter::CompiledRule
+    {
+        Rule::Type type = Rule::Type::Prefix;
+        uint32_t kinds = 0;
+        // Prefix rules match exactly this; regex rules can only match URLs starting with it
+        std::string prefix;
+        std::optional<std::regex> regex;
+        std::vector<Segment> replacement;
+        bool usesTokens = false;
+    };
+
+    UrlRewriter::UrlRewriter(const std::vector<Rule> &rules_)
+    {
+        rules.reserve(rules_.size());
+        for (const auto &rule : rules_)
+        {
+            CompiledRule compiled;
+            compiled.type = rule.type;
+            compiled.kinds = rule.kinds;
+            if (rule.type == Rule::Type::Regex)
+            {
+                try
+                {
+                    compiled.regex.emplace(rule.pattern, std::regex::ECMAScript | std::regex::optimize);
+                }
+                catch (const std::regex_error &e)
+                {
+                    throw std::invalid_argument("Invalid URL rewrite pattern '" + rule.pattern + "': " + e.what());
+                }
+                compiled.prefix = literalPrefix(rule.pattern);
+            }
+            else
+            {
+                compiled.prefix = rule.pattern;
+            }
+            compiled.replacement = parseReplacement(rule.replacement);
+            compiled.usesTokens = std::any_of(compiled.replacement.begin(), compiled.replacement.end(), [](const Segment &segment)
+                                              { return segment.type == Segment::Type::Token; });
+            rules.push_back(std::move(compiled));
+        }
+    }
+
+    UrlRewriter::~UrlRewriter() = default;
+
+    std::optional<std::string> UrlRewriter::rewrite(const std::string &url, mbgl::Resource::Kind kind) const
+    {
+        const uint32_t kindBit = 1u << static_cast<uint32_t>(kind);
+        for (const auto &rule : rules)
+        {
+            if ((rule.kinds && !(rule.kinds & kindBit)) || url.compare(0, rule.prefix.size(), rule.prefix) != 0)
+            {
+                continue;
+            }
+
+            std::smatch match;
+            if (rule.regex && !std::regex_match(url, match, *rule.regex))
+            {
+                continue;
+            }
+
+            const auto tokenValues = rule.usesTokens ? currentTokens() : nullptr;
+            std::string result;
+            result.reserve(url.size() + 32);
+            for (const auto &segment : rule.replacement)
+            {
+                switch (segment.type)
+                {
+                case Segment::Type::Literal:
+                    result += segment.text;
+                    break;
+                case Segment::Type::Group:
+                    if (rule.regex && segment.group < match.size())
+                    {
+                        result += match[segment.group].str();
+                    }
+                    else if (!rule.regex && segment.group == 0)
+                    {
+                        result += rule.prefix;
+                    }
+                    break;
+                case Segment::Type::Token:
+                {
+                    auto it = tokenValues->find(segment.text);
+                    if (it != tokenValues->end())
+                    {
+                        result += it->second;
+                    }
+                    break;
+                }
+                }
+            }
+
+            if (!rule.regex)
+            {
+                result.append(url, rule.prefix.size(), std::string::npos);
+            }
+            return result;
+        }
+        return std::nullopt;
+    }
+
+    void UrlRewriter::setToken(const std::string &name, const std::string &value)
+    {
+        std::lock_guard<std::mutex> lock(tokensMutex);
+        auto updated = std::make_shared<TokenMap>(*tokens);
+        if (value.empty())
+        {
+            updated->erase(name);
+        }
+        else
+        {
+            (*updated)[name] = value;
+        }
+        tokens = std::move(updated);
+    }
+
+} // namespace maplibre_jni
+
+// JNI bindings
+extern "C"
+{
+
+    JNIEXPORT void JNICALL Java_org_maplibre_kmp_native_UrlRewriteRule_nativeSetToken(JNIEnv *env, jclass, jstring name, jstring value)
+    {
+        try
+        {
+            maplibre_jni::UrlRewriter::setToken(jstringToString(env, name), jstringToString(env, value));
+        }
+        catch (const std::exception &e)
+        {
+            throwJavaException(env, "java/lang/RuntimeException", e.what());
+        }
+    }
+
+} // extern "C"
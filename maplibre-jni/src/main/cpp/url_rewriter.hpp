@@ -0,0 +1,60 @@
+#pragma once
+
+#include <mbgl/storage/resource.hpp>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace maplibre_jni
+{
+
+    // Rewrites request URLs through a table of rules compiled once
+    //
+    // A prefix rule replaces the start of a URL; a regex rule (ECMAScript syntax) must match the
+    // whole URL and replaces it. Replacements may refer to capture groups as $0 to $9 and to
+    // named tokens as {name}; "$$" is a literal dollar sign. Tokens are process-wide and can be
+    // changed at any time, e.g. to rotate signatures, without rebuilding any map. The first
+    // matching rule wins. Regex rules are only tried after their literal leading characters
+    // match, so URLs that can't match cost a string comparison per rule.
+    class UrlRewriter
+    {
+    public:
+        struct Rule
+        {
+            enum class Type : int
+            {
+                Prefix = 0,
+                Regex = 1,
+            };
+
+            Type type = Type::Prefix;
+            std::string pattern;
+            std::string replacement;
+            // Bit (1 << kind) for each mbgl::Resource::Kind the rule applies to; 0 for all kinds
+            uint32_t kinds = 0;
+
+            bool operator==(const Rule &other) const
+            {
+                return type == other.type && pattern == other.pattern && replacement == other.replacement &&
+                       kinds == other.kinds;
+            }
+        };
+
+        // Throws std::invalid_argument for a regex that doesn't compile
+        explicit UrlRewriter(const std::vector<Rule> &rules);
+        ~UrlRewriter();
+
+        // URL produced by the first matching rule, or nullopt if no rule matches
+        std::optional<std::string> rewrite(const std::string &url, mbgl::Resource::Kind kind) const;
+
+        // Sets the value of a {name} token; an empty value removes it, which expands to nothing
+        static void setToken(const std::string &name, const std::string &value);
+
+    private:
+        struct CompiledRule;
+
+        std::vector<CompiledRule> rules;
+    };
+
+} // namespace maplibre_jni
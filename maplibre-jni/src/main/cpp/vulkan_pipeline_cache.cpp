@@ -0,0 +1,265 @@
+#ifdef USE_VULKAN_BACKEND
+
+#include "vulkan_pipeline_cache.hpp"
+#include "mapped_file.hpp"
+#include <mbgl/util/logging.hpp>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        constexpr char MAGIC[8] = {'M', 'L', 'V', 'K', 'P', 'C', '\0', '\0'};
+        constexpr uint32_t FORMAT_VERSION = 1;
+
+        struct Header
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t vendorID;
+            uint32_t deviceID;
+            uint32_t driverVersion;
+            uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+            uint64_t length;
+            uint64_t checksum;
+        };
+
+        // Header the driver itself puts at the start of vkGetPipelineCacheData output
+        struct DriverHeader
+        {
+            uint32_t headerSize;
+            uint32_t headerVersion;
+            uint32_t vendorID;
+            uint32_t deviceID;
+            uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+        };
+
+        uint64_t checksum(const uint8_t *data, size_t length)
+        {
+            uint64_t hash = 14695981039346656037ull;
+            for (size_t i = 0; i < length; ++i)
+            {
+                hash ^= data[i];
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        // The trampoline is a plain function pointer, so caches are looked up by device
+        std::mutex registryMutex;
+        std::unordered_map<VkDevice, VulkanPipelineCache *> registry;
+    } // namespace
+
+    VulkanPipelineCache::VulkanPipelineCache(std::string path_,
+                                             const vk::PhysicalDeviceProperties &properties_,
+                                             vk::Device device_,
+                                             const vk::DispatchLoaderDynamic &dispatcher_)
+        : path(std::move(path_)),
+          properties(properties_),
+          device(device_),
+          dispatcher(dispatcher_)
+    {
+        const std::vector<uint8_t> initialData = loadValidated();
+
+        VkPipelineCacheCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        createInfo.initialDataSize = initialData.size();
+        createInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+        VkResult result = dispatcher.vkCreatePipelineCache(static_cast<VkDevice>(device), &createInfo, nullptr, &cache);
+        if (result != VK_SUCCESS && !initialData.empty())
+        {
+            // Some drivers reject data they wrote themselves after an update; start empty
+            createInfo.initialDataSize = 0;
+            createInfo.pInitialData = nullptr;
+            result = dispatcher.vkCreatePipelineCache(static_cast<VkDevice>(device), &createInfo, nullptr, &cache);
+        }
+        if (result != VK_SUCCESS)
+        {
+            cache = VK_NULL_HANDLE;
+            mbgl::Log::Warning(mbgl::Event::Render, "Failed to create Vulkan pipeline cache");
+            return;
+        }
+
+        mbgl::Log::Info(mbgl::Event::Render,
+                        "Vulkan pipeline cache loaded " + std::to_string(initialData.size()) + " bytes");
+    }
+
+    VulkanPipelineCache::~VulkanPipelineCache()
+    {
+        if (cache != VK_NULL_HANDLE)
+        {
+            dispatcher.vkDestroyPipelineCache(static_cast<VkDevice>(device), cache, nullptr);
+        }
+    }
+
+    void VulkanPipelineCache::install(vk::DispatchLoaderDynamic &target)
+    {
+        if (cache == VK_NULL_HANDLE || originalCreateGraphicsPipelines)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        registry[static_cast<VkDevice>(device)] = this;
+        originalCreateGraphicsPipelines = target.vkCreateGraphicsPipelines;
+        target.vkCreateGraphicsPipelines = &VulkanPipelineCache::createGraphicsPipelines;
+    }
+
+    void VulkanPipelineCache::uninstall(vk::DispatchLoaderDynamic &target)
+    {
+        if (!originalCreateGraphicsPipelines)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        target.vkCreateGraphicsPipelines = originalCreateGraphicsPipelines;
+        registry.erase(static_cast<VkDevice>(device));
+    }
+
+    VkResult VulkanPipelineCache::createGraphicsPipelines(
+        VkDevice device,
+        VkPipelineCache pipelineCache,
+        uint32_t createInfoCount,
+        const VkGraphicsPipelineCreateInfo *createInfos,
+        const VkAllocationCallbacks *allocator,
+        VkPipeline *pipelines)
+    {
+        VulkanPipelineCache *self = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            auto it = registry.find(device);
+            if (it != registry.end())
+            {
+                self = it->second;
+            }
+        }
+        if (!self)
+        {
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+
+        if (pipelineCache == VK_NULL_HANDLE)
+        {
+            pipelineCache = self->cache;
+            self->pipelinesSinceSave += createInfoCount;
+        }
+        return self->originalCreateGraphicsPipelines(device, pipelineCache, createInfoCount, createInfos, allocator, pipelines);
+    }
+
+    std::vector<uint8_t> VulkanPipelineCache::loadValidated() const
+    {
+        std::unique_ptr<MappedFile> file;
+        try
+        {
+            file = MappedFile::open(path);
+        }
+        catch (const std::exception &)
+        {
+            return {};
+        }
+
+        if (file->size() < sizeof(Header))
+        {
+            return {};
+        }
+
+        Header header;
+        std::memcpy(&header, file->data(), sizeof(Header));
+        const uint8_t *data = file->data() + sizeof(Header);
+
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != FORMAT_VERSION ||
+            header.length != file->size() - sizeof(Header) || header.checksum != checksum(data, header.length))
+        {
+            mbgl::Log::Warning(mbgl::Event::Render, "Discarding corrupt Vulkan pipeline cache " + path);
+            return {};
+        }
+
+        // A cache from another GPU or driver build is at best useless and at worst crashes the driver
+        if (header.vendorID != properties.vendorID || header.deviceID != properties.deviceID ||
+            header.driverVersion != properties.driverVersion ||
+            std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) != 0)
+        {
+            mbgl::Log::Info(mbgl::Event::Render, "Vulkan pipeline cache is from another device or driver, rebuilding");
+            return {};
+        }
+
+        DriverHeader driverHeader;
+        if (header.length < sizeof(DriverHeader))
+        {
+            return {};
+        }
+        std::memcpy(&driverHeader, data, sizeof(DriverHeader));
+        if (driverHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+            driverHeader.vendorID != properties.vendorID || driverHeader.deviceID != properties.deviceID ||
+            std::memcmp(driverHeader.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) != 0)
+        {
+            return {};
+        }
+
+        return std::vector<uint8_t>(data, data + header.length);
+    }
+
+    void VulkanPipelineCache::save()
+    {
+        if (cache == VK_NULL_HANDLE || pipelinesSinceSave.exchange(0) == 0)
+        {
+            return;
+        }
+
+        size_t length = 0;
+        if (dispatcher.vkGetPipelineCacheData(static_cast<VkDevice>(device), cache, &length, nullptr) != VK_SUCCESS ||
+            length == 0)
+        {
+            return;
+        }
+        std::vector<uint8_t> data(length);
+        if (dispatcher.vkGetPipelineCacheData(static_cast<VkDevice>(device), cache, &length, data.data()) != VK_SUCCESS)
+        {
+            return;
+        }
+        data.resize(length);
+
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = FORMAT_VERSION;
+        header.vendorID = properties.vendorID;
+        header.deviceID = properties.deviceID;
+        header.driverVersion = properties.driverVersion;
+        std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE);
+        header.length = data.size();
+        header.checksum = checksum(data.data(), data.size());
+
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+        // Write to a temporary file first so a crash never leaves a truncated cache behind
+        const std::string temp = path + ".tmp";
+        {
+            std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+            out.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+            if (!out)
+            {
+                mbgl::Log::Warning(mbgl::Event::Render, "Failed to write Vulkan pipeline cache " + temp);
+                return;
+            }
+        }
+
+        std::filesystem::rename(temp, path, error);
+        if (error)
+        {
+            mbgl::Log::Warning(mbgl::Event::Render, "Failed to store Vulkan pipeline cache: " + error.message());
+        }
+    }
+
+} // namespace maplibre_jni
+
+#endif // USE_VULKAN_BACKEND
@@ -0,0 +1,61 @@
+#pragma once
+
+#ifdef USE_VULKAN_BACKEND
+
+#include <mbgl/vulkan/renderer_backend.hpp>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace maplibre_jni
+{
+
+    // Persistent VkPipelineCache shared by every pipeline the backend creates
+    //
+    // mbgl creates its pipelines without a cache handle, so install() swaps the dispatcher's
+    // vkCreateGraphicsPipelines for a trampoline that substitutes this cache whenever the caller
+    // passes none. The file is only reused when the vendor, device, pipeline cache UUID and
+    // driver version all match the current device; anything else starts from an empty cache.
+    class VulkanPipelineCache
+    {
+    public:
+        VulkanPipelineCache(std::string path,
+                            const vk::PhysicalDeviceProperties &properties,
+                            vk::Device device,
+                            const vk::DispatchLoaderDynamic &dispatcher);
+        ~VulkanPipelineCache();
+
+        VulkanPipelineCache(const VulkanPipelineCache &) = delete;
+        VulkanPipelineCache &operator=(const VulkanPipelineCache &) = delete;
+
+        // Route pipeline creation through this cache until uninstall()
+        void install(vk::DispatchLoaderDynamic &dispatcher);
+        void uninstall(vk::DispatchLoaderDynamic &dispatcher);
+
+        // Write the cache to disk if pipelines were created since the last save
+        void save();
+
+    private:
+        static VKAPI_ATTR VkResult VKAPI_CALL createGraphicsPipelines(
+            VkDevice device,
+            VkPipelineCache pipelineCache,
+            uint32_t createInfoCount,
+            const VkGraphicsPipelineCreateInfo *createInfos,
+            const VkAllocationCallbacks *allocator,
+            VkPipeline *pipelines);
+
+        std::vector<uint8_t> loadValidated() const;
+
+        std::string path;
+        vk::PhysicalDeviceProperties properties;
+        vk::Device device;
+        const vk::DispatchLoaderDynamic &dispatcher;
+        VkPipelineCache cache = VK_NULL_HANDLE;
+        PFN_vkCreateGraphicsPipelines originalCreateGraphicsPipelines = nullptr;
+        std::atomic<uint32_t> pipelinesSinceSave{0};
+    };
+
+} // namespace maplibre_jni
+
+#endif // USE_VULKAN_BACKEND
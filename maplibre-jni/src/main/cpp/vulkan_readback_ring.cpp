@@ -0,0 +1,350 @@
+#ifdef USE_VULKAN_BACKEND
+
+#include "vulkan_readback_ring.hpp"
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace maplibre_jni
+{
+
+    VulkanReadbackRing::VulkanReadbackRing(mbgl::vulkan::RendererBackend &backend_, uint32_t slotCount)
+        : backend(backend_)
+    {
+        const auto &device = backend.getDevice();
+        const auto &dispatcher = backend.getDispatcher();
+
+        commandPool = device->createCommandPoolUnique(
+            vk::CommandPoolCreateInfo()
+                .setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer)
+                .setQueueFamilyIndex(static_cast<uint32_t>(backend.getGraphicsQueueIndex())),
+            nullptr, dispatcher);
+
+        auto commandBuffers = device->allocateCommandBuffersUnique(
+            vk::CommandBufferAllocateInfo()
+                .setCommandPool(commandPool.get())
+                .setLevel(vk::CommandBufferLevel::ePrimary)
+                .setCommandBufferCount(slotCount),
+            dispatcher);
+
+        slots.resize(slotCount);
+        for (uint32_t i = 0; i < slotCount; ++i)
+        {
+            slots[i].commandBuffer = std::move(commandBuffers[i]);
+            slots[i].fence = device->createFenceUnique(vk::FenceCreateInfo(), nullptr, dispatcher);
+            slots[i].semaphore = device->createSemaphoreUnique(vk::SemaphoreCreateInfo(), nullptr, dispatcher);
+        }
+    }
+
+    VulkanReadbackRing::~VulkanReadbackRing()
+    {
+        for (auto &slot : slots)
+        {
+            wait(slot);
+            if (slot.mapped)
+            {
+                backend.getDevice()->unmapMemory(slot.memory.get(), backend.getDispatcher());
+            }
+        }
+    }
+
+    uint32_t VulkanReadbackRing::findMemoryType(uint32_t typeBits, bool &coherent) const
+    {
+        const auto properties = backend.getPhysicalDevice().getMemoryProperties(backend.getDispatcher());
+
+        // Cached memory makes CPU reads fast; coherent spares the invalidate call
+        const vk::MemoryPropertyFlags preferences[] = {
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCached | vk::MemoryPropertyFlagBits::eHostCoherent,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCached,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+        };
+
+        for (const auto &wanted : preferences)
+        {
+            for (uint32_t i = 0; i < properties.memoryTypeCount; ++i)
+            {
+                if ((typeBits & (1u << i)) && (properties.memoryTypes[i].propertyFlags & wanted) == wanted)
+                {
+                    coherent = static_cast<bool>(properties.memoryTypes[i].propertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent);
+                    return i;
+                }
+            }
+        }
+        throw std::runtime_error("No host-visible memory type for readback");
+    }
+
+    void VulkanReadbackRing::ensureCapacity(Slot &slot, vk::DeviceSize bytes)
+    {
+        if (slot.capacity >= bytes)
+        {
+            return;
+        }
+
+        const auto &device = backend.getDevice();
+        const auto &dispatcher = backend.getDispatcher();
+
+        if (slot.mapped)
+        {
+            device->unmapMemory(slot.memory.get(), dispatcher);
+            slot.mapped = nullptr;
+        }
+        slot.buffer.reset();
+        slot.memory.reset();
+
+        slot.buffer = device->createBufferUnique(
+            vk::BufferCreateInfo()
+                .setSize(bytes)
+                .setUsage(vk::BufferUsageFlagBits::eTransferDst)
+                .setSharingMode(vk::SharingMode::eExclusive),
+            nullptr, dispatcher);
+
+        const auto requirements = device->getBufferMemoryRequirements(slot.buffer.get(), dispatcher);
+        slot.memory = device->allocateMemoryUnique(
+            vk::MemoryAllocateInfo()
+                .setAllocationSize(requirements.size)
+                .setMemoryTypeIndex(findMemoryType(requirements.memoryTypeBits, slot.coherent)),
+            nullptr, dispatcher);
+        device->bindBufferMemory(slot.buffer.get(), slot.memory.get(), 0, dispatcher);
+
+        // Persistently mapped for the lifetime of the allocation
+        slot.mapped = device->mapMemory(slot.memory.get(), 0, VK_WHOLE_SIZE, {}, dispatcher);
+        slot.capacity = bytes;
+    }
+
+    void VulkanReadbackRing::complete(Slot &slot)
+    {
+        const auto &device = backend.getDevice();
+        const auto &dispatcher = backend.getDispatcher();
+
+        device->resetFences(1, &slot.fence.get(), dispatcher);
+        slot.state = State::Ready;
+
+        if (!slot.coherent)
+        {
+            device->invalidateMappedMemoryRanges(
+                vk::MappedMemoryRange().setMemory(slot.memory.get()).setOffset(0).setSize(VK_WHOLE_SIZE),
+                dispatcher);
+        }
+    }
+
+    void VulkanReadbackRing::wait(Slot &slot)
+    {
+        if (slot.state != State::Pending)
+        {
+            return;
+        }
+
+        const auto result = backend.getDevice()->waitForFences(
+            1, &slot.fence.get(), VK_TRUE, std::numeric_limits<uint64_t>::max(), backend.getDispatcher());
+        if (result != vk::Result::eSuccess)
+        {
+            throw std::runtime_error("Failed to wait for frame readback");
+        }
+        complete(slot);
+    }
+
+    bool VulkanReadbackRing::poll(Slot &slot)
+    {
+        if (slot.state == State::Pending &&
+            backend.getDevice()->getFenceStatus(slot.fence.get(), backend.getDispatcher()) == vk::Result::eSuccess)
+        {
+            complete(slot);
+        }
+        return slot.state == State::Ready;
+    }
+
+    vk::Semaphore VulkanReadbackRing::capture(const Capture &capture)
+    {
+        if (capture.size.isEmpty())
+        {
+            return {};
+        }
+
+        const auto &dispatcher = backend.getDispatcher();
+
+        // Never write into memory the JVM is still reading: held slots are passed over, and
+        // the frame is skipped only when every slot is held
+        const auto count = static_cast<uint32_t>(slots.size());
+        uint32_t index = next;
+        while (slots[index].state == State::Held)
+        {
+            index = (index + 1) % count;
+            if (index == next)
+            {
+                stats.dropped++;
+                return {};
+            }
+        }
+        auto &slot = slots[index];
+
+        // The ring wrapped around before the GPU finished this slot; this is the only blocking point
+        wait(slot);
+        if (slot.state == State::Ready)
+        {
+            // Overwriting a frame nobody acquired
+            stats.dropped++;
+        }
+
+        next = (index + 1) % count;
+
+        ensureCapacity(slot, static_cast<vk::DeviceSize>(capture.size.width) * capture.size.height * 4);
+        slot.size = capture.size;
+        slot.bgra = capture.format == vk::Format::eB8G8R8A8Unorm || capture.format == vk::Format::eB8G8R8A8Srgb;
+
+        auto &commandBuffer = slot.commandBuffer.get();
+        commandBuffer.reset({}, dispatcher);
+        commandBuffer.begin(vk::CommandBufferBeginInfo().setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit), dispatcher);
+
+        const auto range = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+
+        // Make the render pass writes visible to the transfer
+        commandBuffer.pipelineBarrier(
+            vk::PipelineStageFlagBits::eColorAttachmentOutput,
+            vk::PipelineStageFlagBits::eTransfer,
+            {}, nullptr, nullptr,
+            vk::ImageMemoryBarrier()
+                .setSrcAccessMask(vk::AccessFlagBits::eColorAttachmentWrite)
+                .setDstAccessMask(vk::AccessFlagBits::eTransferRead)
+                .setOldLayout(capture.layout)
+                .setNewLayout(vk::ImageLayout::eTransferSrcOptimal)
+                .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                .setImage(capture.image)
+                .setSubresourceRange(range),
+            dispatcher);
+
+        commandBuffer.copyImageToBuffer(
+            capture.image,
+            vk::ImageLayout::eTransferSrcOptimal,
+            slot.buffer.get(),
+            vk::BufferImageCopy()
+                .setBufferOffset(0)
+                .setBufferRowLength(0)
+                .setBufferImageHeight(0)
+                .setImageSubresource(vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1))
+                .setImageOffset({0, 0, 0})
+                .setImageExtent({capture.size.width, capture.size.height, 1}),
+            dispatcher);
+
+        // Hand the image back in its original layout. The next frame's render pass must not
+        // overwrite it before the copy has read it, and the host must see the copied bytes
+        // once the fence signals.
+        commandBuffer.pipelineBarrier(
+            vk::PipelineStageFlagBits::eTransfer,
+            vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eBottomOfPipe | vk::PipelineStageFlagBits::eHost,
+            {},
+            vk::MemoryBarrier()
+                .setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+                .setDstAccessMask(vk::AccessFlagBits::eHostRead),
+            nullptr,
+            vk::ImageMemoryBarrier()
+                .setSrcAccessMask({})
+                .setDstAccessMask({})
+                .setOldLayout(vk::ImageLayout::eTransferSrcOptimal)
+                .setNewLayout(capture.layout)
+                .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+                .setImage(capture.image)
+                .setSubresourceRange(range),
+            dispatcher);
+
+        commandBuffer.end(dispatcher);
+
+        const std::vector<vk::PipelineStageFlags> waitStages(capture.waitSemaphores.size(), vk::PipelineStageFlagBits::eTransfer);
+        auto submitInfo = vk::SubmitInfo()
+                              .setWaitSemaphores(capture.waitSemaphores)
+                              .setWaitDstStageMask(waitStages)
+                              .setCommandBuffers(commandBuffer);
+        if (capture.signalSemaphore)
+        {
+            submitInfo.setSignalSemaphores(slot.semaphore.get());
+        }
+
+        backend.getGraphicsQueue().submit(submitInfo, slot.fence.get(), dispatcher);
+
+        slot.state = State::Pending;
+        slot.number = frameNumber++;
+        latest = static_cast<int32_t>(index);
+        stats.captured++;
+
+        return capture.signalSemaphore ? slot.semaphore.get() : vk::Semaphore();
+    }
+
+    size_t VulkanReadbackRing::readLatest(uint8_t *dst, size_t capacity)
+    {
+        if (latest < 0)
+        {
+            return 0;
+        }
+
+        auto &slot = slots[latest];
+        const size_t bytes = static_cast<size_t>(slot.size.width) * slot.size.height * 4;
+        if (bytes > capacity)
+        {
+            return bytes;
+        }
+
+        wait(slot);
+        std::memcpy(dst, slot.mapped, bytes);
+        return bytes;
+    }
+
+    std::optional<VulkanReadbackRing::Frame> VulkanReadbackRing::acquire()
+    {
+        Slot *oldest = nullptr;
+        uint32_t oldestIndex = 0;
+        for (uint32_t i = 0; i < slots.size(); ++i)
+        {
+            if (poll(slots[i]) && (!oldest || slots[i].number < oldest->number))
+            {
+                oldest = &slots[i];
+                oldestIndex = i;
+            }
+        }
+        if (!oldest)
+        {
+            return std::nullopt;
+        }
+
+        oldest->state = State::Held;
+        return Frame{oldestIndex,
+                     oldest->number,
+                     oldest->size,
+                     oldest->bgra,
+                     static_cast<uint8_t *>(oldest->mapped),
+                     static_cast<size_t>(oldest->size.width) * oldest->size.height * 4};
+    }
+
+    void VulkanReadbackRing::release(uint32_t index, uint64_t number)
+    {
+        if (index < slots.size() && slots[index].state == State::Held && slots[index].number == number)
+        {
+            slots[index].state = State::Free;
+        }
+    }
+
+    jobject acquireFrameForJava(JNIEnv *env, VulkanReadbackRing &ring, jlongArray info)
+    {
+        auto frame = ring.acquire();
+        if (!frame)
+        {
+            return nullptr;
+        }
+
+        const jlong values[] = {
+            static_cast<jlong>(frame->slot),
+            static_cast<jlong>(frame->number),
+            static_cast<jlong>(frame->size.width),
+            static_cast<jlong>(frame->size.height),
+            frame->bgra ? 1 : 0,
+            static_cast<jlong>(ring.getStats().dropped),
+        };
+        env->SetLongArrayRegion(info, 0, 6, values);
+
+        // No copy: the buffer aliases the slot until the frame is released
+        return env->NewDirectByteBuffer(frame->pixels, static_cast<jlong>(frame->byteSize));
+    }
+
+} // namespace maplibre_jni
+
+#endif // USE_VULKAN_BACKEND
@@ -0,0 +1,128 @@
+#pragma once
+
+#ifdef USE_VULKAN_BACKEND
+
+#include <mbgl/vulkan/renderer_backend.hpp>
+#include <mbgl/util/size.hpp>
+#include <jni.h>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace maplibre_jni
+{
+
+    // Ring of host-visible staging buffers that rendered frames are copied into
+    //
+    // Each capture records an image-to-buffer copy into the next slot not held by the consumer
+    // and submits it on the graphics queue behind the frame that was just rendered, signalling
+    // that slot's fence.
+    // The CPU only waits when it reads a slot, or when the ring wraps onto a slot whose copy
+    // has not completed yet, so with N slots the GPU can run up to N - 1 frames ahead of the
+    // consumer. Pixels are tightly packed 8-bit RGBA or BGRA, premultiplied, top row first.
+    class VulkanReadbackRing
+    {
+    public:
+        struct Capture
+        {
+            vk::Image image;
+            vk::Format format = vk::Format::eR8G8B8A8Unorm;
+            mbgl::Size size;
+
+            // Layout the image is in; it is restored after the copy
+            vk::ImageLayout layout = vk::ImageLayout::eTransferSrcOptimal;
+
+            // Wait for these before copying and signal a semaphore when done (used before present)
+            std::vector<vk::Semaphore> waitSemaphores;
+            bool signalSemaphore = false;
+        };
+
+        // A completed capture handed to the consumer until release()
+        struct Frame
+        {
+            uint32_t slot;
+            uint64_t number;
+            mbgl::Size size;
+            bool bgra;
+            uint8_t *pixels;
+            size_t byteSize;
+        };
+
+        struct Stats
+        {
+            uint64_t captured = 0;
+            // Frames overwritten before they were acquired, or skipped because every slot was held
+            uint64_t dropped = 0;
+        };
+
+        VulkanReadbackRing(mbgl::vulkan::RendererBackend &backend, uint32_t slotCount);
+        ~VulkanReadbackRing();
+
+        VulkanReadbackRing(const VulkanReadbackRing &) = delete;
+        VulkanReadbackRing &operator=(const VulkanReadbackRing &) = delete;
+
+        // Queue a copy of the image; returns the semaphore to wait on if one was requested
+        // (null if the frame was skipped, in which case the caller's own semaphores still apply)
+        vk::Semaphore capture(const Capture &capture);
+
+        // Copy the most recent capture into dst if it fits; returns its size in bytes (0 if none)
+        size_t readLatest(uint8_t *dst, size_t capacity);
+
+        // Oldest completed frame not yet handed out; never blocks
+        std::optional<Frame> acquire();
+
+        // Return an acquired frame's slot to the ring; ignored unless the slot still holds that frame
+        void release(uint32_t slot, uint64_t number);
+
+        Stats getStats() const { return stats; }
+
+    private:
+        enum class State
+        {
+            Free,
+            Pending,
+            Ready,
+            Held,
+        };
+
+        struct Slot
+        {
+            vk::UniqueBuffer buffer;
+            vk::UniqueDeviceMemory memory;
+            vk::UniqueCommandBuffer commandBuffer;
+            vk::UniqueFence fence;
+            vk::UniqueSemaphore semaphore;
+            void *mapped = nullptr;
+            bool coherent = true;
+            vk::DeviceSize capacity = 0;
+            mbgl::Size size;
+            bool bgra = false;
+            uint64_t number = 0;
+            State state = State::Free;
+        };
+
+        void ensureCapacity(Slot &slot, vk::DeviceSize bytes);
+        void wait(Slot &slot);
+        bool poll(Slot &slot);
+        void complete(Slot &slot);
+        uint32_t findMemoryType(uint32_t typeBits, bool &coherent) const;
+
+        mbgl::vulkan::RendererBackend &backend;
+        vk::UniqueCommandPool commandPool;
+        std::vector<Slot> slots;
+        uint32_t next = 0;
+        int32_t latest = -1;
+        uint64_t frameNumber = 0;
+        Stats stats;
+    };
+
+    // Acquire the next frame as a direct ByteBuffer over the mapped staging memory, or null.
+    // The buffer is only valid while the ring exists; RenderedFrame keeps its map reachable.
+    // info receives slot, frame number, width, height, pixel format (0 RGBA, 1 BGRA) and the
+    // number of frames dropped so far
+    jobject acquireFrameForJava(JNIEnv *env, VulkanReadbackRing &ring, jlongArray info);
+
+} // namespace maplibre_jni
+
+#endif // USE_VULKAN_BACKEND
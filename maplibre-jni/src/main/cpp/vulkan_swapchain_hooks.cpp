@@ -0,0 +1,263 @@
+#ifdef USE_VULKAN_BACKEND
+
+#include "vulkan_swapchain_hooks.hpp"
+#include <mbgl/util/logging.hpp>
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        std::mutex registryMutex;
+        std::unordered_map<VkDevice, VulkanSwapchainHooks *> devices;
+        std::unordered_map<VkQueue, VulkanSwapchainHooks *> queues;
+
+        template <typename Key>
+        VulkanSwapchainHooks *lookup(const std::unordered_map<Key, VulkanSwapchainHooks *> &map, Key key)
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            auto it = map.find(key);
+            return it != map.end() ? it->second : nullptr;
+        }
+    } // namespace
+
+    VulkanSwapchainHooks::VulkanSwapchainHooks(vk::PhysicalDevice physicalDevice_,
+                                               vk::Device device_,
+                                               vk::Queue presentQueue_,
+                                               vk::DispatchLoaderDynamic &dispatcher_)
+        : physicalDevice(physicalDevice_),
+          device(device_),
+          presentQueue(presentQueue_),
+          dispatcher(dispatcher_)
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        devices[static_cast<VkDevice>(device)] = this;
+        queues[static_cast<VkQueue>(presentQueue)] = this;
+
+        originalCreateSwapchain = dispatcher.vkCreateSwapchainKHR;
+        originalQueuePresent = dispatcher.vkQueuePresentKHR;
+        dispatcher.vkCreateSwapchainKHR = &VulkanSwapchainHooks::createSwapchain;
+        dispatcher.vkQueuePresentKHR = &VulkanSwapchainHooks::queuePresent;
+    }
+
+    VulkanSwapchainHooks::~VulkanSwapchainHooks()
+    {
+        // Fences must not be destroyed while an empty submit may still signal them
+        setMaxFramesInFlight(0);
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        dispatcher.vkCreateSwapchainKHR = originalCreateSwapchain;
+        dispatcher.vkQueuePresentKHR = originalQueuePresent;
+        devices.erase(static_cast<VkDevice>(device));
+        queues.erase(static_cast<VkQueue>(presentQueue));
+    }
+
+    VkResult VulkanSwapchainHooks::createSwapchain(
+        VkDevice device,
+        const VkSwapchainCreateInfoKHR *createInfo,
+        const VkAllocationCallbacks *allocator,
+        VkSwapchainKHR *swapchain)
+    {
+        auto *hooks = lookup(devices, device);
+        if (!hooks)
+        {
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+        return hooks->onCreateSwapchain(createInfo, allocator, swapchain);
+    }
+
+    VkResult VulkanSwapchainHooks::queuePresent(VkQueue queue, const VkPresentInfoKHR *presentInfo)
+    {
+        auto *hooks = lookup(queues, queue);
+        if (!hooks)
+        {
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+        return hooks->onPresent(queue, presentInfo);
+    }
+
+    VkResult VulkanSwapchainHooks::onCreateSwapchain(const VkSwapchainCreateInfoKHR *createInfo,
+                                                     const VkAllocationCallbacks *allocator,
+                                                     VkSwapchainKHR *result)
+    {
+        VkSwapchainCreateInfoKHR info = *createInfo;
+
+        VkSurfaceCapabilitiesKHR capabilities{};
+        dispatcher.vkGetPhysicalDeviceSurfaceCapabilitiesKHR(static_cast<VkPhysicalDevice>(physicalDevice), info.surface, &capabilities);
+
+        const auto extraUsage = static_cast<VkImageUsageFlags>(extraImageUsage);
+        if ((capabilities.supportedUsageFlags & extraUsage) == extraUsage)
+        {
+            info.imageUsage |= extraUsage;
+        }
+        else if (extraUsage)
+        {
+            mbgl::Log::Warning(mbgl::Event::Render, "Surface does not support the requested swapchain image usage");
+        }
+
+        if (presentMode)
+        {
+            uint32_t count = 0;
+            dispatcher.vkGetPhysicalDeviceSurfacePresentModesKHR(static_cast<VkPhysicalDevice>(physicalDevice), info.surface, &count, nullptr);
+            std::vector<VkPresentModeKHR> supported(count);
+            dispatcher.vkGetPhysicalDeviceSurfacePresentModesKHR(static_cast<VkPhysicalDevice>(physicalDevice), info.surface, &count, supported.data());
+
+            const auto wanted = static_cast<VkPresentModeKHR>(*presentMode);
+            if (std::find(supported.begin(), supported.end(), wanted) != supported.end())
+            {
+                info.presentMode = wanted;
+            }
+            else
+            {
+                mbgl::Log::Warning(mbgl::Event::Render, "Requested present mode is not supported by the surface");
+            }
+        }
+
+        if (minImageCount > 0)
+        {
+            // maxImageCount 0 means no upper limit
+            const uint32_t maxImages = capabilities.maxImageCount ? capabilities.maxImageCount : std::numeric_limits<uint32_t>::max();
+            info.minImageCount = std::clamp(minImageCount, capabilities.minImageCount, maxImages);
+        }
+
+        const VkResult status = originalCreateSwapchain(static_cast<VkDevice>(device), &info, allocator, result);
+        if (status != VK_SUCCESS)
+        {
+            return status;
+        }
+
+        swapchain = *result;
+        swapchainFormat = static_cast<vk::Format>(info.imageFormat);
+        swapchainSize = {info.imageExtent.width, info.imageExtent.height};
+
+        uint32_t count = 0;
+        dispatcher.vkGetSwapchainImagesKHR(static_cast<VkDevice>(device), swapchain, &count, nullptr);
+        swapchainImages.resize(count);
+        dispatcher.vkGetSwapchainImagesKHR(static_cast<VkDevice>(device), swapchain, &count, swapchainImages.data());
+
+        // Images without the extra usage can't be used by the present callback
+        if ((info.imageUsage & extraUsage) != extraUsage)
+        {
+            swapchainImages.clear();
+        }
+        return status;
+    }
+
+    VkResult VulkanSwapchainHooks::onPresent(VkQueue queue, const VkPresentInfoKHR *presentInfo)
+    {
+        if (!presentCallback || presentInfo->swapchainCount != 1 || presentInfo->pSwapchains[0] != swapchain ||
+            presentInfo->pImageIndices[0] >= swapchainImages.size())
+        {
+            return present(queue, presentInfo);
+        }
+
+        std::vector<vk::Semaphore> waits;
+        waits.reserve(presentInfo->waitSemaphoreCount);
+        for (uint32_t i = 0; i < presentInfo->waitSemaphoreCount; ++i)
+        {
+            waits.emplace_back(presentInfo->pWaitSemaphores[i]);
+        }
+
+        const vk::Semaphore signal = presentCallback(
+            vk::Image(swapchainImages[presentInfo->pImageIndices[0]]), swapchainFormat, swapchainSize, waits);
+        if (!signal)
+        {
+            return present(queue, presentInfo);
+        }
+
+        const VkSemaphore wait = static_cast<VkSemaphore>(signal);
+        VkPresentInfoKHR info = *presentInfo;
+        info.waitSemaphoreCount = 1;
+        info.pWaitSemaphores = &wait;
+        return present(queue, &info);
+    }
+
+    VkResult VulkanSwapchainHooks::present(VkQueue queue, const VkPresentInfoKHR *presentInfo)
+    {
+        std::vector<VkRectLayerKHR> rects;
+        rects.reserve(presentDamage.size());
+        for (const auto &rect : presentDamage)
+        {
+            rects.push_back({{rect.x, rect.y},
+                             {static_cast<uint32_t>(rect.width), static_cast<uint32_t>(rect.height)},
+                             0});
+        }
+        presentDamage.clear();
+
+        VkPresentInfoKHR info = *presentInfo;
+        VkPresentRegionKHR region{static_cast<uint32_t>(rects.size()), rects.data()};
+        VkPresentRegionsKHR regions{VK_STRUCTURE_TYPE_PRESENT_REGIONS_KHR, info.pNext, 1, &region};
+        if (incrementalPresent && !rects.empty() && info.swapchainCount == 1)
+        {
+            info.pNext = &regions;
+        }
+
+        const VkResult status = originalQueuePresent(queue, &info);
+        if (frameFences.empty())
+        {
+            return status;
+        }
+
+        // An empty submit signals its fence once everything queued before it, i.e. this frame, is done
+        const size_t index = presentedFrames % frameFences.size();
+        if (frameFencePending[index])
+        {
+            waitForFrameSlot();
+        }
+        const VkFence fence = static_cast<VkFence>(frameFences[index].get());
+        if (dispatcher.vkQueueSubmit(queue, 0, nullptr, fence) == VK_SUCCESS)
+        {
+            frameFencePending[index] = true;
+        }
+        presentedFrames++;
+        return status;
+    }
+
+    void VulkanSwapchainHooks::setMaxFramesInFlight(uint32_t frames)
+    {
+        // Drain the old fences before replacing them
+        for (size_t i = 0; i < frameFences.size(); ++i)
+        {
+            if (frameFencePending[i])
+            {
+                const VkFence fence = static_cast<VkFence>(frameFences[i].get());
+                dispatcher.vkWaitForFences(static_cast<VkDevice>(device), 1, &fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+            }
+        }
+        frameFences.clear();
+        frameFencePending.assign(frames, false);
+        presentedFrames = 0;
+
+        for (uint32_t i = 0; i < frames; ++i)
+        {
+            frameFences.push_back(device.createFenceUnique(vk::FenceCreateInfo(), nullptr, dispatcher));
+        }
+    }
+
+    void VulkanSwapchainHooks::waitForFrameSlot()
+    {
+        if (frameFences.empty())
+        {
+            return;
+        }
+
+        // The slot the next present will use holds the fence of the frame maxFramesInFlight back
+        const size_t index = presentedFrames % frameFences.size();
+        if (!frameFencePending[index])
+        {
+            return;
+        }
+
+        const VkFence fence = static_cast<VkFence>(frameFences[index].get());
+        dispatcher.vkWaitForFences(static_cast<VkDevice>(device), 1, &fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+        dispatcher.vkResetFences(static_cast<VkDevice>(device), 1, &fence);
+        frameFencePending[index] = false;
+    }
+
+} // namespace maplibre_jni
+
+#endif // USE_VULKAN_BACKEND
@@ -0,0 +1,109 @@
+#pragma once
+
+#ifdef USE_VULKAN_BACKEND
+
+#include "damage_tracker.hpp"
+#include <mbgl/vulkan/renderer_backend.hpp>
+#include <mbgl/util/size.hpp>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace maplibre_jni
+{
+
+    // Intercepts swapchain creation and presentation on a backend's dispatcher
+    //
+    // mbgl owns the swapchain and presents from inside Context::submitFrame, so the only way to
+    // adjust how the swapchain is created, or to touch an image between rendering and present,
+    // is to swap the dispatcher's function pointers. Like VulkanPipelineCache, the trampolines
+    // are plain function pointers and find their hooks through a registry keyed by device/queue.
+    // Changes to creation parameters take effect on the next swapchain rebuild.
+    class VulkanSwapchainHooks
+    {
+    public:
+        // Called with the image about to be presented (in PRESENT_SRC_KHR layout) and the
+        // semaphores the present would have waited on. Returns a semaphore the present waits on
+        // instead, or a null handle to present unchanged.
+        using PresentCallback = std::function<vk::Semaphore(vk::Image image,
+                                                            vk::Format format,
+                                                            mbgl::Size size,
+                                                            const std::vector<vk::Semaphore> &waitSemaphores)>;
+
+        VulkanSwapchainHooks(vk::PhysicalDevice physicalDevice,
+                             vk::Device device,
+                             vk::Queue presentQueue,
+                             vk::DispatchLoaderDynamic &dispatcher);
+        ~VulkanSwapchainHooks();
+
+        VulkanSwapchainHooks(const VulkanSwapchainHooks &) = delete;
+        VulkanSwapchainHooks &operator=(const VulkanSwapchainHooks &) = delete;
+
+        // Extra usage requested for swapchain images, if the surface supports it
+        void setExtraImageUsage(vk::ImageUsageFlags usage) { extraImageUsage = usage; }
+
+        void setPresentCallback(PresentCallback callback) { presentCallback = std::move(callback); }
+
+        // Present mode to request; falls back to the driver's choice if the surface lacks it
+        void setPresentMode(std::optional<vk::PresentModeKHR> mode) { presentMode = mode; }
+
+        // Minimum swapchain image count, clamped to the surface limits (0 keeps mbgl's choice)
+        void setMinImageCount(uint32_t count) { minImageCount = count; }
+
+        // Limit how many presented frames may still be executing on the GPU (0 for no limit)
+        void setMaxFramesInFlight(uint32_t frames);
+
+        // Block until another frame may be started without exceeding the frames-in-flight limit
+        void waitForFrameSlot();
+
+        // Regions the next present changes, passed on with VK_KHR_incremental_present when the
+        // device has it enabled; empty presents the whole image
+        void setIncrementalPresent(bool enabled) { incrementalPresent = enabled; }
+        void setPresentDamage(std::vector<DamageRect> damage) { presentDamage = std::move(damage); }
+
+    private:
+        static VKAPI_ATTR VkResult VKAPI_CALL createSwapchain(
+            VkDevice device,
+            const VkSwapchainCreateInfoKHR *createInfo,
+            const VkAllocationCallbacks *allocator,
+            VkSwapchainKHR *swapchain);
+
+        static VKAPI_ATTR VkResult VKAPI_CALL queuePresent(VkQueue queue, const VkPresentInfoKHR *presentInfo);
+
+        VkResult onCreateSwapchain(const VkSwapchainCreateInfoKHR *createInfo,
+                                   const VkAllocationCallbacks *allocator,
+                                   VkSwapchainKHR *swapchain);
+        VkResult onPresent(VkQueue queue, const VkPresentInfoKHR *presentInfo);
+        VkResult present(VkQueue queue, const VkPresentInfoKHR *presentInfo);
+
+        vk::PhysicalDevice physicalDevice;
+        vk::Device device;
+        vk::Queue presentQueue;
+        vk::DispatchLoaderDynamic &dispatcher;
+
+        PFN_vkCreateSwapchainKHR originalCreateSwapchain = nullptr;
+        PFN_vkQueuePresentKHR originalQueuePresent = nullptr;
+
+        vk::ImageUsageFlags extraImageUsage;
+        PresentCallback presentCallback;
+        std::optional<vk::PresentModeKHR> presentMode;
+        uint32_t minImageCount = 0;
+        bool incrementalPresent = false;
+        std::vector<DamageRect> presentDamage;
+
+        // One fence per allowed frame in flight, signalled by an empty submit after each present
+        std::vector<vk::UniqueFence> frameFences;
+        std::vector<bool> frameFencePending;
+        uint64_t presentedFrames = 0;
+
+        // The swapchain created last, which is the one mbgl presents to
+        VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+        std::vector<VkImage> swapchainImages;
+        vk::Format swapchainFormat = vk::Format::eUndefined;
+        mbgl::Size swapchainSize;
+    };
+
+} // namespace maplibre_jni
+
+#endif // USE_VULKAN_BACKEND
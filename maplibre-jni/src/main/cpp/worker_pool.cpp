@@ -0,0 +1,191 @@
+#include "worker_pool.hpp"
+
+#include <mbgl/util/logging.hpp>
+#include <mbgl/util/thread_pool.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif __APPLE__
+#include <pthread/qos.h>
+#endif
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        // How long pool creation waits for every worker to pick up its setup task
+        constexpr auto SETUP_TIMEOUT = std::chrono::seconds(2);
+
+        void configureCurrentThread(const WorkerPoolOptions &options, size_t index)
+        {
+            const std::string name = options.name + " " + std::to_string(index);
+
+#ifdef __linux__
+            // Linux thread names are limited to 15 characters
+            pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+
+            const int niceValue = options.priority == WorkerPoolOptions::Priority::Low      ? 19
+                                  : options.priority == WorkerPoolOptions::Priority::Normal ? 0
+                                                                                            : -5;
+            if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), niceValue) != 0)
+            {
+                mbgl::Log::Warning(mbgl::Event::General, "Could not set worker thread priority");
+            }
+
+            if (!options.cpuAffinity.empty())
+            {
+                const int cpu = options.cpuAffinity[index % options.cpuAffinity.size()];
+                bool pinned = false;
+                if (cpu >= 0 && cpu < CPU_SETSIZE)
+                {
+                    cpu_set_t cpus;
+                    CPU_ZERO(&cpus);
+                    CPU_SET(cpu, &cpus);
+                    pinned = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+                }
+                if (!pinned)
+                {
+                    mbgl::Log::Warning(mbgl::Event::General, "Could not pin worker thread to CPU");
+                }
+            }
+#elif _WIN32
+            const std::wstring wideName(name.begin(), name.end());
+            SetThreadDescription(GetCurrentThread(), wideName.c_str());
+
+            const int threadPriority = options.priority == WorkerPoolOptions::Priority::Low      ? THREAD_PRIORITY_LOWEST
+                                       : options.priority == WorkerPoolOptions::Priority::Normal ? THREAD_PRIORITY_NORMAL
+                                                                                                 : THREAD_PRIORITY_ABOVE_NORMAL;
+            SetThreadPriority(GetCurrentThread(), threadPriority);
+
+            if (!options.cpuAffinity.empty())
+            {
+                const int cpu = options.cpuAffinity[index % options.cpuAffinity.size()];
+                if (cpu < 0 || cpu >= 64 || SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) == 0)
+                {
+                    mbgl::Log::Warning(mbgl::Event::General, "Could not pin worker thread to CPU");
+                }
+            }
+#elif __APPLE__
+            pthread_setname_np(name.c_str());
+
+            const qos_class_t qos = options.priority == WorkerPoolOptions::Priority::Low      ? QOS_CLASS_UTILITY
+                                    : options.priority == WorkerPoolOptions::Priority::Normal ? QOS_CLASS_DEFAULT
+                                                                                              : QOS_CLASS_USER_INITIATED;
+            pthread_set_qos_class_self_np(qos, 0);
+
+            // macOS has no API to pin a thread to a CPU
+            if (!options.cpuAffinity.empty() && index == 0)
+            {
+                mbgl::Log::Warning(mbgl::Event::General, "CPU affinity is not supported on macOS");
+            }
+#endif
+        }
+
+        std::shared_ptr<mbgl::Scheduler> createWorkerPool(const WorkerPoolOptions &options)
+        {
+            const size_t threads = options.threads > 0
+                                       ? options.threads
+                                       : std::max<size_t>(1, std::thread::hardware_concurrency());
+            auto pool = std::make_shared<mbgl::ThreadedScheduler>(threads);
+
+            // mbgl names and prioritises its workers itself, so each worker reconfigures itself
+            // from a setup task. Every task waits until all of them have started, which makes each
+            // run on a different worker.
+            struct Setup
+            {
+                std::mutex mutex;
+                std::condition_variable cv;
+                size_t started = 0;
+                size_t finished = 0;
+            };
+            auto setup = std::make_shared<Setup>();
+
+            for (size_t i = 0; i < threads; i++)
+            {
+                pool->schedule([setup, options, threads] {
+                    std::unique_lock<std::mutex> lock(setup->mutex);
+                    const size_t index = setup->started++;
+                    setup->cv.notify_all();
+                    setup->cv.wait_for(lock, SETUP_TIMEOUT, [&] { return setup->started == threads; });
+                    lock.unlock();
+
+                    configureCurrentThread(options, index);
+
+                    lock.lock();
+                    setup->finished++;
+                    setup->cv.notify_all();
+                });
+            }
+
+            std::unique_lock<std::mutex> lock(setup->mutex);
+            if (!setup->cv.wait_for(lock, SETUP_TIMEOUT * 2, [&] { return setup->finished == threads; }))
+            {
+                mbgl::Log::Warning(mbgl::Event::General, "Worker pool setup timed out; some workers keep mbgl's defaults");
+            }
+
+            mbgl::Log::Info(mbgl::Event::General, "Created worker pool '" + options.name + "' with " +
+                                                      std::to_string(threads) + " threads");
+            return pool;
+        }
+
+        struct SharedPool
+        {
+            WorkerPoolOptions options;
+            std::weak_ptr<mbgl::Scheduler> pool;
+        };
+
+        std::mutex sharedPoolsMutex;
+        std::vector<SharedPool> sharedPools;
+    } // namespace
+
+    bool WorkerPoolOptions::operator==(const WorkerPoolOptions &other) const
+    {
+        return threads == other.threads && name == other.name && priority == other.priority &&
+               cpuAffinity == other.cpuAffinity && shared == other.shared;
+    }
+
+    std::shared_ptr<mbgl::Scheduler> acquireWorkerPool(const WorkerPoolOptions &options)
+    {
+        if (!options.shared)
+        {
+            return createWorkerPool(options);
+        }
+
+        std::lock_guard<std::mutex> lock(sharedPoolsMutex);
+        sharedPools.erase(std::remove_if(sharedPools.begin(), sharedPools.end(),
+                                         [](const SharedPool &entry) { return entry.pool.expired(); }),
+                          sharedPools.end());
+
+        for (const auto &entry : sharedPools)
+        {
+            if (entry.options == options)
+            {
+                if (auto pool = entry.pool.lock())
+                {
+                    return pool;
+                }
+            }
+        }
+
+        auto pool = createWorkerPool(options);
+        sharedPools.push_back({options, pool});
+        return pool;
+    }
+
+} // namespace maplibre_jni
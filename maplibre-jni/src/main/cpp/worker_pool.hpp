@@ -0,0 +1,41 @@
+#pragma once
+
+#include <mbgl/actor/scheduler.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace maplibre_jni
+{
+
+    // Thread pool the renderer parses tiles and lays out symbols on
+    //
+    // Without options maps use mbgl's process-wide background pool, whose size is fixed. Maps
+    // given options get a pool built from them instead; shared pools are reused by every map that
+    // asks for the same options, so many maps in one process can split a fixed number of workers.
+    struct WorkerPoolOptions
+    {
+        enum class Priority : int
+        {
+            Low = 0,
+            Normal = 1,
+            High = 2,
+        };
+
+        // Number of workers; 0 uses one per hardware thread
+        uint32_t threads = 0;
+        // Workers are named "<name> <index>" (truncated to the platform's limit)
+        std::string name = "MapWorker";
+        Priority priority = Priority::Low;
+        // CPUs workers are pinned to, worker i to cpuAffinity[i % size]; empty leaves them unpinned
+        std::vector<int> cpuAffinity;
+        // Reuse a live pool with the same options instead of creating one for this map
+        bool shared = true;
+
+        bool operator==(const WorkerPoolOptions &other) const;
+    };
+
+    std::shared_ptr<mbgl::Scheduler> acquireWorkerPool(const WorkerPoolOptions &options);
+
+} // namespace maplibre_jni
@@ -0,0 +1,356 @@
+#include "write_behind_cache_source.hpp"
+#include <mbgl/actor/scheduler.hpp>
+#include <mbgl/storage/sqlite3.hpp>
+#include <mbgl/util/async_request.hpp>
+#include <mbgl/util/logging.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        // Reads arriving closer together than this mean the map is still loading
+        constexpr auto QUIET_PERIOD = std::chrono::milliseconds(200);
+
+        // Schema version of the cache databases mbgl keeps without migrating them
+        constexpr int64_t CACHE_SCHEMA_VERSION = 6;
+
+        int64_t queryPragma(mapbox::sqlite::Database &db, const char *sql)
+        {
+            mapbox::sqlite::Statement statement(db, sql);
+            mapbox::sqlite::Query query(statement);
+            return query.run() ? query.get<int64_t>(0) : 0;
+        }
+
+        uint64_t sizeOf(const mbgl::Resource &resource, const mbgl::Response &response)
+        {
+            return resource.url.size() + (response.data ? response.data->size() : 0);
+        }
+
+        // Refreshes a body's validity from a 304, as the database would do with the stored one
+        void refresh(mbgl::Response &stored, const mbgl::Response &notModified)
+        {
+            stored.expires = notModified.expires;
+            stored.mustRevalidate = notModified.mustRevalidate;
+            if (notModified.modified)
+            {
+                stored.modified = notModified.modified;
+            }
+            if (notModified.etag)
+            {
+                stored.etag = notModified.etag;
+            }
+        }
+    } // namespace
+
+    struct WriteBehindCacheSource::Queue
+    {
+        struct Pending
+        {
+            mbgl::Resource resource;
+            mbgl::Response response;
+        };
+
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::unordered_map<std::string, Pending> pending;
+        uint64_t pendingBytes = 0;
+        Clock::time_point oldest;
+        Clock::time_point lastRead;
+        bool stopping = false;
+    };
+
+    struct WriteBehindCacheSource::Task
+    {
+        Callback callback;
+    };
+
+    // Handed to the requester of a queued resource; dropping it discards the response
+    class WriteBehindCacheSource::Request final : public mbgl::AsyncRequest
+    {
+    public:
+        explicit Request(std::shared_ptr<Task> task_)
+            : task(std::move(task_))
+        {
+        }
+
+    private:
+        std::shared_ptr<Task> task;
+    };
+
+    namespace
+    {
+        template <typename Pending>
+        void write(const std::shared_ptr<mbgl::FileSource> &upstream, std::unordered_map<std::string, Pending> batch)
+        {
+            for (auto &[url, entry] : batch)
+            {
+                upstream->forward(entry.resource, entry.response, {});
+            }
+        }
+    } // namespace
+
+    WriteBehindCacheSource::WriteBehindCacheSource(std::unique_ptr<mbgl::FileSource> upstream_, const Options &options_)
+        : upstream(std::move(upstream_)),
+          options(options_),
+          queue(std::make_shared<Queue>())
+    {
+        flusher = std::thread([this]
+                              { run(); });
+    }
+
+    WriteBehindCacheSource::~WriteBehindCacheSource()
+    {
+        {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            queue->stopping = true;
+        }
+        queue->changed.notify_all();
+        flusher.join();
+
+        write(upstream, std::move(queue->pending));
+    }
+
+    void WriteBehindCacheSource::run()
+    {
+        std::unique_lock<std::mutex> lock(queue->mutex);
+        while (!queue->stopping)
+        {
+            if (queue->pending.empty())
+            {
+                queue->changed.wait(lock);
+                continue;
+            }
+
+            const auto due = std::min(queue->oldest + options.flushInterval, queue->lastRead + QUIET_PERIOD);
+            if (queue->pendingBytes < options.maxPendingBytes && Clock::now() < due)
+            {
+                queue->changed.wait_until(lock, due);
+                continue;
+            }
+
+            auto batch = std::move(queue->pending);
+            queue->pending.clear();
+            queue->pendingBytes = 0;
+            lock.unlock();
+            write(upstream, std::move(batch));
+            lock.lock();
+        }
+    }
+
+    void WriteBehindCacheSource::prepareDatabase(const std::string &path, const Options &options)
+    {
+        std::error_code error;
+        if (path.empty() || !std::filesystem::is_regular_file(path, error))
+        {
+            return;
+        }
+
+        try
+        {
+            auto db = mapbox::sqlite::Database::open(path, mapbox::sqlite::ReadWrite);
+            db.setBusyTimeout(std::chrono::seconds(1));
+            if (queryPragma(db, "PRAGMA user_version") != CACHE_SCHEMA_VERSION)
+            {
+                return;
+            }
+
+            int64_t pageSize = queryPragma(db, "PRAGMA page_size");
+            if (options.pageSize && options.pageSize != pageSize)
+            {
+                // The page size of a WAL database is fixed; VACUUM applies a new one
+                db.exec("PRAGMA journal_mode = DELETE");
+                db.exec("PRAGMA page_size = " + std::to_string(options.pageSize));
+                db.exec("VACUUM");
+                pageSize = queryPragma(db, "PRAGMA page_size");
+            }
+            if (options.cacheSizeKiB && pageSize > 0)
+            {
+                const int64_t pages = std::max<int64_t>(1, static_cast<int64_t>(options.cacheSizeKiB) * 1024 / pageSize);
+                db.exec("PRAGMA default_cache_size = " + std::to_string(pages));
+            }
+            db.exec(options.wal ? "PRAGMA journal_mode = WAL" : "PRAGMA journal_mode = DELETE");
+        }
+        catch (const std::exception &e)
+        {
+            mbgl::Log::Warning(mbgl::Event::Database, "Could not configure cache " + path + ": " + e.what());
+        }
+    }
+
+    std::unique_ptr<mbgl::AsyncRequest> WriteBehindCacheSource::request(const mbgl::Resource &resource, Callback callback)
+    {
+        std::optional<mbgl::Response> queued;
+        {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            queue->lastRead = Clock::now();
+            auto it = queue->pending.find(resource.url);
+            if (it != queue->pending.end() && !it->second.response.notModified)
+            {
+                queued = it->second.response;
+            }
+        }
+        if (!queued)
+        {
+            return upstream->request(resource, std::move(callback));
+        }
+
+        auto task = std::make_shared<Task>();
+        task->callback = std::move(callback);
+        std::weak_ptr<Task> weak = task;
+        auto deliver = [weak, response = std::move(*queued)]
+        {
+            if (auto task = weak.lock())
+            {
+                task->callback(response);
+            }
+        };
+        if (auto *scheduler = mbgl::Scheduler::GetCurrent())
+        {
+            scheduler->schedule(std::move(deliver));
+        }
+        else
+        {
+            deliver();
+        }
+        return std::make_unique<Request>(std::move(task));
+    }
+
+    void WriteBehindCacheSource::forward(const mbgl::Resource &resource, const mbgl::Response &response, std::function<void()> callback)
+    {
+        // Errors aren't cached; let the database decide what to do with them as before
+        if (response.error)
+        {
+            upstream->forward(resource, response, std::move(callback));
+            return;
+        }
+
+        // The database runs completion callbacks on the forwarding thread's RunLoop, which may
+        // be gone by the time a queued write is made, so such forwards are written right away.
+        // They take any queued write of the same resource with them, so it can't overwrite
+        // them later.
+        if (callback)
+        {
+            std::optional<mbgl::Response> merged;
+            {
+                std::lock_guard<std::mutex> lock(queue->mutex);
+                auto it = queue->pending.find(resource.url);
+                if (it != queue->pending.end())
+                {
+                    auto &entry = it->second;
+                    queue->pendingBytes -= sizeOf(entry.resource, entry.response);
+                    if (response.notModified && !entry.response.notModified)
+                    {
+                        merged = std::move(entry.response);
+                        refresh(*merged, response);
+                    }
+                    queue->pending.erase(it);
+                }
+            }
+            upstream->forward(resource, merged ? *merged : response, std::move(callback));
+            return;
+        }
+
+        bool full = false;
+        bool first = false;
+        {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            first = queue->pending.empty();
+            if (first)
+            {
+                queue->oldest = Clock::now();
+            }
+
+            auto it = queue->pending.find(resource.url);
+            const bool inserted = it == queue->pending.end();
+            if (inserted)
+            {
+                it = queue->pending.emplace(resource.url, Queue::Pending{resource, response}).first;
+            }
+            auto &entry = it->second;
+            if (!inserted && response.notModified && !entry.response.notModified)
+            {
+                refresh(entry.response, response);
+            }
+            else
+            {
+                if (!inserted)
+                {
+                    queue->pendingBytes -= sizeOf(entry.resource, entry.response);
+                }
+                entry.resource = resource;
+                entry.response = response;
+                queue->pendingBytes += sizeOf(entry.resource, entry.response);
+            }
+            full = queue->pendingBytes >= options.maxPendingBytes;
+        }
+        if (first || full)
+        {
+            queue->changed.notify_one();
+        }
+    }
+
+    bool WriteBehindCacheSource::canRequest(const mbgl::Resource &resource) const
+    {
+        return upstream->canRequest(resource);
+    }
+
+    bool WriteBehindCacheSource::supportsCacheOnlyRequests() const
+    {
+        return upstream->supportsCacheOnlyRequests();
+    }
+
+    void WriteBehindCacheSource::pause()
+    {
+        upstream->pause();
+    }
+
+    void WriteBehindCacheSource::resume()
+    {
+        upstream->resume();
+    }
+
+    void WriteBehindCacheSource::setProperty(const std::string &key, const mapbox::base::Value &value)
+    {
+        upstream->setProperty(key, value);
+    }
+
+    mapbox::base::Value WriteBehindCacheSource::getProperty(const std::string &key) const
+    {
+        return upstream->getProperty(key);
+    }
+
+    void WriteBehindCacheSource::setResourceTransform(mbgl::ResourceTransform transform)
+    {
+        upstream->setResourceTransform(std::move(transform));
+    }
+
+    void WriteBehindCacheSource::setResourceOptions(mbgl::ResourceOptions options_)
+    {
+        upstream->setResourceOptions(std::move(options_));
+    }
+
+    mbgl::ResourceOptions WriteBehindCacheSource::getResourceOptions()
+    {
+        return upstream->getResourceOptions();
+    }
+
+    void WriteBehindCacheSource::setClientOptions(mbgl::ClientOptions options_)
+    {
+        upstream->setClientOptions(std::move(options_));
+    }
+
+    mbgl::ClientOptions WriteBehindCacheSource::getClientOptions()
+    {
+        return upstream->getClientOptions();
+    }
+
+} // namespace maplibre_jni
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/resource.hpp>
+#include <mbgl/storage/response.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace maplibre_jni
+{
+
+    // FileSource wrapper that defers and coalesces writes to the ambient cache
+    //
+    // The resource loader forwards every network response to the database source, which runs
+    // reads and writes on one thread, so during a pan cache lookups for new tiles wait behind
+    // writes of the tiles just fetched. Forwarded responses are queued here instead, keyed by
+    // URL so a response replaces an older one for the same resource, and a 304 refreshes the
+    // queued body's expiry. The queue is handed to the database in one burst once no reads
+    // have arrived for a short while, once it holds maxPendingBytes, or once its oldest entry
+    // has waited flushInterval. Reads of queued resources are answered from the queue.
+    // Forwards that want a completion callback are written right away.
+    class WriteBehindCacheSource final : public mbgl::FileSource
+    {
+    public:
+        struct Options
+        {
+            // Queue writes; otherwise only the database settings below apply
+            bool writeBehind = true;
+            std::chrono::milliseconds flushInterval{1000};
+            uint64_t maxPendingBytes = 4 * 1024 * 1024;
+            // Journal mode of the cache database: WAL, or SQLite's default rollback journal
+            bool wal = true;
+            // 0 keeps the current page size
+            uint32_t pageSize = 0;
+            // Default page cache size stored in the database; 0 keeps the current one
+            uint32_t cacheSizeKiB = 0;
+
+            bool operator==(const Options &other) const
+            {
+                return writeBehind == other.writeBehind && flushInterval == other.flushInterval &&
+                       maxPendingBytes == other.maxPendingBytes && wal == other.wal && pageSize == other.pageSize &&
+                       cacheSizeKiB == other.cacheSizeKiB;
+            }
+        };
+
+        WriteBehindCacheSource(std::unique_ptr<mbgl::FileSource> upstream, const Options &options);
+        // Writes whatever is still queued
+        ~WriteBehindCacheSource() override;
+
+        // Applies the journal mode, page size and cache size to an existing cache database
+        // before mbgl opens it. mbgl resets the journal mode when it creates or migrates a
+        // cache, so a new cache picks the settings up the next time it is opened. Changing
+        // the page size rewrites the whole file. Failures are logged, never thrown.
+        static void prepareDatabase(const std::string &path, const Options &options);
+
+        std::unique_ptr<mbgl::AsyncRequest> request(const mbgl::Resource &resource, Callback callback) override;
+
+        void forward(const mbgl::Resource &resource, const mbgl::Response &response, std::function<void()> callback) override;
+        bool canRequest(const mbgl::Resource &resource) const override;
+        bool supportsCacheOnlyRequests() const override;
+        void pause() override;
+        void resume() override;
+        void setProperty(const std::string &key, const mapbox::base::Value &value) override;
+        mapbox::base::Value getProperty(const std::string &key) const override;
+        void setResourceTransform(mbgl::ResourceTransform transform) override;
+        void setResourceOptions(mbgl::ResourceOptions options) override;
+        mbgl::ResourceOptions getResourceOptions() override;
+        void setClientOptions(mbgl::ClientOptions options) override;
+        mbgl::ClientOptions getClientOptions() override;
+
+    private:
+        struct Queue;
+        struct Task;
+        class Request;
+
+        void run();
+
+        // Shared with writes posted to other threads
+        std::shared_ptr<mbgl::FileSource> upstream;
+        Options options;
+        std::shared_ptr<Queue> queue;
+        std::thread flusher;
+    };
+
+} // namespace maplibre_jni
@@ -0,0 +1,275 @@
+#include "zip_archive.hpp"
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include <zlib.h>
+
+namespace maplibre_jni
+{
+
+    namespace
+    {
+        constexpr uint32_t END_OF_CENTRAL_DIRECTORY = 0x06054b50;
+        constexpr uint32_t ZIP64_END_OF_CENTRAL_DIRECTORY = 0x06064b50;
+        constexpr uint32_t ZIP64_LOCATOR = 0x07064b50;
+        constexpr uint32_t CENTRAL_DIRECTORY_HEADER = 0x02014b50;
+        constexpr uint32_t LOCAL_FILE_HEADER = 0x04034b50;
+
+        constexpr size_t END_RECORD_SIZE = 22;
+        constexpr size_t ZIP64_LOCATOR_SIZE = 20;
+        constexpr size_t ZIP64_END_RECORD_SIZE = 56;
+        constexpr size_t CENTRAL_HEADER_SIZE = 46;
+        constexpr size_t LOCAL_HEADER_SIZE = 30;
+        constexpr size_t MAX_COMMENT_SIZE = 0xffff;
+
+        constexpr uint16_t METHOD_STORED = 0;
+        constexpr uint16_t METHOD_DEFLATED = 8;
+        constexpr uint16_t FLAG_ENCRYPTED = 0x1;
+        constexpr uint16_t ZIP64_EXTRA_FIELD = 0x0001;
+
+        // ZIP fields are little-endian and unaligned
+        uint16_t read16(const uint8_t *p)
+        {
+            return static_cast<uint16_t>(p[0] | (p[1] << 8));
+        }
+
+        uint32_t read32(const uint8_t *p)
+        {
+            return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                   (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+        }
+
+        uint64_t read64(const uint8_t *p)
+        {
+            return static_cast<uint64_t>(read32(p)) | (static_cast<uint64_t>(read32(p + 4)) << 32);
+        }
+
+        std::mutex archivesMutex;
+        std::unordered_map<std::string, std::weak_ptr<ZipArchive>> archives;
+    } // namespace
+
+    std::shared_ptr<ZipArchive> ZipArchive::open(const std::string &path)
+    {
+        std::lock_guard<std::mutex> lock(archivesMutex);
+        if (auto existing = archives[path].lock())
+        {
+            return existing;
+        }
+
+        auto archive = std::shared_ptr<ZipArchive>(new ZipArchive(path, MappedFile::open(path)));
+        archive->index();
+        archives[path] = archive;
+        return archive;
+    }
+
+    ZipArchive::ZipArchive(std::string path_, std::unique_ptr<MappedFile> file_)
+        : path(std::move(path_)),
+          file(std::move(file_))
+    {
+    }
+
+    void ZipArchive::index()
+    {
+        const uint8_t *data = file->data();
+        const size_t size = file->size();
+        if (size < END_RECORD_SIZE)
+        {
+            throw std::runtime_error(path + " is not a ZIP archive");
+        }
+
+        // The end record sits before a comment of up to 64 KiB
+        const size_t searchStart = size > END_RECORD_SIZE + MAX_COMMENT_SIZE ? size - END_RECORD_SIZE - MAX_COMMENT_SIZE : 0;
+        size_t end = size - END_RECORD_SIZE + 1;
+        do
+        {
+            end--;
+        } while (end > searchStart && read32(data + end) != END_OF_CENTRAL_DIRECTORY);
+        if (read32(data + end) != END_OF_CENTRAL_DIRECTORY)
+        {
+            throw std::runtime_error(path + " is not a ZIP archive");
+        }
+
+        uint64_t count = read16(data + end + 10);
+        uint64_t directorySize = read32(data + end + 12);
+        uint64_t directoryOffset = read32(data + end + 16);
+
+        if (end >= ZIP64_LOCATOR_SIZE && read32(data + end - ZIP64_LOCATOR_SIZE) == ZIP64_LOCATOR)
+        {
+            const uint64_t recordOffset = read64(data + end - ZIP64_LOCATOR_SIZE + 8);
+            if (recordOffset > size || size - recordOffset < ZIP64_END_RECORD_SIZE ||
+                read32(data + recordOffset) != ZIP64_END_OF_CENTRAL_DIRECTORY)
+            {
+                throw std::runtime_error(path + " has a corrupt ZIP64 end record");
+            }
+            count = read64(data + recordOffset + 32);
+            directorySize = read64(data + recordOffset + 40);
+            directoryOffset = read64(data + recordOffset + 48);
+        }
+
+        if (directoryOffset > size || directorySize > size - directoryOffset)
+        {
+            throw std::runtime_error(path + " has a truncated central directory");
+        }
+
+        // Each entry takes at least a header, which bounds a count read from the archive
+        entries.reserve(static_cast<size_t>(std::min<uint64_t>(count, directorySize / CENTRAL_HEADER_SIZE)));
+        const uint8_t *header = data + directoryOffset;
+        const uint8_t *directoryEnd = header + directorySize;
+        for (uint64_t i = 0; i < count; i++)
+        {
+            if (header + CENTRAL_HEADER_SIZE > directoryEnd || read32(header) != CENTRAL_DIRECTORY_HEADER)
+            {
+                throw std::runtime_error(path + " has a corrupt central directory");
+            }
+
+            const uint16_t flags = read16(header + 8);
+            const uint16_t method = read16(header + 10);
+            const uint16_t nameLength = read16(header + 28);
+            const uint16_t extraLength = read16(header + 30);
+            const uint16_t commentLength = read16(header + 32);
+            const uint8_t *name = header + CENTRAL_HEADER_SIZE;
+            const uint8_t *extra = name + nameLength;
+            const uint8_t *next = extra + extraLength + commentLength;
+            if (next > directoryEnd)
+            {
+                throw std::runtime_error(path + " has a corrupt central directory");
+            }
+
+            Entry entry;
+            entry.compressedSize = read32(header + 20);
+            entry.size = read32(header + 24);
+            entry.headerOffset = read32(header + 42);
+            entry.deflated = method == METHOD_DEFLATED;
+
+            // Sizes and offsets that don't fit 32 bits are in the ZIP64 extra field, in this order
+            if (entry.size == 0xffffffff || entry.compressedSize == 0xffffffff || entry.headerOffset == 0xffffffff)
+            {
+                for (const uint8_t *field = extra; field + 4 <= extra + extraLength;)
+                {
+                    const uint16_t id = read16(field);
+                    const uint16_t length = read16(field + 2);
+                    const uint8_t *value = field + 4;
+                    const uint8_t *valueEnd = std::min(value + length, extra + extraLength);
+                    if (id == ZIP64_EXTRA_FIELD)
+                    {
+                        for (uint64_t *target : {&entry.size, &entry.compressedSize, &entry.headerOffset})
+                        {
+                            if (*target == 0xffffffff && value + 8 <= valueEnd)
+                            {
+                                *target = read64(value);
+                                value += 8;
+                            }
+                        }
+                        break;
+                    }
+                    field = value + length;
+                }
+            }
+
+            // Stored entries are read as size bytes of data checked to be compressedSize long
+            const bool readable = !(flags & FLAG_ENCRYPTED) &&
+                                  ((method == METHOD_STORED && entry.size == entry.compressedSize) || method == METHOD_DEFLATED);
+            if (readable && nameLength > 0 && name[nameLength - 1] != '/')
+            {
+                // Later duplicates of a name replace earlier ones
+                entries[std::string_view(reinterpret_cast<const char *>(name), nameLength)] = entry;
+            }
+            header = next;
+        }
+    }
+
+    std::optional<ZipArchive::Entry> ZipArchive::find(std::string_view name) const
+    {
+        auto it = entries.find(name);
+        if (it == entries.end())
+        {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    const uint8_t *ZipArchive::storedData(const Entry &entry) const
+    {
+        const uint8_t *data = file->data();
+        const uint64_t size = file->size();
+        // Offsets come from the archive, so every bound is checked by subtraction, which can't wrap
+        if (entry.headerOffset > size || size - entry.headerOffset < LOCAL_HEADER_SIZE ||
+            read32(data + entry.headerOffset) != LOCAL_FILE_HEADER)
+        {
+            return nullptr;
+        }
+
+        // The local header's name and extra field can differ in length from the central copy;
+        // with the header in the file, adding their 16-bit lengths stays far below 2^64
+        const uint8_t *header = data + entry.headerOffset;
+        const uint64_t start = entry.headerOffset + LOCAL_HEADER_SIZE + read16(header + 26) + read16(header + 28);
+        if (start > size || entry.compressedSize > size - start)
+        {
+            return nullptr;
+        }
+        return data + start;
+    }
+
+    std::string ZipArchive::read(const Entry &entry) const
+    {
+        const uint8_t *stored = storedData(entry);
+        if (!stored || (!entry.deflated && entry.size != entry.compressedSize))
+        {
+            throw std::runtime_error("Corrupt entry in " + path);
+        }
+
+        if (!entry.deflated)
+        {
+            return std::string(reinterpret_cast<const char *>(stored), static_cast<size_t>(entry.size));
+        }
+
+        std::string result(static_cast<size_t>(entry.size), '\0');
+        if (entry.size == 0)
+        {
+            return result;
+        }
+
+        z_stream stream{};
+        // Negative window bits: raw deflate data without a zlib header
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+        {
+            throw std::runtime_error("Could not initialize inflate");
+        }
+
+        // zlib counts in 32 bits, so large entries are fed in chunks
+        constexpr uint64_t CHUNK = 1u << 30;
+        uint64_t inputLeft = entry.compressedSize;
+        uint64_t outputLeft = entry.size;
+        stream.next_in = const_cast<Bytef *>(stored);
+        stream.next_out = reinterpret_cast<Bytef *>(result.data());
+        int status = Z_OK;
+        while (status == Z_OK)
+        {
+            if (stream.avail_in == 0)
+            {
+                stream.avail_in = static_cast<uInt>(std::min(inputLeft, CHUNK));
+                inputLeft -= stream.avail_in;
+            }
+            if (stream.avail_out == 0)
+            {
+                stream.avail_out = static_cast<uInt>(std::min(outputLeft, CHUNK));
+                outputLeft -= stream.avail_out;
+            }
+            status = inflate(&stream, Z_NO_FLUSH);
+            if (status == Z_BUF_ERROR && stream.avail_in == 0 && inputLeft == 0)
+            {
+                break;
+            }
+        }
+        const uint64_t produced = entry.size - outputLeft - stream.avail_out;
+        inflateEnd(&stream);
+
+        if (status != Z_STREAM_END || produced != entry.size)
+        {
+            throw std::runtime_error("Corrupt deflated entry in " + path);
+        }
+        return result;
+    }
+
+} // namespace maplibre_jni
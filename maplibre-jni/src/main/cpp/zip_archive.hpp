@@ -0,0 +1,61 @@
+#pragma once
+
+#include "mapped_file.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace maplibre_jni
+{
+
+    // Read-only view of a ZIP or JAR file through a memory mapping
+    //
+    // Opening parses the central directory in place into a name index, so finding an entry
+    // is a hash lookup and reading a stored entry is a copy out of the mapping. ZIP64 archives
+    // are supported; encrypted entries and compression methods other than deflate are not.
+    class ZipArchive
+    {
+    public:
+        struct Entry
+        {
+            // Offset of the local file header
+            uint64_t headerOffset = 0;
+            uint64_t compressedSize = 0;
+            uint64_t size = 0;
+            bool deflated = false;
+        };
+
+        // Archive at path, shared with every other live opener of the same path. Throws
+        // std::runtime_error if the file can't be mapped or isn't a ZIP archive.
+        static std::shared_ptr<ZipArchive> open(const std::string &path);
+
+        ZipArchive(const ZipArchive &) = delete;
+        ZipArchive &operator=(const ZipArchive &) = delete;
+
+        std::optional<Entry> find(std::string_view name) const;
+
+        // The entry's bytes as stored in the archive, or nullptr if its header is corrupt
+        const uint8_t *storedData(const Entry &entry) const;
+
+        // The entry's contents; deflated entries are decompressed. Throws std::runtime_error if
+        // the entry is corrupt.
+        std::string read(const Entry &entry) const;
+
+        const std::string &getPath() const { return path; }
+
+    private:
+        ZipArchive(std::string path, std::unique_ptr<MappedFile> file);
+
+        void index();
+
+        std::string path;
+        std::unique_ptr<MappedFile> file;
+        // Names point into the mapping
+        std::unordered_map<std::string_view, Entry> entries;
+    };
+
+} // namespace maplibre_jni
@@ -0,0 +1,40 @@
+package org.maplibre.kmp.native
+
+/**
+ * How the ambient cache database at [ResourceOptions.cachePath] is written.
+ *
+ * With write-behind, responses headed for the cache are queued and written together once the
+ * map stops loading for a moment, so cache writes no longer compete with the cache reads of a
+ * pan or zoom. Repeated responses for the same resource are written once, and queued
+ * responses are served from the queue. The queue is written out when it reaches
+ * [maxPendingBytes], after [flushIntervalMs] at the latest, and when the map is released.
+ *
+ * The database settings are applied when an existing cache is opened. A cache created during
+ * this run picks them up from the next start, since MapLibre sets up new caches its own way.
+ *
+ * @property writeBehind Queue cache writes as described above
+ * @property flushIntervalMs Longest time a response waits in the queue
+ * @property maxPendingBytes Queued response bytes that trigger an immediate write
+ * @property walMode Use SQLite's write-ahead log, which makes each write an append. SQLite can't
+ *   use it on network file systems; turn it off for caches stored on one.
+ * @property pageSize SQLite page size in bytes, a power of two from 512 to 65536; 0 keeps the
+ *   current one. Changing it rewrites the whole cache once.
+ * @property cacheSizeKb Page cache size SQLite uses for the database, in KiB; 0 keeps the default
+ */
+data class AmbientCacheOptions(
+    val writeBehind: Boolean = true,
+    val flushIntervalMs: Long = 1000,
+    val maxPendingBytes: Long = 4 * 1024 * 1024,
+    val walMode: Boolean = true,
+    val pageSize: Int = 0,
+    val cacheSizeKb: Int = 0
+) {
+    init {
+        require(flushIntervalMs >= 0) { "flushIntervalMs must not be negative" }
+        require(maxPendingBytes >= 0) { "maxPendingBytes must not be negative" }
+        require(pageSize == 0 || (pageSize in 512..65536 && pageSize and (pageSize - 1) == 0)) {
+            "pageSize must be 0 or a power of two from 512 to 65536"
+        }
+        require(cacheSizeKb >= 0) { "cacheSizeKb must not be negative" }
+    }
+}
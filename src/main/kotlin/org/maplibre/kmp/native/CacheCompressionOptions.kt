@@ -0,0 +1,70 @@
+package org.maplibre.kmp.native
+
+/**
+ * Compression of the bodies stored in the ambient cache at [ResourceOptions.cachePath].
+ *
+ * Responses are compressed with zstd on a worker thread before they are stored, and
+ * decompressed on a worker thread when the map reads them back, so neither blocks the map.
+ * Tiles, glyphs and sprite indexes are compressed, vector tiles most effectively with a
+ * [Dictionary] trained on tiles of the same source; images, styles and TileJSON are stored as
+ * they are, so offline downloads can still read them. Entries stored before compression was
+ * turned on, and those of offline downloads, stay readable. Maps sharing the cache file
+ * without these options read compressed entries too; an entry whose dictionary isn't
+ * configured for the reading map counts as missing and is fetched again.
+ *
+ * Requires a native library built with `MAPLIBRE_JNI_WITH_ZSTD`; check [isSupported]. Other
+ * builds log a warning, store entries uncompressed, and treat compressed entries left by
+ * another build as missing.
+ *
+ * @property level zstd compression level, 1 (fastest) to 19 (smallest)
+ * @property dictionaries Dictionaries by URL prefix; the longest matching prefix applies
+ */
+data class CacheCompressionOptions(
+    val level: Int = 3,
+    val dictionaries: List<Dictionary> = emptyList()
+) {
+    init {
+        require(level in 1..19) { "level must be between 1 and 19" }
+    }
+
+    /**
+     * Dictionary for the resources whose URL starts with [urlPrefix], e.g. the tile URL of one
+     * source without the `{z}/{x}/{y}` part, stored in the file at [path]. See [trainDictionary].
+     */
+    data class Dictionary(
+        val urlPrefix: String,
+        val path: String
+    )
+
+    companion object {
+
+        /**
+         * Whether this build of the native library can compress the ambient cache.
+         */
+        val isSupported: Boolean by lazy {
+            MapLibreNativeLoader.load()
+            nativeIsSupported()
+        }
+
+        /**
+         * Trains a dictionary of at most [maxSize] bytes on [samples] of one source, e.g. a
+         * few hundred of its tiles as served. Save the result to a file and name it in a
+         * [Dictionary]; keep the file unchanged while the cache holds entries compressed with it.
+         *
+         * @throws UnsupportedOperationException if [isSupported] is false
+         * @throws RuntimeException if there are too few samples to train on
+         */
+        @JvmStatic
+        fun trainDictionary(samples: List<ByteArray>, maxSize: Int = 112640): ByteArray {
+            require(maxSize > 0) { "maxSize must be positive" }
+            MapLibreNativeLoader.load()
+            return nativeTrainDictionary(samples.toTypedArray(), maxSize)
+        }
+
+        @JvmStatic
+        private external fun nativeIsSupported(): Boolean
+
+        @JvmStatic
+        private external fun nativeTrainDictionary(samples: Array<ByteArray>, capacity: Int): ByteArray
+    }
+}
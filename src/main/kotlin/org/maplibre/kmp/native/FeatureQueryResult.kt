@@ -0,0 +1,150 @@
+package org.maplibre.kmp.native
+
+import java.nio.ByteBuffer
+
+/**
+ * Read-only view over the compact binary result of a feature query.
+ * Fields are decoded on access, so hit-testing code that only needs ids or
+ * geometry types never materializes property maps.
+ *
+ * The result is backed by a buffer owned by the map and is only valid until the next query.
+ */
+class FeatureQueryResult internal constructor(private val buffer: ByteBuffer) {
+
+    /** Number of features in the result. */
+    val size: Int = buffer.getInt(0)
+
+    val isEmpty: Boolean get() = size == 0
+
+    private val sourceCount: Int = buffer.getInt(4)
+    private val sourceTableOffset: Int = buffer.getInt(8)
+
+    /**
+     * Returns the feature id, or null if the feature has none.
+     * @return A [Long] for integer ids, [ULong] for unsigned ids, [Double] or [String]
+     */
+    fun id(index: Int): Any? {
+        val record = recordOffset(index)
+        val bits = buffer.getLong(record)
+        return when (buffer.get(record + 18).toInt()) {
+            ID_UINT -> bits.toULong()
+            ID_INT -> bits
+            ID_DOUBLE -> Double.fromBits(bits)
+            ID_STRING -> readString(bits.toInt())
+            else -> null
+        }
+    }
+
+    /** Returns the geometry type of the feature. */
+    fun geometryType(index: Int): GeometryType {
+        return GeometryType.fromNative(buffer.get(recordOffset(index) + 19).toInt())
+    }
+
+    /**
+     * Returns the index of the feature's (source, sourceLayer) pair.
+     * Features from the same source layer share an index, so it can be used as a cheap grouping key.
+     */
+    fun sourceIndex(index: Int): Int {
+        return buffer.getShort(recordOffset(index) + 16).toInt() and 0xFFFF
+    }
+
+    /** Returns the id of the source the feature belongs to. */
+    fun source(index: Int): String = sourceEntry(sourceIndex(index)).first
+
+    /** Returns the source layer the feature belongs to (empty for GeoJSON sources). */
+    fun sourceLayer(index: Int): String = sourceEntry(sourceIndex(index)).second
+
+    /** Returns the number of properties of the feature without decoding them. */
+    fun propertyCount(index: Int): Int = buffer.getInt(recordOffset(index) + 12)
+
+    /**
+     * Decodes the properties of the feature.
+     * Values are [Boolean], [Long], [ULong], [Double], [String], [List], [Map] or null.
+     */
+    fun properties(index: Int): Map<String, Any?> {
+        val record = recordOffset(index)
+        val cursor = Cursor(buffer.getInt(record + 8))
+        val count = buffer.getInt(record + 12)
+        val result = LinkedHashMap<String, Any?>(count * 2)
+        repeat(count) {
+            val key = cursor.readString()
+            result[key] = cursor.readValue()
+        }
+        return result
+    }
+
+    private fun recordOffset(index: Int): Int {
+        if (index !in 0 until size) {
+            throw IndexOutOfBoundsException("Feature index $index out of bounds for size $size")
+        }
+        return HEADER_SIZE + index * FEATURE_RECORD_SIZE
+    }
+
+    private val sourceTable: List<Pair<String, String>> by lazy {
+        val cursor = Cursor(sourceTableOffset)
+        List(sourceCount) { cursor.readString() to cursor.readString() }
+    }
+
+    private fun sourceEntry(sourceIndex: Int): Pair<String, String> = sourceTable[sourceIndex]
+
+    private fun readString(offset: Int): String = Cursor(offset).readString()
+
+    private inner class Cursor(var position: Int) {
+        fun readString(): String {
+            val length = buffer.getInt(position)
+            val bytes = ByteArray(length)
+            buffer.get(position + 4, bytes)
+            position += 4 + length
+            return String(bytes, Charsets.UTF_8)
+        }
+
+        fun readValue(): Any? {
+            val tag = buffer.get(position).toInt()
+            position += 1
+            return when (tag) {
+                VALUE_NULL -> null
+                VALUE_BOOL -> (buffer.get(position) != 0.toByte()).also { position += 1 }
+                VALUE_UINT -> buffer.getLong(position).toULong().also { position += 8 }
+                VALUE_INT -> buffer.getLong(position).also { position += 8 }
+                VALUE_DOUBLE -> buffer.getDouble(position).also { position += 8 }
+                VALUE_STRING -> readString()
+                VALUE_ARRAY -> {
+                    val count = buffer.getInt(position)
+                    position += 4
+                    List(count) { readValue() }
+                }
+                VALUE_OBJECT -> {
+                    val count = buffer.getInt(position)
+                    position += 4
+                    val map = LinkedHashMap<String, Any?>(count * 2)
+                    repeat(count) {
+                        val key = readString()
+                        map[key] = readValue()
+                    }
+                    map
+                }
+                else -> throw IllegalStateException("Unknown value tag: $tag")
+            }
+        }
+    }
+
+    private companion object {
+        // Must match FeatureEncoder in feature_encoder.hpp
+        const val HEADER_SIZE = 16
+        const val FEATURE_RECORD_SIZE = 24
+
+        const val ID_UINT = 1
+        const val ID_INT = 2
+        const val ID_DOUBLE = 3
+        const val ID_STRING = 4
+
+        const val VALUE_NULL = 0
+        const val VALUE_BOOL = 1
+        const val VALUE_UINT = 2
+        const val VALUE_INT = 3
+        const val VALUE_DOUBLE = 4
+        const val VALUE_STRING = 5
+        const val VALUE_ARRAY = 6
+        const val VALUE_OBJECT = 7
+    }
+}
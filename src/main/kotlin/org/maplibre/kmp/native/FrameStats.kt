@@ -0,0 +1,20 @@
+package org.maplibre.kmp.native
+
+/**
+ * Frame timing reported by [MaplibreMap.getFrameStats].
+ * Frame times cover rendering and presenting a frame on the calling thread.
+ */
+data class FrameStats(
+    val renderedFrames: Long,
+    /** Ticks where a frame showing only new tiles or a fade was postponed by the frame budget */
+    val deferredFrames: Long,
+    /** Rendered frames that drew tiles or fades postponed on earlier ticks */
+    val batchedFrames: Long,
+    val overBudgetFrames: Long,
+    val lastFrameTimeMs: Double,
+    val averageFrameTimeMs: Double,
+    /** Average time of the batched frames, to compare against [averageFrameTimeMs] */
+    val averageBatchedFrameTimeMs: Double,
+    /** Whether recent frames are over budget, which also pauses tile prefetching */
+    val isOverBudget: Boolean
+)
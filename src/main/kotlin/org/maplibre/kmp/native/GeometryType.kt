@@ -0,0 +1,19 @@
+package org.maplibre.kmp.native
+
+enum class GeometryType(val nativeValue: Int) {
+    EMPTY(0),
+    POINT(1),
+    LINE_STRING(2),
+    POLYGON(3),
+    MULTI_POINT(4),
+    MULTI_LINE_STRING(5),
+    MULTI_POLYGON(6),
+    GEOMETRY_COLLECTION(7);
+
+    companion object {
+        fun fromNative(value: Int): GeometryType {
+            return values().find { it.nativeValue == value }
+                ?: throw IllegalArgumentException("Unknown GeometryType value: $value")
+        }
+    }
+}
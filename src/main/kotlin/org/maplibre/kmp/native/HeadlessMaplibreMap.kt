@@ -0,0 +1,158 @@
+package org.maplibre.kmp.native
+
+import java.nio.ByteBuffer
+
+/**
+ * A map rendered offscreen without a Canvas, for batch rendering workers.
+ * Rendering uses the Vulkan backend (e.g. lavapipe on machines without a GPU);
+ * check [isSupported] before constructing one on other builds.
+ *
+ * All methods must be called from the thread that created the map.
+ */
+class HeadlessMaplibreMap(
+    private val mapObserver: MapObserver,  // Keep reference to prevent GC
+    private val mapOptions: MapOptions,
+    private val resourceOptions: ResourceOptions,
+    private val clientOptions: ClientOptions,
+) : NativeObject(
+  new = {
+    nativeNew(
+      width = (mapOptions.size.width * mapOptions.pixelRatio).toInt(),
+      height = (mapOptions.size.height * mapOptions.pixelRatio).toInt(),
+      pixelRatio = mapOptions.pixelRatio,
+      mapObserver = mapObserver,
+      mapOptions = mapOptions,
+      resourceOptions = resourceOptions,
+      clientOptions = clientOptions
+    )
+  },
+  destroy = ::nativeDestroy
+) {
+
+    /**
+     * Process events and render if needed.
+     * Every rendered frame is queued for readback without waiting for the GPU.
+     * @return true if a frame was rendered, false if there was nothing to render
+     */
+    fun tick(): Boolean {
+        return nativeTick(nativePtr)
+    }
+
+    /**
+     * Loads a style from the given URL.
+     * @param url The URL of the style to load (can be a local file:// URL)
+     */
+    fun loadStyleURL(url: String) {
+        nativeLoadStyleURL(nativePtr, url)
+    }
+
+    /**
+     * Loads a style from a JSON string.
+     * @param json The style JSON as a string
+     */
+    fun loadStyleJSON(json: String) {
+        nativeLoadStyleJSON(nativePtr, json)
+    }
+
+    /**
+     * Updates the camera position.
+     * @param options The camera options to apply
+     */
+    fun jumpTo(options: CameraOptions) {
+        nativeJumpTo(nativePtr, options)
+    }
+
+    /**
+     * Sets the size of the offscreen target.
+     * @param size The new size in pixels
+     */
+    fun setSize(size: Size) {
+        nativeSetSize(nativePtr, size)
+    }
+
+    /**
+     * Copies the most recently rendered frame into a direct buffer.
+     * Pixels are tightly packed premultiplied RGBA, top row first.
+     * @param buffer A direct ByteBuffer to receive the pixels
+     * @return The size of the frame in bytes; nothing is copied if it exceeds the buffer's
+     *         capacity, and 0 is returned if no frame has been rendered yet
+     */
+    fun readPixels(buffer: ByteBuffer): Int {
+        return nativeReadPixels(nativePtr, buffer)
+    }
+
+    /**
+     * Takes the oldest frame that has finished copying, without blocking.
+     * While frames are held, the GPU keeps rendering into the remaining slots; frames that
+     * find no free slot are dropped and counted in [RenderedFrame.droppedFrames].
+     * Call [releaseFrame] once the pixels have been consumed.
+     * @return The frame, or null if none is ready
+     */
+    fun acquireFrame(): RenderedFrame? {
+        val info = LongArray(RenderedFrame.INFO_SIZE)
+        return RenderedFrame.fromNative(nativeAcquireFrame(nativePtr, info), info, this)
+    }
+
+    /**
+     * Returns a frame's buffer to the readback ring; its pixels can't be used afterwards.
+     * Releasing a frame again has no effect.
+     */
+    fun releaseFrame(frame: RenderedFrame) {
+        require(frame.owner === this) { "Frame was acquired from another map" }
+        if (frame.markReleased()) {
+            nativeReleaseFrame(nativePtr, frame.slot, frame.number)
+        }
+    }
+
+    companion object {
+
+        /**
+         * Whether this build of the native library can render headless maps.
+         */
+        val isSupported: Boolean by lazy {
+            MapLibreNativeLoader.load()
+            nativeIsSupported()
+        }
+
+        @JvmStatic
+        private external fun nativeIsSupported(): Boolean
+
+        @JvmStatic
+        private external fun nativeNew(
+            width: Int,
+            height: Int,
+            pixelRatio: Float,
+            mapObserver: MapObserver,
+            mapOptions: MapOptions,
+            resourceOptions: ResourceOptions,
+            clientOptions: ClientOptions
+        ): Long
+
+        @JvmStatic
+        private external fun nativeDestroy(ptr: Long)
+
+        @JvmStatic
+        private external fun nativeTick(ptr: Long): Boolean
+
+        @JvmStatic
+        private external fun nativeLoadStyleURL(ptr: Long, url: String)
+
+        @JvmStatic
+        private external fun nativeLoadStyleJSON(ptr: Long, json: String)
+
+        @JvmStatic
+        private external fun nativeJumpTo(ptr: Long, cameraOptions: CameraOptions)
+
+        @JvmStatic
+        private external fun nativeSetSize(ptr: Long, size: Size)
+
+        @JvmStatic
+        private external fun nativeReadPixels(ptr: Long, buffer: ByteBuffer): Int
+
+        @JvmStatic
+        private external fun nativeAcquireFrame(ptr: Long, info: LongArray): ByteBuffer?
+
+        @JvmStatic
+        private external fun nativeReleaseFrame(ptr: Long, slot: Int, number: Long)
+    }
+}
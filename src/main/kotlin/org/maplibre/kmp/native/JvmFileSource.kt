@@ -0,0 +1,177 @@
+package org.maplibre.kmp.native
+
+import java.lang.ref.WeakReference
+import java.nio.ByteBuffer
+
+/**
+ * A network file source implemented on the JVM, for fetching through your own HTTP stack.
+ * Pass it in [ResourceOptions.fileSource]; maps using those options send every network request
+ * to the [Handler] instead of the built-in HTTP client. Local files, assets and the ambient
+ * cache are still served natively, and requests still pass through the shared priority queue.
+ *
+ * Requests are delivered in batches on a dedicated thread: everything a map asks for during
+ * one run loop turn arrives in a single [Handler.onRequests] call. Answer each request once,
+ * from any thread, with [complete] or [fail]. Requests the map no longer needs are reported
+ * through [Handler.onCancelled]; answering them afterwards is harmless.
+ *
+ * Tile server URLs (such as `maptiler://`) are resolved before the handler sees them. The
+ * handler is responsible for retries and for honouring the prior ETag and modification date.
+ */
+class JvmFileSource private constructor(
+    private val upcalls: Upcalls,
+) : NativeObject(
+    new = { nativeNew(upcalls) },
+    destroy = ::nativeDestroy
+) {
+
+    constructor(handler: Handler) : this(Upcalls(handler))
+
+    init {
+        upcalls.source = WeakReference(this)
+    }
+
+    /**
+     * A resource requested by a map.
+     * @property priorEtag ETag of the cached copy, for a conditional request
+     * @property priorModified Modification date of the cached copy in seconds since the epoch, or 0
+     */
+    data class Request(
+        val id: Long,
+        val url: String,
+        val kind: ResourceKind,
+        val priorEtag: String?,
+        val priorModified: Long,
+    )
+
+    interface Handler {
+        /**
+         * Called on the source's dispatch thread with the requests made since the last call.
+         * Must not block; start the requests and answer them later.
+         */
+        fun onRequests(source: JvmFileSource, requests: List<Request>)
+
+        /**
+         * Called on the dispatch thread with requests the maps no longer need.
+         */
+        fun onCancelled(source: JvmFileSource, ids: LongArray) {}
+    }
+
+    /**
+     * Why a request failed, in the terms the map understands.
+     */
+    enum class ErrorReason(val nativeValue: Int) {
+        NOT_FOUND(2),
+        SERVER(3),
+        CONNECTION(4),
+        RATE_LIMIT(5),
+        OTHER(6),
+    }
+
+    /**
+     * Allocates native memory for a response body, to be filled and passed to [complete].
+     * A body written here becomes the map's response without being copied. The buffer must
+     * not be used once the request has been answered, once [Handler.onCancelled] has returned
+     * for it, or after the source is released.
+     * @return The buffer, or null if the request is no longer outstanding
+     */
+    fun allocateBody(id: Long, size: Int): ByteBuffer? {
+        require(size >= 0) { "size must be non-negative" }
+        return nativeAllocateBody(nativePtr, id, size)
+    }
+
+    /**
+     * Answers a request successfully.
+     * @param body A direct buffer holding the body between its position and limit. Buffers from
+     *        [allocateBody] are adopted; any other direct buffer is copied once. Null means the
+     *        resource has no content, unless [notModified] is set.
+     * @param etag ETag to store with the cached copy
+     * @param modified Modification date in seconds since the epoch, or 0
+     * @param expires Expiry date in seconds since the epoch, or 0
+     * @param mustRevalidate Whether the cached copy must be revalidated before use once expired
+     * @param notModified Whether the cached copy is still current, for a conditional request
+     */
+    fun complete(
+        id: Long,
+        body: ByteBuffer?,
+        etag: String? = null,
+        modified: Long = 0,
+        expires: Long = 0,
+        mustRevalidate: Boolean = false,
+        notModified: Boolean = false,
+    ) {
+        require(body == null || body.isDirect) { "body must be a direct ByteBuffer" }
+        nativeComplete(
+            nativePtr, id, body, body?.position() ?: 0, body?.remaining() ?: 0,
+            etag, modified, expires, mustRevalidate, notModified
+        )
+    }
+
+    /**
+     * Answers a request with an error.
+     * @param retryAfter When the map may try again, in seconds since the epoch, or 0
+     */
+    fun fail(id: Long, reason: ErrorReason, message: String = "", retryAfter: Long = 0) {
+        nativeFail(nativePtr, id, reason.nativeValue, message, retryAfter)
+    }
+
+    /**
+     * Abandons a request on the JVM side, e.g. when the HTTP client cancelled it.
+     * The map sees a connection error.
+     */
+    fun cancel(id: Long) {
+        fail(id, ErrorReason.CONNECTION, "Request cancelled")
+    }
+
+    // Called from native code; holds the source weakly so it can still be collected
+    private class Upcalls(private val handler: Handler) {
+        @Volatile
+        var source: WeakReference<JvmFileSource>? = null
+
+        fun onRequests(
+            ids: LongArray,
+            urls: Array<String>,
+            kinds: IntArray,
+            priorEtags: Array<String?>,
+            priorModified: LongArray,
+        ) {
+            val target = source?.get() ?: return
+            val requests = List(ids.size) { i ->
+                Request(ids[i], urls[i], ResourceKind.fromNative(kinds[i]), priorEtags[i], priorModified[i])
+            }
+            handler.onRequests(target, requests)
+        }
+
+        fun onCancelled(ids: LongArray) {
+            val target = source?.get() ?: return
+            handler.onCancelled(target, ids)
+        }
+    }
+
+    companion object {
+        @JvmStatic
+        private external fun nativeNew(upcalls: Any): Long
+
+        @JvmStatic
+        private external fun nativeDestroy(ptr: Long)
+
+        @JvmStatic
+        private external fun nativeAllocateBody(ptr: Long, id: Long, size: Int): ByteBuffer?
+
+        @JvmStatic
+        private external fun nativeComplete(
+            ptr: Long,
+            id: Long,
+            body: ByteBuffer?,
+            offset: Int,
+            length: Int,
+            etag: String?,
+            modified: Long,
+            expires: Long,
+            mustRevalidate: Boolean,
+            notModified: Boolean
+        )
+
+        @JvmStatic
+        private external fun nativeFail(ptr: Long, id: Long, reason: Int, message: String, retryAfter: Long)
+    }
+}
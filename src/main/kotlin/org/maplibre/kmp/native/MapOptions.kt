@@ -11,7 +11,11 @@ data class MapOptions(
     val crossSourceCollisions: Boolean = true,
     val northOrientation: NorthOrientation = NorthOrientation.UPWARDS,
     val size: Size = Size(64, 64),
-    val pixelRatio: Float = 1.0f
+    val pixelRatio: Float = 1.0f,
+    // Null keeps MapLibre's default tile worker pool
+    val workerPool: WorkerPoolOptions? = null,
+    // Null keeps MapLibre's default tile level of detail
+    val tileLod: TileLodOptions? = null
 ) {
     init {
         require(pixelRatio > 0) { "pixelRatio must be positive" }
@@ -0,0 +1,63 @@
+package org.maplibre.kmp.native
+
+import javax.swing.Timer
+
+/**
+ * Renders a group of maps in one pass per frame from a single Swing timer.
+ *
+ * All maps on a thread already share one native run loop. Maps created with a host on the same
+ * thread also share one OpenGL context on EGL, each drawing to its own canvas surface; maps
+ * created on other threads get a context of their own. Those surfaces present without waiting
+ * for vsync, so the host's timer alone paces the pass and no map waits behind another's swap.
+ * Without a compositor, frames may tear. Sharing the context saves contexts and context
+ * switches, not GPU memory: each map keeps its own renderer, shader programs and buffers.
+ * Other backends keep a context per map but still render in the shared pass.
+ *
+ * Call [tick], or [start] the host's timer, from the event dispatch thread.
+ */
+class MapRenderHost(private val frameRate: Int = 60) {
+
+  private val maps = mutableListOf<MaplibreMap>()
+  private var renderTimer: Timer? = null
+
+  /**
+   * Adds a map to the render pass. Maps constructed with this host are added automatically.
+   */
+  fun add(map: MaplibreMap) {
+    if (map !in maps) {
+      maps.add(map)
+    }
+  }
+
+  /**
+   * Removes a map from the render pass, e.g. before its canvas is disposed.
+   */
+  fun remove(map: MaplibreMap) {
+    maps.remove(map)
+  }
+
+  /**
+   * Ticks every map once.
+   * @return The number of maps that rendered a frame
+   */
+  fun tick(): Int {
+    return maps.count { it.tick() }
+  }
+
+  /**
+   * Starts ticking all maps at the host's frame rate.
+   */
+  fun start() {
+    if (renderTimer != null) return
+    renderTimer = Timer(1000 / frameRate) {
+      tick()
+    }.apply {
+      start()
+    }
+  }
+
+  fun stop() {
+    renderTimer?.stop()
+    renderTimer = null
+  }
+}
@@ -17,7 +17,9 @@ class MaplibreCanvas(
   private val resourceOptions: ResourceOptions,
   private val clientOptions: ClientOptions,
   private val frameRate: Int = 60,
-  private val onMapReady: ((MaplibreMap, MaplibreCanvas) -> Unit) = { _, _ -> }
+  private val onMapReady: ((MaplibreMap, MaplibreCanvas) -> Unit) = { _, _ -> },
+  // When set, the host renders the map and this canvas runs no timer of its own
+  private val renderHost: MapRenderHost? = null
 ) : Canvas() {
 
   private var map: MaplibreMap? = null
@@ -26,20 +28,9 @@ class MaplibreCanvas(
   init {
     addComponentListener(object : ComponentAdapter() {
       override fun componentResized(e: ComponentEvent) {
-        if (width > 0 && height > 0) {
-          if (map == null) {
-            initializeMap()
-          } else {
-            // Update map size on resize
-            val pixelRatio = graphicsConfiguration?.defaultTransform?.scaleX?.toFloat() ?: 1.0f
-            val newSize = Size(
-              width = (width * pixelRatio).toInt(),
-              height = (height * pixelRatio).toInt()
-            )
-            map?.setSize(newSize)
-            // Force repaint
-            repaint()
-          }
+        // Later resizes are handled by MaplibreMap's own listener
+        if (width > 0 && height > 0 && map == null) {
+          initializeMap()
         }
       }
     })
@@ -64,10 +55,13 @@ class MaplibreCanvas(
         mapObserver = mapObserver,
         mapOptions = adjustedMapOptions,
         resourceOptions = resourceOptions,
-        clientOptions = clientOptions
+        clientOptions = clientOptions,
+        renderHost = renderHost
       ).also { this.map = it }
 
-      startRenderLoop()
+      if (renderHost == null) {
+        startRenderLoop()
+      }
 
       onMapReady(map, this)
     } catch (e: Exception) {
@@ -87,6 +81,7 @@ class MaplibreCanvas(
   fun dispose() {
     renderTimer?.stop()
     renderTimer = null
+    map?.let { renderHost?.remove(it) }
     map = null
   }
 
@@ -3,10 +3,15 @@ package org.maplibre.kmp.native
 import java.awt.Canvas
 import java.awt.event.ComponentAdapter
 import java.awt.event.ComponentEvent
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
 
 /**
  * The MaplibreMap class manages the map state, style, and camera position.
  * It also manages the renderer lifecycle, creating it internally from the provided Canvas.
+ * When a [MapRenderHost] is given, the map is rendered by the host's render pass and shares
+ * its GPU context with the host's other maps where the backend allows it; its GPU resources
+ * stay its own.
  */
 class MaplibreMap(
     private val canvas: Canvas,  // Keep reference to prevent GC
@@ -14,6 +19,7 @@ class MaplibreMap(
     mapOptions: MapOptions,
     private val resourceOptions: ResourceOptions,
     private val clientOptions: ClientOptions,
+    renderHost: MapRenderHost? = null,
 ) : NativeObject(
   new = {
     val pixelRatio = canvas.graphicsConfiguration?.defaultTransform?.scaleX?.toFloat()
@@ -26,17 +32,23 @@ class MaplibreMap(
       mapObserver = mapObserver,
       mapOptions = mapOptions,
       resourceOptions = resourceOptions,
-      clientOptions = clientOptions
+      clientOptions = clientOptions,
+      sharedContext = renderHost != null
     )
   },
   destroy = ::nativeDestroy
 ) {
 
+  // Reused across feature queries; grown when a result does not fit
+  private var queryBuffer: ByteBuffer = allocateQueryBuffer(INITIAL_QUERY_BUFFER_SIZE)
+
   init {
+    renderHost?.add(this)
     canvas.addComponentListener(object : ComponentAdapter() {
       override fun componentResized(e: ComponentEvent) {
+        if (canvas.width <= 0 || canvas.height <= 0) return
         val scale =
-          canvas.graphicsConfiguration!!.defaultTransform.scaleX.toFloat()
+          canvas.graphicsConfiguration?.defaultTransform?.scaleX?.toFloat() ?: 1.0f
         val pixelWidth = (canvas.width * scale).toInt()
         val pixelHeight = (canvas.height * scale).toInt()
         this@MaplibreMap.setSize(Size(pixelWidth, pixelHeight))
@@ -62,6 +74,89 @@ class MaplibreMap(
         nativeSetOpenGLSwapBehavior(nativePtr, flush)
     }
 
+    /**
+     * Enables rendering at a reduced resolution while a gesture is in progress (OpenGL backends only).
+     * The scale is lowered step by step while frames take longer than [targetFrameTimeMs] and raised
+     * again when there is headroom; frames go back to full resolution as soon as the gesture ends.
+     * @param enabled Whether frames may be rendered below full resolution
+     * @param minScale Smallest fraction of the full resolution to render at
+     * @param targetFrameTimeMs Frame time to aim for during gestures
+     */
+    fun setDynamicResolution(enabled: Boolean, minScale: Float = 0.5f, targetFrameTimeMs: Double = 33.0) {
+        require(minScale > 0f && minScale <= 1f) { "minScale must be in (0, 1]" }
+        require(targetFrameTimeMs > 0.0) { "targetFrameTimeMs must be positive" }
+        nativeSetDynamicResolution(nativePtr, enabled, minScale, targetFrameTimeMs)
+    }
+
+    /**
+     * Declares that the next frame only changes pixels inside the given rectangle, e.g. after
+     * updating a single marker. Hints from several calls are combined. A frame is presented as
+     * a partial update where the platform supports it (EGL swap with damage, Vulkan incremental
+     * present) only if everything that changed since the last frame was a style or annotation
+     * change made after the hints. Damage is never derived from tiles, annotations or feature
+     * state: camera, size or resolution changes, tile arrivals (including tiles re-parsed after
+     * a source data change), fades, label placement changes and changes without hints make the
+     * frame present in full. Declare the hints before making the change they cover. Pixels
+     * changed outside the hinted regions may stay stale on screen.
+     * @param x Left edge in pixels
+     * @param y Top edge in pixels
+     * @param width Width in pixels
+     * @param height Height in pixels
+     */
+    fun addDamageRegion(x: Int, y: Int, width: Int, height: Int) {
+        nativeAddDamageRegion(nativePtr, x, y, width, height)
+    }
+
+    /**
+     * Sets a frame time budget. While frames run over it, frames that only show newly loaded tiles
+     * or continue a fade are postponed for up to two ticks so their uploads are batched, and
+     * lower-zoom tile prefetching is paused. Camera, size, style and annotation changes always
+     * render on the next [tick]. [getFrameStats] reports how many frames were postponed and how
+     * long the batched frames took.
+     * @param targetFrameTimeMs Target time per frame, or 0 to render every change immediately (default)
+     */
+    fun setFrameBudget(targetFrameTimeMs: Double) {
+        require(targetFrameTimeMs >= 0.0) { "targetFrameTimeMs must not be negative" }
+        nativeSetFrameBudget(nativePtr, targetFrameTimeMs)
+    }
+
+    /**
+     * Returns frame timing, how often frames ran over the frame budget and how many were postponed
+     * by it so far.
+     */
+    fun getFrameStats(): FrameStats {
+        return nativeGetFrameStats(nativePtr)
+    }
+
+    /**
+     * Returns how many network requests of this map are waiting and running.
+     *
+     * Maps created with equal [ResourceOptions] share a request queue, so their stats are
+     * the same. Requests for styles, sprites and glyphs go first, then tiles near the center of
+     * any map's viewport, then its edges, then parent and prefetched tiles. Running requests for
+     * tiles that left every viewport are cancelled while visible tiles wait.
+     */
+    fun getRequestQueueStats(): RequestQueueStats {
+        return nativeGetRequestQueueStats(nativePtr)
+    }
+
+    /**
+     * Sets swapchain presentation options (has no effect on Metal/OpenGL backends).
+     * Changes are applied with a single swapchain rebuild when the next frame starts.
+     * @param presentMode How frames are queued for display; falls back to the driver's choice if unsupported
+     * @param maxFramesInFlight Frames the CPU may run ahead of the GPU, 0 for the default
+     * @param imageCount Swapchain image count hint, clamped to what the surface supports; 0 for the default
+     */
+    fun setVulkanPresentOptions(
+        presentMode: VulkanPresentMode = VulkanPresentMode.FIFO,
+        maxFramesInFlight: Int = 0,
+        imageCount: Int = 0
+    ) {
+        require(maxFramesInFlight >= 0) { "maxFramesInFlight must not be negative" }
+        require(imageCount >= 0) { "imageCount must not be negative" }
+        nativeSetVulkanPresentOptions(nativePtr, presentMode.nativeValue, maxFramesInFlight, imageCount)
+    }
+
     /**
      * Triggers a repaint of the map.
      */
@@ -85,6 +180,17 @@ class MaplibreMap(
         nativeLoadStyleJSON(nativePtr, json)
     }
 
+    /**
+     * Loads a style bundle written with [StyleBundleWriter].
+     * The bundle is memory-mapped and its style, sprites, glyphs and tiles are served from it,
+     * without the network or the ambient cache. It stays open until another style is loaded.
+     * @param path The path of the bundle
+     * @throws RuntimeException if the file is not a valid bundle
+     */
+    fun loadStyleBundle(path: String) {
+        nativeLoadStyleBundle(nativePtr, path)
+    }
+
     /**
      * Updates the camera position.
      * @param options The camera options to apply
@@ -111,6 +217,31 @@ class MaplibreMap(
         nativeFlyTo(nativePtr, options, duration)
     }
 
+    /**
+     * Replaces the tile level-of-detail settings given in [MapOptions.tileLod].
+     */
+    fun setTileLodOptions(options: TileLodOptions) {
+        nativeSetTileLodOptions(nativePtr, options)
+    }
+
+    /**
+     * Returns how far adaptive level of detail has currently lowered tile detail,
+     * from 0 (the configured settings) to 4.
+     */
+    fun getTileLodLevel(): Int {
+        return nativeGetTileLodLevel(nativePtr)
+    }
+
+    /**
+     * Sets how many bytes of tiles [easeTo] and [flyTo] may prefetch along their path.
+     * Prefetched tiles are requested behind visible ones; 0 disables prefetching.
+     * @param bytes Budget per animation, 8 MiB by default
+     */
+    fun setTrajectoryPrefetchBudget(bytes: Long) {
+        require(bytes >= 0) { "bytes must not be negative" }
+        nativeSetTrajectoryPrefetchBudget(nativePtr, bytes)
+    }
+
     /**
      * Gets the current camera options.
      * @return The current camera position and orientation
@@ -121,6 +252,8 @@ class MaplibreMap(
 
     /**
      * Sets the map size. This should be called when the viewport resizes.
+     * The change is applied once at the start of the next [tick], so a burst of
+     * resize events costs a single resize.
      * @param size The new size in pixels
      */
     fun setSize(size: Size) {
@@ -220,8 +353,163 @@ class MaplibreMap(
         return nativeIsRenderingStatsViewEnabled(nativePtr)
     }
 
+    /**
+     * Queries the rendered features at a screen point.
+     * The result is only valid until the next query on this map.
+     * @param point The screen coordinate in pixels
+     * @param layerIds Optional style layer ids to restrict the query to
+     */
+    fun queryRenderedFeatures(point: ScreenCoordinate, layerIds: List<String>? = null): FeatureQueryResult {
+        val layers = layerIds?.toTypedArray()
+        return runQuery { buffer ->
+            nativeQueryRenderedFeaturesAtPoint(nativePtr, point.x, point.y, layers, buffer)
+        }
+    }
+
+    /**
+     * Queries the rendered features inside a screen box.
+     * The result is only valid until the next query on this map.
+     * @param min The top-left corner of the box in pixels
+     * @param max The bottom-right corner of the box in pixels
+     * @param layerIds Optional style layer ids to restrict the query to
+     */
+    fun queryRenderedFeatures(min: ScreenCoordinate, max: ScreenCoordinate, layerIds: List<String>? = null): FeatureQueryResult {
+        val layers = layerIds?.toTypedArray()
+        return runQuery { buffer ->
+            nativeQueryRenderedFeaturesInBox(nativePtr, min.x, min.y, max.x, max.y, layers, buffer)
+        }
+    }
+
+    /**
+     * Queries the features of a source, whether or not they are currently rendered.
+     * The result is only valid until the next query on this map.
+     * @param sourceId The id of the source
+     * @param sourceLayerIds Source layers to query (required for vector sources)
+     */
+    fun querySourceFeatures(sourceId: String, sourceLayerIds: List<String>? = null): FeatureQueryResult {
+        val sourceLayers = sourceLayerIds?.toTypedArray()
+        return runQuery { buffer ->
+            nativeQuerySourceFeatures(nativePtr, sourceId, sourceLayers, buffer)
+        }
+    }
+
+    /**
+     * Pre-warms the on-disk cache with the glyph ranges and sprite sheets used by a style,
+     * fetching them in parallel before the first frame needs them.
+     * Progress is reported by [getPreloadProgress] and advances while [tick] runs.
+     * @param url The URL of the style
+     * @param glyphRanges Code point ranges to preload for every font stack in the style
+     */
+    fun preloadStyleResources(url: String, glyphRanges: List<IntRange> = DEFAULT_GLYPH_RANGES) {
+        nativePreloadStyleURL(nativePtr, url, glyphRangeStarts(glyphRanges))
+    }
+
+    /**
+     * Pre-warms the on-disk cache with the glyph ranges and sprite sheets used by a style JSON.
+     * @param json The style JSON as a string
+     * @param glyphRanges Code point ranges to preload for every font stack in the style
+     */
+    fun preloadStyleJSONResources(json: String, glyphRanges: List<IntRange> = DEFAULT_GLYPH_RANGES) {
+        nativePreloadStyleJSON(nativePtr, json, glyphRangeStarts(glyphRanges))
+    }
+
+    /**
+     * Warms the ambient cache with the resources of a recorded session, so the regions opened
+     * last time load from disk. Resources are requested at low priority, behind anything the
+     * map shows, those requested by most sessions first; cached ones that are still fresh
+     * cost no network request, and stale ones are revalidated.
+     * Progress is reported by [getPreloadProgress] and advances while [tick] runs.
+     * @param sessionPath A session log, e.g. an aggregate made with [SessionLog.merge]; null
+     *   uses the one recorded next to this map's cache with [ResourceOptions.recordSession]
+     * @param maxRequests The most resources to request
+     * @return The number of resources requested
+     * @throws RuntimeException if the session log can't be read
+     */
+    fun warmUpCache(sessionPath: String? = null, maxRequests: Int = 2000): Int {
+        require(maxRequests >= 0) { "maxRequests must not be negative" }
+        return nativeWarmUpCache(nativePtr, sessionPath, maxRequests)
+    }
+
+    /**
+     * Gets the progress of all preloading started on this map.
+     */
+    fun getPreloadProgress(): PreloadProgress {
+        return nativeGetPreloadProgress(nativePtr)
+    }
+
+    /**
+     * Cancels all outstanding preload requests.
+     */
+    fun cancelPreload() {
+        nativeCancelPreload(nativePtr)
+    }
+
+    /**
+     * Starts copying every presented frame into a ring of host-visible buffers (Vulkan only).
+     * Copies are pipelined with rendering: the CPU reads frame N while the GPU renders the next ones.
+     * @param slots Number of frames that can be in flight or held at once
+     * @throws UnsupportedOperationException on OpenGL and Metal builds
+     */
+    fun enableFrameReadback(slots: Int = 3) {
+        require(slots >= 2) { "slots must be at least 2" }
+        nativeEnableFrameReadback(nativePtr, slots)
+    }
+
+    /**
+     * Takes the oldest frame that has finished copying, without blocking.
+     * Call [releaseFrame] once the pixels have been consumed.
+     * @return The frame, or null if none is ready
+     */
+    fun acquireFrame(): RenderedFrame? {
+        val info = LongArray(RenderedFrame.INFO_SIZE)
+        return RenderedFrame.fromNative(nativeAcquireFrame(nativePtr, info), info, this)
+    }
+
+    /**
+     * Returns a frame's buffer to the readback ring; its pixels can't be used afterwards.
+     * Releasing a frame again has no effect.
+     */
+    fun releaseFrame(frame: RenderedFrame) {
+        require(frame.owner === this) { "Frame was acquired from another map" }
+        if (frame.markReleased()) {
+            nativeReleaseFrame(nativePtr, frame.slot, frame.number)
+        }
+    }
+
+    private fun runQuery(query: (ByteBuffer) -> Int): FeatureQueryResult {
+        var size = query(queryBuffer)
+        if (size > queryBuffer.capacity()) {
+            // The native side keeps the encoded result, so only the copy is repeated
+            // Doubling past 1 GiB would overflow, so such results get a buffer of their own size
+            val capacity = if (size >= 1 shl 30) size else Integer.highestOneBit(size) shl 1
+            queryBuffer = allocateQueryBuffer(capacity)
+            size = nativeCopyQueryResult(nativePtr, queryBuffer)
+        }
+        val view = queryBuffer.duplicate().order(ByteOrder.nativeOrder())
+        view.limit(size)
+        return FeatureQueryResult(view)
+    }
+
     companion object {
 
+        private const val INITIAL_QUERY_BUFFER_SIZE = 64 * 1024
+
+        // Basic Latin and Latin-1 Supplement
+        private val DEFAULT_GLYPH_RANGES = listOf(0..255)
+
+        // Glyph PBFs are served in blocks of 256 code points
+        private fun glyphRangeStarts(ranges: List<IntRange>): IntArray {
+            return ranges
+                .flatMap { range -> (range.first / 256..range.last / 256).map { it * 256 } }
+                .filter { it in 0..0xFFFF }
+                .distinct()
+                .toIntArray()
+        }
+
+        private fun allocateQueryBuffer(capacity: Int): ByteBuffer {
+            return ByteBuffer.allocateDirect(capacity).order(ByteOrder.nativeOrder())
+        }
+
         @JvmStatic
         private external fun nativeNew(
             canvas: Canvas,
@@ -231,7 +519,8 @@ class MaplibreMap(
             mapObserver: MapObserver,
             mapOptions: MapOptions,
             resourceOptions: ResourceOptions,
-            clientOptions: ClientOptions
+            clientOptions: ClientOptions,
+            sharedContext: Boolean
         ): Long
 
         @JvmStatic
@@ -246,6 +535,9 @@ class MaplibreMap(
         @JvmStatic
         private external fun nativeLoadStyleJSON(ptr: Long, json: String)
 
+        @JvmStatic
+        private external fun nativeLoadStyleBundle(ptr: Long, path: String)
+
         @JvmStatic
         private external fun nativeJumpTo(ptr: Long, cameraOptions: CameraOptions)
 
@@ -267,6 +559,33 @@ class MaplibreMap(
         @JvmStatic
         private external fun nativeSetOpenGLSwapBehavior(ptr: Long, flush: Boolean)
 
+        @JvmStatic
+        private external fun nativeSetDynamicResolution(ptr: Long, enabled: Boolean, minScale: Float, targetFrameTimeMs: Double)
+
+        @JvmStatic
+        private external fun nativeAddDamageRegion(ptr: Long, x: Int, y: Int, width: Int, height: Int)
+
+        @JvmStatic
+        private external fun nativeSetFrameBudget(ptr: Long, targetFrameTimeMs: Double)
+
+        @JvmStatic
+        private external fun nativeGetFrameStats(ptr: Long): FrameStats
+
+        @JvmStatic
+        private external fun nativeGetRequestQueueStats(ptr: Long): RequestQueueStats
+
+        @JvmStatic
+        private external fun nativeSetTrajectoryPrefetchBudget(ptr: Long, bytes: Long)
+
+        @JvmStatic
+        private external fun nativeSetTileLodOptions(ptr: Long, options: TileLodOptions)
+
+        @JvmStatic
+        private external fun nativeGetTileLodLevel(ptr: Long): Int
+
+        @JvmStatic
+        private external fun nativeSetVulkanPresentOptions(ptr: Long, presentMode: Int, maxFramesInFlight: Int, imageCount: Int)
+
         @JvmStatic
         private external fun nativeMoveBy(ptr: Long, screenCoordinate: ScreenCoordinate)
 
@@ -299,5 +618,41 @@ class MaplibreMap(
         
         @JvmStatic
         private external fun nativeIsRenderingStatsViewEnabled(ptr: Long): Boolean
+    
+        @JvmStatic
+        private external fun nativeQueryRenderedFeaturesAtPoint(ptr: Long, x: Double, y: Double, layerIds: Array<String>?, buffer: ByteBuffer): Int
+
+        @JvmStatic
+        private external fun nativeQueryRenderedFeaturesInBox(ptr: Long, minX: Double, minY: Double, maxX: Double, maxY: Double, layerIds: Array<String>?, buffer: ByteBuffer): Int
+
+        @JvmStatic
+        private external fun nativeQuerySourceFeatures(ptr: Long, sourceId: String, sourceLayerIds: Array<String>?, buffer: ByteBuffer): Int
+
+        @JvmStatic
+        private external fun nativeCopyQueryResult(ptr: Long, buffer: ByteBuffer): Int
+    
+        @JvmStatic
+        private external fun nativePreloadStyleURL(ptr: Long, url: String, rangeStarts: IntArray)
+
+        @JvmStatic
+        private external fun nativePreloadStyleJSON(ptr: Long, json: String, rangeStarts: IntArray)
+
+        @JvmStatic
+        private external fun nativeWarmUpCache(ptr: Long, sessionPath: String?, maxRequests: Int): Int
+
+        @JvmStatic
+        private external fun nativeGetPreloadProgress(ptr: Long): PreloadProgress
+
+        @JvmStatic
+        private external fun nativeCancelPreload(ptr: Long)
+
+        @JvmStatic
+        private external fun nativeEnableFrameReadback(ptr: Long, slotCount: Int)
+
+        @JvmStatic
+        private external fun nativeAcquireFrame(ptr: Long, info: LongArray): ByteBuffer?
+
+        @JvmStatic
+        private external fun nativeReleaseFrame(ptr: Long, slot: Int, number: Long)
     }
 }
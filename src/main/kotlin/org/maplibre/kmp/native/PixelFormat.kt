@@ -0,0 +1,13 @@
+package org.maplibre.kmp.native
+
+enum class PixelFormat(val nativeValue: Int) {
+    RGBA(0),
+    BGRA(1);
+
+    companion object {
+        fun fromNative(value: Int): PixelFormat {
+            return values().find { it.nativeValue == value }
+                ?: throw IllegalArgumentException("Unknown PixelFormat value: $value")
+        }
+    }
+}
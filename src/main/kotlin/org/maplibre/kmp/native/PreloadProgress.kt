@@ -0,0 +1,13 @@
+package org.maplibre.kmp.native
+
+/**
+ * Progress of resource preloading started with [MaplibreMap.preloadStyleResources].
+ * A resource that is not found on the server counts as completed, not failed.
+ */
+data class PreloadProgress(
+    val requested: Int,
+    val completed: Int,
+    val failed: Int
+) {
+    val isComplete: Boolean get() = completed + failed >= requested
+}
@@ -0,0 +1,64 @@
+package org.maplibre.kmp.native
+
+import java.nio.ByteBuffer
+
+/**
+ * A rendered frame read back from the GPU.
+ *
+ * [pixels] is a direct buffer over native staging memory: it is only valid until the frame is
+ * released, and the slot it occupies can't receive new frames until then. The frame keeps its
+ * map, and so that memory, from being freed while the frame is reachable; don't keep the buffer
+ * beyond the frame. Pixels are tightly packed, premultiplied 8-bit [pixelFormat], top row first.
+ */
+class RenderedFrame internal constructor(
+    val number: Long,
+    val width: Int,
+    val height: Int,
+    val pixelFormat: PixelFormat,
+    private val buffer: ByteBuffer,
+    /** Frames dropped since readback started because the consumer fell behind */
+    val droppedFrames: Long,
+    internal val slot: Int,
+    /** Map whose readback ring holds the pixels */
+    internal val owner: NativeObject,
+) {
+    @Volatile
+    private var released = false
+
+    /**
+     * The frame's pixels.
+     * @throws IllegalStateException once the frame has been released
+     */
+    val pixels: ByteBuffer
+        get() {
+            check(!released) { "Frame $number has been released" }
+            return buffer
+        }
+
+    /** Marks the frame released; returns false if it already was */
+    internal fun markReleased(): Boolean {
+        synchronized(this) {
+            if (released) return false
+            released = true
+            return true
+        }
+    }
+
+    internal companion object {
+        const val INFO_SIZE = 6
+
+        fun fromNative(pixels: ByteBuffer?, info: LongArray, owner: NativeObject): RenderedFrame? {
+            if (pixels == null) return null
+            return RenderedFrame(
+                number = info[1],
+                width = info[2].toInt(),
+                height = info[3].toInt(),
+                pixelFormat = PixelFormat.fromNative(info[4].toInt()),
+                buffer = pixels,
+                droppedFrames = info[5],
+                slot = info[0].toInt(),
+                owner = owner,
+            )
+        }
+    }
+}
@@ -0,0 +1,17 @@
+package org.maplibre.kmp.native
+
+/**
+ * State of the network request queue reported by [MaplibreMap.getRequestQueueStats].
+ * Counts cover the maps sharing the queried map's resource options, for as long as their
+ * queue lives.
+ */
+data class RequestQueueStats(
+    /** Requests waiting for a free connection slot */
+    val queued: Int,
+    val inFlight: Int,
+    /** Running tile requests cancelled because the tile left every viewport */
+    val cancelled: Long,
+    val completed: Long,
+    /** Response bytes received */
+    val bytes: Long
+)
@@ -0,0 +1,21 @@
+package org.maplibre.kmp.native
+
+/**
+ * What a resource requested by the map is used for.
+ */
+enum class ResourceKind(val nativeValue: Int) {
+    UNKNOWN(0),
+    STYLE(1),
+    SOURCE(2),
+    TILE(3),
+    GLYPHS(4),
+    SPRITE_IMAGE(5),
+    SPRITE_JSON(6),
+    IMAGE(7);
+
+    companion object {
+        fun fromNative(value: Int): ResourceKind {
+            return values().find { it.nativeValue == value } ?: UNKNOWN
+        }
+    }
+}
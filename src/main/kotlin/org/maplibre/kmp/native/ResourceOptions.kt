@@ -1,5 +1,8 @@
 package org.maplibre.kmp.native
 
+import java.nio.file.Files
+import java.nio.file.Paths
+
 /**
  * Configuration options for resource loading and caching.
  * This controls how MapLibre fetches and caches map resources.
@@ -8,10 +11,44 @@ data class ResourceOptions(
     val apiKey: String = "",
     val tileServerOptions: TileServerOptions = TileServerOptions.DemoTiles,
     val cachePath: String = "maplibre-cache",
+    /**
+     * Directory that asset:// URLs resolve against, or a JAR or ZIP archive read in place
+     * without extracting it: "app.jar!/prefix/" or a path ending in .jar or .zip. See
+     * [classpathAssetPath].
+     */
     val assetPath: String = "",
-    val maximumCacheSize: Long = 50 * 1024 * 1024 // 50 MB default
+    val maximumCacheSize: Long = 50 * 1024 * 1024, // 50 MB default
+    /** Serves the map's network requests instead of the built-in HTTP client, when set */
+    val fileSource: JvmFileSource? = null,
+    /** Rewrite network request URLs natively; the first matching rule applies */
+    val urlRewriteRules: List<UrlRewriteRule> = emptyList(),
+    /** How the ambient cache is written; null keeps MapLibre's immediate writes */
+    val ambientCache: AmbientCacheOptions? = null,
+    /** How ambient cache entries are compressed; null stores them as MapLibre does */
+    val cacheCompression: CacheCompressionOptions? = null,
+    /**
+     * Record the resources maps request to a session log next to [cachePath], for
+     * [MaplibreMap.warmUpCache] to replay on the next launch. See [SessionLog].
+     */
+    val recordSession: Boolean = false
 ) {
     init {
         require(maximumCacheSize >= 0) { "maximumCacheSize must be non-negative" }
     }
+
+    companion object {
+        /**
+         * Asset path serving asset:// URLs from [prefix] in the classpath entry that holds
+         * [anchor], e.g. `classpathAssetPath("maplibre/", MyApp::class.java)`. A JAR is read in
+         * place; when running from a classes directory, e.g. in an IDE, that directory is used.
+         */
+        fun classpathAssetPath(prefix: String, anchor: Class<*>): String {
+            val location = Paths.get(anchor.protectionDomain.codeSource.location.toURI())
+            return if (Files.isDirectory(location)) {
+                location.resolve(prefix).toString()
+            } else {
+                "$location!/$prefix"
+            }
+        }
+    }
 }
@@ -0,0 +1,35 @@
+package org.maplibre.kmp.native
+
+/**
+ * Session logs: the resources maps requested during a session, for warming the ambient cache.
+ *
+ * With [ResourceOptions.recordSession], each remote resource a map requests is logged once to
+ * [pathFor] of its cache; each session replaces the previous one's log.
+ * [MaplibreMap.warmUpCache] replays a log at low priority. Logs collected from many users can
+ * be merged into a deployment-wide aggregate and shipped with the application, so new
+ * installs start with the regions everyone opens.
+ */
+object SessionLog {
+
+    /**
+     * The session log recorded for the ambient cache at [cachePath].
+     */
+    @JvmStatic
+    fun pathFor(cachePath: String): String = "$cachePath.session"
+
+    /**
+     * Merges session logs into one at [output], keeping the [maxEntries] resources requested
+     * by the most sessions; [MaplibreMap.warmUpCache] replays those first.
+     * @return The number of resources in the merged log
+     * @throws RuntimeException if a log can't be read or the result can't be written
+     */
+    @JvmStatic
+    fun merge(inputs: List<String>, output: String, maxEntries: Int = 20000): Int {
+        require(maxEntries >= 0) { "maxEntries must not be negative" }
+        MapLibreNativeLoader.load()
+        return nativeMerge(inputs.toTypedArray(), output, maxEntries)
+    }
+
+    @JvmStatic
+    private external fun nativeMerge(inputs: Array<String>, output: String, maxEntries: Int): Int
+}
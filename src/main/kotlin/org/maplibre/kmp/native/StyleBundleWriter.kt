@@ -0,0 +1,83 @@
+package org.maplibre.kmp.native
+
+/**
+ * Writes a style bundle: a style with its sprites, glyphs, tiles and data in one file, for
+ * opening with [MaplibreMap.loadStyleBundle] on machines without network access.
+ *
+ * Add the resources in any order, then call [finish] with the style. The style is rewritten to
+ * use the bundled resources: sources with tiles, the glyphs URL and sprites with added sheets
+ * point into the bundle, and any string starting with `bundle://` is resolved to the entry
+ * named by the rest of it, e.g. `"data": "bundle://data/parcels.geojson"`. Nothing appears at
+ * [path] until [finish] succeeds.
+ */
+class StyleBundleWriter(val path: String) : NativeObject(
+    new = { nativeNew(path) },
+    destroy = ::nativeDestroy
+) {
+
+    /**
+     * Adds an entry referenced from the style as `bundle://` followed by [name].
+     */
+    fun add(name: String, data: ByteArray) {
+        nativeAdd(nativePtr, name, data)
+    }
+
+    /**
+     * Adds tile [z]/[x]/[y] of a vector, raster or raster-dem source, numbered in the XYZ scheme.
+     * Tiles the bundle lacks render empty.
+     */
+    fun addTile(sourceId: String, z: Int, x: Int, y: Int, data: ByteArray) {
+        require(z in 0..25) { "z must be between 0 and 25" }
+        require(x >= 0 && y >= 0) { "x and y must be non-negative" }
+        nativeAddTile(nativePtr, sourceId, z, x, y, data)
+    }
+
+    /**
+     * Adds the glyph PBF of [fontStack] (comma-separated, as in the glyphs URL) covering the 256
+     * code points from [rangeStart].
+     */
+    fun addGlyphs(fontStack: String, rangeStart: Int, data: ByteArray) {
+        require(rangeStart in 0..0xFF00 && rangeStart % 256 == 0) { "rangeStart must be a multiple of 256" }
+        nativeAddGlyphs(nativePtr, fontStack, rangeStart, data)
+    }
+
+    /**
+     * Adds a sprite sheet. Use the id `default` for a style with a single sprite URL.
+     * @param pixelRatio 1 for the standard sheet, 2 for the `@2x` one
+     */
+    fun addSprite(spriteId: String = "default", pixelRatio: Int = 1, json: ByteArray, image: ByteArray) {
+        require(pixelRatio >= 1) { "pixelRatio must be at least 1" }
+        nativeAddSprite(nativePtr, spriteId, pixelRatio, json, image)
+    }
+
+    /**
+     * Rewrites and validates [styleJson], then completes the bundle.
+     * @throws IllegalArgumentException if the style does not parse or the bundle can't be written
+     */
+    fun finish(styleJson: String) {
+        nativeFinish(nativePtr, styleJson)
+    }
+
+    companion object {
+        @JvmStatic
+        private external fun nativeNew(path: String): Long
+
+        @JvmStatic
+        private external fun nativeDestroy(ptr: Long)
+
+        @JvmStatic
+        private external fun nativeAdd(ptr: Long, name: String, data: ByteArray)
+
+        @JvmStatic
+        private external fun nativeAddTile(ptr: Long, sourceId: String, z: Int, x: Int, y: Int, data: ByteArray)
+
+        @JvmStatic
+        private external fun nativeAddGlyphs(ptr: Long, fontStack: String, rangeStart: Int, data: ByteArray)
+
+        @JvmStatic
+        private external fun nativeAddSprite(ptr: Long, spriteId: String, pixelRatio: Int, json: ByteArray, image: ByteArray)
+
+        @JvmStatic
+        private external fun nativeFinish(ptr: Long, styleJson: String)
+    }
+}
@@ -0,0 +1,31 @@
+package org.maplibre.kmp.native
+
+/**
+ * Tile level-of-detail settings. Distant tiles in pitched views are loaded at lower zoom levels
+ * than the ones near the camera, which cuts how many tiles a high-pitch view needs.
+ *
+ * @property minRadius Radius around the camera, in tiles, always loaded at full detail (at least 1)
+ * @property scale Factor applied to tile distances; values above 1 lower detail sooner
+ * @property pitchThreshold Pitch in degrees above which distant tiles lose detail
+ * @property zoomShift Zoom offset for distant tiles; negative values trade detail for speed
+ * @property prefetchZoomDelta How many lower zoom levels are prefetched as placeholders
+ * @property adaptiveTargetFrameTimeMs When positive, the map lowers detail step by step while
+ *   frames take longer than this or the network falls behind, and restores it once both calm
+ *   down. 0 keeps the settings fixed.
+ */
+data class TileLodOptions(
+    val minRadius: Double = 3.0,
+    val scale: Double = 1.0,
+    val pitchThreshold: Double = 60.0,
+    val zoomShift: Double = 0.0,
+    val prefetchZoomDelta: Int = 4,
+    val adaptiveTargetFrameTimeMs: Double = 0.0
+) {
+    init {
+        require(minRadius >= 1.0) { "minRadius must be at least 1" }
+        require(scale > 0.0) { "scale must be positive" }
+        require(pitchThreshold in 0.0..90.0) { "pitchThreshold must be between 0 and 90 degrees" }
+        require(prefetchZoomDelta in 0..255) { "prefetchZoomDelta must be between 0 and 255" }
+        require(adaptiveTargetFrameTimeMs >= 0.0) { "adaptiveTargetFrameTimeMs must not be negative" }
+    }
+}
@@ -0,0 +1,47 @@
+package org.maplibre.kmp.native
+
+/**
+ * Rewrites the URL of matching network requests, set in [ResourceOptions.urlRewriteRules].
+ * Rules are compiled natively once and applied without calling into the JVM. Only the network
+ * sees the rewritten URL; the ambient cache keeps storing responses under the original one.
+ * Rules see URLs before tile server schemes such as `maptiler://` are resolved, so they can
+ * also map custom schemes.
+ *
+ * The replacement may contain `$0` to `$9` for capture groups (for prefix rules, `$0` is the
+ * prefix), `{name}` for a token set with [setToken], and `$$` for a literal dollar sign.
+ *
+ * @property pattern The URL prefix to replace, or for [Type.REGEX] an ECMAScript regular
+ *   expression that must match the whole URL
+ * @property replacement What the prefix, or the whole URL for [Type.REGEX], is replaced with
+ * @property type How [pattern] matches
+ * @property kinds Kinds of resources the rule applies to; empty for all
+ */
+data class UrlRewriteRule(
+    val pattern: String,
+    val replacement: String,
+    val type: Type = Type.PREFIX,
+    val kinds: Set<ResourceKind> = emptySet()
+) {
+    enum class Type(val nativeValue: Int) {
+        PREFIX(0),
+        REGEX(1)
+    }
+
+    // Read by the native conversion
+    internal val kindMask: Int = kinds.fold(0) { mask, kind -> mask or (1 shl kind.nativeValue) }
+
+    companion object {
+        /**
+         * Sets the value substituted for `{name}` in every rule, e.g. a rotating signature.
+         * Takes effect for the next request; an empty value removes the token.
+         */
+        @JvmStatic
+        fun setToken(name: String, value: String) {
+            MapLibreNativeLoader.load()
+            nativeSetToken(name, value)
+        }
+
+        @JvmStatic
+        private external fun nativeSetToken(name: String, value: String)
+    }
+}
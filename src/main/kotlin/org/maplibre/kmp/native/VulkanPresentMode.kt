@@ -0,0 +1,20 @@
+package org.maplibre.kmp.native
+
+/**
+ * Swapchain present modes; native values match VkPresentModeKHR.
+ */
+enum class VulkanPresentMode(val nativeValue: Int) {
+    /** No vsync; lowest latency but may tear */
+    IMMEDIATE(0),
+    /** Tear-free, replaces queued frames with newer ones for lower latency */
+    MAILBOX(1),
+    /** Vsync, never drops frames; always supported */
+    FIFO(2);
+
+    companion object {
+        fun fromNative(value: Int): VulkanPresentMode {
+            return values().find { it.nativeValue == value }
+                ?: throw IllegalArgumentException("Unknown VulkanPresentMode value: $value")
+        }
+    }
+}
@@ -0,0 +1,43 @@
+package org.maplibre.kmp.native
+
+/**
+ * Threads a map parses tiles and lays out symbols on.
+ *
+ * Maps without these options share MapLibre's fixed-size background pool.
+ *
+ * @property threads Number of workers; 0 uses one per available processor
+ * @property name Prefix of the worker thread names
+ * @property priority Scheduling priority of the workers
+ * @property cpuAffinity CPUs to pin workers to, worker i to `cpuAffinity[i % size]`; empty leaves
+ *   them unpinned. Not supported on macOS.
+ * @property shared Reuse a live pool created with equal options, so every map configured alike
+ *   splits the same workers; false gives the map a pool of its own
+ */
+data class WorkerPoolOptions(
+    val threads: Int = 0,
+    val name: String = "MapWorker",
+    val priority: WorkerPriority = WorkerPriority.LOW,
+    val cpuAffinity: IntArray = IntArray(0),
+    val shared: Boolean = true
+) {
+    init {
+        require(threads >= 0) { "threads must not be negative" }
+        require(cpuAffinity.all { it >= 0 }) { "cpuAffinity must only contain CPU indices" }
+    }
+
+    override fun equals(other: Any?): Boolean {
+        if (this === other) return true
+        if (other !is WorkerPoolOptions) return false
+        return threads == other.threads && name == other.name && priority == other.priority &&
+            cpuAffinity.contentEquals(other.cpuAffinity) && shared == other.shared
+    }
+
+    override fun hashCode(): Int {
+        var result = threads
+        result = 31 * result + name.hashCode()
+        result = 31 * result + priority.hashCode()
+        result = 31 * result + cpuAffinity.contentHashCode()
+        result = 31 * result + shared.hashCode()
+        return result
+    }
+}
@@ -0,0 +1,14 @@
+package org.maplibre.kmp.native
+
+enum class WorkerPriority(val nativeValue: Int) {
+    LOW(0),
+    NORMAL(1),
+    HIGH(2);
+
+    companion object {
+        fun fromNative(value: Int): WorkerPriority {
+            return values().find { it.nativeValue == value }
+                ?: throw IllegalArgumentException("Unknown WorkerPriority value: $value")
+        }
+    }
+}